@@ -44,6 +44,10 @@
 #define UINT32_t uint32_t
 #endif
 
+#ifndef INT64_t
+#define INT64_t int64_t
+#endif
+
 #ifndef UINT64_t
 #define UINT64_t uint64_t
 #endif
@@ -67,11 +71,59 @@
 #define INKY_SPI_SPEED_HZ_MAX		488000
 #define INKY_SPI_BITS_DEFAULT		8
 
+/* Timeout passed to the BUSY pin poll callback */
+#define INKY_BUSY_TIMEOUT_US		30000000
+
 /**
  * @}
  * Inky Setup Flags
  */
 
+/**
+ * @defgroup inkyfixed Build-time panel selection
+ *
+ * Define INKY_FIXED_PRODUCT as INKY_WHAT or INKY_PHAT to make the
+ * framebuffer geometry a compile-time constant, and INKY_FIXED_COLOR
+ * as INKY_COLOR_BLACK, INKY_COLOR_RED or INKY_COLOR_YELLOW to make
+ * color availability one. inky_config.pdt must then match, and
+ * inky_config.color is ignored.
+ * @{
+ */
+
+#ifdef INKY_FIXED_PRODUCT
+#define INKY_PRODUCT(cfg)	(INKY_FIXED_PRODUCT)
+#define INKY_FB_WIDTH(fb)	(INKY_FIXED_PRODUCT == INKY_WHAT ? 400 : 122)
+#define INKY_FB_HEIGHT(fb)	(INKY_FIXED_PRODUCT == INKY_WHAT ? 300 : 250)
+#else
+#define INKY_PRODUCT(cfg)	((cfg)->pdt)
+#define INKY_FB_WIDTH(fb)	((fb)->width)
+#define INKY_FB_HEIGHT(fb)	((fb)->height)
+#endif /* #ifdef INKY_FIXED_PRODUCT */
+
+/* A fixed color also fixes the framebuffer pixel format */
+#ifdef INKY_FIXED_COLOR
+#define INKY_FB_BPP(fb)		(INKY_FIXED_COLOR == INKY_COLOR_BLACK ? 1 : 2)
+#else
+#define INKY_FB_BPP(fb)		((fb)->fmt.bpp)
+#endif /* #ifdef INKY_FIXED_COLOR */
+
+/** @brief Bytes per framebuffer row of width pixels at bpp bits,
+ * rounded up to a whole 32 bit word */
+#define INKY_ROW_STRIDE(width, bpp)				\
+	((((UINT32_t) (width) * (bpp) + 31) / 32) * 4)
+
+#if defined(INKY_FIXED_PRODUCT) && defined(INKY_FIXED_COLOR)
+#define INKY_FB_STRIDE(fb)					\
+	INKY_ROW_STRIDE(INKY_FB_WIDTH(fb), INKY_FB_BPP(fb))
+#else
+#define INKY_FB_STRIDE(fb)	((fb)->stride)
+#endif /* #if defined(INKY_FIXED_PRODUCT) && defined(INKY_FIXED_COLOR) */
+
+/**
+ * @}
+ * Build-time panel selection
+ */
+
 /** @defgroup inkyerrorstates Inky error states
  * @{
  */
@@ -86,6 +138,7 @@
 #define INKY_E_NULL_PTR			-7
 #define INKY_E_FAILURE			-8
 #define INKY_E_COMM_FAILURE		-9
+#define INKY_E_BAD_DATA			-10
 
 /**
  * @}
@@ -206,8 +259,79 @@ extern "C" {
 		UINT8_t yellow;
 	} inky_color_config;
 
+/* Panel Definitions */
+
+/**
+ * @defgroup inkyinitprog Panel init program opcodes
+ *
+ * An init program is a sequence of commands, each encoded as the
+ * command byte, the number of data bytes, then the data bytes. The
+ * following opcodes are interpreted by the driver instead of being
+ * sent to the panel.
+ * @{
+ */
+
+/* Send the following command only if red is available */
+#define INKY_INIT_IF_RED		0xf1
+/* Send the following command only if yellow is available */
+#define INKY_INIT_IF_YELLOW		0xf2
+/* Send the panel LUT for the available colors with command 0x32 */
+#define INKY_INIT_LUTS			0xf3
+
+/**
+ * @}
+ * Panel init program opcodes
+ */
+
+/** @brief Everything the driver needs to know about a panel
+    @var width Pixels per row
+    @var height Rows
+    @var row_stride Bytes per row of panel RAM, 0 for (width + 7) / 8
+    @var init Init program sent after reset, see INKY_INIT_*
+    @var init_len Length of init in bytes
+    @var lut_black LUT for black and white panels
+    @var lut_red LUT for panels with red
+    @var lut_yellow LUT for panels with yellow
+    @var lut_len Length of each LUT in bytes
+**/
+	typedef struct inky_panelnode {
+		UINT16_t width;
+		UINT16_t height;
+		UINT16_t row_stride;
+		const UINT8_t *init;
+		UINT32_t init_len;
+		const UINT8_t *lut_black;
+		const UINT8_t *lut_red;
+		const UINT8_t *lut_yellow;
+		UINT32_t lut_len;
+	} inky_panel;
+
 /* Framebuffer Definitions */
 
+/** @brief Pixel formats a framebuffer can be stored in
+ * @var INKY_PIXFMT_AUTO 1BPP without red or yellow, otherwise 2BPP
+ * @var INKY_PIXFMT_1BPP White 0, black 1
+ * @var INKY_PIXFMT_2BPP White 0, black 1, red or yellow 2
+ * @var INKY_PIXFMT_4BPP inky_color value, for panels with more colors
+ */
+	typedef enum {
+		INKY_PIXFMT_AUTO,
+		INKY_PIXFMT_1BPP,
+		INKY_PIXFMT_2BPP,
+		INKY_PIXFMT_4BPP
+	} inky_pixel_format;
+
+/** @brief Pixel format descriptor carried by each framebuffer
+    @var format Format of the framebuffer, never INKY_PIXFMT_AUTO
+    @var bpp Bits per pixel
+    @var mask Mask of one pixel in the lowest bits of a byte
+**/
+	typedef struct inky_pixfmtnode {
+		inky_pixel_format format;
+		UINT8_t bpp;
+		UINT8_t mask;
+	} inky_pixfmt;
+
 /** @brief Framebuffer type dictates how the buffer is displayed and
  * refreshed
  * @var INKY_FB_REFRESH_ALWAYS full refresh anytime the fb is written
@@ -220,19 +344,92 @@ extern "C" {
 		INKY_FB_OVERLAY,
 	} inky_fb_type;
 
+/** @brief How the framebuffer is turned onto the panel
+ * @var INKY_ORIENT_0 Framebuffer as the panel is addressed
+ * @var INKY_ORIENT_90 Turned a quarter clockwise: panel width and height
+ * swap
+ * @var INKY_ORIENT_180 Turned upside down
+ * @var INKY_ORIENT_270 Turned a quarter anticlockwise
+ * @var INKY_ORIENT_MIRROR Flag to OR into one of the above, mirroring
+ * the framebuffer left to right before it is turned
+ */
+	typedef enum {
+		INKY_ORIENT_0,
+		INKY_ORIENT_90,
+		INKY_ORIENT_180,
+		INKY_ORIENT_270,
+		INKY_ORIENT_MIRROR
+	} inky_orientation;
+
+/** @brief Rectangle of w by h pixels with its top left corner at x, y */
+	typedef struct inky_rectnode {
+		UINT16_t x;
+		UINT16_t y;
+		UINT16_t w;
+		UINT16_t h;
+	} inky_rect;
+
+	struct inky_layernode;
+
+	struct inky_bandnode;
+
 /** @brief Framebuffer is defined by the following struct, but will be
  *  setup by the API commands in this section unless the user decides
- *  they are unworthy of use */
+ *  they are unworthy of use
+ *
+ *  Each row starts on a 32 bit boundary, stride bytes after the one
+ *  before it. Bits after the last pixel of a row are padding.
+ *
+ *  dirty bounds the pixels changed since the panel last showed the
+ *  framebuffer, with w and h 0 when there are none. Blits, sprites,
+ *  text, bulk moves and the drawing primitives mark it themselves.
+ *  Pixel and row writes such as inky_fb_set_pixel(), inky_fb_hline()
+ *  and inky_fb_write_row() do not, so mark those with
+ *  inky_fb_mark_dirty().
+ *
+ *  orientation is an inky_orientation, set with
+ *  inky_fb_set_orientation(). Width, height and every coordinate are
+ *  in the turned framebuffer, the panel is only turned when sending.
+ *
+ *  The framebuffer may be a canvas larger than the panel, see
+ *  inky_fb_set_canvas(). The panel then shows the window of the
+ *  panel's size with its top left pixel at view_x, view_y.
+ *
+ *  Each pixel covers scale by scale panel pixels, see
+ *  inky_fb_set_scale(). The panel's size above is then divided by
+ *  scale, rounding up.
+ *
+ *  layers is the bottom of a stack of framebuffers composed over this
+ *  one as rows are sent, NULL for none, see inky-layer.h.
+ *
+ *  band is NULL, unless the framebuffer only keeps one band of rows
+ *  in memory, see inky_band_setup(). Its buffer is then NULL.
+ */
 	typedef struct inky_fbnode {
 		UINT16_t width;
 		UINT16_t height;
 		UINT8_t *buffer;
-		UINT16_t bytes;
+		UINT32_t stride;
+		UINT32_t bytes;
+		inky_pixfmt fmt;
 		inky_fb_type fb_type;
+		inky_rect dirty;
+		UINT8_t orientation;
+		UINT8_t scale;
+		UINT16_t view_x;
+		UINT16_t view_y;
+		struct inky_layernode *layers;
+		struct inky_bandnode *band;
 		void *usrptr1;
 		void *usrptr2;
 	} inky_fb;
 
+/** @brief Framebuffer coordinate */
+	typedef struct inky_pointnode {
+		UINT16_t x;
+		UINT16_t y;
+	} inky_point;
+
 	typedef UINT16_t inky_flags;
 
 /** @brief Configuration structure for Inky, to pass to setup function
@@ -241,6 +438,10 @@ extern "C" {
     @var *fb Frame buffer to be allocated by library (note: must free later)
     @var *active_fb Not set by user. Always null when REFRESH_ALWAYS
     @var exclude_flags Config flags to remove
+    @var fb_format Pixel format of the allocated fb, INKY_PIXFMT_AUTO
+    to choose from the available colors
+    @var *panel Panel descriptor. Register one for INKY_CUSTOM, set by
+    setup for other products
     @var gpio_init_cb gpio init callback
 **/
 	typedef struct inky_confignode {
@@ -249,6 +450,8 @@ extern "C" {
 		inky_fb *fb;
 		inky_fb *active_fb;
 		inky_flags exclude_flags;
+		inky_pixel_format fb_format;
+		const inky_panel *panel;
 		inky_user_gpio_initialize gpio_init_cb;
 		inky_user_gpio_setup_pin gpio_setup_pin_cb; /**< GPIO pin config callback */
 		inky_user_gpio_output_state gpio_output_cb; /**< GPIO set output callback */
@@ -263,31 +466,303 @@ extern "C" {
 		void *usrptr2; /**< Optional usrptr. Pass NULL if not needed */
 	} inky_config;
 
+/**
+ * @defgroup inkyops Non-blocking operations
+ * @{
+ */
+
+/** @brief Operations that can be driven one step at a time */
+	typedef enum {
+		INKY_OP_RESET,
+		INKY_OP_UPDATE,
+		INKY_OP_CLEAR
+	} inky_op_type;
+
+/** @brief What an operation needs before its next step
+ * @var INKY_WAIT_NONE Operation is complete
+ * @var INKY_WAIT_DELAY Call inky_op_step() after delay_us has passed
+ * @var INKY_WAIT_BUSY Call inky_op_step() once the BUSY pin is
+ * released, or give up after delay_us
+ */
+	typedef enum {
+		INKY_WAIT_NONE,
+		INKY_WAIT_DELAY,
+		INKY_WAIT_BUSY
+	} inky_wait;
+
+/** @brief State of an operation in progress. Allocated by the user,
+ * but only modified by inky_op_begin() and inky_op_step()
+    @var type Operation being performed
+    @var stage Internal progress marker
+    @var wait What the operation is waiting on
+    @var delay_us Delay, or BUSY timeout, in us
+    @var area Framebuffer rectangle an update sends to the panel RAM
+**/
+	typedef struct inky_opnode {
+		inky_op_type type;
+		UINT8_t stage;
+		inky_wait wait;
+		UINT32_t delay_us;
+		inky_rect area;
+	} inky_op;
+
+/**
+ * @}
+ * Non-blocking operations
+ */
+
+/**
+ * @defgroup inkyband Band rendering
+ * @{
+ */
+
+/** @brief Draw the part of the picture inside band
+ *
+ * cfg->fb is the framebuffer of the band while it is called, band->w
+ * by band->h pixels, so everything must be drawn band->x, band->y up
+ * and to the left. The drawing functions clip what falls outside.
+ */
+	typedef inky_error_state (*inky_band_render)(inky_config *cfg,
+						     const inky_rect *band,
+						     void *usrptr);
+
+/** @brief Band rendering state, allocated by inky_band_setup()
+    @var fb Framebuffer of one band
+    @var area Rectangle of the picture fb holds, h 0 for none
+    @var rows Rows of fb
+    @var render, *usrptr Callback drawing each band, and its argument
+**/
+	typedef struct inky_bandnode {
+		inky_fb fb;
+		inky_rect area;
+		UINT16_t rows;
+		inky_band_render render;
+		void *usrptr;
+	} inky_band;
+
+/**
+ * @}
+ * Band rendering
+ */
+
 /** @brief Setup Function */
 	inky_error_state inky_setup(inky_config *cfg);
 
 /** @brief Free memory from setup */
 	inky_error_state inky_free(inky_config *cfg);
 
+/** @brief Built-in descriptor of a product, NULL for INKY_CUSTOM */
+	const inky_panel *inky_panel_get(inky_product pdt);
+
+/** @brief Check and attach a panel descriptor before inky_setup()
+ *
+ * The descriptor is not copied and must outlive the config.
+ */
+	inky_error_state inky_panel_register(inky_config *cfg,
+					     const inky_panel *panel);
+
+/** @brief True if color c can be shown on the configured panel */
+	UINT8_t inky_color_available(const inky_config *cfg, inky_color c);
+
 /** @brief Attach usrptr to framebuffer */
 	inky_error_state inky_fb_usrptr_attach(inky_config *cfg,
 					       UINT8_t pos, void *ptr);
 
+/** @brief Turn and mirror the framebuffer on the panel
+ *
+ * Turning a quarter swaps the width and height the panel shows. A
+ * framebuffer no longer covering that is resized to it and cleared to
+ * white, otherwise it keeps its pixels and the viewport moves back
+ * inside it if need be. Either way the viewport is marked dirty.
+ * Nothing is rotated in memory: the panel controller scans mirrored
+ * rows and columns, and quarter turns are transposed in blocks of 8 by
+ * 8 pixels as rows are sent.
+ *
+ * @return INKY_E_NOT_AVAILABLE for quarter turns when INKY_FIXED_PRODUCT
+ * fixes the framebuffer size, or when it is rendered in bands
+ */
+	inky_error_state inky_fb_set_orientation(inky_config *cfg,
+						 inky_orientation orientation);
+
+/** @brief Make the framebuffer a canvas of width by height pixels,
+ * at least the size the panel shows
+ *
+ * The canvas is cleared to white, the viewport goes back to its top
+ * left corner and is marked dirty. Updates only send the viewport.
+ *
+ * @return INKY_E_NOT_AVAILABLE for any other size than the panel's
+ * when INKY_FIXED_PRODUCT fixes the framebuffer size, and for any size
+ * when it is rendered in bands
+ */
+	inky_error_state inky_fb_set_canvas(inky_config *cfg, UINT16_t width,
+					    UINT16_t height);
+
+/** @brief Show the window of the canvas with its top left pixel at x, y
+ *
+ * The window must lie inside the canvas. It is only marked dirty:
+ * nothing is copied, the rows are packed from the canvas as they are
+ * sent, so panning is this and inky_update_dirty().
+ */
+	inky_error_state inky_fb_set_viewport(inky_config *cfg, UINT16_t x,
+					      UINT16_t y);
+
+/** @brief Draw at 1/scale of the panel resolution, scale being 1, 2 or
+ * 4
+ *
+ * The framebuffer is resized to the panel's size divided by scale,
+ * rounding up, and cleared to white. Updates widen every bit scale
+ * times through lookup tables while packing, so the framebuffer takes
+ * 1/4 or 1/16 of the memory and drawing 1/4 or 1/16 of the work.
+ *
+ * @return INKY_E_NOT_AVAILABLE for scales other than 1 when
+ * INKY_FIXED_PRODUCT fixes the framebuffer size
+ */
+	inky_error_state inky_fb_set_scale(inky_config *cfg, UINT8_t scale);
+
+/** @brief Render the picture one band of rows at a time, without a
+ * framebuffer holding all of it
+ *
+ * Call after inky_setup() with INKY_FLAG_ALLOCATE_FB excluded. The
+ * framebuffer then only keeps rows rows, a multiple of 8. Each update
+ * clears them to white and calls render for every band of rows it
+ * sends, packing and sending a band before drawing the next.
+ * Elsewhere there are no pixels to draw into or read: the functions
+ * doing so return INKY_E_NOT_AVAILABLE, and only orientation, scale
+ * and updates apply to cfg->fb. Use inky_update()
+ * or inky_update_region(): drawing in render marks nothing dirty.
+ *
+ * @return INKY_E_NOT_AVAILABLE when a framebuffer is already allocated
+ * or INKY_FIXED_PRODUCT fixes its size
+ */
+	inky_error_state inky_band_setup(inky_config *cfg, UINT16_t rows,
+					 inky_band_render render,
+					 void *usrptr);
+
 /** @brief Set pixel color in fb */
 	inky_error_state inky_fb_set_pixel(inky_config *cfg, UINT16_t x,
 					   UINT16_t y, inky_color c);
 
+/** @brief Get pixel color from fb */
+	inky_error_state inky_fb_get_pixel(inky_config *cfg, UINT16_t x,
+					   UINT16_t y, inky_color *out);
+
+/** @brief Set every pixel in fb to one color */
+	inky_error_state inky_fb_fill(inky_config *cfg, inky_color c);
+
+/** @brief Set len pixels of row y, starting at x, to one color
+ *
+ * The whole span must fit in the row. Whole bytes are written at once.
+ */
+	inky_error_state inky_fb_hline(inky_config *cfg, UINT16_t x,
+				       UINT16_t y, UINT16_t len, inky_color c);
+
+/** @brief Write the first n pixels of row y from an array of colors
+ *
+ * Every color is checked before anything is written, so a rejected
+ * row leaves the framebuffer unchanged.
+ */
+	inky_error_state inky_fb_write_row(inky_config *cfg, UINT16_t y,
+					   const inky_color *src, UINT16_t n);
+
+/** @brief Set n scattered pixels to one color
+ *
+ * Every point is range checked before anything is written.
+ */
+	inky_error_state inky_fb_set_pixels(inky_config *cfg,
+					    const inky_point *pts, UINT32_t n,
+					    inky_color c);
+
+/** @brief Framebuffer code of a color for a pixel format of bpp bits */
+	static inline UINT8_t inky_pixfmt_encode(UINT8_t bpp, inky_color c)
+	{
+		if (bpp == 4) {
+			return (UINT8_t) c;
+		}
+
+		/* White: 0, Black: 1, Color: 2 */
+		return c == INKY_COLOR_BLACK ? 0x01 :
+			c == INKY_COLOR_WHITE ? 0x00 : 0x02;
+	}
+
+/** @brief Set pixel color in fb without range or color checks
+ *
+ * For tight drawing loops. The caller guarantees x and y are inside
+ * the framebuffer and the color is available on the panel.
+ */
+	static inline void inky_fb_set_pixel_unchecked(inky_fb *fb,
+						       UINT16_t x,
+						       UINT16_t y,
+						       inky_color c)
+	{
+		UINT8_t bpp = INKY_FB_BPP(fb);
+		UINT8_t mask = (UINT8_t) ((1 << bpp) - 1);
+		UINT32_t bit_addr;
+		UINT8_t *byte_rst;
+		UINT8_t px;
+
+		bit_addr = (UINT32_t) x * bpp;
+		byte_rst = &fb->buffer[INKY_FB_STRIDE(fb) * y + bit_addr / 8];
+		bit_addr = bit_addr % 8;
+
+		px = inky_pixfmt_encode(bpp, c) & mask;
+
+		*byte_rst = (UINT8_t) ((*byte_rst & ~(mask << bit_addr)) |
+				       (px << bit_addr));
+	}
+
 /** @brief Update Inky screen to current fb state using config update
  * mode */
 	inky_error_state inky_update(inky_config *cfg);
 
+/** @brief Grow the dirty rectangle of the framebuffer to cover area,
+ * clipped to the framebuffer */
+	inky_error_state inky_fb_mark_dirty(inky_config *cfg,
+					    const inky_rect *area);
+
+/** @brief Send the dirty rectangle with inky_update_region() and mark
+ * the framebuffer clean. Does nothing when it is already clean, or
+ * when nothing in the viewport is dirty */
+	inky_error_state inky_update_dirty(inky_config *cfg);
+
+/** @brief Send only a rectangle of the framebuffer, then refresh
+ *
+ * The rest of the panel RAM keeps what the last update sent, so this
+ * is only correct when nothing outside area changed since then. area
+ * is in framebuffer coordinates, and only its part in the viewport is
+ * sent. Panel rows are sent from the byte holding its first pixel to
+ * the byte holding its last.
+ */
+	inky_error_state inky_update_region(inky_config *cfg,
+					    const inky_rect *area);
+
 /** @brief Update Inky screen to current fb by given mode */
 	inky_error_state inky_update_by_mode(inky_config *cfg,
 					     inky_fb_type update_type);
 
-/** @brief Clear Inky screen */
+/** @brief Clear Inky screen
+ *
+ * The framebuffer is filled with white and sent without its layers,
+ * which keep their pixels. Nothing is left dirty afterwards.
+ */
 	inky_error_state inky_clear(inky_config *cfg);
 
+/** @brief Start an operation without blocking
+ *
+ * Runs the operation until it first has to wait. The caller must
+ * then honour op->wait and call inky_op_step() until op->wait is
+ * INKY_WAIT_NONE. The delay and poll callbacks are not used.
+ */
+	inky_error_state inky_op_begin(inky_config *cfg, inky_op *op,
+				       inky_op_type type);
+
+/** @brief Start an update of a rectangle without blocking, see
+ * inky_update_region() */
+	inky_error_state inky_op_begin_region(inky_config *cfg, inky_op *op,
+					      const inky_rect *area);
+
+/** @brief Continue an operation after the wait in op->wait */
+	inky_error_state inky_op_step(inky_config *cfg, inky_op *op);
+
 #ifdef __cplusplus
 }
 #endif /* #ifdef __cplusplus */
@@ -0,0 +1,112 @@
+/* Adaptive threshold binarization for the Pimoroni Inky driver */
+#ifndef INKY_BINARIZE_H
+#define INKY_BINARIZE_H
+
+#include <inky-api.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif /* #ifdef __cplusplus */
+
+/**
+ * @defgroup inkybinarize Adaptive threshold binarization
+ * @{
+ */
+
+/** @brief Largest window radius */
+#define INKY_BINARIZE_MAX_RADIUS	127
+
+/** @brief How the threshold of a pixel follows its neighbourhood
+ *
+ * @var INKY_BINARIZE_BRADLEY Black below level percent under the mean
+ * of the window. 15 suits most pictures
+ * @var INKY_BINARIZE_SAUVOLA Black below mean * (1 + k * (deviation /
+ * 128 - 1)) of the window, with level the k in hundredths. Flat areas
+ * turn white more readily than with Bradley; 20 to 50 suits most
+ * pictures
+ */
+	typedef enum {
+		INKY_BINARIZE_BRADLEY,
+		INKY_BINARIZE_SAUVOLA
+	} inky_binarize_mode;
+
+/** @brief Binarizer fed a row of gray at a time
+    @var mode, radius, level Threshold, over a window of 2 * radius + 1
+    pixels square, clipped to the picture
+    @var width Pixels per row
+    @var x, y Framebuffer position of the top left pixel
+    @var rows Rows fed so far
+    @var lo First row counted in sum and sq
+    @var out Rows written to the framebuffer so far
+    @var black, white Framebuffer codes
+    @var *ring The last 2 * radius + 1 rows fed
+    @var *sum, *sq Sums of each column, and of its squares, over rows
+    lo to rows - 1. sq is NULL for Bradley
+**/
+	typedef struct inky_binarizenode {
+		inky_binarize_mode mode;
+		UINT16_t width;
+		UINT8_t radius;
+		UINT8_t level;
+		INT16_t x;
+		INT16_t y;
+		UINT16_t rows;
+		UINT16_t lo;
+		UINT16_t out;
+		UINT8_t black;
+		UINT8_t white;
+		UINT8_t *ring;
+		UINT32_t *sum;
+		UINT32_t *sq;
+	} inky_binarize;
+
+/** @brief Start binarizing a picture width pixels wide into the
+ * framebuffer at x, y
+ *
+ * Allocates 2 * radius + 1 rows of gray and one or two sums a column,
+ * whatever the height of the picture.
+ */
+	inky_error_state inky_binarize_begin(inky_config *cfg,
+					     inky_binarize *b,
+					     inky_binarize_mode mode,
+					     UINT16_t width, UINT8_t radius,
+					     UINT8_t level, INT16_t x,
+					     INT16_t y);
+
+/** @brief Feed the next row of width bytes of gray
+ *
+ * A row is written out once the radius rows below it have been fed,
+ * as soon as its window is complete. Output is packed straight into
+ * the framebuffer, clipped to it, and the pixels changed are marked
+ * dirty.
+ */
+	inky_error_state inky_binarize_row(inky_config *cfg, inky_binarize *b,
+					   const UINT8_t *gray);
+
+/** @brief Write the rows still waiting for rows below them, which the
+ * picture does not have, and free the binarizer */
+	inky_error_state inky_binarize_end(inky_config *cfg, inky_binarize *b);
+
+/** @brief Free a binarizer without writing its last rows */
+	void inky_binarize_free(inky_binarize *b);
+
+/** @brief Binarize a w by h gray buffer, rows stride bytes apart, into
+ * the framebuffer at x, y */
+	inky_error_state inky_binarize_rect(inky_config *cfg,
+					    inky_binarize_mode mode,
+					    const UINT8_t *gray,
+					    UINT32_t stride, UINT16_t w,
+					    UINT16_t h, UINT8_t radius,
+					    UINT8_t level, INT16_t x,
+					    INT16_t y);
+
+/**
+ * @}
+ * Adaptive threshold binarization
+ */
+
+#ifdef __cplusplus
+}
+#endif /* #ifdef __cplusplus */
+
+#endif /* #ifndef INKY_BINARIZE_H */
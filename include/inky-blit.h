@@ -0,0 +1,198 @@
+/* Raster-op blitter for the Pimoroni Inky driver */
+#ifndef INKY_BLIT_H
+#define INKY_BLIT_H
+
+#include <inky-api.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif /* #ifdef __cplusplus */
+
+/**
+ * @defgroup inkyblit Bitmaps and raster operations
+ * @{
+ */
+
+/** @brief Layouts of a source bitmap
+ *
+ * @var INKY_BITMAP_MASK One bit per pixel, pixel 0 in the lowest bit.
+ * Set bits are drawn in the foreground color, clear bits in white
+ * @var INKY_BITMAP_PACKED Pixels in one of the framebuffer pixel
+ * formats, laid out like an inky_fb
+ * @var INKY_BITMAP_PLANAR The panel RAM layout, MSB first: a black
+ * plane where 0 is black and an optional color plane where 1 is color
+ */
+	typedef enum {
+		INKY_BITMAP_MASK,
+		INKY_BITMAP_PACKED,
+		INKY_BITMAP_PLANAR
+	} inky_bitmap_type;
+
+/** @brief Read-only source image for inky_fb_blit()
+    @var type Layout of data
+    @var format Pixel format for INKY_BITMAP_PACKED
+    @var width Pixels per row
+    @var height Rows
+    @var stride Bytes from the start of one row to the next, in each
+    plane
+    @var *data Pixels, mask bits or the black plane
+    @var *color Color plane for INKY_BITMAP_PLANAR, may be NULL
+**/
+	typedef struct inky_bitmapnode {
+		inky_bitmap_type type;
+		inky_pixel_format format;
+		UINT16_t width;
+		UINT16_t height;
+		UINT32_t stride;
+		const UINT8_t *data;
+		const UINT8_t *color;
+	} inky_bitmap;
+
+/** @brief How source pixels combine with the framebuffer
+ *
+ * OR, AND and XOR work on the framebuffer codes of the pixels. With
+ * 2bpp formats an OR of black and color gives code 3, which reads and
+ * displays as the panel color.
+ *
+ * @var INKY_ROP_COPY Replace the destination
+ * @var INKY_ROP_OR Destination OR source
+ * @var INKY_ROP_AND Destination AND source
+ * @var INKY_ROP_XOR Destination XOR source
+ * @var INKY_ROP_TRANSPARENT Copy source pixels that are not the key
+ * color
+ */
+	typedef enum {
+		INKY_ROP_COPY,
+		INKY_ROP_OR,
+		INKY_ROP_AND,
+		INKY_ROP_XOR,
+		INKY_ROP_TRANSPARENT
+	} inky_rop;
+
+/** @brief Bitmap encoded once in a framebuffer format at every sub-byte
+ * pixel phase, so drawing it needs no shifting
+    @var width Pixels per row
+    @var height Rows
+    @var format Framebuffer format the sprite was encoded for
+    @var phases Pixels per byte, one encoded copy each
+    @var stride Bytes per row of one copy
+    @var *pixels phases copies of height rows of framebuffer codes
+    @var *mask Same layout, bits set where the sprite is opaque
+**/
+	typedef struct inky_spritenode {
+		UINT16_t width;
+		UINT16_t height;
+		inky_pixel_format format;
+		UINT8_t phases;
+		UINT32_t stride;
+		UINT8_t *pixels;
+		UINT8_t *mask;
+	} inky_sprite;
+
+/** @brief Describe a framebuffer as a packed bitmap, for blits between
+ * framebuffers */
+	inky_error_state inky_bitmap_from_fb(const inky_fb *fb,
+					     inky_bitmap *out);
+
+/** @brief Copy a rectangle of src into the framebuffer
+ *
+ * @param area Rectangle of src to copy, NULL for all of it. It must lie
+ * inside src
+ * @param dx, dy Destination of the top left pixel of area. The copy is
+ * clipped to the framebuffer
+ * @param fg Color of set bits in INKY_BITMAP_MASK sources
+ * @param key Color skipped by INKY_ROP_TRANSPARENT
+ *
+ * Rows are combined a 32 bit word at a time. Sources in the
+ * framebuffer's own format are shifted into place, others are
+ * converted one pixel at a time first. The destination rectangle is
+ * marked dirty.
+ */
+	inky_error_state inky_fb_blit(inky_config *cfg,
+				      const inky_bitmap *src,
+				      const inky_rect *area,
+				      INT16_t dx, INT16_t dy, inky_rop rop,
+				      inky_color fg, inky_color key);
+
+/** @brief Encode a rectangle of src as a sprite for cfg's framebuffer
+ *
+ * @param area Rectangle of src, NULL for all of it
+ * @param fg Color of set bits in INKY_BITMAP_MASK sources
+ * @param key Color left transparent, NULL for an opaque sprite
+ *
+ * Allocates phases * 2 * height * stride bytes. Release them with
+ * inky_sprite_free().
+ */
+	inky_error_state inky_sprite_create(inky_config *cfg,
+					    inky_sprite *spr,
+					    const inky_bitmap *src,
+					    const inky_rect *area,
+					    inky_color fg,
+					    const inky_color *key);
+
+/** @brief Encode a rectangle of a mask bitmap as a sprite shaped by
+ * its bits
+ *
+ * Set bits are drawn in fg. Clear bits are drawn in bg, or left
+ * transparent when bg is NULL, whatever color fg is.
+ */
+	inky_error_state inky_sprite_create_mask(inky_config *cfg,
+						 inky_sprite *spr,
+						 const inky_bitmap *src,
+						 const inky_rect *area,
+						 inky_color fg,
+						 const inky_color *bg);
+
+/** @brief Free the memory of a sprite */
+	inky_error_state inky_sprite_free(inky_sprite *spr);
+
+/** @brief Draw a sprite with its top left pixel at x, y
+ *
+ * Picks the copy matching the phase of x and merges it into each row
+ * a byte at a time. Clipped to the framebuffer, and the part of the
+ * sprite drawn is marked dirty.
+ */
+	inky_error_state inky_fb_draw_sprite(inky_config *cfg,
+					     const inky_sprite *spr,
+					     INT16_t x, INT16_t y);
+
+/** @brief Draw a sprite clipped to a rectangle of the framebuffer
+ *
+ * Only the two edge bytes of each row are masked down to the clip.
+ */
+	inky_error_state inky_fb_draw_sprite_clip(inky_config *cfg,
+						  const inky_sprite *spr,
+						  INT16_t x, INT16_t y,
+						  const inky_rect *clip);
+
+/** @brief Copy a rectangle of the framebuffer so its top left pixel
+ * lands on dx, dy
+ *
+ * src must lie inside the framebuffer, the destination is clipped to
+ * it, and the two may overlap. Rows are moved with memmove, merging
+ * only the edge bytes when src and the destination share a pixel
+ * phase. Marks the destination dirty.
+ */
+	inky_error_state inky_fb_copy_rect(inky_config *cfg,
+					   const inky_rect *src,
+					   INT16_t dx, INT16_t dy);
+
+/** @brief Scroll the contents of a rectangle by dx, dy pixels
+ *
+ * Pixels moved outside area are lost and the strips left uncovered are
+ * set to fill. A vertical scroll of full framebuffer rows is a single
+ * memmove. Marks area dirty.
+ */
+	inky_error_state inky_fb_scroll(inky_config *cfg, const inky_rect *area,
+					INT16_t dx, INT16_t dy, inky_color fill);
+
+/**
+ * @}
+ * Bitmaps and raster operations
+ */
+
+#ifdef __cplusplus
+}
+#endif /* #ifdef __cplusplus */
+
+#endif /* #ifndef INKY_BLIT_H */
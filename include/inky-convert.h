@@ -0,0 +1,88 @@
+/* Bulk pixel format conversion for the Pimoroni Inky driver */
+#ifndef INKY_CONVERT_H
+#define INKY_CONVERT_H
+
+#include <inky-api.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif /* #ifdef __cplusplus */
+
+/**
+ * @defgroup inkyconvert Pixel format conversion
+ * @{
+ */
+
+/** @brief Bytes of the RGB565 lookup table, 2 bits for each value */
+#define INKY_CONVERT_LUT_SIZE	(65536 / 4)
+
+/** @brief Layouts of the pixels of a source buffer
+ *
+ * @var INKY_CONVERT_RGB888 Three bytes: red, green, blue
+ * @var INKY_CONVERT_RGB565 A UINT16_t with red in the top 5 bits and
+ * blue in the bottom 5
+ * @var INKY_CONVERT_ARGB8888 A UINT32_t of 0xAARRGGBB, not
+ * premultiplied. Transparent pixels are blended over white
+ * @var INKY_CONVERT_GRAY8 One byte of gray
+ */
+	typedef enum {
+		INKY_CONVERT_RGB888,
+		INKY_CONVERT_RGB565,
+		INKY_CONVERT_ARGB8888,
+		INKY_CONVERT_GRAY8
+	} inky_convert_format;
+
+/** @brief Nearest panel color of every source value, worked out once
+    @var n_colors, colors Panel colors converted to
+    @var codes Framebuffer code of each of colors
+    @var gray Framebuffer code of each gray level
+    @var *lut Index into colors of each RGB565 value, four to a byte
+    with the lowest value in the lowest bits
+**/
+	typedef struct inky_convertnode {
+		UINT8_t n_colors;
+		inky_color colors[4];
+		UINT8_t codes[4];
+		UINT8_t gray[256];
+		UINT8_t *lut;
+	} inky_convert;
+
+/** @brief Build the lookup tables for the colors of the panel
+ *
+ * Allocates INKY_CONVERT_LUT_SIZE bytes. Build it again if the
+ * available colors or the framebuffer format change.
+ */
+	inky_error_state inky_convert_init(inky_config *cfg,
+					   inky_convert *cv);
+
+/** @brief Release the lookup table */
+	void inky_convert_free(inky_convert *cv);
+
+/** @brief Convert a w by h buffer into the framebuffer with its top
+ * left pixel at x, y
+ *
+ * @param src First row, aligned for the pixel type of format
+ * @param stride Bytes from the start of one row to the next
+ *
+ * Every pixel is classified with a table lookup, gray exactly and the
+ * RGB formats at RGB565 precision, and packed straight into the
+ * framebuffer a byte at a time. Clipped to the framebuffer, and marks
+ * the pixels it changed dirty.
+ */
+	inky_error_state inky_convert_rect(inky_config *cfg,
+					   const inky_convert *cv,
+					   inky_convert_format format,
+					   const void *src, UINT32_t stride,
+					   UINT16_t w, UINT16_t h,
+					   INT16_t x, INT16_t y);
+
+/**
+ * @}
+ * Pixel format conversion
+ */
+
+#ifdef __cplusplus
+}
+#endif /* #ifdef __cplusplus */
+
+#endif /* #ifndef INKY_CONVERT_H */
@@ -0,0 +1,241 @@
+/**
+ * @file inky-coro.hpp
+ *
+ * Optional C++20 coroutine interface for the Pimoroni Inky driver
+ *
+ * Wraps the non-blocking inky_op_* functions so reset, update and
+ * clear can be awaited. Instead of sleeping in the delay callback or
+ * blocking in the BUSY poll callback, the coroutine suspends and is
+ * resumed by a user supplied executor, so one thread can drive many
+ * displays.
+ */
+#ifndef INKY_CORO_HPP
+#define INKY_CORO_HPP
+
+#include <inky-api.h>
+
+#include <coroutine>
+#include <cstdint>
+#include <exception>
+#include <utility>
+
+namespace inky {
+
+/**
+ * @brief Requirements for the executor resuming suspended operations
+ *
+ * schedule_after(us, h) must resume h once us microseconds have
+ * passed.
+ *
+ * schedule_on_busy(cfg, timeout_us, h, result) must resume h once the
+ * BUSY pin of the display in cfg is released. If timeout_us passes
+ * first, set *result to INKY_E_TIMEOUT (or another error) before
+ * resuming.
+ *
+ * Handles must be resumed from the executor's own loop, never from
+ * inside the schedule call.
+ */
+template <class E>
+concept executor = requires(E &ex, std::coroutine_handle<> h,
+			    inky_config *cfg, std::uint32_t us,
+			    inky_error_state *result) {
+	ex.schedule_after(us, h);
+	ex.schedule_on_busy(cfg, us, h, result);
+};
+
+/**
+ * @brief Lazily started coroutine producing an inky_error_state
+ *
+ * Either co_await it from another coroutine, or call start() and
+ * check done() and result() from the executor loop.
+ */
+class task {
+public:
+	struct promise_type {
+		inky_error_state value = INKY_OK;
+		std::coroutine_handle<> continuation;
+
+		struct final_awaiter {
+			bool await_ready() const noexcept { return false; }
+
+			std::coroutine_handle<>
+			await_suspend(std::coroutine_handle<promise_type> h)
+				noexcept
+			{
+				if (h.promise().continuation) {
+					return h.promise().continuation;
+				}
+
+				return std::noop_coroutine();
+			}
+
+			void await_resume() const noexcept {}
+		};
+
+		task get_return_object() noexcept
+		{
+			return task(std::coroutine_handle<promise_type>::
+				    from_promise(*this));
+		}
+
+		std::suspend_always initial_suspend() const noexcept
+		{
+			return {};
+		}
+
+		final_awaiter final_suspend() const noexcept { return {}; }
+
+		void return_value(inky_error_state v) noexcept { value = v; }
+
+		void unhandled_exception() const noexcept { std::terminate(); }
+	};
+
+	task(task &&other) noexcept : h_(std::exchange(other.h_, {})) {}
+
+	task &operator=(task &&other) noexcept
+	{
+		if (this != &other) {
+			destroy();
+			h_ = std::exchange(other.h_, {});
+		}
+
+		return *this;
+	}
+
+	task(const task &) = delete;
+	task &operator=(const task &) = delete;
+
+	~task() { destroy(); }
+
+	/** @brief Run until the first suspension, without a continuation */
+	void start()
+	{
+		if (h_ && !h_.done()) {
+			h_.resume();
+		}
+	}
+
+	bool done() const noexcept { return !h_ || h_.done(); }
+
+	/** @brief Result of a finished task */
+	inky_error_state result() const noexcept
+	{
+		return h_ ? h_.promise().value : INKY_E_NOT_CONFIGURED;
+	}
+
+	bool await_ready() const noexcept { return done(); }
+
+	std::coroutine_handle<>
+	await_suspend(std::coroutine_handle<> continuation) noexcept
+	{
+		h_.promise().continuation = continuation;
+
+		return h_;
+	}
+
+	inky_error_state await_resume() const noexcept { return result(); }
+
+private:
+	explicit task(std::coroutine_handle<promise_type> h) noexcept
+		: h_(h) {}
+
+	void destroy() noexcept
+	{
+		if (h_) {
+			h_.destroy();
+			h_ = {};
+		}
+	}
+
+	std::coroutine_handle<promise_type> h_;
+};
+
+/**
+ * @brief Awaitable view of a configured inky_config
+ *
+ * inky_setup() must have been called on the config. The config and
+ * executor must outlive every task returned by the display.
+ */
+template <executor Executor>
+class display {
+public:
+	display(inky_config &cfg, Executor &ex) noexcept
+		: cfg_(&cfg), ex_(&ex) {}
+
+	/** @brief Hardware reset, resumes once BUSY is released */
+	task reset() { return run(cfg_, ex_, INKY_OP_RESET); }
+
+	/** @brief Send the framebuffer and wait for the refresh */
+	task update() { return run(cfg_, ex_, INKY_OP_UPDATE); }
+
+	/** @brief Blank the framebuffer and display */
+	task clear() { return run(cfg_, ex_, INKY_OP_CLEAR); }
+
+	inky_config &config() const noexcept { return *cfg_; }
+
+private:
+	struct delay_awaiter {
+		Executor *ex;
+		std::uint32_t us;
+
+		bool await_ready() const noexcept { return false; }
+
+		void await_suspend(std::coroutine_handle<> h)
+		{
+			ex->schedule_after(us, h);
+		}
+
+		void await_resume() const noexcept {}
+	};
+
+	struct busy_awaiter {
+		Executor *ex;
+		inky_config *cfg;
+		std::uint32_t timeout_us;
+		inky_error_state result = INKY_OK;
+
+		bool await_ready() const noexcept { return false; }
+
+		void await_suspend(std::coroutine_handle<> h)
+		{
+			ex->schedule_on_busy(cfg, timeout_us, h, &result);
+		}
+
+		inky_error_state await_resume() const noexcept
+		{
+			return result;
+		}
+	};
+
+	static task run(inky_config *cfg, Executor *ex, inky_op_type type)
+	{
+		inky_op op;
+		inky_error_state ret;
+
+		ret = inky_op_begin(cfg, &op, type);
+
+		while (ret == INKY_OK && op.wait != INKY_WAIT_NONE) {
+			if (op.wait == INKY_WAIT_DELAY) {
+				co_await delay_awaiter{ex, op.delay_us};
+			} else {
+				ret = co_await busy_awaiter{ex, cfg,
+							    op.delay_us};
+
+				if (ret != INKY_OK) {
+					break;
+				}
+			}
+
+			ret = inky_op_step(cfg, &op);
+		}
+
+		co_return ret;
+	}
+
+	inky_config *cfg_;
+	Executor *ex_;
+};
+
+} /* namespace inky */
+
+#endif /* #ifndef INKY_CORO_HPP */
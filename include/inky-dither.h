@@ -0,0 +1,121 @@
+/* Dithering to the panel palettes for the Pimoroni Inky driver */
+#ifndef INKY_DITHER_H
+#define INKY_DITHER_H
+
+#include <inky-api.h>
+#include <inky-image.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif /* #ifdef __cplusplus */
+
+/**
+ * @defgroup inkydither Dithering
+ * @{
+ */
+
+/** @brief How shades between the panel colors are rendered
+ *
+ * @var INKY_DITHER_THRESHOLD Nearest panel color, no dithering
+ * @var INKY_DITHER_BAYER 8x8 ordered Bayer matrix
+ * @var INKY_DITHER_BLUE_NOISE 16x16 ordered blue noise mask, without
+ * the cross hatching of the Bayer matrix
+ * @var INKY_DITHER_FLOYD_STEINBERG Error diffusion to four neighbours
+ * @var INKY_DITHER_ATKINSON Error diffusion of three quarters of the
+ * error to six neighbours, with more contrast than Floyd-Steinberg
+ */
+	typedef enum {
+		INKY_DITHER_THRESHOLD,
+		INKY_DITHER_BAYER,
+		INKY_DITHER_BLUE_NOISE,
+		INKY_DITHER_FLOYD_STEINBERG,
+		INKY_DITHER_ATKINSON
+	} inky_dither_mode;
+
+/** @brief Ditherer for rows of one width
+    @var mode How to dither
+    @var width Pixels per row
+    @var n_colors, colors Panel colors to dither to
+    @var codes Framebuffer code of each of colors
+    @var hysteresis 0 to always take the nearest color. Otherwise a
+    pixel keeps the color already in the framebuffer unless another is
+    closer by more than moving a gray hysteresis levels past the middle
+    of black and white would make it. Set after inky_dither_init()
+    @var *err Error diffusion state: two rows of width + 2 entries of
+    three channels, in 1/16 of a level. NULL for the ordered modes
+    @var cur Which of the two rows of err is the row to dither next
+**/
+	typedef struct inky_dithernode {
+		inky_dither_mode mode;
+		UINT16_t width;
+		UINT8_t n_colors;
+		inky_color colors[4];
+		UINT8_t codes[4];
+		UINT8_t hysteresis;
+		INT16_t *err;
+		UINT8_t cur;
+	} inky_dither;
+
+/** @brief Hysteresis that keeps a small change to the picture from
+ * reshuffling the dither pattern of the rest of it */
+#define INKY_DITHER_STABLE	24
+
+/** @brief Set up a ditherer for rows of width pixels to the colors of
+ * the panel
+ *
+ * Only the error diffusion modes allocate memory: two rows of error,
+ * 12 bytes a pixel, whatever the height of the picture.
+ */
+	inky_error_state inky_dither_init(inky_config *cfg, inky_dither *d,
+					  inky_dither_mode mode,
+					  UINT16_t width);
+
+/** @brief Release the memory of a ditherer */
+	void inky_dither_free(inky_dither *d);
+
+/** @brief Dither a row of RGB888 into the framebuffer at x, y
+ *
+ * @param rgb d->width * 3 bytes of red, green and blue
+ *
+ * Rows are expected top to bottom, one after the other: error
+ * diffusion carries the error of each row into the next. Ordered modes
+ * index their mask by framebuffer position, so rows of separate calls
+ * line up. Pixels are packed straight into the framebuffer row, a byte
+ * at a time. Clipped to the framebuffer without changing the pixels
+ * that are visible, and marks the pixels it changed dirty.
+ *
+ * With hysteresis, dither each frame over the last one rather than a
+ * cleared framebuffer. Error diffusion then counts the error of the
+ * colors kept, so shades stay right, while the same picture dithers
+ * to exactly the pixels already there and a small change flips few
+ * pixels outside itself, keeping the dirty area and the partial
+ * update small.
+ */
+	inky_error_state inky_dither_row(inky_config *cfg, inky_dither *d,
+					 const UINT8_t *rgb, INT16_t x,
+					 INT16_t y);
+
+/** @brief Decode the remaining rows of an image and dither them into
+ * the framebuffer with the top left pixel at x, y
+ *
+ * Holds one row of RGB and, for error diffusion, two rows of error.
+ * Rows are dithered in the order they are decoded.
+ *
+ * @param hysteresis As inky_dither::hysteresis, INKY_DITHER_STABLE
+ * to redraw a changing picture in place
+ */
+	inky_error_state inky_dither_image(inky_config *cfg, inky_image *img,
+					   INT16_t x, INT16_t y,
+					   inky_dither_mode mode,
+					   UINT8_t hysteresis);
+
+/**
+ * @}
+ * Dithering
+ */
+
+#ifdef __cplusplus
+}
+#endif /* #ifdef __cplusplus */
+
+#endif /* #ifndef INKY_DITHER_H */
@@ -0,0 +1,152 @@
+/* 2D drawing primitives for the Pimoroni Inky driver */
+#ifndef INKY_DRAW_H
+#define INKY_DRAW_H
+
+#include <inky-api.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif /* #ifdef __cplusplus */
+
+/**
+ * @defgroup inkydraw Drawing primitives
+ * @{
+ */
+
+/** @brief Most clip rectangles on the stack, including the whole
+ * framebuffer at the bottom */
+#define INKY_DRAW_MAX_CLIP	8
+
+/** @brief Most vertices of a filled polygon */
+#define INKY_DRAW_MAX_POINTS	64
+
+/** @brief Clip state for the drawing primitives
+    @var clip Stack of clip rectangles, each inside the one below it.
+    The top one, clip[depth - 1], bounds every pixel drawn
+    @var depth Rectangles on the stack, at least 1
+**/
+	typedef struct inky_drawnode {
+		inky_rect clip[INKY_DRAW_MAX_CLIP];
+		UINT8_t depth;
+	} inky_draw;
+
+/** @brief Start drawing with the whole framebuffer as the clip */
+	inky_error_state inky_draw_init(inky_config *cfg, inky_draw *draw);
+
+/** @brief Push the intersection of area and the current clip
+ *
+ * The intersection may be empty, then nothing draws until it is
+ * popped. Returns INKY_E_OUT_OF_RANGE when the stack is full.
+ */
+	inky_error_state inky_draw_push_clip(inky_draw *draw,
+					     const inky_rect *area);
+
+/** @brief Return to the clip before the last push
+ *
+ * Returns INKY_E_OUT_OF_RANGE when only the framebuffer is left.
+ */
+	inky_error_state inky_draw_pop_clip(inky_draw *draw);
+
+/*
+ * Every primitive below is clipped to the top of the stack, writes
+ * whole spans of a row at once and marks what it drew dirty.
+ * Coordinates may lie outside the framebuffer. Colors the panel lacks
+ * return INKY_E_NOT_AVAILABLE before anything is drawn.
+ */
+
+/** @brief Line from x0, y0 to x1, y1, both ends included
+ *
+ * Bresenham's algorithm, with the pixels of each row written as one
+ * span.
+ */
+	inky_error_state inky_draw_line(inky_config *cfg,
+					const inky_draw *draw, INT16_t x0,
+					INT16_t y0, INT16_t x1, INT16_t y1,
+					inky_color c);
+
+/** @brief One pixel wide outline of a w by h rectangle */
+	inky_error_state inky_draw_rect(inky_config *cfg,
+					const inky_draw *draw, INT16_t x,
+					INT16_t y, UINT16_t w, UINT16_t h,
+					inky_color c);
+
+/** @brief Filled w by h rectangle */
+	inky_error_state inky_draw_fill_rect(inky_config *cfg,
+					     const inky_draw *draw, INT16_t x,
+					     INT16_t y, UINT16_t w,
+					     UINT16_t h, inky_color c);
+
+/** @brief Outline of a rectangle with corners of radius r
+ *
+ * r is limited to half the shorter side, less a pixel.
+ */
+	inky_error_state inky_draw_round_rect(inky_config *cfg,
+					      const inky_draw *draw,
+					      INT16_t x, INT16_t y,
+					      UINT16_t w, UINT16_t h,
+					      UINT16_t r, inky_color c);
+
+/** @brief Filled rectangle with corners of radius r */
+	inky_error_state inky_draw_fill_round_rect(inky_config *cfg,
+						   const inky_draw *draw,
+						   INT16_t x, INT16_t y,
+						   UINT16_t w, UINT16_t h,
+						   UINT16_t r, inky_color c);
+
+/** @brief Outline of an ellipse centered on pixel cx, cy
+ *
+ * A pixel is inside when its distance from the center, scaled by
+ * rx + 1/2 across and ry + 1/2 down, is at most 1. The outline is the
+ * inside pixels next to an outside one across or down.
+ */
+	inky_error_state inky_draw_ellipse(inky_config *cfg,
+					   const inky_draw *draw, INT16_t cx,
+					   INT16_t cy, UINT16_t rx,
+					   UINT16_t ry, inky_color c);
+
+/** @brief Filled ellipse, see inky_draw_ellipse() */
+	inky_error_state inky_draw_fill_ellipse(inky_config *cfg,
+						const inky_draw *draw,
+						INT16_t cx, INT16_t cy,
+						UINT16_t rx, UINT16_t ry,
+						inky_color c);
+
+/** @brief Outline of a circle of radius r, see inky_draw_ellipse() */
+	inky_error_state inky_draw_circle(inky_config *cfg,
+					  const inky_draw *draw, INT16_t cx,
+					  INT16_t cy, UINT16_t r,
+					  inky_color c);
+
+/** @brief Filled circle of radius r */
+	inky_error_state inky_draw_fill_circle(inky_config *cfg,
+					       const inky_draw *draw,
+					       INT16_t cx, INT16_t cy,
+					       UINT16_t r, inky_color c);
+
+/** @brief Lines joining n points, and the last point to the first */
+	inky_error_state inky_draw_polygon(inky_config *cfg,
+					   const inky_draw *draw,
+					   const inky_point *pts, UINT16_t n,
+					   inky_color c);
+
+/** @brief Fill a polygon of n points with the even-odd rule
+ *
+ * Points are pixel corners, so a pixel is filled when its center is
+ * inside: the square 0,0 10,0 10,10 0,10 fills pixels 0 to 9 of rows
+ * 0 to 9. Returns INKY_E_OUT_OF_RANGE past INKY_DRAW_MAX_POINTS.
+ */
+	inky_error_state inky_draw_fill_polygon(inky_config *cfg,
+						const inky_draw *draw,
+						const inky_point *pts,
+						UINT16_t n, inky_color c);
+
+/**
+ * @}
+ * Drawing primitives
+ */
+
+#ifdef __cplusplus
+}
+#endif /* #ifdef __cplusplus */
+
+#endif /* #ifndef INKY_DRAW_H */
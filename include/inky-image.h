@@ -0,0 +1,129 @@
+/* Streaming image decoders for the Pimoroni Inky driver */
+#ifndef INKY_IMAGE_H
+#define INKY_IMAGE_H
+
+#include <inky-api.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif /* #ifdef __cplusplus */
+
+/**
+ * @defgroup inkyimage Streaming image decoders
+ * @{
+ */
+
+/** @brief Bytes read from the source at a time */
+#define INKY_IMAGE_READ_AHEAD	64
+
+/** @brief File formats understood by the decoders
+ *
+ * @var INKY_IMAGE_PNM Netpbm PBM, PGM and PPM, plain (P1 to P3) or raw
+ * (P4 to P6), with samples up to 16 bits
+ * @var INKY_IMAGE_BMP Windows BMP with 1, 4 or 8 bit palettes, or 16,
+ * 24 or 32 bit pixels, uncompressed or with bit field masks
+ * @var INKY_IMAGE_QOI The Quite OK Image format
+ */
+	typedef enum {
+		INKY_IMAGE_PNM,
+		INKY_IMAGE_BMP,
+		INKY_IMAGE_QOI
+	} inky_image_format;
+
+/** @brief Read up to len bytes of an image into buf
+ *
+ * @return Bytes read, 0 at the end of the image, negative on errors
+ */
+	typedef INT32_t (*inky_image_read_cb)(void *ctx, UINT8_t *buf,
+					      UINT32_t len);
+
+/** @brief Image being decoded a row at a time
+    @var format File format, from the first bytes
+    @var width, height Size in pixels
+    @var rows Rows decoded so far
+    @var read, *ctx Source of the bytes, NULL read for a memory source
+    @var *data, size Memory source
+    @var pos Bytes of the image decoded so far
+    @var ahead, n_ahead, at Bytes read from a callback but not yet
+    decoded
+    The remaining fields are internal decoder state
+**/
+	typedef struct inky_imagenode {
+		inky_image_format format;
+		UINT16_t width;
+		UINT16_t height;
+		UINT16_t rows;
+		inky_image_read_cb read;
+		void *ctx;
+		const UINT8_t *data;
+		UINT32_t size;
+		UINT32_t pos;
+		UINT8_t ahead[INKY_IMAGE_READ_AHEAD];
+		UINT8_t n_ahead;
+		UINT8_t at;
+		/* PNM type 1 to 6, bits per BMP pixel or QOI channels */
+		UINT8_t kind;
+		UINT8_t bottom_up;
+		UINT16_t maxval;
+		UINT32_t pad;
+		UINT32_t masks[4];
+		UINT32_t run;
+		UINT8_t px[4];
+		/* BMP palette, or the QOI index of 64 RGBA pixels */
+		UINT8_t table[256 * 3];
+	} inky_image;
+
+/** @brief Start decoding an image held in memory */
+	inky_error_state inky_image_open_memory(inky_image *img,
+						const UINT8_t *data,
+						UINT32_t size);
+
+/** @brief Start decoding an image read through a callback
+ *
+ * The callback is asked for at most INKY_IMAGE_READ_AHEAD bytes at a
+ * time and is never seeked.
+ */
+	inky_error_state inky_image_open(inky_image *img,
+					 inky_image_read_cb read, void *ctx);
+
+/** @brief Decode the next row of the image
+ *
+ * @param rgb width * 3 bytes, set to the red, green and blue of each
+ * pixel. Transparent pixels are blended over white
+ * @param y Set to the row decoded. Bottom up BMP files come last row
+ * first
+ *
+ * Returns INKY_E_OUT_OF_RANGE once every row is decoded and
+ * INKY_E_BAD_DATA when the image is cut short or corrupt.
+ */
+	inky_error_state inky_image_read_row(inky_image *img, UINT8_t *rgb,
+					     UINT16_t *y);
+
+/** @brief Panel color closest to a red, green and blue value
+ *
+ * Distances weigh green over red over blue, roughly as the eye does.
+ */
+	inky_color inky_image_nearest(const inky_config *cfg, UINT8_t r,
+				      UINT8_t g, UINT8_t b);
+
+/** @brief Decode the remaining rows into the framebuffer with the top
+ * left pixel at x, y
+ *
+ * Each pixel is set to the nearest panel color, in runs of one color
+ * written straight into the framebuffer row. Only one row of RGB is
+ * held at a time. Clipped to the framebuffer, and marks what it drew
+ * dirty.
+ */
+	inky_error_state inky_image_draw(inky_config *cfg, inky_image *img,
+					 INT16_t x, INT16_t y);
+
+/**
+ * @}
+ * Streaming image decoders
+ */
+
+#ifdef __cplusplus
+}
+#endif /* #ifdef __cplusplus */
+
+#endif /* #ifndef INKY_IMAGE_H */
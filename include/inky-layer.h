@@ -0,0 +1,123 @@
+/* Layered framebuffers for the Pimoroni Inky driver */
+#ifndef INKY_LAYER_H
+#define INKY_LAYER_H
+
+#include <inky-api.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif /* #ifdef __cplusplus */
+
+/**
+ * @defgroup inkylayer Layers
+ * @{
+ */
+
+/** @brief Framebuffer stacked over cfg's framebuffer and composed with
+ * it row by row as the panel is sent
+    @var fb Pixels of the layer, in the format of cfg's framebuffer. Its
+    dirty rectangle is in layer coordinates
+    @var x, y Position of the top left pixel on the canvas, may be
+    negative
+    @var z Layers with higher z cover lower ones
+    @var visible Layer is composed
+    @var keyed Pixels of code key are transparent
+    @var key Framebuffer code left transparent
+    @var *base Framebuffer drawn to before inky_layer_begin()
+    @var *next Layer above this one
+**/
+	typedef struct inky_layernode {
+		inky_fb fb;
+		INT16_t x;
+		INT16_t y;
+		INT8_t z;
+		UINT8_t visible;
+		UINT8_t keyed;
+		UINT8_t key;
+		inky_fb *base;
+		struct inky_layernode *next;
+	} inky_layer;
+
+/** @brief Allocate a visible width by height layer
+ *
+ * @param key Color left transparent, NULL for an opaque layer. The
+ * layer starts out filled with it, or white when opaque
+ *
+ * @return INKY_E_NOT_AVAILABLE for a key the panel does not have, or
+ * for any other size than the framebuffer's when INKY_FIXED_PRODUCT
+ * fixes it
+ */
+	inky_error_state inky_layer_create(inky_config *cfg,
+					   inky_layer *layer, UINT16_t width,
+					   UINT16_t height,
+					   const inky_color *key);
+
+/** @brief Free the pixels of a layer, which must not be in a stack */
+	inky_error_state inky_layer_free(inky_layer *layer);
+
+/** @brief Put a layer in cfg's stack at depth z, above the layers of
+ * the same z already there, and mark its area dirty
+ *
+ * A layer already in the stack moves to z.
+ */
+	inky_error_state inky_layer_add(inky_config *cfg, inky_layer *layer,
+					INT8_t z);
+
+/** @brief Take a layer out of cfg's stack and mark its area dirty
+ *
+ * @return INKY_E_OUT_OF_RANGE when it is not in the stack
+ */
+	inky_error_state inky_layer_remove(inky_config *cfg,
+					   inky_layer *layer);
+
+/** @brief Move a layer's top left pixel to x, y, marking the area it
+ * left and the area it covers dirty */
+	inky_error_state inky_layer_move(inky_config *cfg, inky_layer *layer,
+					 INT16_t x, INT16_t y);
+
+/** @brief Show or hide a layer, marking its area dirty on a change */
+	inky_error_state inky_layer_show(inky_config *cfg, inky_layer *layer,
+					 UINT8_t visible);
+
+/** @brief Draw into a layer
+ *
+ * Until inky_layer_end(), cfg's framebuffer is the layer's, so every
+ * drawing call draws into it in layer coordinates. Those that mark the
+ * framebuffer dirty, as described for inky_fb, grow the layer's dirty
+ * rectangle; mark other writes with inky_fb_mark_dirty(). Do not
+ * update the panel or change the stack meanwhile.
+ */
+	inky_error_state inky_layer_begin(inky_config *cfg,
+					  inky_layer *layer);
+
+/** @brief Go back to drawing into the framebuffer under the layers */
+	inky_error_state inky_layer_end(inky_config *cfg, inky_layer *layer);
+
+/** @brief Compose n pixels of row y of a framebuffer from pixel x with
+ * its visible layers, bottom up, into out at pixel 0
+ *
+ * out holds at least INKY_ROW_STRIDE(n, bpp) bytes. Each layer is
+ * copied a word at a time, with the pixels of its key color masked
+ * out, so only the spans of the layers crossing the row are touched.
+ */
+	void inky_layer_compose_row(const inky_fb *fb, UINT16_t y, UINT16_t x,
+				    UINT16_t n, UINT8_t *out);
+
+/** @brief Grow cfg's dirty rectangle over the dirty rectangles of its
+ * visible layers, moved onto the canvas, and mark every layer clean
+ *
+ * inky_update_dirty() does this first, so changing one layer sends
+ * only the rows it changed, composed with the layers around it.
+ */
+	inky_error_state inky_layer_collect_dirty(inky_config *cfg);
+
+/**
+ * @}
+ * Layers
+ */
+
+#ifdef __cplusplus
+}
+#endif /* #ifdef __cplusplus */
+
+#endif /* #ifndef INKY_LAYER_H */
@@ -0,0 +1,375 @@
+/**
+ * @file inky-panel.hpp
+ *
+ * Header-only C++17 wrapper for the Pimoroni Inky driver
+ *
+ * inky::panel owns an inky_config and its framebuffer, fills in the
+ * callbacks from a HAL policy type, and provides unchecked pixel
+ * accessors whose colors are known at compile time.
+ */
+#ifndef INKY_PANEL_HPP
+#define INKY_PANEL_HPP
+
+#include <inky-api.h>
+
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <utility>
+
+namespace inky {
+
+/**
+ * @brief Color sets a panel can be built for
+ *
+ * Each provides the inky_color_config handed to the driver and a
+ * constexpr query for compile-time color checks.
+ */
+namespace colors {
+
+	struct black {
+		static constexpr inky_color_config config = {1, 1, 0, 0};
+	};
+
+	struct red {
+		static constexpr inky_color_config config = {1, 1, 1, 0};
+	};
+
+	struct yellow {
+		static constexpr inky_color_config config = {1, 1, 0, 1};
+	};
+
+	/** @brief True if color c is available in color set C */
+	template <class C>
+	constexpr bool has(inky_color c) noexcept
+	{
+		switch (c) {
+		case INKY_COLOR_WHITE:
+			return C::config.white != 0;
+		case INKY_COLOR_BLACK:
+			return C::config.black != 0;
+		case INKY_COLOR_RED:
+			return C::config.red != 0;
+		case INKY_COLOR_YELLOW:
+			return C::config.yellow != 0;
+		}
+
+		return false;
+	}
+
+} /* namespace colors */
+
+/**
+ * @brief Owning wrapper around a configured Inky display
+ *
+ * @tparam Width Panel width in pixels
+ * @tparam Height Panel height in pixels
+ * @tparam Colors One of the inky::colors sets
+ * @tparam Hal Policy type providing the hardware callbacks as
+ * member functions, with the same arguments as the inky_user_*
+ * types minus the trailing interface pointer:
+ *
+ *     inky_error_state gpio_initialize();
+ *     inky_error_state gpio_setup_pin(inky_pin, inky_gpio_direction,
+ *                                     inky_pin_state,
+ *                                     inky_gpio_pull_up_down);
+ *     inky_error_state gpio_output(inky_pin, inky_pin_state);
+ *     inky_error_state gpio_input(inky_pin, inky_pin_state*);
+ *     inky_error_state gpio_poll(inky_pin, UINT64_t timeout);
+ *     inky_error_state spi_setup();
+ *     inky_error_state spi_write(const UINT8_t*, UINT32_t);
+ *     inky_error_state spi_write16(const UINT16_t*, UINT32_t);
+ *     inky_error_state delay_us(UINT32_t);
+ *
+ * The driver reaches the HAL through one static trampoline per
+ * callback, generated for this Hal type, so the member bodies are
+ * inlined into the trampolines. Pixel access never leaves the header.
+ *
+ * The panel is move-only. The framebuffer is released with
+ * inky_free() when the owning panel is destroyed.
+ */
+template <std::uint16_t Width, std::uint16_t Height, class Colors,
+	  class Hal>
+class panel {
+public:
+	static constexpr std::uint16_t width = Width;
+	static constexpr std::uint16_t height = Height;
+
+	/** @brief Bits per pixel, as chosen by INKY_PIXFMT_AUTO */
+	static constexpr std::uint8_t bpp =
+		(Colors::config.red || Colors::config.yellow) ? 2 : 1;
+
+	/** @brief Bytes per framebuffer row, padded to a 32 bit word, as
+	 * allocated by setup()
+	 *
+	 * inky_fb_set_canvas(), inky_fb_set_scale() and quarter turns of
+	 * inky_fb_set_orientation() reshape the framebuffer afterwards, so
+	 * the pixel accessors read its geometry at run time.
+	 */
+	static constexpr std::size_t stride = INKY_ROW_STRIDE(Width, bpp);
+
+	static constexpr std::size_t bytes = stride * Height;
+
+	static constexpr inky_product product =
+		(Width == 400 && Height == 300) ? INKY_WHAT :
+		(Width == 122 && Height == 250) ? INKY_PHAT : INKY_CUSTOM;
+
+	static_assert(product != INKY_CUSTOM,
+		      "Geometry does not match a supported Inky product");
+
+#ifdef INKY_FIXED_PRODUCT
+	static_assert(product == INKY_FIXED_PRODUCT,
+		      "Geometry does not match INKY_FIXED_PRODUCT");
+#endif /* #ifdef INKY_FIXED_PRODUCT */
+
+	template <class... Args>
+	explicit panel(Args&&... hal_args)
+		: s_(new state{Hal(std::forward<Args>(hal_args)...)})
+	{
+		inky_config *dev = &s_->dev;
+
+		s_->color = Colors::config;
+
+		dev->pdt = product;
+		dev->color = &s_->color;
+		dev->fb = nullptr;
+		dev->active_fb = nullptr;
+		dev->exclude_flags = 0;
+		dev->fb_format = INKY_PIXFMT_AUTO;
+		dev->panel = nullptr;
+
+		dev->gpio_init_cb = gpio_init_cb;
+		dev->gpio_setup_pin_cb = gpio_setup_pin_cb;
+		dev->gpio_output_cb = gpio_output_cb;
+		dev->gpio_input_cb = gpio_input_cb;
+		dev->gpio_poll_cb = gpio_poll_cb;
+		dev->spi_setup_cb = spi_setup_cb;
+		dev->spi_write_cb = spi_write_cb;
+		dev->spi_write16_cb = spi_write16_cb;
+		dev->delay_us_cb = delay_us_cb;
+
+		dev->intf_ptr = s_.get();
+		dev->usrptr1 = nullptr;
+		dev->usrptr2 = nullptr;
+	}
+
+	panel(panel &&) noexcept = default;
+	panel &operator=(panel &&) noexcept = default;
+
+	panel(const panel &) = delete;
+	panel &operator=(const panel &) = delete;
+
+	~panel() = default;
+
+	/** @brief Initialize hardware and allocate the framebuffer */
+	inky_error_state setup() noexcept { return inky_setup(&s_->dev); }
+
+	inky_error_state update() noexcept { return inky_update(&s_->dev); }
+
+	inky_error_state clear() noexcept { return inky_clear(&s_->dev); }
+
+	/** @brief True once setup() has allocated the framebuffer */
+	bool ready() const noexcept { return s_ && s_->dev.fb; }
+
+	Hal &hal() noexcept { return s_->hal; }
+
+	/** @brief Underlying C configuration, for the rest of the API */
+	inky_config &config() noexcept { return s_->dev; }
+
+	std::uint8_t *data() noexcept { return s_->dev.fb->buffer; }
+
+	const std::uint8_t *data() const noexcept
+	{
+		return s_->dev.fb->buffer;
+	}
+
+	/** @brief Framebuffer width in pixels, after any reshaping */
+	std::uint16_t fb_width() const noexcept
+	{
+		return INKY_FB_WIDTH(s_->dev.fb);
+	}
+
+	/** @brief Framebuffer height in pixels, after any reshaping */
+	std::uint16_t fb_height() const noexcept
+	{
+		return INKY_FB_HEIGHT(s_->dev.fb);
+	}
+
+	/** @brief Set a pixel with a color checked at compile time */
+	template <inky_color C>
+	void set(std::uint16_t x, std::uint16_t y) noexcept
+	{
+		static_assert(colors::has<Colors>(C),
+			      "Color not available on this panel");
+
+		put(offset(x, y), code(C));
+	}
+
+	/** @brief Set a pixel without range or color checks */
+	void set(std::uint16_t x, std::uint16_t y, inky_color c) noexcept
+	{
+		assert(x < fb_width() && y < fb_height() &&
+		       colors::has<Colors>(c));
+
+		put(offset(x, y), code(c));
+	}
+
+	/** @brief Read back a pixel without range checks */
+	inky_color get(std::uint16_t x, std::uint16_t y) const noexcept
+	{
+		std::size_t bit = offset(x, y);
+		std::uint8_t px = (data()[bit / 8] >> (bit % 8)) & mask;
+
+		if (px == 0x01) {
+			return INKY_COLOR_BLACK;
+		}
+
+		if (px == 0x02) {
+			return Colors::config.yellow ? INKY_COLOR_YELLOW :
+				INKY_COLOR_RED;
+		}
+
+		return INKY_COLOR_WHITE;
+	}
+
+	/** @brief Fill len pixels of row y starting at x, unchecked */
+	void span(std::uint16_t x, std::uint16_t y, std::uint16_t len,
+		  inky_color c) noexcept
+	{
+		assert(x + len <= fb_width() && y < fb_height());
+
+		std::size_t bit = offset(x, y);
+		std::size_t end = bit + static_cast<std::size_t>(len) * bpp;
+		std::uint8_t px = code(c);
+		std::uint8_t *buf = data();
+
+		/* Leading pixels up to a byte boundary */
+		for (; bit < end && bit % 8; bit += bpp) {
+			put(bit, px);
+		}
+
+		/* Whole bytes of 8 / bpp pixels */
+		std::uint8_t fill = px * (0xff / mask);
+
+		for (; bit + 8 <= end; bit += 8) {
+			buf[bit / 8] = fill;
+		}
+
+		for (; bit < end; bit += bpp) {
+			put(bit, px);
+		}
+	}
+
+	/** @brief Fill the whole framebuffer, padding included, with one
+	 * color */
+	void fill(inky_color c) noexcept
+	{
+		std::uint8_t fill = code(c) * (0xff / mask);
+		std::uint8_t *buf = data();
+
+		for (std::size_t i = 0; i < s_->dev.fb->bytes; i++) {
+			buf[i] = fill;
+		}
+	}
+
+private:
+	struct state {
+		Hal hal;
+		inky_color_config color;
+		inky_config dev;
+
+		~state() { inky_free(&dev); }
+	};
+
+	/** @brief Bit offset of pixel x, y in the framebuffer */
+	std::size_t offset(std::uint16_t x, std::uint16_t y) const noexcept
+	{
+		std::size_t row = INKY_FB_STRIDE(s_->dev.fb);
+
+		return (static_cast<std::size_t>(y) * row * 8) +
+			static_cast<std::size_t>(x) * bpp;
+	}
+
+	static constexpr std::uint8_t mask = (1 << bpp) - 1;
+
+	/** @brief Framebuffer code for a color */
+	static constexpr std::uint8_t code(inky_color c) noexcept
+	{
+		return c == INKY_COLOR_BLACK ? 0x01 :
+			c == INKY_COLOR_WHITE ? 0x00 : 0x02;
+	}
+
+	void put(std::size_t bit, std::uint8_t px) noexcept
+	{
+		std::uint8_t *b = &data()[bit / 8];
+
+		*b = (*b & ~(mask << (bit % 8))) | (px << (bit % 8));
+	}
+
+	static Hal &hal_of(void *intf_ptr) noexcept
+	{
+		return static_cast<state*>(intf_ptr)->hal;
+	}
+
+	static inky_error_state gpio_init_cb(void *p)
+	{
+		return hal_of(p).gpio_initialize();
+	}
+
+	static inky_error_state gpio_setup_pin_cb(inky_pin pin,
+						  inky_gpio_direction dir,
+						  inky_pin_state st,
+						  inky_gpio_pull_up_down pull,
+						  void *p)
+	{
+		return hal_of(p).gpio_setup_pin(pin, dir, st, pull);
+	}
+
+	static inky_error_state gpio_output_cb(inky_pin pin,
+					       inky_pin_state st, void *p)
+	{
+		return hal_of(p).gpio_output(pin, st);
+	}
+
+	static inky_error_state gpio_input_cb(inky_pin pin,
+					      inky_pin_state *out, void *p)
+	{
+		return hal_of(p).gpio_input(pin, out);
+	}
+
+	static inky_error_state gpio_poll_cb(inky_pin pin, UINT64_t timeout,
+					     void *p)
+	{
+		return hal_of(p).gpio_poll(pin, timeout);
+	}
+
+	static inky_error_state spi_setup_cb(void *p)
+	{
+		return hal_of(p).spi_setup();
+	}
+
+	static inky_error_state spi_write_cb(const UINT8_t *buf, UINT32_t len,
+					     void *p)
+	{
+		return hal_of(p).spi_write(buf, len);
+	}
+
+	static inky_error_state spi_write16_cb(const UINT16_t *buf,
+					       UINT32_t len, void *p)
+	{
+		return hal_of(p).spi_write16(buf, len);
+	}
+
+	static inky_error_state delay_us_cb(UINT32_t us, void *p)
+	{
+		return hal_of(p).delay_us(us);
+	}
+
+	/* Heap state keeps intf_ptr and color valid across moves */
+	std::unique_ptr<state> s_;
+};
+
+} /* namespace inky */
+
+#endif /* #ifndef INKY_PANEL_HPP */
@@ -0,0 +1,68 @@
+/* Image scaling into the framebuffer for the Pimoroni Inky driver */
+#ifndef INKY_SCALE_H
+#define INKY_SCALE_H
+
+#include <inky-api.h>
+#include <inky-dither.h>
+#include <inky-image.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif /* #ifdef __cplusplus */
+
+/**
+ * @defgroup inkyscale Image scaling
+ * @{
+ */
+
+/** @brief How source pixels are resampled
+ *
+ * @var INKY_SCALE_NEAREST The source pixel under the centre of each
+ * pixel. Fastest, and keeps hard edges, but drops detail when shrinking
+ * @var INKY_SCALE_BOX The average of the source area each pixel
+ * covers. Best for shrinking photos and text
+ * @var INKY_SCALE_BILINEAR Blend of the four source pixels around the
+ * centre of each pixel. Smoothest for enlarging
+ */
+	typedef enum {
+		INKY_SCALE_NEAREST,
+		INKY_SCALE_BOX,
+		INKY_SCALE_BILINEAR
+	} inky_scale_filter;
+
+/** @brief Largest size of an sw by sh picture that fits a bw by bh box
+ * with its aspect ratio kept, rounded to the nearest pixel and at least
+ * one pixel each way */
+	void inky_scale_fit(UINT16_t sw, UINT16_t sh, UINT16_t bw, UINT16_t bh,
+			    UINT16_t *w, UINT16_t *h);
+
+/** @brief Decode the remaining rows of an image and draw them scaled
+ * to w by h pixels, with the top left pixel at x, y
+ *
+ * Source positions are stepped in fixed point, and each source row is
+ * scaled across as it is decoded, then rows are combined down into
+ * output rows that go straight to inky_dither_row() for quantization
+ * and packing. No scaled copy of the picture is made: besides the
+ * ditherer, memory is one decoded row and two scaled rows, plus a row
+ * of sums for INKY_SCALE_BOX.
+ *
+ * @param mode, hysteresis As inky_dither_image(). INKY_DITHER_THRESHOLD
+ * takes the nearest panel color
+ */
+	inky_error_state inky_fb_draw_scaled(inky_config *cfg, inky_image *img,
+					     INT16_t x, INT16_t y, UINT16_t w,
+					     UINT16_t h,
+					     inky_scale_filter filter,
+					     inky_dither_mode mode,
+					     UINT8_t hysteresis);
+
+/**
+ * @}
+ * Image scaling
+ */
+
+#ifdef __cplusplus
+}
+#endif /* #ifdef __cplusplus */
+
+#endif /* #ifndef INKY_SCALE_H */
@@ -0,0 +1,123 @@
+/* Character cell terminal for the Pimoroni Inky driver */
+#ifndef INKY_TERM_H
+#define INKY_TERM_H
+
+#include <inky-api.h>
+#include <inky-text.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif /* #ifdef __cplusplus */
+
+/**
+ * @defgroup inkyterm Character cell terminal
+ * @{
+ */
+
+/** @brief Most numeric parameters kept from one escape sequence */
+#define INKY_TERM_MAX_PARAMS	4
+
+/** @brief One character cell
+    @var cp Code point shown in the cell
+    @var fg Color of the glyph
+    @var bg Color of the rest of the cell
+**/
+	typedef struct inky_term_cellnode {
+		UINT32_t cp;
+		inky_color fg;
+		inky_color bg;
+	} inky_term_cell;
+
+/** @brief Grid of character cells drawn into part of the framebuffer
+    @var *font Font of every cell
+    @var x, y Framebuffer position of the top left cell
+    @var cols, rows Size of the grid in cells
+    @var cell_w, cell_h Size of a cell in pixels
+    @var col, row Cursor position. col may equal cols after the last
+    column is written, until the next character wraps the line
+    @var fg, bg Colors of the next characters written
+    @var def_fg, def_bg Colors restored by SGR 0, 39 and 49
+    @var reverse Set while SGR 7 swaps fg and bg
+    @var state Internal escape sequence parser state
+    @var n_params Parameters seen in the current escape sequence
+    @var params Values of the parameters
+    @var *cells cols * rows cells, row by row
+    @var *damage One bit per cell, set when the cell changed since it
+    was last rendered
+**/
+	typedef struct inky_termnode {
+		const inky_font *font;
+		UINT16_t x;
+		UINT16_t y;
+		UINT16_t cols;
+		UINT16_t rows;
+		UINT8_t cell_w;
+		UINT8_t cell_h;
+		UINT16_t col;
+		UINT16_t row;
+		inky_color fg;
+		inky_color bg;
+		inky_color def_fg;
+		inky_color def_bg;
+		UINT8_t reverse;
+		UINT8_t state;
+		UINT8_t n_params;
+		UINT16_t params[INKY_TERM_MAX_PARAMS];
+		inky_term_cell *cells;
+		UINT8_t *damage;
+	} inky_term;
+
+/** @brief Create a terminal filling area of the framebuffer
+ *
+ * @param area Rectangle of the framebuffer, NULL for all of it. The
+ * grid holds as many whole cells as fit
+ * @param fg, bg Default colors
+ *
+ * Cells are as wide as the advance of the font's space, or of its
+ * fallback glyph without one, and as tall as the font. Every cell
+ * starts blank and damaged.
+ */
+	inky_error_state inky_term_create(inky_config *cfg, inky_term *term,
+					  const inky_font *font,
+					  const inky_rect *area,
+					  inky_color fg, inky_color bg);
+
+/** @brief Free the cells of a terminal */
+	inky_error_state inky_term_free(inky_term *term);
+
+/** @brief Write a UTF-8 string to the terminal
+ *
+ * Handles CR, LF (which also returns the carriage), BS, TAB and a
+ * subset of VT100 escape sequences: ESC c, and CSI A, B, C, D, H, f,
+ * J, K and m with colors 30, 31, 33 and 37, backgrounds 40, 41, 43
+ * and 47, 39, 49, 0, 7 and 27. Colors the panel lacks are ignored.
+ * Writing past the last row scrolls the grid. Escape sequences may
+ * span calls, characters may not.
+ */
+	inky_error_state inky_term_write(inky_config *cfg, inky_term *term,
+					 const char *utf8);
+
+/** @brief Draw the damaged cells into the framebuffer
+ *
+ * @param dirty Set to the bounding rectangle of the cells drawn, with
+ * w and h 0 when nothing was damaged. May be NULL
+ */
+	inky_error_state inky_term_render(inky_config *cfg, inky_term *term,
+					  inky_rect *dirty);
+
+/** @brief Render the damaged cells and send only them to the panel
+ *
+ * Does nothing when no cell changed. See inky_update_region().
+ */
+	inky_error_state inky_term_update(inky_config *cfg, inky_term *term);
+
+/**
+ * @}
+ * Character cell terminal
+ */
+
+#ifdef __cplusplus
+}
+#endif /* #ifdef __cplusplus */
+
+#endif /* #ifndef INKY_TERM_H */
@@ -0,0 +1,115 @@
+/* Bitmap fonts and text drawing for the Pimoroni Inky driver */
+#ifndef INKY_TEXT_H
+#define INKY_TEXT_H
+
+#include <inky-api.h>
+#include <inky-blit.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif /* #ifdef __cplusplus */
+
+/**
+ * @defgroup inkytext Bitmap fonts and text
+ * @{
+ */
+
+/** @brief Returned by inky_utf8_next() for malformed input */
+#define INKY_UTF8_INVALID	0xfffd
+
+/** @brief One character of a bitmap font
+    @var codepoint Unicode code point
+    @var offset Byte offset of the first row in the font bitmap
+    @var width Pixels per row of the glyph
+    @var advance Pixels from this glyph to the next
+**/
+	typedef struct inky_glyphnode {
+		UINT32_t codepoint;
+		UINT32_t offset;
+		UINT8_t width;
+		UINT8_t advance;
+	} inky_glyph;
+
+/** @brief Bitmap font compiled into a C array
+    @var height Rows per glyph, and the line height
+    @var n_glyphs Number of glyphs
+    @var *glyphs Glyphs sorted by code point
+    @var *bitmap Glyph rows of (width + 7) / 8 bytes, pixel 0 in the
+    lowest bit of the first byte, set bits inked
+    @var fallback Code point drawn for characters the font lacks
+**/
+	typedef struct inky_fontnode {
+		UINT8_t height;
+		UINT16_t n_glyphs;
+		const inky_glyph *glyphs;
+		const UINT8_t *bitmap;
+		UINT32_t fallback;
+	} inky_font;
+
+/** @brief Glyphs of a font encoded as sprites for one framebuffer
+    @var *font Font the atlas was built from
+    @var *glyphs One sprite per font glyph, in the same order
+**/
+	typedef struct inky_text_atlasnode {
+		const inky_font *font;
+		inky_sprite *glyphs;
+	} inky_text_atlas;
+
+/** @brief Built-in 5x7 font covering printable ASCII */
+	extern const inky_font inky_font_5x7;
+
+/** @brief Decode the next code point of a UTF-8 string
+ *
+ * Advances *s past the character. Returns 0 at the terminating NUL,
+ * without advancing, and INKY_UTF8_INVALID for each byte of a
+ * malformed, overlong or surrogate sequence.
+ */
+	UINT32_t inky_utf8_next(const char **s);
+
+/** @brief Glyph for a code point, or NULL if the font has none */
+	const inky_glyph *inky_font_find(const inky_font *font, UINT32_t cp);
+
+/** @brief Width in pixels of the widest line of a UTF-8 string */
+	UINT32_t inky_text_width(const inky_font *font, const char *utf8);
+
+/** @brief Encode every glyph of a font as a sprite
+ *
+ * @param fg Color of the inked pixels
+ * @param bg Color of the rest of each character cell, NULL to leave
+ * it transparent
+ *
+ * The sprites are built for cfg's framebuffer format. Release them with
+ * inky_text_atlas_free().
+ */
+	inky_error_state inky_text_atlas_create(inky_config *cfg,
+						inky_text_atlas *atlas,
+						const inky_font *font,
+						inky_color fg,
+						const inky_color *bg);
+
+/** @brief Free the sprites of an atlas */
+	inky_error_state inky_text_atlas_free(inky_text_atlas *atlas);
+
+/** @brief Draw a UTF-8 string with the top left of its first line at x, y
+ *
+ * '\\n' starts a new line under x. Characters missing from the font are
+ * drawn as its fallback glyph, or skipped without one. The glyphs
+ * drawn are marked dirty.
+ *
+ * @param clip Rectangle to draw inside, NULL for the whole framebuffer
+ */
+	inky_error_state inky_text_draw(inky_config *cfg,
+					const inky_text_atlas *atlas,
+					INT16_t x, INT16_t y, const char *utf8,
+					const inky_rect *clip);
+
+/**
+ * @}
+ * Bitmap fonts and text
+ */
+
+#ifdef __cplusplus
+}
+#endif /* #ifdef __cplusplus */
+
+#endif /* #ifndef INKY_TEXT_H */
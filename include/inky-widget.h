@@ -0,0 +1,173 @@
+/* Retained widgets for the Pimoroni Inky driver */
+#ifndef INKY_WIDGET_H
+#define INKY_WIDGET_H
+
+#include <inky-api.h>
+#include <inky-blit.h>
+#include <inky-text.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif /* #ifdef __cplusplus */
+
+/**
+ * @defgroup inkywidget Retained widgets
+ * @{
+ */
+
+/** @brief Longest text of a text widget, in bytes with the NUL */
+#define INKY_WIDGET_MAX_TEXT	32
+
+/** @brief What a widget draws over its background
+ *
+ * @var INKY_WIDGET_RECT Outline of the bounds in fg, filled while value
+ * is not 0
+ * @var INKY_WIDGET_TEXT Text drawn with its atlas from the top left
+ * @var INKY_WIDGET_BITMAP Bitmap drawn from the top left, mask bits in
+ * fg
+ * @var INKY_WIDGET_BAR Outline in fg, filled in proportion to value
+ * between min and max. Left to right, or bottom up when taller than
+ * wide
+ * @var INKY_WIDGET_SPARKLINE Line in fg through the last values, the
+ * newest on the right, scaled from min to max, or to the values shown
+ * when min equals max
+ */
+	typedef enum {
+		INKY_WIDGET_RECT,
+		INKY_WIDGET_TEXT,
+		INKY_WIDGET_BITMAP,
+		INKY_WIDGET_BAR,
+		INKY_WIDGET_SPARKLINE
+	} inky_widget_type;
+
+/** @brief Node of a tree of widgets, each repainted only when damaged
+    @var type What the widget draws
+    @var bounds Framebuffer rectangle the widget fills. Children draw
+    over their parent, clipped to its bounds. Siblings should not
+    overlap
+    @var fg, bg Colors of the content and of the rest of the bounds
+    @var value Current value, see inky_widget_type
+    @var min, max Range of bars and sparklines
+    @var text Text of a text widget
+    @var *atlas Glyphs of a text widget, which also give its colors
+    @var *bitmap Picture of a bitmap widget
+    @var *samples Ring of the last n_samples values of a sparkline,
+    count of them held, the next going to head
+    @var damaged Repaint at the next render
+    @var *parent, *child, *next Tree links: the parent, the first child
+    and the next sibling
+**/
+	typedef struct inky_widgetnode {
+		inky_widget_type type;
+		inky_rect bounds;
+		inky_color fg;
+		inky_color bg;
+		INT32_t value;
+		INT32_t min;
+		INT32_t max;
+		char text[INKY_WIDGET_MAX_TEXT];
+		const inky_text_atlas *atlas;
+		const inky_bitmap *bitmap;
+		INT32_t *samples;
+		UINT16_t n_samples;
+		UINT16_t count;
+		UINT16_t head;
+		UINT8_t damaged;
+		struct inky_widgetnode *parent;
+		struct inky_widgetnode *child;
+		struct inky_widgetnode *next;
+	} inky_widget;
+
+/** @brief Set up a damaged widget with no children, black on white,
+ * value 0 and a range of 0 to 100 */
+	inky_error_state inky_widget_init(inky_widget *widget,
+					  inky_widget_type type,
+					  const inky_rect *bounds);
+
+/** @brief Add child as the last child of parent, drawn over the ones
+ * before it
+ *
+ * @return INKY_E_OUT_OF_RANGE when child already has a parent
+ */
+	inky_error_state inky_widget_add(inky_widget *parent,
+					 inky_widget *child);
+
+/*
+ * The setters below damage the widget only when what it shows changes,
+ * so they can be called with the same values on every refresh.
+ */
+
+/** @brief Set the value. Sparklines keep it as their newest sample */
+	inky_error_state inky_widget_set_value(inky_widget *widget,
+					       INT32_t value);
+
+/** @brief Set the range of a bar or sparkline, max at least min */
+	inky_error_state inky_widget_set_range(inky_widget *widget,
+					       INT32_t min, INT32_t max);
+
+/** @brief Give a sparkline a ring of n values to remember, at least 2,
+ * emptying it */
+	inky_error_state inky_widget_set_samples(inky_widget *widget,
+						 INT32_t *samples,
+						 UINT16_t n);
+
+/** @brief Copy the text of a text widget and set its atlas
+ *
+ * @return INKY_E_OUT_OF_RANGE for text of INKY_WIDGET_MAX_TEXT bytes
+ * or more
+ */
+	inky_error_state inky_widget_set_text(inky_widget *widget,
+					      const inky_text_atlas *atlas,
+					      const char *utf8);
+
+/** @brief Set the picture of a bitmap widget. After changing the
+ * pixels of the same bitmap, use inky_widget_damage() */
+	inky_error_state inky_widget_set_bitmap(inky_widget *widget,
+						const inky_bitmap *bitmap);
+
+/** @brief Set the colors of a widget */
+	inky_error_state inky_widget_set_colors(inky_widget *widget,
+						inky_color fg, inky_color bg);
+
+/** @brief Move or resize a widget, damaging its parent to repaint the
+ * area it leaves */
+	inky_error_state inky_widget_set_bounds(inky_widget *widget,
+						const inky_rect *bounds);
+
+/** @brief Repaint a widget at the next render */
+	inky_error_state inky_widget_damage(inky_widget *widget);
+
+/** @brief Repaint the damaged widgets of a tree into the framebuffer
+ *
+ * A damaged widget is repainted whole, then its children over it.
+ * Nothing else is drawn.
+ *
+ * @param dirty Set to the bounding rectangle of the widgets repainted,
+ * with w and h 0 when none were damaged. May be NULL
+ *
+ * @return INKY_E_OUT_OF_RANGE for trees deeper than
+ * INKY_DRAW_MAX_CLIP - 1
+ */
+	inky_error_state inky_widget_render(inky_config *cfg,
+					    inky_widget *root,
+					    inky_rect *dirty);
+
+/** @brief Render the damaged widgets and send only them to the panel
+ *
+ * Does nothing when no widget changed. The widgets' boxes are marked
+ * dirty and sent with inky_update_dirty(), so whatever else was marked
+ * goes with them and the framebuffer is left clean.
+ */
+	inky_error_state inky_widget_update(inky_config *cfg,
+					    inky_widget *root);
+
+/**
+ * @}
+ * Retained widgets
+ */
+
+#ifdef __cplusplus
+}
+#endif /* #ifdef __cplusplus */
+
+#endif /* #ifndef INKY_WIDGET_H */
@@ -3,5 +3,16 @@
 #define inky_h
 
 #include <inky-api.h>
+#include <inky-blit.h>
+#include <inky-text.h>
+#include <inky-term.h>
+#include <inky-draw.h>
+#include <inky-image.h>
+#include <inky-dither.h>
+#include <inky-convert.h>
+#include <inky-binarize.h>
+#include <inky-scale.h>
+#include <inky-layer.h>
+#include <inky-widget.h>
 
 #endif
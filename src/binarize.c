@@ -0,0 +1,301 @@
+#include "pixfmt.h"
+
+#include <inky-binarize.h>
+
+#include <stdlib.h>
+#include <string.h>
+
+/*
+**********************************************************************
+********************** Binarize Definitions **************************
+**********************************************************************
+*/
+
+/** @brief Rows held in the ring */
+#define _SPAN(b)	(2 * (UINT32_t) (b)->radius + 1)
+
+/** @brief Take the first row counted out of the column sums */
+static void _drop(inky_binarize *b);
+
+/** @brief Threshold the next row waiting for output into the
+ * framebuffer, its window being rows lo to rows - 1 */
+static void _emit(inky_config *cfg, inky_binarize *b);
+
+/** @brief Whether a pixel of value p is black in a window of n pixels
+ * with the given sum and sum of squares */
+static inline UINT8_t _is_black(const inky_binarize *b, UINT8_t p,
+				UINT32_t n, UINT32_t sum, UINT64_t sq);
+
+/*
+**********************************************************************
+************************** API Functions *****************************
+**********************************************************************
+*/
+
+inky_error_state inky_binarize_begin(inky_config *cfg, inky_binarize *b,
+				     inky_binarize_mode mode, UINT16_t width,
+				     UINT8_t radius, UINT8_t level, INT16_t x,
+				     INT16_t y)
+{
+	if (!cfg->fb) {
+		return INKY_E_NOT_CONFIGURED;
+	}
+
+	if (!b) {
+		return INKY_E_NULL_PTR;
+	}
+
+	if (mode > INKY_BINARIZE_SAUVOLA || width == 0 || radius == 0 ||
+	    radius > INKY_BINARIZE_MAX_RADIUS || level > 100) {
+		return INKY_E_OUT_OF_RANGE;
+	}
+
+	b->mode = mode;
+	b->width = width;
+	b->radius = radius;
+	b->level = level;
+	b->x = x;
+	b->y = y;
+	b->rows = 0;
+	b->lo = 0;
+	b->out = 0;
+	b->black = inky_pixfmt_encode(INKY_FB_BPP(cfg->fb), INKY_COLOR_BLACK) &
+		cfg->fb->fmt.mask;
+	b->white = inky_pixfmt_encode(INKY_FB_BPP(cfg->fb), INKY_COLOR_WHITE) &
+		cfg->fb->fmt.mask;
+	b->ring = malloc(_SPAN(b) * width);
+	b->sum = calloc(width, sizeof(*b->sum));
+	b->sq = mode == INKY_BINARIZE_SAUVOLA ?
+		calloc(width, sizeof(*b->sq)) : NULL;
+
+	if (!b->ring || !b->sum ||
+	    (mode == INKY_BINARIZE_SAUVOLA && !b->sq)) {
+		inky_binarize_free(b);
+		return INKY_E_OUT_OF_MEMORY;
+	}
+
+	return INKY_OK;
+}
+
+inky_error_state inky_binarize_row(inky_config *cfg, inky_binarize *b,
+				   const UINT8_t *gray)
+{
+	inky_error_state ret;
+	UINT8_t *slot;
+
+	if ((ret = pixfmt_fb_check(cfg->fb)) != INKY_OK) {
+		return ret;
+	}
+
+	if (!b || !gray || !b->ring) {
+		return INKY_E_NULL_PTR;
+	}
+
+	if (b->rows == 0xffff) {
+		return INKY_E_OUT_OF_RANGE;
+	}
+
+	/* The slot of the new row holds the row leaving the window */
+	while (b->lo + _SPAN(b) <= b->rows) {
+		_drop(b);
+	}
+
+	slot = &b->ring[(b->rows % _SPAN(b)) * b->width];
+	memcpy(slot, gray, b->width);
+
+	for (UINT16_t i = 0; i < b->width; i++) {
+		b->sum[i] += gray[i];
+
+		if (b->sq) {
+			b->sq[i] += (UINT32_t) gray[i] * gray[i];
+		}
+	}
+
+	b->rows++;
+
+	if (b->rows > b->radius) {
+		_emit(cfg, b);
+	}
+
+	return INKY_OK;
+}
+
+inky_error_state inky_binarize_end(inky_config *cfg, inky_binarize *b)
+{
+	inky_error_state ret;
+
+	if ((ret = pixfmt_fb_check(cfg->fb)) != INKY_OK) {
+		return ret;
+	}
+
+	if (!b || !b->ring) {
+		return INKY_E_NULL_PTR;
+	}
+
+	while (b->out < b->rows) {
+		_emit(cfg, b);
+	}
+
+	inky_binarize_free(b);
+
+	return INKY_OK;
+}
+
+void inky_binarize_free(inky_binarize *b)
+{
+	if (b) {
+		free(b->ring);
+		free(b->sum);
+		free(b->sq);
+		b->ring = NULL;
+		b->sum = NULL;
+		b->sq = NULL;
+	}
+}
+
+inky_error_state inky_binarize_rect(inky_config *cfg,
+				    inky_binarize_mode mode,
+				    const UINT8_t *gray, UINT32_t stride,
+				    UINT16_t w, UINT16_t h, UINT8_t radius,
+				    UINT8_t level, INT16_t x, INT16_t y)
+{
+	inky_error_state ret;
+	inky_binarize b;
+
+	if (!gray) {
+		return INKY_E_NULL_PTR;
+	}
+
+	ret = inky_binarize_begin(cfg, &b, mode, w, radius, level, x, y);
+
+	if (ret != INKY_OK) {
+		return ret;
+	}
+
+	for (UINT16_t j = 0; j < h; j++) {
+		ret = inky_binarize_row(cfg, &b, &gray[stride * j]);
+
+		if (ret != INKY_OK) {
+			inky_binarize_free(&b);
+			return ret;
+		}
+	}
+
+	return inky_binarize_end(cfg, &b);
+}
+
+/*
+**********************************************************************
+************************* INTERNAL API *******************************
+**********************************************************************
+*/
+
+static void _drop(inky_binarize *b)
+{
+	const UINT8_t *row = &b->ring[(b->lo % _SPAN(b)) * b->width];
+
+	for (UINT16_t i = 0; i < b->width; i++) {
+		b->sum[i] -= row[i];
+
+		if (b->sq) {
+			b->sq[i] -= (UINT32_t) row[i] * row[i];
+		}
+	}
+
+	b->lo++;
+}
+
+static void _emit(inky_config *cfg, inky_binarize *b)
+{
+	inky_fb *fb = cfg->fb;
+	UINT16_t c = b->out++;
+	INT32_t fy = b->y + c;
+	const UINT8_t *row;
+	UINT32_t sum = 0;
+	UINT64_t sq = 0;
+	UINT32_t n;
+	INT32_t i0, i1;
+	pixfmt_writer wr;
+
+	/* Rows above the window of this row leave the sums */
+	while (b->lo + b->radius < c) {
+		_drop(b);
+	}
+
+	i0 = b->x < 0 ? -b->x : 0;
+	i1 = INKY_FB_WIDTH(fb) - b->x;
+	i1 = i1 < b->width ? i1 : b->width;
+
+	if (fy < 0 || fy >= INKY_FB_HEIGHT(fb) || i0 >= i1) {
+		return;
+	}
+
+	row = &b->ring[(c % _SPAN(b)) * b->width];
+	n = b->rows - b->lo;
+
+	/* Columns up to radius - 1, then slide the window along, one
+	 * column in on the right and one out on the left */
+	for (INT32_t i = 0; i < b->radius && i < b->width; i++) {
+		sum += b->sum[i];
+		sq += b->sq ? b->sq[i] : 0;
+	}
+
+	pixfmt_writer_begin(&wr, &fb->buffer[INKY_FB_STRIDE(fb) * fy],
+			    b->x + i0, &fb->fmt);
+
+	for (INT32_t i = 0; i < i1; i++) {
+		INT32_t in = i + b->radius;
+		INT32_t out = i - b->radius - 1;
+		INT32_t l = i - b->radius < 0 ? 0 : i - b->radius;
+		INT32_t r = in < b->width ? in : b->width - 1;
+
+		if (in < b->width) {
+			sum += b->sum[in];
+			sq += b->sq ? b->sq[in] : 0;
+		}
+
+		if (out >= 0) {
+			sum -= b->sum[out];
+			sq -= b->sq ? b->sq[out] : 0;
+		}
+
+		if (i >= i0) {
+			pixfmt_writer_put(&wr, _is_black(b, row[i],
+							 n * (r - l + 1), sum,
+							 sq) ?
+					  b->black : b->white);
+		}
+	}
+
+	pixfmt_writer_end(&wr);
+
+	if (wr.first <= wr.last) {
+		inky_rect d;
+
+		d.x = b->x + i0 + wr.first;
+		d.y = fy;
+		d.w = wr.last - wr.first + 1;
+		d.h = 1;
+
+		inky_fb_mark_dirty(cfg, &d);
+	}
+}
+
+static inline UINT8_t _is_black(const inky_binarize *b, UINT8_t p,
+				UINT32_t n, UINT32_t sum, UINT64_t sq)
+{
+	INT64_t dev;
+
+	if (b->mode == INKY_BINARIZE_BRADLEY) {
+		return (UINT64_t) p * n * 100 <
+			(UINT64_t) sum * (100 - b->level);
+	}
+
+	/* With the deviation as sqrt(dev) / n, both sides times
+	 * 12800 * n * n */
+	dev = pixfmt_isqrt64((UINT64_t) sq * n - (UINT64_t) sum * sum);
+
+	return (INT64_t) p * n * n * 12800 <
+		(INT64_t) sum * ((INT64_t) 12800 * n +
+				 (INT64_t) b->level * (dev - 128 * (INT64_t) n));
+}
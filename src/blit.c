@@ -0,0 +1,819 @@
+#include "pixfmt.h"
+
+#include <inky-blit.h>
+
+#include <stdlib.h>
+#include <string.h>
+
+/*
+**********************************************************************
+************************ Blit Definitions ****************************
+**********************************************************************
+*/
+
+/** @brief Check a bitmap is complete enough to read from */
+static inky_error_state _bitmap_check(const inky_bitmap *src);
+
+/** @brief Resolve the source rectangle of a blit, NULL for all of src */
+static inky_error_state _bitmap_area(const inky_bitmap *src,
+				     const inky_rect *area, inky_rect *r);
+
+/** @brief Allocate and encode the phases of a sprite. Shaped sprites
+ * take their opacity from the bits of a mask source */
+static inky_error_state _sprite_build(inky_config *cfg, inky_sprite *spr,
+				      const inky_bitmap *src,
+				      const inky_rect *r, inky_color fg,
+				      const inky_color *key, UINT8_t shaped,
+				      const inky_color *bg);
+
+/** @brief Move a w by h rectangle of the framebuffer from sx, sy to
+ * dx, dy. Both must lie inside it, and may overlap */
+static void _move_rect(inky_fb *fb, UINT16_t sx, UINT16_t sy, UINT16_t w,
+		       UINT16_t h, UINT16_t dx, UINT16_t dy);
+
+/** @brief Set a w by h rectangle of the framebuffer to one code */
+static void _fill_rect(inky_fb *fb, UINT16_t x, UINT16_t y, UINT16_t w,
+		       UINT16_t h, UINT8_t code);
+
+/** @brief Color of pixel x of row y of a bitmap */
+static inky_color _bitmap_color(const inky_bitmap *src,
+				const inky_pixfmt *fmt,
+				const inky_color_config *color, UINT16_t x,
+				UINT16_t y, inky_color fg);
+
+/** @brief Convert n pixels of a source row into dst, starting at bit
+ * dbit, in the framebuffer format */
+static void _convert_row(const inky_config *cfg, const inky_bitmap *src,
+			 UINT16_t sx, UINT16_t sy, UINT16_t n,
+			 UINT8_t *dst, UINT32_t dbit, inky_color fg);
+
+/*
+**********************************************************************
+*********************** Blit Implementation **************************
+**********************************************************************
+*/
+
+inky_error_state inky_bitmap_from_fb(const inky_fb *fb, inky_bitmap *out)
+{
+	inky_error_state ret;
+
+	if (!fb || !out) {
+		return INKY_E_NULL_PTR;
+	}
+
+	if ((ret = pixfmt_fb_check(fb)) != INKY_OK) {
+		return ret;
+	}
+
+	out->type = INKY_BITMAP_PACKED;
+	out->format = fb->fmt.format;
+	out->width = INKY_FB_WIDTH(fb);
+	out->height = INKY_FB_HEIGHT(fb);
+	out->stride = INKY_FB_STRIDE(fb);
+	out->data = fb->buffer;
+	out->color = NULL;
+
+	return INKY_OK;
+}
+
+inky_error_state inky_fb_blit(inky_config *cfg,
+			      const inky_bitmap *src,
+			      const inky_rect *area,
+			      INT16_t dx, INT16_t dy, inky_rop rop,
+			      inky_color fg, inky_color key)
+{
+	inky_error_state ret;
+	inky_rect r;
+	UINT8_t bpp;
+	UINT8_t key_code;
+	UINT32_t key_pattern;
+
+	if ((ret = pixfmt_fb_check(cfg->fb)) != INKY_OK) {
+		return ret;
+	}
+
+	if (!src) {
+		return INKY_E_NULL_PTR;
+	}
+
+	ret = _bitmap_area(src, area, &r);
+
+	if (ret != INKY_OK) {
+		return ret;
+	}
+
+	if (rop > INKY_ROP_TRANSPARENT) {
+		return INKY_E_NOT_AVAILABLE;
+	}
+
+	if (src->type == INKY_BITMAP_MASK && !inky_color_available(cfg, fg)) {
+		return INKY_E_NOT_AVAILABLE;
+	}
+
+	/* Clip to the framebuffer */
+	if (dx < 0) {
+		if (-dx >= r.w) {
+			return INKY_OK;
+		}
+
+		r.x = r.x - dx;
+		r.w = r.w + dx;
+		dx = 0;
+	}
+
+	if (dy < 0) {
+		if (-dy >= r.h) {
+			return INKY_OK;
+		}
+
+		r.y = r.y - dy;
+		r.h = r.h + dy;
+		dy = 0;
+	}
+
+	if (dx >= INKY_FB_WIDTH(cfg->fb) || dy >= INKY_FB_HEIGHT(cfg->fb)) {
+		return INKY_OK;
+	}
+
+	if (dx + r.w > INKY_FB_WIDTH(cfg->fb)) {
+		r.w = INKY_FB_WIDTH(cfg->fb) - dx;
+	}
+
+	if (dy + r.h > INKY_FB_HEIGHT(cfg->fb)) {
+		r.h = INKY_FB_HEIGHT(cfg->fb) - dy;
+	}
+
+	if (r.w == 0 || r.h == 0) {
+		return INKY_OK;
+	}
+
+	bpp = INKY_FB_BPP(cfg->fb);
+	key_code = inky_pixfmt_encode(bpp, key) & cfg->fb->fmt.mask;
+	key_pattern = pixfmt_pattern32(bpp, key_code);
+
+	for (UINT16_t j = 0; j < r.h; j++) {
+		UINT32_t bit = (UINT32_t) dx * bpp;
+		UINT32_t end = bit + (UINT32_t) r.w * bpp;
+		UINT32_t first = bit / 32;
+		UINT32_t last = (end + 31) / 32;
+		UINT8_t *row = &cfg->fb->buffer[INKY_FB_STRIDE(cfg->fb) *
+						 (dy + j)];
+		UINT8_t tmp[(last - first) * 4];
+
+		/*
+		 * Bring the source row into the framebuffer format at the
+		 * same bit phase as the destination, so both can be
+		 * combined a word at a time with only the two edge words
+		 * masked.
+		 */
+		memset(tmp, 0, sizeof(tmp));
+		_convert_row(cfg, src, r.x, r.y + j, r.w, tmp, bit % 32, fg);
+
+		for (UINT32_t i = first; i < last; i++) {
+			UINT32_t lo = i == first ? bit % 32 : 0;
+			UINT32_t hi = i == last - 1 ? end - i * 32 : 32;
+			UINT32_t mask;
+			UINT32_t s = pixfmt_load32(&tmp[(i - first) * 4]);
+			UINT32_t d = pixfmt_load32(&row[i * 4]);
+			UINT32_t v;
+
+			mask = (hi == 32 ? 0xffffffffu : (1u << hi) - 1) &
+				~((1u << lo) - 1);
+
+			switch (rop) {
+			case INKY_ROP_OR:
+				v = d | s;
+				break;
+			case INKY_ROP_AND:
+				v = d & s;
+				break;
+			case INKY_ROP_XOR:
+				v = d ^ s;
+				break;
+			case INKY_ROP_TRANSPARENT:
+				mask = mask & pixfmt_differs32(bpp, s,
+								key_pattern);
+				v = s;
+				break;
+			default:
+				v = s;
+				break;
+			}
+
+			pixfmt_store32(&row[i * 4], (d & ~mask) | (v & mask));
+		}
+	}
+
+	r.x = dx;
+	r.y = dy;
+
+	return inky_fb_mark_dirty(cfg, &r);
+}
+
+inky_error_state inky_sprite_create(inky_config *cfg,
+				    inky_sprite *spr,
+				    const inky_bitmap *src,
+				    const inky_rect *area,
+				    inky_color fg,
+				    const inky_color *key)
+{
+	inky_error_state ret;
+	inky_rect r;
+
+	if (!cfg->fb) {
+		return INKY_E_NOT_CONFIGURED;
+	}
+
+	if (!spr || !src) {
+		return INKY_E_NULL_PTR;
+	}
+
+	ret = _bitmap_area(src, area, &r);
+
+	if (ret != INKY_OK) {
+		return ret;
+	}
+
+	if (src->type == INKY_BITMAP_MASK && !inky_color_available(cfg, fg)) {
+		return INKY_E_NOT_AVAILABLE;
+	}
+
+	return _sprite_build(cfg, spr, src, &r, fg, key, 0, NULL);
+}
+
+inky_error_state inky_sprite_create_mask(inky_config *cfg,
+					 inky_sprite *spr,
+					 const inky_bitmap *src,
+					 const inky_rect *area,
+					 inky_color fg,
+					 const inky_color *bg)
+{
+	inky_error_state ret;
+	inky_rect r;
+
+	if (!cfg->fb) {
+		return INKY_E_NOT_CONFIGURED;
+	}
+
+	if (!spr || !src) {
+		return INKY_E_NULL_PTR;
+	}
+
+	if (src->type != INKY_BITMAP_MASK) {
+		return INKY_E_NOT_AVAILABLE;
+	}
+
+	ret = _bitmap_area(src, area, &r);
+
+	if (ret != INKY_OK) {
+		return ret;
+	}
+
+	if (!inky_color_available(cfg, fg) ||
+	    (bg && !inky_color_available(cfg, *bg))) {
+		return INKY_E_NOT_AVAILABLE;
+	}
+
+	return _sprite_build(cfg, spr, src, &r, fg, NULL, 1, bg);
+}
+
+inky_error_state inky_sprite_free(inky_sprite *spr)
+{
+	if (!spr) {
+		return INKY_E_NULL_PTR;
+	}
+
+	/* The mask shares the allocation of the pixels */
+	free(spr->pixels);
+
+	spr->pixels = NULL;
+	spr->mask = NULL;
+
+	return INKY_OK;
+}
+
+inky_error_state inky_fb_draw_sprite(inky_config *cfg,
+				     const inky_sprite *spr,
+				     INT16_t x, INT16_t y)
+{
+	return inky_fb_draw_sprite_clip(cfg, spr, x, y, NULL);
+}
+
+inky_error_state inky_fb_draw_sprite_clip(inky_config *cfg,
+					  const inky_sprite *spr,
+					  INT16_t x, INT16_t y,
+					  const inky_rect *clip)
+{
+	inky_error_state ret;
+	UINT8_t bpp;
+	UINT8_t phase;
+	UINT8_t lo_mask;
+	UINT8_t hi_mask;
+	INT32_t cx0 = 0;
+	INT32_t cy0 = 0;
+	INT32_t cx1;
+	INT32_t cy1;
+	INT32_t start;
+	INT32_t first;
+	INT32_t last;
+	INT32_t row_first;
+	INT32_t row_last;
+	inky_rect box;
+
+	if ((ret = pixfmt_fb_check(cfg->fb)) != INKY_OK) {
+		return ret;
+	}
+
+	if (!spr || !spr->pixels) {
+		return INKY_E_NULL_PTR;
+	}
+
+	if (spr->format != cfg->fb->fmt.format) {
+		return INKY_E_NOT_AVAILABLE;
+	}
+
+	bpp = INKY_FB_BPP(cfg->fb);
+
+	/* Clip rectangle inside the framebuffer */
+	cx1 = INKY_FB_WIDTH(cfg->fb);
+	cy1 = INKY_FB_HEIGHT(cfg->fb);
+
+	if (clip) {
+		cx0 = clip->x > 0 ? clip->x : 0;
+		cy0 = clip->y > 0 ? clip->y : 0;
+
+		if (clip->x + clip->w < cx1) {
+			cx1 = clip->x + clip->w;
+		}
+
+		if (clip->y + clip->h < cy1) {
+			cy1 = clip->y + clip->h;
+		}
+	}
+
+	if (x + spr->width <= cx0 || x >= cx1 ||
+	    y + spr->height <= cy0 || y >= cy1 || cx0 >= cx1) {
+		return INKY_OK;
+	}
+
+	/*
+	 * Byte of the framebuffer row holding sprite byte 0, and the
+	 * phase of x within it. Floor division keeps both right for
+	 * negative x.
+	 */
+	start = (INT32_t) x * bpp;
+	phase = (UINT8_t) (((start % 8) + 8) % 8 / bpp);
+	start = (start - (INT32_t) phase * bpp) / 8;
+
+	/* Bytes of the sprite row inside the clip, and the bits of the
+	 * two edge bytes that are */
+	first = cx0 * bpp / 8 - start;
+	last = (cx1 * bpp + 7) / 8 - start;
+	lo_mask = (UINT8_t) (0xff << (cx0 * bpp % 8));
+	hi_mask = (cx1 * bpp % 8) ? (UINT8_t) ~(0xff << (cx1 * bpp % 8)) :
+		0xff;
+
+	if (first < 0) {
+		first = 0;
+		lo_mask = 0xff;
+	}
+
+	if (last > (INT32_t) spr->stride) {
+		last = spr->stride;
+		hi_mask = 0xff;
+	}
+
+	row_first = cy0 > y ? cy0 - y : 0;
+	row_last = cy1 - y < spr->height ? cy1 - y : spr->height;
+
+	for (INT32_t j = row_first; j < row_last; j++) {
+		UINT32_t off = ((UINT32_t) phase * spr->height + j) *
+			spr->stride;
+		const UINT8_t *px = &spr->pixels[off];
+		const UINT8_t *mask = &spr->mask[off];
+		UINT8_t *row = &cfg->fb->buffer[INKY_FB_STRIDE(cfg->fb) *
+						 (y + j)];
+
+		for (INT32_t k = first; k < last; k++) {
+			UINT8_t *b = &row[start + k];
+			UINT8_t m = mask[k];
+
+			if (k == first) {
+				m = m & lo_mask;
+			}
+
+			if (k == last - 1) {
+				m = m & hi_mask;
+			}
+
+			*b = (*b & ~m) | (px[k] & m);
+		}
+	}
+
+	/* The box of the sprite left inside the clip */
+	box.x = (UINT16_t) (x > cx0 ? x : cx0);
+	box.y = (UINT16_t) (y + row_first);
+	box.w = (UINT16_t) ((x + spr->width < cx1 ? x + spr->width : cx1) -
+			    box.x);
+	box.h = (UINT16_t) (row_last - row_first);
+
+	return inky_fb_mark_dirty(cfg, &box);
+}
+
+inky_error_state inky_fb_copy_rect(inky_config *cfg, const inky_rect *src,
+				   INT16_t dx, INT16_t dy)
+{
+	inky_error_state ret;
+	inky_rect d;
+	UINT16_t sx;
+	UINT16_t sy;
+	INT32_t w;
+	INT32_t h;
+
+	if ((ret = pixfmt_fb_check(cfg->fb)) != INKY_OK) {
+		return ret;
+	}
+
+	if (!src) {
+		return INKY_E_NULL_PTR;
+	}
+
+	if (src->x + src->w > INKY_FB_WIDTH(cfg->fb) ||
+	    src->y + src->h > INKY_FB_HEIGHT(cfg->fb)) {
+		return INKY_E_OUT_OF_RANGE;
+	}
+
+	/* Clip the destination, trimming the source to match */
+	sx = src->x;
+	sy = src->y;
+	w = src->w;
+	h = src->h;
+
+	if (dx < 0) {
+		sx = sx - dx;
+		w = w + dx;
+		dx = 0;
+	}
+
+	if (dy < 0) {
+		sy = sy - dy;
+		h = h + dy;
+		dy = 0;
+	}
+
+	if (dx + w > INKY_FB_WIDTH(cfg->fb)) {
+		w = INKY_FB_WIDTH(cfg->fb) - dx;
+	}
+
+	if (dy + h > INKY_FB_HEIGHT(cfg->fb)) {
+		h = INKY_FB_HEIGHT(cfg->fb) - dy;
+	}
+
+	if (w <= 0 || h <= 0) {
+		return INKY_OK;
+	}
+
+	_move_rect(cfg->fb, sx, sy, w, h, dx, dy);
+
+	d.x = dx;
+	d.y = dy;
+	d.w = w;
+	d.h = h;
+
+	return inky_fb_mark_dirty(cfg, &d);
+}
+
+inky_error_state inky_fb_scroll(inky_config *cfg, const inky_rect *area,
+				INT16_t dx, INT16_t dy, inky_color fill)
+{
+	inky_error_state ret;
+	UINT8_t code;
+	UINT16_t adx = dx < 0 ? -dx : dx;
+	UINT16_t ady = dy < 0 ? -dy : dy;
+
+	if ((ret = pixfmt_fb_check(cfg->fb)) != INKY_OK) {
+		return ret;
+	}
+
+	if (!area) {
+		return INKY_E_NULL_PTR;
+	}
+
+	if (area->x + area->w > INKY_FB_WIDTH(cfg->fb) ||
+	    area->y + area->h > INKY_FB_HEIGHT(cfg->fb)) {
+		return INKY_E_OUT_OF_RANGE;
+	}
+
+	if (!inky_color_available(cfg, fill)) {
+		return INKY_E_NOT_AVAILABLE;
+	}
+
+	code = inky_pixfmt_encode(INKY_FB_BPP(cfg->fb), fill) &
+		cfg->fb->fmt.mask;
+
+	/* Everything scrolls out of view */
+	if (adx >= area->w || ady >= area->h) {
+		_fill_rect(cfg->fb, area->x, area->y, area->w, area->h, code);
+		return inky_fb_mark_dirty(cfg, area);
+	}
+
+	_move_rect(cfg->fb, dx < 0 ? area->x + adx : area->x,
+		   dy < 0 ? area->y + ady : area->y,
+		   area->w - adx, area->h - ady,
+		   dx > 0 ? area->x + adx : area->x,
+		   dy > 0 ? area->y + ady : area->y);
+
+	/* Fill the rows, then the columns, left behind */
+	_fill_rect(cfg->fb, area->x,
+		   dy > 0 ? area->y : area->y + area->h - ady,
+		   area->w, ady, code);
+	_fill_rect(cfg->fb, dx > 0 ? area->x : area->x + area->w - adx,
+		   area->y, adx, area->h, code);
+
+	return inky_fb_mark_dirty(cfg, area);
+}
+
+/*
+**********************************************************************
+************************* INTERNAL API *******************************
+**********************************************************************
+*/
+
+static inky_error_state _bitmap_check(const inky_bitmap *src)
+{
+	UINT32_t bits;
+
+	if (!src->data) {
+		return INKY_E_NULL_PTR;
+	}
+
+	switch (src->type) {
+	case INKY_BITMAP_MASK:
+	case INKY_BITMAP_PLANAR:
+		bits = src->width;
+		break;
+	case INKY_BITMAP_PACKED:
+		if (!pixfmt_describe(src->format)) {
+			return INKY_E_NOT_AVAILABLE;
+		}
+
+		bits = (UINT32_t) src->width * pixfmt_describe(src->format)->bpp;
+		break;
+	default:
+		return INKY_E_NOT_AVAILABLE;
+	}
+
+	if (src->stride < (bits + 7) / 8) {
+		return INKY_E_OUT_OF_RANGE;
+	}
+
+	return INKY_OK;
+}
+
+static inky_error_state _bitmap_area(const inky_bitmap *src,
+				     const inky_rect *area, inky_rect *r)
+{
+	inky_error_state ret;
+
+	ret = _bitmap_check(src);
+
+	if (ret != INKY_OK) {
+		return ret;
+	}
+
+	if (area) {
+		*r = *area;
+	} else {
+		r->x = 0;
+		r->y = 0;
+		r->w = src->width;
+		r->h = src->height;
+	}
+
+	if ((UINT32_t) r->x + r->w > src->width ||
+	    (UINT32_t) r->y + r->h > src->height) {
+		return INKY_E_OUT_OF_RANGE;
+	}
+
+	return INKY_OK;
+}
+
+static inky_error_state _sprite_build(inky_config *cfg, inky_sprite *spr,
+				      const inky_bitmap *src,
+				      const inky_rect *r, inky_color fg,
+				      const inky_color *key, UINT8_t shaped,
+				      const inky_color *bg)
+{
+	UINT8_t bpp = INKY_FB_BPP(cfg->fb);
+	UINT8_t key_code = 0;
+	UINT8_t fg_code = inky_pixfmt_encode(bpp, fg) & cfg->fb->fmt.mask;
+	UINT8_t bg_code = 0;
+	UINT32_t size;
+
+	if (key) {
+		key_code = inky_pixfmt_encode(bpp, *key) & cfg->fb->fmt.mask;
+	}
+
+	if (bg) {
+		bg_code = inky_pixfmt_encode(bpp, *bg) & cfg->fb->fmt.mask;
+	}
+
+	spr->width = r->w;
+	spr->height = r->h;
+	spr->format = cfg->fb->fmt.format;
+	spr->phases = 8 / bpp;
+
+	/* Room for the widest phase, which starts 8 - bpp bits in */
+	spr->stride = ((UINT32_t) r->w * bpp + 8 - bpp + 7) / 8;
+
+	size = (UINT32_t) spr->phases * spr->height * spr->stride;
+
+	spr->pixels = calloc(2, size ? size : 1);
+
+	if (!spr->pixels) {
+		spr->mask = NULL;
+		return INKY_E_OUT_OF_MEMORY;
+	}
+
+	spr->mask = &spr->pixels[size];
+
+	for (UINT8_t p = 0; p < spr->phases; p++) {
+		for (UINT16_t j = 0; j < r->h; j++) {
+			UINT32_t off = ((UINT32_t) p * r->h + j) * spr->stride;
+			UINT8_t *row = &spr->pixels[off];
+			UINT8_t *mask = &spr->mask[off];
+			UINT32_t bit = (UINT32_t) p * bpp;
+
+			/* Shaped by the mask: set bits fg, clear bits bg
+			 * or transparent */
+			if (shaped) {
+				const UINT8_t *bits = &src->data[src->stride *
+								 (r->y + j)];
+
+				for (UINT16_t i = 0; i < r->w; i++) {
+					UINT32_t b = bit + (UINT32_t) i * bpp;
+
+					if (pixfmt_read_bits(bits, r->x + i, 1)) {
+						row[b / 8] |= fg_code << (b % 8);
+					} else if (bg) {
+						row[b / 8] |= bg_code << (b % 8);
+					} else {
+						continue;
+					}
+
+					pixfmt_fill_bits(mask, b, b + bpp, 0xff);
+				}
+
+				continue;
+			}
+
+			_convert_row(cfg, src, r->x, r->y + j, r->w, row, bit,
+				     fg);
+
+			if (!key) {
+				pixfmt_fill_bits(mask, bit,
+						 bit + (UINT32_t) r->w * bpp, 0xff);
+				continue;
+			}
+
+			for (UINT16_t i = 0; i < r->w; i++) {
+				UINT32_t b = bit + (UINT32_t) i * bpp;
+
+				if (pixfmt_read_bits(row, b, bpp) != key_code) {
+					pixfmt_fill_bits(mask, b, b + bpp, 0xff);
+				}
+			}
+		}
+	}
+
+	return INKY_OK;
+}
+
+static inky_color _bitmap_color(const inky_bitmap *src,
+				const inky_pixfmt *fmt,
+				const inky_color_config *color, UINT16_t x,
+				UINT16_t y, inky_color fg)
+{
+	const UINT8_t *data = &src->data[src->stride * y];
+	UINT8_t bit = 0x80 >> (x % 8);
+
+	switch (src->type) {
+	case INKY_BITMAP_MASK:
+		return pixfmt_read_bits(data, x, 1) ? fg : INKY_COLOR_WHITE;
+	case INKY_BITMAP_PLANAR:
+		if (src->color && (src->color[src->stride * y + x / 8] & bit)) {
+			return (color && color->yellow) ? INKY_COLOR_YELLOW :
+				INKY_COLOR_RED;
+		}
+
+		return (data[x / 8] & bit) ? INKY_COLOR_WHITE :
+			INKY_COLOR_BLACK;
+	default:
+		return pixfmt_decode(fmt, color,
+				     (UINT8_t) pixfmt_read_bits(data,
+								(UINT32_t) x *
+								fmt->bpp,
+								fmt->bpp));
+	}
+}
+
+static void _convert_row(const inky_config *cfg, const inky_bitmap *src,
+			 UINT16_t sx, UINT16_t sy, UINT16_t n,
+			 UINT8_t *dst, UINT32_t dbit, inky_color fg)
+{
+	const inky_pixfmt *dfmt = &cfg->fb->fmt;
+	const inky_pixfmt *sfmt = NULL;
+	UINT8_t bpp = INKY_FB_BPP(cfg->fb);
+
+	if (src->type == INKY_BITMAP_PACKED) {
+		sfmt = pixfmt_describe(src->format);
+
+		/* Same format: shift and merge whole bytes */
+		if (sfmt->format == dfmt->format) {
+			pixfmt_copy_bits(dst, dbit,
+					 &src->data[src->stride * sy],
+					 (UINT32_t) sx * bpp,
+					 (UINT32_t) n * bpp);
+			return;
+		}
+	}
+
+	/* A black mask on a 1bpp framebuffer is already in its format */
+	if (src->type == INKY_BITMAP_MASK && bpp == 1) {
+		if (inky_pixfmt_encode(bpp, fg)) {
+			pixfmt_copy_bits(dst, dbit,
+					 &src->data[src->stride * sy], sx, n);
+		}
+
+		return;
+	}
+
+	for (UINT16_t i = 0; i < n; i++) {
+		inky_color c;
+		UINT32_t bit = dbit + (UINT32_t) i * bpp;
+
+		c = _bitmap_color(src, sfmt, cfg->color, sx + i, sy, fg);
+
+		dst[bit / 8] = dst[bit / 8] |
+			((inky_pixfmt_encode(bpp, c) & dfmt->mask) << (bit % 8));
+	}
+}
+
+static void _move_rect(inky_fb *fb, UINT16_t sx, UINT16_t sy, UINT16_t w,
+		       UINT16_t h, UINT16_t dx, UINT16_t dy)
+{
+	UINT8_t bpp = INKY_FB_BPP(fb);
+	UINT32_t stride = INKY_FB_STRIDE(fb);
+	UINT32_t n = (UINT32_t) w * bpp;
+
+	if (w == 0 || h == 0 || (sx == dx && sy == dy)) {
+		return;
+	}
+
+	/* Whole rows are one contiguous block, padding included */
+	if (sx == 0 && dx == 0 && w == INKY_FB_WIDTH(fb)) {
+		memmove(&fb->buffer[stride * dy], &fb->buffer[stride * sy],
+			stride * h);
+		return;
+	}
+
+	for (UINT16_t i = 0; i < h; i++) {
+		/* Work away from the destination so no source row is
+		 * overwritten before it is read */
+		UINT16_t j = dy > sy ? h - 1 - i : i;
+		UINT8_t *dst = &fb->buffer[stride * (dy + j)];
+		const UINT8_t *src = &fb->buffer[stride * (sy + j)];
+
+		if (dy != sy) {
+			pixfmt_copy_bits(dst, (UINT32_t) dx * bpp, src,
+					 (UINT32_t) sx * bpp, n);
+			continue;
+		}
+
+		/* Within one row, go through a copy so overlapping bits
+		 * are read before they are written */
+		{
+			UINT8_t tmp[stride + 1];
+			UINT32_t phase = ((UINT32_t) dx * bpp) % 8;
+
+			pixfmt_copy_bits(tmp, phase, src,
+					 (UINT32_t) sx * bpp, n);
+			pixfmt_copy_bits(dst, (UINT32_t) dx * bpp, tmp, phase,
+					 n);
+		}
+	}
+}
+
+static void _fill_rect(inky_fb *fb, UINT16_t x, UINT16_t y, UINT16_t w,
+		       UINT16_t h, UINT8_t code)
+{
+	const pixfmt_ops *ops = pixfmt_get_ops(&fb->fmt);
+
+	if (w == 0) {
+		return;
+	}
+
+	for (UINT16_t j = y; j < y + h; j++) {
+		ops->fill(&fb->buffer[INKY_FB_STRIDE(fb) * j], x, w, code);
+	}
+}
@@ -0,0 +1,232 @@
+#include "pixfmt.h"
+
+#include <inky-convert.h>
+
+#include <stdlib.h>
+
+/*
+**********************************************************************
+*********************** Convert Definitions **************************
+**********************************************************************
+*/
+
+/** @brief Convert n pixels of one source row, from pixel i0 */
+static void _convert_row(const inky_convert *cv, inky_convert_format format,
+			 const UINT8_t *row, UINT32_t i0, UINT32_t n,
+			 pixfmt_writer *w);
+
+/** @brief Framebuffer code of an RGB565 value */
+static inline UINT8_t _rgb565(const inky_convert *cv, UINT16_t v);
+
+/** @brief Framebuffer code of 8 bit red, green and blue */
+static inline UINT8_t _rgb888(const inky_convert *cv, UINT8_t r, UINT8_t g,
+			      UINT8_t b);
+
+/** @brief Channel c blended at alpha a over white */
+static inline UINT8_t _over_white(UINT8_t c, UINT8_t a);
+
+/*
+**********************************************************************
+************************** API Functions *****************************
+**********************************************************************
+*/
+
+inky_error_state inky_convert_init(inky_config *cfg, inky_convert *cv)
+{
+	if (!cfg->fb) {
+		return INKY_E_NOT_CONFIGURED;
+	}
+
+	if (!cv) {
+		return INKY_E_NULL_PTR;
+	}
+
+	cv->n_colors = 0;
+
+	for (UINT8_t c = INKY_COLOR_WHITE; c <= INKY_COLOR_YELLOW; c++) {
+		if (!inky_color_available(cfg, (inky_color) c)) {
+			continue;
+		}
+
+		cv->colors[cv->n_colors] = (inky_color) c;
+		cv->codes[cv->n_colors] =
+			inky_pixfmt_encode(INKY_FB_BPP(cfg->fb),
+					   (inky_color) c) & cfg->fb->fmt.mask;
+		cv->n_colors++;
+	}
+
+	for (UINT16_t g = 0; g < 256; g++) {
+		cv->gray[g] = cv->codes[pixfmt_nearest(cv->colors, cv->n_colors,
+						       g, g, g)];
+	}
+
+	cv->lut = malloc(INKY_CONVERT_LUT_SIZE);
+
+	if (!cv->lut) {
+		return INKY_E_OUT_OF_MEMORY;
+	}
+
+	/* Each 5 or 6 bit channel stands for the 8 bit value it widens
+	 * to, its top bits repeated below it */
+	for (UINT32_t v = 0; v < 65536; v += 4) {
+		UINT8_t byte = 0;
+
+		for (UINT8_t k = 0; k < 4; k++) {
+			UINT8_t r = (v + k) >> 11;
+			UINT8_t g = ((v + k) >> 5) & 0x3f;
+			UINT8_t b = (v + k) & 0x1f;
+
+			byte |= pixfmt_nearest(cv->colors, cv->n_colors,
+					       (r << 3) | (r >> 2),
+					       (g << 2) | (g >> 4),
+					       (b << 3) | (b >> 2)) << (2 * k);
+		}
+
+		cv->lut[v / 4] = byte;
+	}
+
+	return INKY_OK;
+}
+
+void inky_convert_free(inky_convert *cv)
+{
+	if (cv) {
+		free(cv->lut);
+		cv->lut = NULL;
+	}
+}
+
+inky_error_state inky_convert_rect(inky_config *cfg, const inky_convert *cv,
+				   inky_convert_format format,
+				   const void *src, UINT32_t stride,
+				   UINT16_t w, UINT16_t h, INT16_t x,
+				   INT16_t y)
+{
+	inky_error_state ret;
+	inky_fb *fb = cfg->fb;
+	INT32_t i0, i1, j0, j1;
+	INT32_t x0 = 0x7fffffff;
+	INT32_t x1 = -1;
+	INT32_t y0 = -1;
+	INT32_t y1 = -1;
+
+	if ((ret = pixfmt_fb_check(fb)) != INKY_OK) {
+		return ret;
+	}
+
+	if (!cv || !cv->lut || (!src && w && h)) {
+		return INKY_E_NULL_PTR;
+	}
+
+	if (format > INKY_CONVERT_GRAY8) {
+		return INKY_E_OUT_OF_RANGE;
+	}
+
+	/* Columns and rows of the source inside the framebuffer */
+	i0 = x < 0 ? -x : 0;
+	i1 = INKY_FB_WIDTH(fb) - x;
+	i1 = i1 < w ? i1 : w;
+	j0 = y < 0 ? -y : 0;
+	j1 = INKY_FB_HEIGHT(fb) - y;
+	j1 = j1 < h ? j1 : h;
+
+	for (INT32_t j = j0; j < j1 && i0 < i1; j++) {
+		pixfmt_writer wr;
+
+		pixfmt_writer_begin(&wr,
+				    &fb->buffer[INKY_FB_STRIDE(fb) * (y + j)],
+				    x + i0, &fb->fmt);
+		_convert_row(cv, format, (const UINT8_t *) src + stride * j,
+			     i0, i1 - i0, &wr);
+		pixfmt_writer_end(&wr);
+
+		if (wr.first <= wr.last) {
+			x0 = x + i0 + (INT32_t) wr.first < x0 ?
+				x + i0 + (INT32_t) wr.first : x0;
+			x1 = x + i0 + (INT32_t) wr.last > x1 ?
+				x + i0 + (INT32_t) wr.last : x1;
+			y0 = y0 < 0 ? y + j : y0;
+			y1 = y + j;
+		}
+	}
+
+	if (y0 >= 0) {
+		inky_rect r;
+
+		r.x = x0;
+		r.y = y0;
+		r.w = x1 - x0 + 1;
+		r.h = y1 - y0 + 1;
+
+		inky_fb_mark_dirty(cfg, &r);
+	}
+
+	return INKY_OK;
+}
+
+/*
+**********************************************************************
+************************* INTERNAL API *******************************
+**********************************************************************
+*/
+
+static void _convert_row(const inky_convert *cv, inky_convert_format format,
+			 const UINT8_t *row, UINT32_t i0, UINT32_t n,
+			 pixfmt_writer *w)
+{
+	switch (format) {
+	case INKY_CONVERT_RGB888:
+		for (const UINT8_t *p = &row[3 * i0], *e = p + 3 * n; p < e;
+		     p += 3) {
+			pixfmt_writer_put(w, _rgb888(cv, p[0], p[1], p[2]));
+		}
+		break;
+
+	case INKY_CONVERT_RGB565:
+		for (const UINT16_t *p = (const UINT16_t *) row + i0,
+		     *e = p + n; p < e; p++) {
+			pixfmt_writer_put(w, _rgb565(cv, *p));
+		}
+		break;
+
+	case INKY_CONVERT_ARGB8888:
+		for (const UINT32_t *p = (const UINT32_t *) row + i0,
+		     *e = p + n; p < e; p++) {
+			UINT8_t a = *p >> 24;
+			UINT8_t r = *p >> 16;
+			UINT8_t g = *p >> 8;
+			UINT8_t b = *p;
+
+			if (a != 0xff) {
+				r = _over_white(r, a);
+				g = _over_white(g, a);
+				b = _over_white(b, a);
+			}
+
+			pixfmt_writer_put(w, _rgb888(cv, r, g, b));
+		}
+		break;
+
+	case INKY_CONVERT_GRAY8:
+		for (const UINT8_t *p = &row[i0], *e = p + n; p < e; p++) {
+			pixfmt_writer_put(w, cv->gray[*p]);
+		}
+		break;
+	}
+}
+
+static inline UINT8_t _rgb565(const inky_convert *cv, UINT16_t v)
+{
+	return cv->codes[(cv->lut[v >> 2] >> ((v & 3) * 2)) & 3];
+}
+
+static inline UINT8_t _rgb888(const inky_convert *cv, UINT8_t r, UINT8_t g,
+			      UINT8_t b)
+{
+	return _rgb565(cv, ((r >> 3) << 11) | ((g >> 2) << 5) | (b >> 3));
+}
+
+static inline UINT8_t _over_white(UINT8_t c, UINT8_t a)
+{
+	return (c * a + 255 * (255 - a) + 127) / 255;
+}
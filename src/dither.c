@@ -0,0 +1,395 @@
+#include "pixfmt.h"
+
+#include <inky-dither.h>
+
+#include <stdlib.h>
+#include <string.h>
+
+/*
+**********************************************************************
+*********************** Dither Definitions ***************************
+**********************************************************************
+*/
+
+/** @brief Ranks of the 8x8 Bayer matrix */
+static const UINT8_t _bayer[8][8] = {
+	{ 0, 32, 8, 40, 2, 34, 10, 42 },
+	{ 48, 16, 56, 24, 50, 18, 58, 26 },
+	{ 12, 44, 4, 36, 14, 46, 6, 38 },
+	{ 60, 28, 52, 20, 62, 30, 54, 22 },
+	{ 3, 35, 11, 43, 1, 33, 9, 41 },
+	{ 51, 19, 59, 27, 49, 17, 57, 25 },
+	{ 15, 47, 7, 39, 13, 45, 5, 37 },
+	{ 63, 31, 55, 23, 61, 29, 53, 21 },
+};
+
+/** @brief Thresholds of a 16x16 blue noise mask, made with the void and
+ * cluster method */
+static const UINT8_t _blue_noise[16][16] = {
+	{ 234, 50, 188, 19, 58, 171, 121, 47,
+	  163, 1, 247, 104, 22, 132, 14, 65 },
+	{ 209, 8, 118, 97, 240, 205, 23, 228,
+	  138, 64, 123, 170, 72, 224, 99, 149 },
+	{ 85, 139, 229, 165, 78, 146, 111, 84,
+	  176, 216, 30, 231, 153, 201, 42, 180 },
+	{ 25, 62, 195, 29, 43, 185, 7, 249,
+	  41, 100, 191, 48, 87, 5, 128, 243 },
+	{ 221, 152, 101, 253, 130, 220, 59, 200,
+	  156, 12, 136, 112, 254, 174, 69, 109 },
+	{ 46, 189, 0, 73, 172, 90, 142, 116,
+	  80, 237, 210, 61, 147, 33, 206, 160 },
+	{ 81, 124, 217, 113, 208, 15, 241, 27,
+	  168, 45, 178, 20, 193, 96, 225, 18 },
+	{ 242, 164, 60, 35, 157, 53, 181, 68,
+	  223, 105, 125, 83, 236, 131, 55, 141 },
+	{ 197, 10, 227, 134, 246, 95, 126, 198,
+	  148, 3, 244, 161, 71, 9, 182, 106 },
+	{ 40, 93, 179, 75, 192, 6, 218, 36,
+	  91, 57, 202, 34, 215, 155, 233, 74 },
+	{ 252, 120, 150, 24, 110, 63, 166, 119,
+	  232, 183, 133, 103, 49, 117, 31, 167 },
+	{ 16, 212, 51, 238, 207, 137, 255, 21,
+	  76, 151, 13, 250, 190, 88, 203, 135 },
+	{ 102, 184, 82, 169, 38, 89, 187, 52,
+	  204, 98, 173, 67, 129, 4, 222, 56 },
+	{ 230, 144, 2, 127, 226, 11, 154, 114,
+	  239, 39, 219, 28, 235, 145, 175, 77 },
+	{ 196, 37, 248, 70, 107, 199, 66, 177,
+	  17, 143, 115, 159, 86, 44, 108, 26 },
+	{ 122, 92, 158, 214, 140, 32, 245, 94,
+	  213, 79, 194, 54, 211, 186, 251, 162 },
+};
+
+/** @brief Threshold or ordered dithering of pixels i0 to i1 - 1 */
+static void _ordered(const inky_dither *d, const UINT8_t *rgb, INT32_t x,
+		     INT32_t y, INT32_t i0, INT32_t i1, pixfmt_writer *o);
+
+/** @brief Error diffusion of a whole row, writing pixels i0 to i1 - 1 */
+static void _diffuse(inky_dither *d, const UINT8_t *rgb, INT32_t i0,
+		     INT32_t i1, pixfmt_writer *o);
+
+/** @brief Index of the color to give a pixel of value v, prev the index
+ * of the color it has, -1 when it has none of d's colors */
+static UINT8_t _pick(const inky_dither *d, const UINT8_t *v, INT8_t prev);
+
+/** @brief Index of the color the next pixel of o has, -1 when it has
+ * none of d's colors or d keeps no colors */
+static INT8_t _prev(const inky_dither *d, const pixfmt_writer *o);
+
+/** @brief a / 16 rounded to the nearest, halves up */
+static inline INT32_t _round16(INT32_t a);
+
+static inline UINT8_t _clamp(INT32_t v);
+
+/*
+**********************************************************************
+************************** API Functions *****************************
+**********************************************************************
+*/
+
+inky_error_state inky_dither_init(inky_config *cfg, inky_dither *d,
+				  inky_dither_mode mode, UINT16_t width)
+{
+	if (!cfg->fb) {
+		return INKY_E_NOT_CONFIGURED;
+	}
+
+	if (!d) {
+		return INKY_E_NULL_PTR;
+	}
+
+	if (mode > INKY_DITHER_ATKINSON || width == 0) {
+		return INKY_E_OUT_OF_RANGE;
+	}
+
+	d->mode = mode;
+	d->width = width;
+	d->n_colors = 0;
+	d->hysteresis = 0;
+	d->err = NULL;
+	d->cur = 0;
+
+	for (UINT8_t c = INKY_COLOR_WHITE; c <= INKY_COLOR_YELLOW; c++) {
+		if (!inky_color_available(cfg, (inky_color) c)) {
+			continue;
+		}
+
+		d->colors[d->n_colors] = (inky_color) c;
+		d->codes[d->n_colors] =
+			inky_pixfmt_encode(INKY_FB_BPP(cfg->fb),
+					   (inky_color) c) & cfg->fb->fmt.mask;
+		d->n_colors++;
+	}
+
+	if (mode >= INKY_DITHER_FLOYD_STEINBERG) {
+		d->err = calloc(2 * ((UINT32_t) width + 2) * 3,
+				sizeof(*d->err));
+
+		if (!d->err) {
+			return INKY_E_OUT_OF_MEMORY;
+		}
+	}
+
+	return INKY_OK;
+}
+
+void inky_dither_free(inky_dither *d)
+{
+	if (d) {
+		free(d->err);
+		d->err = NULL;
+	}
+}
+
+inky_error_state inky_dither_row(inky_config *cfg, inky_dither *d,
+				 const UINT8_t *rgb, INT16_t x, INT16_t y)
+{
+	inky_error_state ret;
+	inky_fb *fb = cfg->fb;
+	INT32_t i0, i1;
+	pixfmt_writer o;
+
+	if ((ret = pixfmt_fb_check(fb)) != INKY_OK) {
+		return ret;
+	}
+
+	if (!d || !rgb) {
+		return INKY_E_NULL_PTR;
+	}
+
+	if (d->mode >= INKY_DITHER_FLOYD_STEINBERG && !d->err) {
+		return INKY_E_NULL_PTR;
+	}
+
+	/* Columns of the row inside the framebuffer */
+	i0 = x < 0 ? -x : 0;
+	i1 = INKY_FB_WIDTH(fb) - x;
+	i1 = i1 < d->width ? i1 : d->width;
+
+	if (y < 0 || y >= INKY_FB_HEIGHT(fb) || i0 >= i1) {
+		i0 = 0;
+		i1 = 0;
+		pixfmt_writer_begin(&o, fb->buffer, 0, &fb->fmt);
+	} else {
+		pixfmt_writer_begin(&o, &fb->buffer[INKY_FB_STRIDE(fb) * y],
+				    x + i0, &fb->fmt);
+	}
+
+	if (d->mode >= INKY_DITHER_FLOYD_STEINBERG) {
+		/* Hidden pixels still pass their error on */
+		_diffuse(d, rgb, i0, i1, &o);
+	} else {
+		_ordered(d, rgb, x, y, i0, i1, &o);
+	}
+
+	pixfmt_writer_end(&o);
+
+	if (o.first <= o.last) {
+		inky_rect r;
+
+		r.x = x + i0 + o.first;
+		r.y = y;
+		r.w = o.last - o.first + 1;
+		r.h = 1;
+
+		inky_fb_mark_dirty(cfg, &r);
+	}
+
+	return INKY_OK;
+}
+
+inky_error_state inky_dither_image(inky_config *cfg, inky_image *img,
+				   INT16_t x, INT16_t y,
+				   inky_dither_mode mode, UINT8_t hysteresis)
+{
+	inky_error_state ret;
+	inky_dither d;
+	UINT8_t *rgb;
+	UINT16_t row;
+
+	if (!img) {
+		return INKY_E_NULL_PTR;
+	}
+
+	ret = inky_dither_init(cfg, &d, mode, img->width);
+
+	if (ret != INKY_OK) {
+		return ret;
+	}
+
+	d.hysteresis = hysteresis;
+
+	rgb = malloc((UINT32_t) img->width * 3);
+
+	if (!rgb) {
+		inky_dither_free(&d);
+		return INKY_E_OUT_OF_MEMORY;
+	}
+
+	/* Rows outside the framebuffer are still decoded and, for error
+	 * diffusion, dithered */
+	while ((ret = inky_image_read_row(img, rgb, &row)) == INKY_OK) {
+		INT32_t fy = y + row;
+
+		if (fy > 0x7fff) {
+			continue;
+		}
+
+		ret = inky_dither_row(cfg, &d, rgb, x, (INT16_t) fy);
+
+		if (ret != INKY_OK) {
+			break;
+		}
+	}
+
+	free(rgb);
+	inky_dither_free(&d);
+
+	return ret == INKY_E_OUT_OF_RANGE ? INKY_OK : ret;
+}
+
+/*
+**********************************************************************
+************************* INTERNAL API *******************************
+**********************************************************************
+*/
+
+static void _ordered(const inky_dither *d, const UINT8_t *rgb, INT32_t x,
+		     INT32_t y, INT32_t i0, INT32_t i1, pixfmt_writer *o)
+{
+	/* Masks repeat, so the low bits of the position index them
+	 * whatever its sign */
+	UINT32_t my = (UINT32_t) y;
+
+	for (INT32_t i = i0; i < i1; i++) {
+		const UINT8_t *p = &rgb[3 * i];
+		UINT32_t mx = (UINT32_t) (x + i);
+		INT32_t t = 0;
+		UINT8_t v[3];
+
+		if (d->mode == INKY_DITHER_BAYER) {
+			t = _bayer[my % 8][mx % 8] * 4 + 2 - 128;
+		} else if (d->mode == INKY_DITHER_BLUE_NOISE) {
+			t = _blue_noise[my % 16][mx % 16] - 128;
+		}
+
+		for (UINT8_t ch = 0; ch < 3; ch++) {
+			v[ch] = _clamp(p[ch] + t);
+		}
+
+		pixfmt_writer_put(o, d->codes[_pick(d, v, _prev(d, o))]);
+	}
+}
+
+static void _diffuse(inky_dither *d, const UINT8_t *rgb, INT32_t i0,
+		     INT32_t i1, pixfmt_writer *o)
+{
+	UINT32_t len = ((UINT32_t) d->width + 2) * 3;
+	INT16_t *cur = &d->err[d->cur * len];
+	INT16_t *next = &d->err[(d->cur ^ 1) * len];
+	UINT8_t atkinson = d->mode == INKY_DITHER_ATKINSON;
+	/* Error for the next two pixels of this row */
+	INT32_t c1[3] = { 0, 0, 0 };
+	INT32_t c2[3] = { 0, 0, 0 };
+
+	for (INT32_t i = 0; i < d->width; i++) {
+		/* Entries are offset by one so i - 1 is never out of the
+		 * row */
+		INT16_t *e = &cur[(i + 1) * 3];
+		INT16_t *n = &next[(i + 1) * 3];
+		UINT8_t v[3];
+		const UINT8_t *p;
+		UINT8_t k;
+
+		for (UINT8_t ch = 0; ch < 3; ch++) {
+			v[ch] = _clamp(rgb[3 * i + ch] +
+				       _round16(e[ch] + c1[ch]));
+		}
+
+		/* Hidden pixels have no color to keep */
+		if (i >= i0 && i < i1) {
+			k = _pick(d, v, _prev(d, o));
+			pixfmt_writer_put(o, d->codes[k]);
+		} else {
+			k = _pick(d, v, -1);
+		}
+
+		p = pixfmt_color_rgb(d->colors[k]);
+
+		/* Weights in sixteenths. This row's entry of cur is used
+		 * up, Atkinson reuses it for the row after next */
+		for (UINT8_t ch = 0; ch < 3; ch++) {
+			INT32_t err = (INT32_t) v[ch] - p[ch];
+
+			if (atkinson) {
+				c1[ch] = c2[ch] + 2 * err;
+				c2[ch] = 2 * err;
+				n[ch - 3] += 2 * err;
+				n[ch] += 2 * err;
+				n[ch + 3] += 2 * err;
+				e[ch] = 2 * err;
+			} else {
+				c1[ch] = 7 * err;
+				n[ch - 3] += 3 * err;
+				n[ch] += 5 * err;
+				n[ch + 3] += err;
+				e[ch] = 0;
+			}
+		}
+	}
+
+	/* Error pushed past either end of this row is dropped */
+	memset(cur, 0, 3 * sizeof(*cur));
+	memset(&cur[len - 3], 0, 3 * sizeof(*cur));
+	memset(next, 0, 3 * sizeof(*next));
+	memset(&next[len - 3], 0, 3 * sizeof(*next));
+
+	d->cur ^= 1;
+}
+
+static UINT8_t _pick(const inky_dither *d, const UINT8_t *v, INT8_t prev)
+{
+	UINT8_t k = pixfmt_nearest(d->colors, d->n_colors, v[0], v[1], v[2]);
+
+	/* Moving a gray h levels past the midpoint of black and white
+	 * brings it 18 * 255 * h closer to the far one */
+	if (prev >= 0 && prev != k &&
+	    pixfmt_distance(d->colors[prev], v[0], v[1], v[2]) <=
+	    pixfmt_distance(d->colors[k], v[0], v[1], v[2]) +
+	    (UINT32_t) d->hysteresis * 18 * 255) {
+		return (UINT8_t) prev;
+	}
+
+	return k;
+}
+
+static INT8_t _prev(const inky_dither *d, const pixfmt_writer *o)
+{
+	UINT8_t code;
+
+	if (!d->hysteresis) {
+		return -1;
+	}
+
+	code = pixfmt_writer_get(o);
+
+	for (UINT8_t k = 0; k < d->n_colors; k++) {
+		if (d->codes[k] == code) {
+			return (INT8_t) k;
+		}
+	}
+
+	return -1;
+}
+
+static inline INT32_t _round16(INT32_t a)
+{
+	a += 8;
+
+	return a >= 0 ? a / 16 : -((15 - a) / 16);
+}
+
+static inline UINT8_t _clamp(INT32_t v)
+{
+	return v < 0 ? 0 : v > 255 ? 255 : (UINT8_t) v;
+}
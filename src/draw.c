@@ -0,0 +1,675 @@
+#include "pixfmt.h"
+
+#include <inky-draw.h>
+
+/*
+**********************************************************************
+************************ Draw Definitions ****************************
+**********************************************************************
+*/
+
+/** @brief State of one primitive: where it may draw, how, and the
+ * bounds of what it drew so far (x0 > x1 while nothing) */
+typedef struct _pennode {
+	inky_fb *fb;
+	const pixfmt_ops *ops;
+	INT32_t cx0;
+	INT32_t cy0;
+	INT32_t cx1;
+	INT32_t cy1;
+	UINT8_t code;
+	INT32_t x0;
+	INT32_t y0;
+	INT32_t x1;
+	INT32_t y1;
+} _pen;
+
+/** @brief Box with elliptical corners of radius rx across and ry down.
+ * An ellipse is a box of 2rx + 1 by 2ry + 1 */
+typedef struct _shapenode {
+	INT32_t x;
+	INT32_t y;
+	INT32_t w;
+	INT32_t h;
+	UINT16_t rx;
+	UINT16_t ry;
+} _shape;
+
+/** @brief Check the arguments shared by every primitive and set up
+ * pen for the top clip of draw */
+static inky_error_state _pen_begin(inky_config *cfg, const inky_draw *draw,
+				   inky_color c, _pen *pen);
+
+/** @brief Mark what pen drew dirty */
+static inky_error_state _pen_end(inky_config *cfg, const _pen *pen);
+
+/** @brief Rounded rectangle, filled or outlined */
+static inky_error_state _round_rect(inky_config *cfg,
+				     const inky_draw *draw, INT16_t x,
+				     INT16_t y, UINT16_t w, UINT16_t h,
+				     UINT16_t r, inky_color c, UINT8_t fill);
+
+/** @brief Ellipse, filled or outlined */
+static inky_error_state _ellipse(inky_config *cfg, const inky_draw *draw,
+				 INT16_t cx, INT16_t cy, UINT16_t rx,
+				 UINT16_t ry, inky_color c, UINT8_t fill);
+
+/** @brief Set pixels x0 to x1 of row y, in either order, inside the
+ * clip */
+static void _span(_pen *pen, INT32_t x0, INT32_t x1, INT32_t y);
+
+static void _line(_pen *pen, INT32_t x0, INT32_t y0, INT32_t x1,
+		  INT32_t y1);
+
+/** @brief First and last pixel of row j of a shape */
+static void _shape_row(const _shape *s, INT32_t j, INT32_t *l, INT32_t *r);
+
+/** @brief Draw a shape filled, or as the pixels of it next to a pixel
+ * outside it */
+static void _shape_draw(_pen *pen, const _shape *s, UINT8_t fill);
+
+/** @brief Largest dx with dx, dy inside an ellipse of radii rx, ry */
+static UINT16_t _ellipse_half(UINT16_t rx, UINT16_t ry, UINT16_t dy);
+
+/** @brief a / b rounded up, for b > 0 */
+static INT64_t _ceil_div(INT64_t a, INT64_t b);
+
+/*
+**********************************************************************
+************************** API Functions *****************************
+**********************************************************************
+*/
+
+inky_error_state inky_draw_init(inky_config *cfg, inky_draw *draw)
+{
+	if (!cfg->fb) {
+		return INKY_E_NOT_CONFIGURED;
+	}
+
+	if (!draw) {
+		return INKY_E_NULL_PTR;
+	}
+
+	draw->clip[0].x = 0;
+	draw->clip[0].y = 0;
+	draw->clip[0].w = INKY_FB_WIDTH(cfg->fb);
+	draw->clip[0].h = INKY_FB_HEIGHT(cfg->fb);
+	draw->depth = 1;
+
+	return INKY_OK;
+}
+
+inky_error_state inky_draw_push_clip(inky_draw *draw, const inky_rect *area)
+{
+	const inky_rect *top;
+	inky_rect *r;
+	UINT32_t x0, y0, x1, y1;
+
+	if (!draw || !area) {
+		return INKY_E_NULL_PTR;
+	}
+
+	if (draw->depth == 0 || draw->depth >= INKY_DRAW_MAX_CLIP) {
+		return INKY_E_OUT_OF_RANGE;
+	}
+
+	top = &draw->clip[draw->depth - 1];
+	r = &draw->clip[draw->depth];
+
+	x0 = area->x > top->x ? area->x : top->x;
+	y0 = area->y > top->y ? area->y : top->y;
+	x1 = (UINT32_t) area->x + area->w;
+	y1 = (UINT32_t) area->y + area->h;
+
+	if (x1 > (UINT32_t) top->x + top->w) {
+		x1 = top->x + top->w;
+	}
+
+	if (y1 > (UINT32_t) top->y + top->h) {
+		y1 = top->y + top->h;
+	}
+
+	r->x = x0;
+	r->y = y0;
+	r->w = x1 > x0 && y1 > y0 ? x1 - x0 : 0;
+	r->h = x1 > x0 && y1 > y0 ? y1 - y0 : 0;
+
+	draw->depth++;
+
+	return INKY_OK;
+}
+
+inky_error_state inky_draw_pop_clip(inky_draw *draw)
+{
+	if (!draw) {
+		return INKY_E_NULL_PTR;
+	}
+
+	if (draw->depth <= 1) {
+		return INKY_E_OUT_OF_RANGE;
+	}
+
+	draw->depth--;
+
+	return INKY_OK;
+}
+
+inky_error_state inky_draw_line(inky_config *cfg, const inky_draw *draw,
+				INT16_t x0, INT16_t y0, INT16_t x1,
+				INT16_t y1, inky_color c)
+{
+	inky_error_state ret;
+	_pen pen;
+
+	ret = _pen_begin(cfg, draw, c, &pen);
+
+	if (ret != INKY_OK) {
+		return ret;
+	}
+
+	_line(&pen, x0, y0, x1, y1);
+
+	return _pen_end(cfg, &pen);
+}
+
+inky_error_state inky_draw_rect(inky_config *cfg, const inky_draw *draw,
+				INT16_t x, INT16_t y, UINT16_t w,
+				UINT16_t h, inky_color c)
+{
+	return inky_draw_round_rect(cfg, draw, x, y, w, h, 0, c);
+}
+
+inky_error_state inky_draw_fill_rect(inky_config *cfg,
+				     const inky_draw *draw, INT16_t x,
+				     INT16_t y, UINT16_t w, UINT16_t h,
+				     inky_color c)
+{
+	inky_error_state ret;
+	_pen pen;
+
+	ret = _pen_begin(cfg, draw, c, &pen);
+
+	if (ret != INKY_OK) {
+		return ret;
+	}
+
+	if (w > 0) {
+		for (INT32_t j = 0; j < h; j++) {
+			_span(&pen, x, x + w - 1, y + j);
+		}
+	}
+
+	return _pen_end(cfg, &pen);
+}
+
+inky_error_state inky_draw_round_rect(inky_config *cfg,
+				      const inky_draw *draw, INT16_t x,
+				      INT16_t y, UINT16_t w, UINT16_t h,
+				      UINT16_t r, inky_color c)
+{
+	return _round_rect(cfg, draw, x, y, w, h, r, c, 0);
+}
+
+inky_error_state inky_draw_fill_round_rect(inky_config *cfg,
+					   const inky_draw *draw, INT16_t x,
+					   INT16_t y, UINT16_t w, UINT16_t h,
+					   UINT16_t r, inky_color c)
+{
+	return _round_rect(cfg, draw, x, y, w, h, r, c, 1);
+}
+
+inky_error_state inky_draw_ellipse(inky_config *cfg, const inky_draw *draw,
+				   INT16_t cx, INT16_t cy, UINT16_t rx,
+				   UINT16_t ry, inky_color c)
+{
+	return _ellipse(cfg, draw, cx, cy, rx, ry, c, 0);
+}
+
+inky_error_state inky_draw_fill_ellipse(inky_config *cfg,
+					const inky_draw *draw, INT16_t cx,
+					INT16_t cy, UINT16_t rx, UINT16_t ry,
+					inky_color c)
+{
+	return _ellipse(cfg, draw, cx, cy, rx, ry, c, 1);
+}
+
+inky_error_state inky_draw_circle(inky_config *cfg, const inky_draw *draw,
+				  INT16_t cx, INT16_t cy, UINT16_t r,
+				  inky_color c)
+{
+	return inky_draw_ellipse(cfg, draw, cx, cy, r, r, c);
+}
+
+inky_error_state inky_draw_fill_circle(inky_config *cfg,
+				       const inky_draw *draw, INT16_t cx,
+				       INT16_t cy, UINT16_t r, inky_color c)
+{
+	return inky_draw_fill_ellipse(cfg, draw, cx, cy, r, r, c);
+}
+
+inky_error_state inky_draw_polygon(inky_config *cfg, const inky_draw *draw,
+				   const inky_point *pts, UINT16_t n,
+				   inky_color c)
+{
+	inky_error_state ret;
+	_pen pen;
+
+	if (!pts && n) {
+		return INKY_E_NULL_PTR;
+	}
+
+	ret = _pen_begin(cfg, draw, c, &pen);
+
+	if (ret != INKY_OK) {
+		return ret;
+	}
+
+	for (UINT16_t i = 0; i < n; i++) {
+		const inky_point *b = &pts[i + 1 < n ? i + 1 : 0];
+
+		_line(&pen, pts[i].x, pts[i].y, b->x, b->y);
+	}
+
+	return _pen_end(cfg, &pen);
+}
+
+inky_error_state inky_draw_fill_polygon(inky_config *cfg,
+					const inky_draw *draw,
+					const inky_point *pts, UINT16_t n,
+					inky_color c)
+{
+	inky_error_state ret;
+	INT32_t xs[INKY_DRAW_MAX_POINTS];
+	INT32_t top, bottom;
+	_pen pen;
+
+	if (!pts && n) {
+		return INKY_E_NULL_PTR;
+	}
+
+	if (n > INKY_DRAW_MAX_POINTS) {
+		return INKY_E_OUT_OF_RANGE;
+	}
+
+	ret = _pen_begin(cfg, draw, c, &pen);
+
+	if (ret != INKY_OK) {
+		return ret;
+	}
+
+	if (n < 3) {
+		return INKY_OK;
+	}
+
+	top = pts[0].y;
+	bottom = pts[0].y;
+
+	for (UINT16_t i = 1; i < n; i++) {
+		top = pts[i].y < top ? pts[i].y : top;
+		bottom = pts[i].y > bottom ? pts[i].y : bottom;
+	}
+
+	top = top > pen.cy0 ? top : pen.cy0;
+	bottom = bottom - 1 < pen.cy1 ? bottom - 1 : pen.cy1;
+
+	/* Cross each row through the pixel centers, y + 1/2. An edge
+	 * counts for the rows from its top end up to its bottom one */
+	for (INT32_t y = top; y <= bottom; y++) {
+		UINT16_t m = 0;
+
+		for (UINT16_t i = 0; i < n; i++) {
+			const inky_point *a = &pts[i];
+			const inky_point *b = &pts[i + 1 < n ? i + 1 : 0];
+			INT64_t num, den;
+			INT32_t x;
+			UINT16_t k;
+
+			if ((y < a->y) == (y < b->y)) {
+				continue;
+			}
+
+			/* The first pixel whose center is right of the
+			 * crossing, ceil(x - 1/2) */
+			num = (INT64_t) (2 * y + 1 - 2 * a->y) *
+				((INT32_t) b->x - a->x);
+			den = 2 * ((INT64_t) b->y - a->y);
+
+			if (den < 0) {
+				num = -num;
+				den = -den;
+			}
+
+			x = (INT32_t) _ceil_div(2 * (INT64_t) a->x * den -
+						den + 2 * num, 2 * den);
+
+			/* Insert in order */
+			k = m++;
+
+			while (k > 0 && xs[k - 1] > x) {
+				xs[k] = xs[k - 1];
+				k--;
+			}
+
+			xs[k] = x;
+		}
+
+		for (UINT16_t k = 0; k + 1 < m; k += 2) {
+			if (xs[k] < xs[k + 1]) {
+				_span(&pen, xs[k], xs[k + 1] - 1, y);
+			}
+		}
+	}
+
+	return _pen_end(cfg, &pen);
+}
+
+/*
+**********************************************************************
+************************* INTERNAL API *******************************
+**********************************************************************
+*/
+
+static inky_error_state _round_rect(inky_config *cfg,
+				     const inky_draw *draw, INT16_t x,
+				     INT16_t y, UINT16_t w, UINT16_t h,
+				     UINT16_t r, inky_color c, UINT8_t fill)
+{
+	inky_error_state ret;
+	UINT16_t side = w < h ? w : h;
+	_shape s;
+	_pen pen;
+
+	ret = _pen_begin(cfg, draw, c, &pen);
+
+	if (ret != INKY_OK) {
+		return ret;
+	}
+
+	if (side == 0) {
+		return INKY_OK;
+	}
+
+	/* Keep the corner centers from crossing */
+	if (r > (side - 1) / 2) {
+		r = (side - 1) / 2;
+	}
+
+	s.x = x;
+	s.y = y;
+	s.w = w;
+	s.h = h;
+	s.rx = r;
+	s.ry = r;
+
+	_shape_draw(&pen, &s, fill);
+
+	return _pen_end(cfg, &pen);
+}
+
+static inky_error_state _ellipse(inky_config *cfg, const inky_draw *draw,
+				 INT16_t cx, INT16_t cy, UINT16_t rx,
+				 UINT16_t ry, inky_color c, UINT8_t fill)
+{
+	inky_error_state ret;
+	_shape s;
+	_pen pen;
+
+	ret = _pen_begin(cfg, draw, c, &pen);
+
+	if (ret != INKY_OK) {
+		return ret;
+	}
+
+	s.x = cx - (INT32_t) rx;
+	s.y = cy - (INT32_t) ry;
+	s.w = 2 * (INT32_t) rx + 1;
+	s.h = 2 * (INT32_t) ry + 1;
+	s.rx = rx;
+	s.ry = ry;
+
+	_shape_draw(&pen, &s, fill);
+
+	return _pen_end(cfg, &pen);
+}
+
+static inky_error_state _pen_begin(inky_config *cfg, const inky_draw *draw,
+				   inky_color c, _pen *pen)
+{
+	inky_error_state ret;
+	const inky_rect *clip;
+
+	if ((ret = pixfmt_fb_check(cfg->fb)) != INKY_OK) {
+		return ret;
+	}
+
+	if (!draw) {
+		return INKY_E_NULL_PTR;
+	}
+
+	if (draw->depth == 0 || draw->depth > INKY_DRAW_MAX_CLIP) {
+		return INKY_E_OUT_OF_RANGE;
+	}
+
+	if (!inky_color_available(cfg, c)) {
+		return INKY_E_NOT_AVAILABLE;
+	}
+
+	clip = &draw->clip[draw->depth - 1];
+
+	pen->fb = cfg->fb;
+	pen->ops = pixfmt_get_ops(&cfg->fb->fmt);
+	pen->code = inky_pixfmt_encode(INKY_FB_BPP(cfg->fb), c) &
+		cfg->fb->fmt.mask;
+
+	/* Inclusive bounds, kept inside the framebuffer even if draw
+	 * was set up for a larger one */
+	pen->cx0 = clip->x;
+	pen->cy0 = clip->y;
+	pen->cx1 = (INT32_t) clip->x + clip->w - 1;
+	pen->cy1 = (INT32_t) clip->y + clip->h - 1;
+
+	if (pen->cx1 >= INKY_FB_WIDTH(cfg->fb)) {
+		pen->cx1 = INKY_FB_WIDTH(cfg->fb) - 1;
+	}
+
+	if (pen->cy1 >= INKY_FB_HEIGHT(cfg->fb)) {
+		pen->cy1 = INKY_FB_HEIGHT(cfg->fb) - 1;
+	}
+
+	pen->x0 = 1;
+	pen->x1 = 0;
+	pen->y0 = 0;
+	pen->y1 = 0;
+
+	return INKY_OK;
+}
+
+static inky_error_state _pen_end(inky_config *cfg, const _pen *pen)
+{
+	inky_rect r;
+
+	if (pen->x0 > pen->x1) {
+		return INKY_OK;
+	}
+
+	r.x = pen->x0;
+	r.y = pen->y0;
+	r.w = pen->x1 - pen->x0 + 1;
+	r.h = pen->y1 - pen->y0 + 1;
+
+	return inky_fb_mark_dirty(cfg, &r);
+}
+
+static void _span(_pen *pen, INT32_t x0, INT32_t x1, INT32_t y)
+{
+	if (x0 > x1) {
+		INT32_t t = x0;
+
+		x0 = x1;
+		x1 = t;
+	}
+
+	if (y < pen->cy0 || y > pen->cy1) {
+		return;
+	}
+
+	x0 = x0 > pen->cx0 ? x0 : pen->cx0;
+	x1 = x1 < pen->cx1 ? x1 : pen->cx1;
+
+	if (x0 > x1) {
+		return;
+	}
+
+	pen->ops->fill(&pen->fb->buffer[INKY_FB_STRIDE(pen->fb) * y], x0,
+		       x1 - x0 + 1, pen->code);
+
+	if (pen->x0 > pen->x1) {
+		pen->x0 = x0;
+		pen->x1 = x1;
+		pen->y0 = y;
+		pen->y1 = y;
+		return;
+	}
+
+	pen->x0 = x0 < pen->x0 ? x0 : pen->x0;
+	pen->x1 = x1 > pen->x1 ? x1 : pen->x1;
+	pen->y0 = y < pen->y0 ? y : pen->y0;
+	pen->y1 = y > pen->y1 ? y : pen->y1;
+}
+
+static void _line(_pen *pen, INT32_t x0, INT32_t y0, INT32_t x1,
+		  INT32_t y1)
+{
+	INT32_t dx = x1 > x0 ? x1 - x0 : x0 - x1;
+	INT32_t dy = y1 > y0 ? y0 - y1 : y1 - y0;
+	INT32_t sx = x0 < x1 ? 1 : -1;
+	INT32_t sy = y0 < y1 ? 1 : -1;
+	INT32_t err = dx + dy;
+	INT32_t run = x0;
+
+	/* Nothing to do when the bounding box misses the clip */
+	if ((x0 < pen->cx0 && x1 < pen->cx0) ||
+	    (x0 > pen->cx1 && x1 > pen->cx1) ||
+	    (y0 < pen->cy0 && y1 < pen->cy0) ||
+	    (y0 > pen->cy1 && y1 > pen->cy1)) {
+		return;
+	}
+
+	/* Pixels are collected into a run until the row changes */
+	for (;;) {
+		INT32_t e2 = 2 * err;
+		INT32_t last = x0;
+
+		if (x0 == x1 && y0 == y1) {
+			_span(pen, run, x0, y0);
+			return;
+		}
+
+		if (e2 >= dy) {
+			err += dy;
+			x0 += sx;
+		}
+
+		if (e2 <= dx) {
+			err += dx;
+			_span(pen, run, last, y0);
+			y0 += sy;
+			run = x0;
+		}
+	}
+}
+
+static void _shape_row(const _shape *s, INT32_t j, INT32_t *l, INT32_t *r)
+{
+	UINT16_t dy = 0;
+	UINT16_t inset = 0;
+
+	/* Distance from the row of the nearest corner centers */
+	if (j < s->ry) {
+		dy = s->ry - j;
+	} else if (j > s->h - 1 - s->ry) {
+		dy = j - (s->h - 1 - s->ry);
+	}
+
+	if (dy) {
+		inset = s->rx - _ellipse_half(s->rx, s->ry, dy);
+	}
+
+	*l = s->x + inset;
+	*r = s->x + s->w - 1 - inset;
+}
+
+static void _shape_draw(_pen *pen, const _shape *s, UINT8_t fill)
+{
+	INT32_t j0 = pen->cy0 - s->y;
+	INT32_t j1 = pen->cy1 - s->y;
+
+	j0 = j0 > 0 ? j0 : 0;
+	j1 = j1 < s->h - 1 ? j1 : s->h - 1;
+
+	for (INT32_t j = j0; j <= j1; j++) {
+		INT32_t l, r, nl, nr, l_end, r_start;
+
+		_shape_row(s, j, &l, &r);
+
+		if (fill) {
+			_span(pen, l, r, s->y + j);
+			continue;
+		}
+
+		/* A pixel is on the outline when it ends its row or lies
+		 * past either end of the row above or below. Rows off
+		 * the shape count as empty */
+		if (j == 0 || j == s->h - 1) {
+			_span(pen, l, r, s->y + j);
+			continue;
+		}
+
+		_shape_row(s, j - 1, &nl, &nr);
+		l_end = nl;
+		r_start = nr;
+		_shape_row(s, j + 1, &nl, &nr);
+		l_end = (nl > l_end ? nl : l_end) - 1;
+		r_start = (nr < r_start ? nr : r_start) + 1;
+
+		l_end = l_end > l ? l_end : l;
+		r_start = r_start < r ? r_start : r;
+
+		if (l_end + 1 >= r_start) {
+			_span(pen, l, r, s->y + j);
+		} else {
+			_span(pen, l, l_end, s->y + j);
+			_span(pen, r_start, r, s->y + j);
+		}
+	}
+}
+
+static UINT16_t _ellipse_half(UINT16_t rx, UINT16_t ry, UINT16_t dy)
+{
+	/* dx^2 / (rx + 1/2)^2 + dy^2 / (ry + 1/2)^2 <= 1 scaled by
+	 * 4 (2rx + 1)^2 (2ry + 1)^2, radii kept small enough for 64
+	 * bits */
+	UINT64_t a, b;
+
+	rx = rx > 0x7fff ? 0x7fff : rx;
+	ry = ry > 0x7fff ? 0x7fff : ry;
+
+	if (dy > ry) {
+		return 0;
+	}
+
+	a = (2 * (UINT64_t) rx + 1) * (2 * (UINT64_t) rx + 1);
+	b = (2 * (UINT64_t) ry + 1) * (2 * (UINT64_t) ry + 1);
+
+	return (UINT16_t) pixfmt_isqrt64(a * (b - 4 * (UINT64_t) dy * dy) /
+					 (4 * b));
+}
+
+static INT64_t _ceil_div(INT64_t a, INT64_t b)
+{
+	if (a >= 0) {
+		return (a + b - 1) / b;
+	}
+
+	return -((-a) / b);
+}
@@ -0,0 +1,319 @@
+/**
+ * @file font5x7.c
+ *
+ * Built-in 5x7 bitmap font for the Pimoroni Inky driver
+ *
+ * Printable ASCII plus the degree sign. Glyphs are 5 pixels wide in
+ * rows of 8, with the baseline under row 6, and advance 6 pixels.
+ */
+
+#include <inky-text.h>
+
+/*
+**********************************************************************
+************************* FONT DEFINITIONS ***************************
+**********************************************************************
+*/
+
+/** @brief One byte per row, 8 rows per glyph, pixel 0 in bit 0 */
+static const UINT8_t _font5x7_bitmap[] = {
+	/* U+0020 space */
+	0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+	/* U+0021 ! */
+	0x04, 0x04, 0x04, 0x04, 0x04, 0x00, 0x04, 0x00,
+	/* U+0022 " */
+	0x0a, 0x0a, 0x0a, 0x00, 0x00, 0x00, 0x00, 0x00,
+	/* U+0023 # */
+	0x0a, 0x0a, 0x1f, 0x0a, 0x1f, 0x0a, 0x0a, 0x00,
+	/* U+0024 $ */
+	0x04, 0x1e, 0x05, 0x0e, 0x14, 0x0f, 0x04, 0x00,
+	/* U+0025 % */
+	0x03, 0x13, 0x08, 0x04, 0x02, 0x19, 0x18, 0x00,
+	/* U+0026 & */
+	0x06, 0x09, 0x05, 0x02, 0x15, 0x09, 0x16, 0x00,
+	/* U+0027 ' */
+	0x06, 0x04, 0x02, 0x00, 0x00, 0x00, 0x00, 0x00,
+	/* U+0028 ( */
+	0x08, 0x04, 0x02, 0x02, 0x02, 0x04, 0x08, 0x00,
+	/* U+0029 ) */
+	0x02, 0x04, 0x08, 0x08, 0x08, 0x04, 0x02, 0x00,
+	/* U+002A * */
+	0x00, 0x0a, 0x04, 0x1f, 0x04, 0x0a, 0x00, 0x00,
+	/* U+002B + */
+	0x00, 0x04, 0x04, 0x1f, 0x04, 0x04, 0x00, 0x00,
+	/* U+002C , */
+	0x00, 0x00, 0x00, 0x00, 0x06, 0x04, 0x02, 0x00,
+	/* U+002D - */
+	0x00, 0x00, 0x00, 0x1f, 0x00, 0x00, 0x00, 0x00,
+	/* U+002E . */
+	0x00, 0x00, 0x00, 0x00, 0x00, 0x06, 0x06, 0x00,
+	/* U+002F / */
+	0x00, 0x10, 0x08, 0x04, 0x02, 0x01, 0x00, 0x00,
+	/* U+0030 0 */
+	0x0e, 0x11, 0x19, 0x15, 0x13, 0x11, 0x0e, 0x00,
+	/* U+0031 1 */
+	0x04, 0x06, 0x04, 0x04, 0x04, 0x04, 0x0e, 0x00,
+	/* U+0032 2 */
+	0x0e, 0x11, 0x10, 0x08, 0x04, 0x02, 0x1f, 0x00,
+	/* U+0033 3 */
+	0x1f, 0x08, 0x04, 0x08, 0x10, 0x11, 0x0e, 0x00,
+	/* U+0034 4 */
+	0x08, 0x0c, 0x0a, 0x09, 0x1f, 0x08, 0x08, 0x00,
+	/* U+0035 5 */
+	0x1f, 0x01, 0x0f, 0x10, 0x10, 0x11, 0x0e, 0x00,
+	/* U+0036 6 */
+	0x0c, 0x02, 0x01, 0x0f, 0x11, 0x11, 0x0e, 0x00,
+	/* U+0037 7 */
+	0x1f, 0x10, 0x08, 0x04, 0x02, 0x02, 0x02, 0x00,
+	/* U+0038 8 */
+	0x0e, 0x11, 0x11, 0x0e, 0x11, 0x11, 0x0e, 0x00,
+	/* U+0039 9 */
+	0x0e, 0x11, 0x11, 0x1e, 0x10, 0x08, 0x06, 0x00,
+	/* U+003A : */
+	0x00, 0x06, 0x06, 0x00, 0x06, 0x06, 0x00, 0x00,
+	/* U+003B ; */
+	0x00, 0x06, 0x06, 0x00, 0x06, 0x04, 0x02, 0x00,
+	/* U+003C < */
+	0x10, 0x08, 0x04, 0x02, 0x04, 0x08, 0x10, 0x00,
+	/* U+003D = */
+	0x00, 0x00, 0x1f, 0x00, 0x1f, 0x00, 0x00, 0x00,
+	/* U+003E > */
+	0x01, 0x02, 0x04, 0x08, 0x04, 0x02, 0x01, 0x00,
+	/* U+003F ? */
+	0x0e, 0x11, 0x10, 0x08, 0x04, 0x00, 0x04, 0x00,
+	/* U+0040 @ */
+	0x0e, 0x11, 0x10, 0x16, 0x15, 0x15, 0x0e, 0x00,
+	/* U+0041 A */
+	0x0e, 0x11, 0x11, 0x11, 0x1f, 0x11, 0x11, 0x00,
+	/* U+0042 B */
+	0x0f, 0x11, 0x11, 0x0f, 0x11, 0x11, 0x0f, 0x00,
+	/* U+0043 C */
+	0x0e, 0x11, 0x01, 0x01, 0x01, 0x11, 0x0e, 0x00,
+	/* U+0044 D */
+	0x07, 0x09, 0x11, 0x11, 0x11, 0x09, 0x07, 0x00,
+	/* U+0045 E */
+	0x1f, 0x01, 0x01, 0x0f, 0x01, 0x01, 0x1f, 0x00,
+	/* U+0046 F */
+	0x1f, 0x01, 0x01, 0x07, 0x01, 0x01, 0x01, 0x00,
+	/* U+0047 G */
+	0x0e, 0x11, 0x01, 0x01, 0x19, 0x11, 0x0e, 0x00,
+	/* U+0048 H */
+	0x11, 0x11, 0x11, 0x1f, 0x11, 0x11, 0x11, 0x00,
+	/* U+0049 I */
+	0x0e, 0x04, 0x04, 0x04, 0x04, 0x04, 0x0e, 0x00,
+	/* U+004A J */
+	0x1c, 0x08, 0x08, 0x08, 0x08, 0x09, 0x06, 0x00,
+	/* U+004B K */
+	0x11, 0x09, 0x05, 0x03, 0x05, 0x09, 0x11, 0x00,
+	/* U+004C L */
+	0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x1f, 0x00,
+	/* U+004D M */
+	0x11, 0x1b, 0x15, 0x11, 0x11, 0x11, 0x11, 0x00,
+	/* U+004E N */
+	0x11, 0x11, 0x13, 0x15, 0x19, 0x11, 0x11, 0x00,
+	/* U+004F O */
+	0x0e, 0x11, 0x11, 0x11, 0x11, 0x11, 0x0e, 0x00,
+	/* U+0050 P */
+	0x0f, 0x11, 0x11, 0x0f, 0x01, 0x01, 0x01, 0x00,
+	/* U+0051 Q */
+	0x0e, 0x11, 0x11, 0x11, 0x15, 0x09, 0x16, 0x00,
+	/* U+0052 R */
+	0x0f, 0x11, 0x11, 0x0f, 0x05, 0x09, 0x11, 0x00,
+	/* U+0053 S */
+	0x1e, 0x01, 0x01, 0x0e, 0x10, 0x10, 0x0f, 0x00,
+	/* U+0054 T */
+	0x1f, 0x04, 0x04, 0x04, 0x04, 0x04, 0x04, 0x00,
+	/* U+0055 U */
+	0x11, 0x11, 0x11, 0x11, 0x11, 0x11, 0x0e, 0x00,
+	/* U+0056 V */
+	0x11, 0x11, 0x11, 0x11, 0x11, 0x0a, 0x04, 0x00,
+	/* U+0057 W */
+	0x11, 0x11, 0x11, 0x15, 0x15, 0x1b, 0x11, 0x00,
+	/* U+0058 X */
+	0x11, 0x11, 0x0a, 0x04, 0x0a, 0x11, 0x11, 0x00,
+	/* U+0059 Y */
+	0x11, 0x11, 0x0a, 0x04, 0x04, 0x04, 0x04, 0x00,
+	/* U+005A Z */
+	0x1f, 0x10, 0x08, 0x04, 0x02, 0x01, 0x1f, 0x00,
+	/* U+005B [ */
+	0x1c, 0x04, 0x04, 0x04, 0x04, 0x04, 0x1c, 0x00,
+	/* U+005C backslash */
+	0x00, 0x01, 0x02, 0x04, 0x08, 0x10, 0x00, 0x00,
+	/* U+005D ] */
+	0x07, 0x04, 0x04, 0x04, 0x04, 0x04, 0x07, 0x00,
+	/* U+005E ^ */
+	0x04, 0x0a, 0x11, 0x00, 0x00, 0x00, 0x00, 0x00,
+	/* U+005F _ */
+	0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x1f, 0x00,
+	/* U+0060 ` */
+	0x02, 0x04, 0x08, 0x00, 0x00, 0x00, 0x00, 0x00,
+	/* U+0061 a */
+	0x00, 0x00, 0x0e, 0x10, 0x1e, 0x11, 0x1e, 0x00,
+	/* U+0062 b */
+	0x01, 0x01, 0x0d, 0x13, 0x11, 0x11, 0x0f, 0x00,
+	/* U+0063 c */
+	0x00, 0x00, 0x0e, 0x01, 0x01, 0x11, 0x0e, 0x00,
+	/* U+0064 d */
+	0x10, 0x10, 0x16, 0x19, 0x11, 0x11, 0x1e, 0x00,
+	/* U+0065 e */
+	0x00, 0x00, 0x0e, 0x11, 0x1f, 0x01, 0x0e, 0x00,
+	/* U+0066 f */
+	0x0c, 0x12, 0x02, 0x07, 0x02, 0x02, 0x02, 0x00,
+	/* U+0067 g */
+	0x00, 0x00, 0x1e, 0x11, 0x1e, 0x10, 0x0c, 0x00,
+	/* U+0068 h */
+	0x01, 0x01, 0x0d, 0x13, 0x11, 0x11, 0x11, 0x00,
+	/* U+0069 i */
+	0x04, 0x00, 0x06, 0x04, 0x04, 0x04, 0x0e, 0x00,
+	/* U+006A j */
+	0x08, 0x00, 0x0c, 0x08, 0x08, 0x09, 0x06, 0x00,
+	/* U+006B k */
+	0x02, 0x02, 0x12, 0x0a, 0x06, 0x0a, 0x12, 0x00,
+	/* U+006C l */
+	0x06, 0x04, 0x04, 0x04, 0x04, 0x04, 0x0e, 0x00,
+	/* U+006D m */
+	0x00, 0x00, 0x0b, 0x15, 0x15, 0x11, 0x11, 0x00,
+	/* U+006E n */
+	0x00, 0x00, 0x0d, 0x13, 0x11, 0x11, 0x11, 0x00,
+	/* U+006F o */
+	0x00, 0x00, 0x0e, 0x11, 0x11, 0x11, 0x0e, 0x00,
+	/* U+0070 p */
+	0x00, 0x00, 0x0f, 0x11, 0x0f, 0x01, 0x01, 0x00,
+	/* U+0071 q */
+	0x00, 0x00, 0x16, 0x19, 0x1e, 0x10, 0x10, 0x00,
+	/* U+0072 r */
+	0x00, 0x00, 0x0d, 0x13, 0x01, 0x01, 0x01, 0x00,
+	/* U+0073 s */
+	0x00, 0x00, 0x0e, 0x01, 0x0e, 0x10, 0x0f, 0x00,
+	/* U+0074 t */
+	0x02, 0x02, 0x07, 0x02, 0x02, 0x12, 0x0c, 0x00,
+	/* U+0075 u */
+	0x00, 0x00, 0x11, 0x11, 0x11, 0x19, 0x16, 0x00,
+	/* U+0076 v */
+	0x00, 0x00, 0x11, 0x11, 0x11, 0x0a, 0x04, 0x00,
+	/* U+0077 w */
+	0x00, 0x00, 0x11, 0x11, 0x15, 0x15, 0x0a, 0x00,
+	/* U+0078 x */
+	0x00, 0x00, 0x11, 0x0a, 0x04, 0x0a, 0x11, 0x00,
+	/* U+0079 y */
+	0x00, 0x00, 0x11, 0x11, 0x1e, 0x10, 0x0e, 0x00,
+	/* U+007A z */
+	0x00, 0x00, 0x1f, 0x08, 0x04, 0x02, 0x1f, 0x00,
+	/* U+007B { */
+	0x08, 0x04, 0x04, 0x02, 0x04, 0x04, 0x08, 0x00,
+	/* U+007C | */
+	0x04, 0x04, 0x04, 0x04, 0x04, 0x04, 0x04, 0x00,
+	/* U+007D } */
+	0x02, 0x04, 0x04, 0x08, 0x04, 0x04, 0x02, 0x00,
+	/* U+007E ~ */
+	0x00, 0x04, 0x08, 0x1f, 0x08, 0x04, 0x00, 0x00,
+	/* U+00B0 degree sign */
+	0x0c, 0x12, 0x12, 0x0c, 0x00, 0x00, 0x00, 0x00
+};
+
+static const inky_glyph _font5x7_glyphs[] = {
+	{0x0020, 0, 5, 6},
+	{0x0021, 8, 5, 6},
+	{0x0022, 16, 5, 6},
+	{0x0023, 24, 5, 6},
+	{0x0024, 32, 5, 6},
+	{0x0025, 40, 5, 6},
+	{0x0026, 48, 5, 6},
+	{0x0027, 56, 5, 6},
+	{0x0028, 64, 5, 6},
+	{0x0029, 72, 5, 6},
+	{0x002a, 80, 5, 6},
+	{0x002b, 88, 5, 6},
+	{0x002c, 96, 5, 6},
+	{0x002d, 104, 5, 6},
+	{0x002e, 112, 5, 6},
+	{0x002f, 120, 5, 6},
+	{0x0030, 128, 5, 6},
+	{0x0031, 136, 5, 6},
+	{0x0032, 144, 5, 6},
+	{0x0033, 152, 5, 6},
+	{0x0034, 160, 5, 6},
+	{0x0035, 168, 5, 6},
+	{0x0036, 176, 5, 6},
+	{0x0037, 184, 5, 6},
+	{0x0038, 192, 5, 6},
+	{0x0039, 200, 5, 6},
+	{0x003a, 208, 5, 6},
+	{0x003b, 216, 5, 6},
+	{0x003c, 224, 5, 6},
+	{0x003d, 232, 5, 6},
+	{0x003e, 240, 5, 6},
+	{0x003f, 248, 5, 6},
+	{0x0040, 256, 5, 6},
+	{0x0041, 264, 5, 6},
+	{0x0042, 272, 5, 6},
+	{0x0043, 280, 5, 6},
+	{0x0044, 288, 5, 6},
+	{0x0045, 296, 5, 6},
+	{0x0046, 304, 5, 6},
+	{0x0047, 312, 5, 6},
+	{0x0048, 320, 5, 6},
+	{0x0049, 328, 5, 6},
+	{0x004a, 336, 5, 6},
+	{0x004b, 344, 5, 6},
+	{0x004c, 352, 5, 6},
+	{0x004d, 360, 5, 6},
+	{0x004e, 368, 5, 6},
+	{0x004f, 376, 5, 6},
+	{0x0050, 384, 5, 6},
+	{0x0051, 392, 5, 6},
+	{0x0052, 400, 5, 6},
+	{0x0053, 408, 5, 6},
+	{0x0054, 416, 5, 6},
+	{0x0055, 424, 5, 6},
+	{0x0056, 432, 5, 6},
+	{0x0057, 440, 5, 6},
+	{0x0058, 448, 5, 6},
+	{0x0059, 456, 5, 6},
+	{0x005a, 464, 5, 6},
+	{0x005b, 472, 5, 6},
+	{0x005c, 480, 5, 6},
+	{0x005d, 488, 5, 6},
+	{0x005e, 496, 5, 6},
+	{0x005f, 504, 5, 6},
+	{0x0060, 512, 5, 6},
+	{0x0061, 520, 5, 6},
+	{0x0062, 528, 5, 6},
+	{0x0063, 536, 5, 6},
+	{0x0064, 544, 5, 6},
+	{0x0065, 552, 5, 6},
+	{0x0066, 560, 5, 6},
+	{0x0067, 568, 5, 6},
+	{0x0068, 576, 5, 6},
+	{0x0069, 584, 5, 6},
+	{0x006a, 592, 5, 6},
+	{0x006b, 600, 5, 6},
+	{0x006c, 608, 5, 6},
+	{0x006d, 616, 5, 6},
+	{0x006e, 624, 5, 6},
+	{0x006f, 632, 5, 6},
+	{0x0070, 640, 5, 6},
+	{0x0071, 648, 5, 6},
+	{0x0072, 656, 5, 6},
+	{0x0073, 664, 5, 6},
+	{0x0074, 672, 5, 6},
+	{0x0075, 680, 5, 6},
+	{0x0076, 688, 5, 6},
+	{0x0077, 696, 5, 6},
+	{0x0078, 704, 5, 6},
+	{0x0079, 712, 5, 6},
+	{0x007a, 720, 5, 6},
+	{0x007b, 728, 5, 6},
+	{0x007c, 736, 5, 6},
+	{0x007d, 744, 5, 6},
+	{0x007e, 752, 5, 6},
+	{0x00b0, 760, 5, 6}
+};
+
+const inky_font inky_font_5x7 = {
+	.height = 8,
+	.n_glyphs = sizeof(_font5x7_glyphs) / sizeof(_font5x7_glyphs[0]),
+	.glyphs = _font5x7_glyphs,
+	.bitmap = _font5x7_bitmap,
+	.fallback = '?'
+};
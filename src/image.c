@@ -0,0 +1,850 @@
+#include "pixfmt.h"
+
+#include <inky-image.h>
+
+#include <stdlib.h>
+#include <string.h>
+
+/*
+**********************************************************************
+************************ Image Definitions ***************************
+**********************************************************************
+*/
+
+/** @brief Read the next batch of bytes from a callback source */
+static inky_error_state _refill(inky_image *img);
+
+/** @brief Next byte of the image, -1 at its end */
+static INT16_t _getc(inky_image *img);
+
+/** @brief Read n bytes of the image into buf */
+static inky_error_state _read(inky_image *img, UINT8_t *buf, UINT32_t n);
+
+static inky_error_state _skip(inky_image *img, UINT32_t n);
+
+/** @brief Little endian value of n bytes */
+static UINT32_t _le(const UINT8_t *b, UINT8_t n);
+
+static UINT32_t _be32(const UINT8_t *b);
+
+/** @brief Identify the format and read the header */
+static inky_error_state _open(inky_image *img);
+
+static inky_error_state _pnm_header(inky_image *img);
+
+/** @brief Read a decimal number, skipping whitespace and comments
+ * before it and the byte after it */
+static inky_error_state _pnm_number(inky_image *img, UINT32_t *out);
+
+static inky_error_state _pnm_row(inky_image *img, UINT8_t *rgb);
+
+static inky_error_state _bmp_header(inky_image *img);
+
+static inky_error_state _bmp_row(inky_image *img, UINT8_t *rgb);
+
+static inky_error_state _qoi_header(inky_image *img);
+
+static inky_error_state _qoi_row(inky_image *img, UINT8_t *rgb);
+
+/** @brief 8 bit value of the bits of px under a BMP channel mask */
+static UINT8_t _mask_channel(UINT32_t px, UINT32_t mask);
+
+/** @brief Blend a pixel of opacity a over white */
+static void _over_white(UINT8_t *rgb, UINT8_t a);
+
+/*
+**********************************************************************
+************************** API Functions *****************************
+**********************************************************************
+*/
+
+inky_error_state inky_image_open_memory(inky_image *img,
+					const UINT8_t *data, UINT32_t size)
+{
+	if (!img || (!data && size)) {
+		return INKY_E_NULL_PTR;
+	}
+
+	img->read = NULL;
+	img->ctx = NULL;
+	img->data = data;
+	img->size = size;
+
+	return _open(img);
+}
+
+inky_error_state inky_image_open(inky_image *img, inky_image_read_cb read,
+				 void *ctx)
+{
+	if (!img || !read) {
+		return INKY_E_NULL_PTR;
+	}
+
+	img->read = read;
+	img->ctx = ctx;
+	img->data = NULL;
+	img->size = 0;
+
+	return _open(img);
+}
+
+inky_error_state inky_image_read_row(inky_image *img, UINT8_t *rgb,
+				     UINT16_t *y)
+{
+	inky_error_state ret;
+
+	if (!img || !rgb) {
+		return INKY_E_NULL_PTR;
+	}
+
+	if (img->rows >= img->height) {
+		return INKY_E_OUT_OF_RANGE;
+	}
+
+	switch (img->format) {
+	case INKY_IMAGE_PNM:
+		ret = _pnm_row(img, rgb);
+		break;
+	case INKY_IMAGE_BMP:
+		ret = _bmp_row(img, rgb);
+		break;
+	case INKY_IMAGE_QOI:
+		ret = _qoi_row(img, rgb);
+		break;
+	default:
+		return INKY_E_BAD_DATA;
+	}
+
+	if (ret != INKY_OK) {
+		return ret;
+	}
+
+	if (y) {
+		*y = img->bottom_up ? img->height - 1 - img->rows : img->rows;
+	}
+
+	img->rows++;
+
+	return INKY_OK;
+}
+
+inky_color inky_image_nearest(const inky_config *cfg, UINT8_t r,
+			      UINT8_t g, UINT8_t b)
+{
+	inky_color colors[4];
+	UINT8_t n = 0;
+
+	for (UINT8_t c = INKY_COLOR_WHITE; c <= INKY_COLOR_YELLOW; c++) {
+		if (inky_color_available(cfg, (inky_color) c)) {
+			colors[n++] = (inky_color) c;
+		}
+	}
+
+	if (n == 0) {
+		return INKY_COLOR_WHITE;
+	}
+
+	return colors[pixfmt_nearest(colors, n, r, g, b)];
+}
+
+inky_error_state inky_image_draw(inky_config *cfg, inky_image *img,
+				 INT16_t x, INT16_t y)
+{
+	inky_error_state ret;
+	const pixfmt_ops *ops;
+	UINT8_t *rgb;
+	UINT16_t row;
+	INT32_t i0, i1;
+	INT32_t top = 0x7fffffff;
+	INT32_t bottom = -1;
+
+	if ((ret = pixfmt_fb_check(cfg->fb)) != INKY_OK) {
+		return ret;
+	}
+
+	if (!img) {
+		return INKY_E_NULL_PTR;
+	}
+
+	ops = pixfmt_get_ops(&cfg->fb->fmt);
+
+	/* Columns of the image inside the framebuffer */
+	i0 = x < 0 ? -x : 0;
+	i1 = INKY_FB_WIDTH(cfg->fb) - x;
+	i1 = i1 < img->width ? i1 : img->width;
+
+	rgb = malloc((UINT32_t) img->width * 3);
+
+	if (!rgb) {
+		return INKY_E_OUT_OF_MEMORY;
+	}
+
+	/* Rows outside the framebuffer are still decoded, the stream
+	 * can only be read in order */
+	while ((ret = inky_image_read_row(img, rgb, &row)) == INKY_OK) {
+		INT32_t fy = y + row;
+		UINT8_t *dst;
+		UINT32_t last = 0xffffffff;
+		UINT8_t code = 0;
+		INT32_t run = i0;
+
+		if (fy < 0 || fy >= INKY_FB_HEIGHT(cfg->fb) || i0 >= i1) {
+			continue;
+		}
+
+		dst = &cfg->fb->buffer[INKY_FB_STRIDE(cfg->fb) * fy];
+
+		/* Pixels of one color are set together */
+		for (INT32_t i = i0; i < i1; i++) {
+			const UINT8_t *p = &rgb[3 * i];
+			UINT32_t v = ((UINT32_t) p[0] << 16) | (p[1] << 8) |
+				p[2];
+			UINT8_t c;
+
+			if (v == last) {
+				continue;
+			}
+
+			c = inky_pixfmt_encode(INKY_FB_BPP(cfg->fb),
+					       inky_image_nearest(cfg, p[0],
+								  p[1], p[2])) &
+				cfg->fb->fmt.mask;
+			last = v;
+
+			if (i > i0 && c != code) {
+				ops->fill(dst, x + run, i - run, code);
+				run = i;
+			}
+
+			code = c;
+		}
+
+		ops->fill(dst, x + run, i1 - run, code);
+
+		top = fy < top ? fy : top;
+		bottom = fy > bottom ? fy : bottom;
+	}
+
+	free(rgb);
+
+	if (bottom >= top) {
+		inky_rect r;
+
+		r.x = x + i0;
+		r.y = top;
+		r.w = i1 - i0;
+		r.h = bottom - top + 1;
+
+		inky_fb_mark_dirty(cfg, &r);
+	}
+
+	return ret == INKY_E_OUT_OF_RANGE ? INKY_OK : ret;
+}
+
+/*
+**********************************************************************
+************************* INTERNAL API *******************************
+**********************************************************************
+*/
+
+static inky_error_state _refill(inky_image *img)
+{
+	INT32_t n = img->read(img->ctx, img->ahead, INKY_IMAGE_READ_AHEAD);
+
+	if (n <= 0 || n > INKY_IMAGE_READ_AHEAD) {
+		return INKY_E_BAD_DATA;
+	}
+
+	img->n_ahead = (UINT8_t) n;
+	img->at = 0;
+
+	return INKY_OK;
+}
+
+static INT16_t _getc(inky_image *img)
+{
+	if (!img->read) {
+		return img->pos < img->size ? img->data[img->pos++] : -1;
+	}
+
+	if (img->at == img->n_ahead && _refill(img) != INKY_OK) {
+		return -1;
+	}
+
+	img->pos++;
+
+	return img->ahead[img->at++];
+}
+
+static inky_error_state _read(inky_image *img, UINT8_t *buf, UINT32_t n)
+{
+	if (!img->read) {
+		if (img->size - img->pos < n) {
+			return INKY_E_BAD_DATA;
+		}
+
+		memcpy(buf, &img->data[img->pos], n);
+		img->pos += n;
+
+		return INKY_OK;
+	}
+
+	while (n) {
+		UINT32_t k;
+
+		if (img->at == img->n_ahead && _refill(img) != INKY_OK) {
+			return INKY_E_BAD_DATA;
+		}
+
+		k = img->n_ahead - img->at;
+		k = k < n ? k : n;
+
+		memcpy(buf, &img->ahead[img->at], k);
+		img->at += k;
+		img->pos += k;
+		buf += k;
+		n -= k;
+	}
+
+	return INKY_OK;
+}
+
+static inky_error_state _skip(inky_image *img, UINT32_t n)
+{
+	while (n--) {
+		if (_getc(img) < 0) {
+			return INKY_E_BAD_DATA;
+		}
+	}
+
+	return INKY_OK;
+}
+
+static UINT32_t _le(const UINT8_t *b, UINT8_t n)
+{
+	UINT32_t v = 0;
+
+	while (n--) {
+		v = (v << 8) | b[n];
+	}
+
+	return v;
+}
+
+static UINT32_t _be32(const UINT8_t *b)
+{
+	return ((UINT32_t) b[0] << 24) | ((UINT32_t) b[1] << 16) |
+		((UINT32_t) b[2] << 8) | b[3];
+}
+
+static inky_error_state _open(inky_image *img)
+{
+	UINT8_t magic[2];
+
+	img->width = 0;
+	img->height = 0;
+	img->rows = 0;
+	img->pos = 0;
+	img->n_ahead = 0;
+	img->at = 0;
+	img->bottom_up = 0;
+	img->pad = 0;
+	img->run = 0;
+	memset(img->masks, 0, sizeof(img->masks));
+
+	if (_read(img, magic, 2) != INKY_OK) {
+		return INKY_E_BAD_DATA;
+	}
+
+	if (magic[0] == 'P' && magic[1] >= '1' && magic[1] <= '6') {
+		img->format = INKY_IMAGE_PNM;
+		img->kind = magic[1] - '0';
+		return _pnm_header(img);
+	}
+
+	if (magic[0] == 'B' && magic[1] == 'M') {
+		img->format = INKY_IMAGE_BMP;
+		return _bmp_header(img);
+	}
+
+	if (magic[0] == 'q' && magic[1] == 'o') {
+		img->format = INKY_IMAGE_QOI;
+		return _qoi_header(img);
+	}
+
+	return INKY_E_BAD_DATA;
+}
+
+static inky_error_state _pnm_header(inky_image *img)
+{
+	UINT32_t w, h, maxval = 1;
+
+	if (_pnm_number(img, &w) != INKY_OK ||
+	    _pnm_number(img, &h) != INKY_OK ||
+	    (img->kind % 3 != 1 && _pnm_number(img, &maxval) != INKY_OK)) {
+		return INKY_E_BAD_DATA;
+	}
+
+	if (w == 0 || h == 0 || w > 0xffff || h > 0xffff || maxval == 0 ||
+	    maxval > 0xffff) {
+		return INKY_E_BAD_DATA;
+	}
+
+	img->width = w;
+	img->height = h;
+	img->maxval = maxval;
+
+	return INKY_OK;
+}
+
+static inky_error_state _pnm_number(inky_image *img, UINT32_t *out)
+{
+	INT16_t c = _getc(img);
+	UINT32_t v = 0;
+	UINT8_t digits = 0;
+
+	for (;;) {
+		if (c == '#') {
+			while (c >= 0 && c != '\n' && c != '\r') {
+				c = _getc(img);
+			}
+		} else if (c == ' ' || (c >= '\t' && c <= '\r')) {
+			c = _getc(img);
+		} else {
+			break;
+		}
+	}
+
+	while (c >= '0' && c <= '9') {
+		/* Anything past 16 bits is out of range anyway */
+		v = v > 0xfffff ? v : v * 10 + (c - '0');
+		digits++;
+		c = _getc(img);
+	}
+
+	/* The byte after the last number of a plain file may be its end */
+	if (!digits || (c >= 0 && c != ' ' && (c < '\t' || c > '\r'))) {
+		return INKY_E_BAD_DATA;
+	}
+
+	*out = v;
+
+	return INKY_OK;
+}
+
+static inky_error_state _pnm_row(inky_image *img, UINT8_t *rgb)
+{
+	UINT16_t w = img->width;
+	UINT8_t ch = img->kind % 3 == 0 ? 3 : 1;
+	UINT16_t maxval = img->maxval;
+
+	switch (img->kind) {
+	case 1:
+		for (UINT16_t x = 0; x < w; x++) {
+			INT16_t c = _getc(img);
+
+			while (c == '#' || c == ' ' || (c >= '\t' && c <= '\r')) {
+				if (c == '#') {
+					while (c >= 0 && c != '\n') {
+						c = _getc(img);
+					}
+				}
+
+				c = _getc(img);
+			}
+
+			if (c != '0' && c != '1') {
+				return INKY_E_BAD_DATA;
+			}
+
+			memset(&rgb[3 * x], c == '1' ? 0x00 : 0xff, 3);
+		}
+
+		return INKY_OK;
+
+	case 4:
+		for (UINT16_t x = 0; x < w; x += 8) {
+			INT16_t c = _getc(img);
+
+			if (c < 0) {
+				return INKY_E_BAD_DATA;
+			}
+
+			for (UINT16_t i = x; i < w && i < x + 8; i++) {
+				memset(&rgb[3 * i],
+				       (c << (i - x)) & 0x80 ? 0x00 : 0xff, 3);
+			}
+		}
+
+		return INKY_OK;
+
+	case 5:
+	case 6:
+		if (maxval < 0x100) {
+			/* Read gray into the end of the row, then spread it
+			 * out from the front, which never overtakes it */
+			UINT8_t *src = &rgb[(UINT32_t) w * (3 - ch)];
+
+			if (_read(img, src, (UINT32_t) w * ch) != INKY_OK) {
+				return INKY_E_BAD_DATA;
+			}
+
+			for (UINT32_t i = 0; i < (UINT32_t) w * 3; i++) {
+				UINT32_t v = src[ch == 3 ? i : i / 3];
+
+				if (v > maxval) {
+					return INKY_E_BAD_DATA;
+				}
+
+				rgb[i] = maxval == 0xff ? v :
+					(v * 255 + maxval / 2) / maxval;
+			}
+
+			return INKY_OK;
+		}
+
+		/* fall through */
+	default:
+		for (UINT32_t i = 0; i < (UINT32_t) w * ch; i++) {
+			UINT32_t v;
+
+			if (img->kind >= 5) {
+				INT16_t hi = _getc(img);
+				INT16_t lo = _getc(img);
+
+				if (hi < 0 || lo < 0) {
+					return INKY_E_BAD_DATA;
+				}
+
+				v = ((UINT32_t) hi << 8) | lo;
+			} else if (_pnm_number(img, &v) != INKY_OK) {
+				return INKY_E_BAD_DATA;
+			}
+
+			if (v > maxval) {
+				return INKY_E_BAD_DATA;
+			}
+
+			v = (v * 255 + maxval / 2) / maxval;
+
+			if (ch == 3) {
+				rgb[i] = v;
+			} else {
+				memset(&rgb[3 * i], v, 3);
+			}
+		}
+
+		return INKY_OK;
+	}
+}
+
+static inky_error_state _bmp_header(inky_image *img)
+{
+	UINT8_t b[40];
+	UINT32_t offset, dib, compression, colors, entry;
+	INT32_t h;
+	UINT32_t w;
+	UINT8_t bpp;
+
+	/* File header after the magic, and the size of the DIB header */
+	if (_read(img, b, 16) != INKY_OK) {
+		return INKY_E_BAD_DATA;
+	}
+
+	offset = _le(&b[8], 4);
+	dib = _le(&b[12], 4);
+
+	if (dib == 12) {
+		/* OS/2 core header */
+		if (_read(img, b, 8) != INKY_OK) {
+			return INKY_E_BAD_DATA;
+		}
+
+		w = _le(&b[0], 2);
+		h = _le(&b[2], 2);
+		bpp = _le(&b[6], 2);
+		compression = 0;
+		colors = 0;
+		entry = 3;
+	} else if (dib >= 40) {
+		if (_read(img, b, 36) != INKY_OK) {
+			return INKY_E_BAD_DATA;
+		}
+
+		w = _le(&b[0], 4);
+		h = (INT32_t) _le(&b[4], 4);
+		bpp = _le(&b[10], 2);
+		compression = _le(&b[12], 4);
+		colors = _le(&b[28], 4);
+		entry = 4;
+
+		/* Bit field masks follow a plain info header, or are the
+		 * start of a larger one */
+		if (compression == 3 || compression == 6) {
+			UINT32_t n = compression == 6 ? 16 : 12;
+
+			if (dib >= 56) {
+				n = 16;
+			} else if (dib > 40) {
+				n = dib - 40 < n ? dib - 40 : n;
+			}
+
+			if (_read(img, b, n) != INKY_OK) {
+				return INKY_E_BAD_DATA;
+			}
+
+			for (UINT8_t i = 0; i < n / 4; i++) {
+				img->masks[i] = _le(&b[4 * i], 4);
+			}
+
+			dib = dib > 40 + n ? dib - n : 40;
+		}
+
+		if (_skip(img, dib - 40) != INKY_OK) {
+			return INKY_E_BAD_DATA;
+		}
+	} else {
+		return INKY_E_BAD_DATA;
+	}
+
+	if (h < 0) {
+		h = -h;
+	} else {
+		img->bottom_up = 1;
+	}
+
+	if (w == 0 || w > 0xffff || h == 0 || h > 0xffff) {
+		return INKY_E_BAD_DATA;
+	}
+
+	switch (bpp) {
+	case 1:
+	case 4:
+	case 8:
+	case 24:
+		if (compression != 0) {
+			return INKY_E_BAD_DATA;
+		}
+		break;
+	case 16:
+	case 32:
+		if (compression == 0) {
+			img->masks[0] = bpp == 16 ? 0x7c00 : 0xff0000;
+			img->masks[1] = bpp == 16 ? 0x03e0 : 0x00ff00;
+			img->masks[2] = bpp == 16 ? 0x001f : 0x0000ff;
+			img->masks[3] = 0;
+		} else if (compression != 3 && compression != 6) {
+			return INKY_E_BAD_DATA;
+		}
+		break;
+	default:
+		return INKY_E_BAD_DATA;
+	}
+
+	img->width = w;
+	img->height = h;
+	img->kind = bpp;
+	img->pad = (((UINT32_t) w * bpp + 31) / 32) * 4 -
+		((UINT32_t) w * bpp + 7) / 8;
+
+	if (bpp <= 8) {
+		colors = colors ? colors : 1u << bpp;
+
+		if (colors > 256) {
+			return INKY_E_BAD_DATA;
+		}
+
+		/* Some writers leave out unused entries, which only shows
+		 * in where the pixels start */
+		if (offset > img->pos && (offset - img->pos) / entry < colors) {
+			colors = (offset - img->pos) / entry;
+		}
+
+		memset(img->table, 0, sizeof(img->table));
+
+		for (UINT32_t i = 0; i < colors; i++) {
+			if (_read(img, b, entry) != INKY_OK) {
+				return INKY_E_BAD_DATA;
+			}
+
+			img->table[3 * i] = b[2];
+			img->table[3 * i + 1] = b[1];
+			img->table[3 * i + 2] = b[0];
+		}
+	}
+
+	if (img->pos > offset) {
+		return INKY_E_BAD_DATA;
+	}
+
+	return _skip(img, offset - img->pos);
+}
+
+static inky_error_state _bmp_row(inky_image *img, UINT8_t *rgb)
+{
+	UINT16_t w = img->width;
+	UINT8_t bpp = img->kind;
+
+	if (bpp == 24) {
+		if (_read(img, rgb, (UINT32_t) w * 3) != INKY_OK) {
+			return INKY_E_BAD_DATA;
+		}
+
+		for (UINT16_t x = 0; x < w; x++) {
+			UINT8_t t = rgb[3 * x];
+
+			rgb[3 * x] = rgb[3 * x + 2];
+			rgb[3 * x + 2] = t;
+		}
+	} else if (bpp >= 16) {
+		for (UINT16_t x = 0; x < w; x++) {
+			UINT8_t b[4];
+			UINT32_t px;
+
+			if (_read(img, b, bpp / 8) != INKY_OK) {
+				return INKY_E_BAD_DATA;
+			}
+
+			px = _le(b, bpp / 8);
+
+			rgb[3 * x] = _mask_channel(px, img->masks[0]);
+			rgb[3 * x + 1] = _mask_channel(px, img->masks[1]);
+			rgb[3 * x + 2] = _mask_channel(px, img->masks[2]);
+
+			if (img->masks[3]) {
+				_over_white(&rgb[3 * x],
+					    _mask_channel(px, img->masks[3]));
+			}
+		}
+	} else {
+		UINT8_t per = 8 / bpp;
+
+		for (UINT16_t x = 0; x < w; x += per) {
+			INT16_t c = _getc(img);
+
+			if (c < 0) {
+				return INKY_E_BAD_DATA;
+			}
+
+			/* Leftmost pixel in the highest bits */
+			for (UINT16_t i = x; i < w && i < x + per; i++) {
+				UINT8_t idx = (c >> (8 - bpp * (i - x + 1))) &
+					((1 << bpp) - 1);
+
+				memcpy(&rgb[3 * i], &img->table[3 * idx], 3);
+			}
+		}
+	}
+
+	return _skip(img, img->pad);
+}
+
+static inky_error_state _qoi_header(inky_image *img)
+{
+	UINT8_t b[12];
+	UINT32_t w, h;
+
+	if (_read(img, b, 12) != INKY_OK || b[0] != 'i' || b[1] != 'f') {
+		return INKY_E_BAD_DATA;
+	}
+
+	w = _be32(&b[2]);
+	h = _be32(&b[6]);
+
+	if (w == 0 || w > 0xffff || h == 0 || h > 0xffff ||
+	    (b[10] != 3 && b[10] != 4)) {
+		return INKY_E_BAD_DATA;
+	}
+
+	img->width = w;
+	img->height = h;
+	img->kind = b[10];
+	img->px[0] = 0;
+	img->px[1] = 0;
+	img->px[2] = 0;
+	img->px[3] = 0xff;
+	memset(img->table, 0, 64 * 4);
+
+	return INKY_OK;
+}
+
+static inky_error_state _qoi_row(inky_image *img, UINT8_t *rgb)
+{
+	UINT8_t *px = img->px;
+
+	for (UINT16_t x = 0; x < img->width; x++) {
+		if (img->run) {
+			img->run--;
+		} else {
+			INT16_t op = _getc(img);
+			UINT8_t *slot;
+
+			if (op < 0) {
+				return INKY_E_BAD_DATA;
+			}
+
+			if (op == 0xfe || op == 0xff) {
+				if (_read(img, px, op == 0xfe ? 3 : 4) != INKY_OK) {
+					return INKY_E_BAD_DATA;
+				}
+			} else if ((op & 0xc0) == 0x00) {
+				memcpy(px, &img->table[4 * op], 4);
+			} else if ((op & 0xc0) == 0x40) {
+				px[0] += ((op >> 4) & 0x03) - 2;
+				px[1] += ((op >> 2) & 0x03) - 2;
+				px[2] += (op & 0x03) - 2;
+			} else if ((op & 0xc0) == 0x80) {
+				INT16_t b = _getc(img);
+				INT8_t dg = (op & 0x3f) - 32;
+
+				if (b < 0) {
+					return INKY_E_BAD_DATA;
+				}
+
+				px[0] += dg - 8 + ((b >> 4) & 0x0f);
+				px[1] += dg;
+				px[2] += dg - 8 + (b & 0x0f);
+			} else {
+				/* Runs carry on across rows */
+				img->run = op & 0x3f;
+			}
+
+			slot = &img->table[4 * ((px[0] * 3 + px[1] * 5 +
+						  px[2] * 7 + px[3] * 11) % 64)];
+			memcpy(slot, px, 4);
+		}
+
+		memcpy(&rgb[3 * x], px, 3);
+
+		if (px[3] != 0xff) {
+			_over_white(&rgb[3 * x], px[3]);
+		}
+	}
+
+	return INKY_OK;
+}
+
+static UINT8_t _mask_channel(UINT32_t px, UINT32_t mask)
+{
+	UINT64_t v;
+
+	if (!mask) {
+		return 0;
+	}
+
+	while (!(mask & 1)) {
+		mask >>= 1;
+		px >>= 1;
+	}
+
+	v = px & mask;
+
+	return (UINT8_t) ((v * 255 + mask / 2) / mask);
+}
+
+static void _over_white(UINT8_t *rgb, UINT8_t a)
+{
+	for (UINT8_t i = 0; i < 3; i++) {
+		rgb[i] = (rgb[i] * a + 255 * (255 - a) + 127) / 255;
+	}
+}
@@ -1,7 +1,10 @@
 #include "luts.h"
+#include "pixfmt.h"
 #include <inky-api.h>
+#include <inky-layer.h>
 
 #include <stdlib.h>
+#include <string.h>
 
 /*
 **********************************************************************
@@ -16,6 +19,16 @@
 		}					\
 	} while (0)
 
+/** @brief Color availability, constant when INKY_FIXED_COLOR is set */
+#ifdef INKY_FIXED_COLOR
+#define INKY_HAS_COLOR(cfg, c)			\
+	((c) == INKY_COLOR_WHITE ||		\
+	 (c) == INKY_COLOR_BLACK ||		\
+	 (c) == INKY_FIXED_COLOR)
+#else
+#define INKY_HAS_COLOR(cfg, c) _color_available((cfg)->color, (c))
+#endif /* #ifdef INKY_FIXED_COLOR */
+
 /* Commands recognized by peripheral */
 typedef enum {
 	SOFT_RESET		= 0x12, /**< Soft Reset */
@@ -41,17 +54,76 @@ typedef enum {
 	ENTER_DEEP_SLEEP	= 0x10 /**< Enter Deep Sleep */
 } dcommand;
 
-static struct _display_res {
-	UINT16_t height;
-	UINT16_t width;
-} _inky_what = {
+/*
+ * Init programs from Pimoroni's Inky library, with the gate setting
+ * holding each panel's height
+ */
+static const UINT8_t _init_what[] = {
+	ANALOG_BLOCK_CONTROL, 1, 0x54,
+	DIGITAL_BLOCK_CONTROL, 1, 0x3b,
+	GATE_SETTING, 3, 0x2c, 0x01, 0x00,
+	GATE_DRIVING_VOLTAGE, 1, 0x17,
+	SOURCE_DRIVING_VOLTAGE, 3, 0x41, 0xac, 0x32,
+	DUMMY_LINE_PERIOD, 1, 0x07,
+	GATE_LINE_WIDTH, 1, 0x04,
+	DATA_ENTRY_MODE, 1, 0x03,
+	VCOM_REGISTER, 1, 0x3c,
+	/* Set border config to white */
+	GS_TRANSITION_DEFINE, 1, 0x00,
+	GS_TRANSITION_DEFINE, 1, 0x31,
+	INKY_INIT_IF_YELLOW, SOURCE_DRIVING_VOLTAGE, 3, 0x07, 0xac, 0x32,
+	INKY_INIT_IF_RED, SOURCE_DRIVING_VOLTAGE, 3, 0x30, 0xac, 0x22,
+	INKY_INIT_LUTS
+}, _init_phat[] = {
+	ANALOG_BLOCK_CONTROL, 1, 0x54,
+	DIGITAL_BLOCK_CONTROL, 1, 0x3b,
+	GATE_SETTING, 3, 0xfa, 0x00, 0x00,
+	GATE_DRIVING_VOLTAGE, 1, 0x17,
+	SOURCE_DRIVING_VOLTAGE, 3, 0x41, 0xac, 0x32,
+	DUMMY_LINE_PERIOD, 1, 0x07,
+	GATE_LINE_WIDTH, 1, 0x04,
+	DATA_ENTRY_MODE, 1, 0x03,
+	VCOM_REGISTER, 1, 0x3c,
+	/* Set border config to white */
+	GS_TRANSITION_DEFINE, 1, 0x00,
+	GS_TRANSITION_DEFINE, 1, 0x31,
+	INKY_INIT_IF_YELLOW, SOURCE_DRIVING_VOLTAGE, 3, 0x07, 0xac, 0x32,
+	INKY_INIT_LUTS
+};
+
+static const inky_panel _inky_what = {
+	.width = 400,
 	.height = 300,
-	.width = 400
+	.row_stride = 0,
+	.init = _init_what,
+	.init_len = sizeof(_init_what),
+	.lut_black = lut_black_refresh,
+	.lut_red = lut_red_refresh,
+	.lut_yellow = lut_yellow_refresh,
+	.lut_len = sizeof(lut_black_refresh)
 }, _inky_phat = {
+	.width = 122,
 	.height = 250,
-	.width = 122
+	.row_stride = 0,
+	.init = _init_phat,
+	.init_len = sizeof(_init_phat),
+	.lut_black = lut_black_refresh,
+	.lut_red = lut_red_refresh,
+	.lut_yellow = lut_yellow_refresh,
+	.lut_len = sizeof(lut_black_refresh)
 };
 
+/** @brief Bytes per row of panel RAM */
+#define INKY_PANEL_STRIDE(panel)				\
+	((panel)->row_stride ? (panel)->row_stride :		\
+	 (UINT16_t) (((panel)->width + 7) / 8))
+
+/** @brief How an orientation is sent: framebuffer columns go down the
+ * panel, and panel columns or rows are scanned in reverse */
+#define _ORIENT_TRANSPOSE	0x01
+#define _ORIENT_FLIP_X		0x02
+#define _ORIENT_FLIP_Y		0x04
+
 /** @brief Send data on SPI bus
  * @p data Data to send on bus
  */
@@ -72,17 +144,103 @@ static inky_error_state _spi_send_command_byte(inky_config *cfg,
 					       dcommand cmd,
 					       UINT8_t arg);
 
+/* Stages of the non-blocking operations, see inky_op_step() */
+typedef enum {
+	_OP_RESET_ASSERT,	/**< Pull RESET low */
+	_OP_RESET_RELEASE,	/**< Release RESET */
+	_OP_RESET_SOFT,		/**< Send soft reset command */
+	_OP_RESET_DONE,		/**< Reset complete, BUSY released */
+	_OP_UPDATE_REFRESH,	/**< Refresh triggered, wait for BUSY */
+	_OP_UPDATE_SLEEP,	/**< Refresh complete, enter deep sleep */
+	_OP_DONE		/**< Nothing left to do */
+} _op_stage;
+
+static inky_error_state _op_wait(inky_op *op, _op_stage next,
+				 inky_wait wait, UINT32_t delay_us);
+
+/** @brief Initialize op for an update of area, NULL for the whole
+ * framebuffer, and run its first step */
+static inky_error_state _op_start(inky_config *cfg, inky_op *op,
+				  inky_op_type type, const inky_rect *area);
+
+/** @brief Run an operation to completion using the delay and poll
+ * callbacks */
+static inky_error_state _op_run(inky_config *cfg, inky_op_type type,
+				const inky_rect *area);
+
 static inky_error_state _reset(inky_config *cfg);
 
 static inky_error_state _busy_wait(inky_config *cfg);
 
-static inky_error_state _allocate_fb(inky_config *cfg);
+/** @brief Send a rectangle of the framebuffer and trigger a refresh,
+ * or of white when blank */
+static inky_error_state _inky_transfer(inky_config *cfg,
+				       const inky_rect *area, UINT8_t blank);
+
+/** @brief _ORIENT_* flags of an inky_orientation */
+static UINT8_t _orient_flags(UINT8_t orientation);
+
+/** @brief Size of the framebuffer window the panel shows when turned
+ * to orientation, in pixels of scale by scale panel pixels */
+static void _view_size(const inky_panel *panel, UINT8_t orientation,
+		       UINT8_t scale, UINT16_t *w, UINT16_t *h);
+
+/** @brief Part of area in the viewport, in viewport coordinates. False
+ * when there is none */
+static UINT8_t _view_clip(const inky_config *cfg, const inky_rect *area,
+			  inky_rect *out);
+
+/** @brief Resize the framebuffer to w by h pixels, cleared to white,
+ * with the viewport at its top left */
+static inky_error_state _fb_resize(inky_config *cfg, UINT16_t w,
+				   UINT16_t h);
+
+/** @brief Pack lines r0 to r1 - 1 of the viewport, at most 8 from
+ * band, a multiple of 8, into rows of stride bytes of bw and color.
+ * Lines are framebuffer rows, or columns when transposed, packed as
+ * the panel row they fill before widening to scale. Layers are left
+ * out when blank */
+static void _pack_band(inky_config *cfg, UINT8_t flags, UINT16_t band,
+		       UINT16_t r0, UINT16_t r1, UINT16_t stride,
+		       UINT8_t blank, UINT8_t *bw, UINT8_t *color);
+
+/** @brief Mark the framebuffer and its layers as shown on the panel */
+static void _dirty_reset(inky_config *cfg);
+
+/** @brief Clear the band of rows holding framebuffer row line and,
+ * unless blank, render it. Nothing to do when it is already held */
+static inky_error_state _band_render(inky_config *cfg, UINT16_t line,
+				     UINT8_t blank);
+
+/** @brief Reverse a packed row of w pixels into the order the panel
+ * takes it while X decrements: the row padded to stride bytes with fill
+ * on the left, LSB first */
+static void _mirror_row(const UINT8_t *src, UINT8_t *dst, UINT16_t stride,
+			UINT16_t w, UINT8_t fill);
+
+/** @brief Use the registered panel, or the product's built-in one */
+static inky_error_state _select_panel(inky_config *cfg);
+
+/** @brief Allocate a framebuffer of the panel's size holding rows rows,
+ * all of them for 0 */
+static inky_error_state _allocate_fb(inky_config *cfg, UINT16_t rows);
+
+/** @brief Send an init program, see INKY_INIT_* */
+static inky_error_state _run_init(inky_config *cfg, const UINT8_t *prog,
+				  UINT32_t len);
+
+/** @brief Send the panel LUT for the available colors */
+static inky_error_state _send_luts(inky_config *cfg);
+
+#ifndef INKY_FIXED_COLOR
+static UINT8_t _color_available(const inky_color_config *color,
+				inky_color c);
+#endif /* #ifndef INKY_FIXED_COLOR */
 
 static UINT8_t* _spi_order_bytes(UINT16_t input, UINT8_t* result,
 				 UINT8_t msb_first);
 
-static inky_error_state _inky_prep(inky_config *cfg,
-				   UINT8_t *height_byte_array);
+static inky_error_state _inky_prep(inky_config *cfg);
 
 /*
 **********************************************************************
@@ -123,8 +281,12 @@ inky_error_state inky_setup(inky_config *cfg)
 		return ret;
 	}
 
+	if ((ret = _select_panel(cfg)) != INKY_OK) {
+		return ret;
+	}
+
 	if ((cfg->exclude_flags & INKY_FLAG_ALLOCATE_FB) == 0) {
-		if ((ret = _allocate_fb(cfg)) != INKY_OK) {
+		if ((ret = _allocate_fb(cfg, 0)) != INKY_OK) {
 			return ret;
 		}
 	}
@@ -141,6 +303,11 @@ inky_error_state inky_setup(inky_config *cfg)
 inky_error_state inky_free(inky_config *cfg)
 {
 	if (cfg->fb) {
+		if (cfg->fb->band) {
+			free(cfg->fb->band->fb.buffer);
+			free(cfg->fb->band);
+		}
+
 		free(cfg->fb->buffer);
 		free(cfg->fb);
 	}
@@ -150,9 +317,56 @@ inky_error_state inky_free(inky_config *cfg)
 		free(cfg->active_fb);
 	}
 
+	/* Safe to free again, or to set up again */
+	cfg->fb = NULL;
+	cfg->active_fb = NULL;
+
+	return INKY_OK;
+}
+
+const inky_panel *inky_panel_get(inky_product pdt)
+{
+	switch (pdt) {
+	case INKY_WHAT:
+		return &_inky_what;
+	case INKY_PHAT:
+		return &_inky_phat;
+	default:
+		return NULL;
+	}
+}
+
+inky_error_state inky_panel_register(inky_config *cfg,
+				     const inky_panel *panel)
+{
+	if (!panel) {
+		return INKY_E_NULL_PTR;
+	}
+
+	if (panel->width == 0 || panel->height == 0) {
+		return INKY_E_OUT_OF_RANGE;
+	}
+
+	/* RAM X addresses are one byte */
+	if (INKY_PANEL_STRIDE(panel) < (panel->width + 7) / 8 ||
+	    INKY_PANEL_STRIDE(panel) > 256) {
+		return INKY_E_OUT_OF_RANGE;
+	}
+
+	if (panel->init_len && !panel->init) {
+		return INKY_E_NULL_PTR;
+	}
+
+	cfg->panel = panel;
+
 	return INKY_OK;
 }
 
+UINT8_t inky_color_available(const inky_config *cfg, inky_color c)
+{
+	return INKY_HAS_COLOR(cfg, c) ? 1 : 0;
+}
+
 inky_error_state inky_fb_usrptr_attach(inky_config *cfg, UINT8_t pos,
 				       void *ptr)
 {
@@ -175,302 +389,697 @@ inky_error_state inky_fb_usrptr_attach(inky_config *cfg, UINT8_t pos,
 	return INKY_OK;
 }
 
-inky_error_state inky_fb_set_pixel(inky_config *cfg, UINT16_t x,
-				   UINT16_t y, inky_color c)
+inky_error_state inky_fb_set_orientation(inky_config *cfg,
+					 inky_orientation orientation)
 {
-	UINT16_t byte_addr;
-	UINT8_t bit_addr;
-	UINT8_t mask;
-	UINT8_t *byte_rst;
+	inky_fb *fb = cfg->fb;
+	inky_rect view;
 
-	/* Check for ranging issues */
-	if (!cfg->fb) {
+	if (!fb || !cfg->panel) {
 		return INKY_E_NOT_CONFIGURED;
 	}
 
-	if (x >= cfg->fb->width) {
+	if ((UINT32_t) orientation > (INKY_ORIENT_270 | INKY_ORIENT_MIRROR)) {
 		return INKY_E_OUT_OF_RANGE;
 	}
 
-	if (y >= cfg->fb->height) {
-		return INKY_E_OUT_OF_RANGE;
+	/* Bands are rows of the framebuffer, so must be rows of the panel */
+	if (fb->band && (orientation & INKY_ORIENT_90)) {
+		return INKY_E_NOT_AVAILABLE;
 	}
 
-	/*
-	 * Address the desired pixel.
-	 *
-	 * Pixel flow is as follows:
-	 *
-	 * 0                   399
-	 * *--------------------->
-	 *                    .
-	 *                 .
-	 *              .
-	 *           .
-	 *        .
-	 *   | .
-	 *   |___
-	 * *--------------------->
-	 * 400                 799
-	 */
-	byte_addr = ((x + cfg->fb->width * y) * 2) / 8;
-	bit_addr = (((x + cfg->fb->width * y) * 2) % 8);
-
-	byte_rst = &cfg->fb->buffer[byte_addr];
-
-	/*
-	 * Find the two-byte pixel data and flip the appropriate bit(s)
-	 */
-	switch (c) {
-
-	case INKY_COLOR_BLACK:
+	_view_size(cfg->panel, (UINT8_t) orientation, fb->scale, &view.w,
+		   &view.h);
 
-		if (cfg->color->black == 0) {
-			return INKY_E_NOT_AVAILABLE;
-		}
+	if (view.w > INKY_FB_WIDTH(fb) || view.h > INKY_FB_HEIGHT(fb)) {
+		inky_error_state ret = _fb_resize(cfg, view.w, view.h);
 
-		mask = 0x01 << bit_addr;
-		*byte_rst = *byte_rst | mask;
+		INKY_CHECK_RESULT(ret, INKY_OK);
+	}
 
-		mask = ~ (0x02 << bit_addr);
-		*byte_rst = *byte_rst & mask;
+	fb->orientation = (UINT8_t) orientation;
 
-		break;
+	/* Keep the viewport inside the canvas */
+	if (fb->view_x + view.w > INKY_FB_WIDTH(fb)) {
+		fb->view_x = INKY_FB_WIDTH(fb) - view.w;
+	}
 
-	case INKY_COLOR_WHITE:
+	if (fb->view_y + view.h > INKY_FB_HEIGHT(fb)) {
+		fb->view_y = INKY_FB_HEIGHT(fb) - view.h;
+	}
 
-		if (cfg->color->white == 0) {
-			return INKY_E_NOT_AVAILABLE;
-		}
+	/* Every pixel lands somewhere else on the panel */
+	view.x = fb->view_x;
+	view.y = fb->view_y;
 
-		mask = ~ (0x03 << bit_addr);
-		*byte_rst = *byte_rst & mask;
+	return inky_fb_mark_dirty(cfg, &view);
+}
 
-		break;
+inky_error_state inky_fb_set_canvas(inky_config *cfg, UINT16_t width,
+				    UINT16_t height)
+{
+	inky_fb *fb = cfg->fb;
+	inky_error_state ret;
+	inky_rect view;
 
-	case INKY_COLOR_RED:
+	if (!fb || !cfg->panel) {
+		return INKY_E_NOT_CONFIGURED;
+	}
 
-		if (cfg->color->red == 0) {
-			return INKY_E_NOT_AVAILABLE;
-		}
+	if (fb->band) {
+		return INKY_E_NOT_AVAILABLE;
+	}
 
-		mask = 0x02 << bit_addr;
-		*byte_rst = *byte_rst | mask;
+	_view_size(cfg->panel, fb->orientation, fb->scale, &view.w, &view.h);
 
-		mask = ~ (0x01 << bit_addr);
-		*byte_rst = *byte_rst & mask;
+	if (width < view.w || height < view.h) {
+		return INKY_E_OUT_OF_RANGE;
+	}
 
-		break;
+	if (width != INKY_FB_WIDTH(fb) || height != INKY_FB_HEIGHT(fb)) {
+		ret = _fb_resize(cfg, width, height);
+		INKY_CHECK_RESULT(ret, INKY_OK);
+	} else {
+		memset(fb->buffer, 0, fb->bytes);
+		fb->view_x = 0;
+		fb->view_y = 0;
+	}
 
-	case INKY_COLOR_YELLOW:
+	view.x = 0;
+	view.y = 0;
 
-		if (cfg->color->yellow == 0) {
-			return INKY_E_NOT_AVAILABLE;
-		}
+	return inky_fb_mark_dirty(cfg, &view);
+}
 
-		mask = 0x02 << bit_addr;
-		*byte_rst = *byte_rst | mask;
+inky_error_state inky_fb_set_viewport(inky_config *cfg, UINT16_t x,
+				      UINT16_t y)
+{
+	inky_fb *fb = cfg->fb;
+	inky_rect view;
 
-		mask = ~ (0x01 << bit_addr);
-		*byte_rst = *byte_rst & mask;
+	if (!fb || !cfg->panel) {
+		return INKY_E_NOT_CONFIGURED;
+	}
 
-		break;
+	_view_size(cfg->panel, fb->orientation, fb->scale, &view.w, &view.h);
 
-	default:
+	if ((UINT32_t) x + view.w > INKY_FB_WIDTH(fb) ||
+	    (UINT32_t) y + view.h > INKY_FB_HEIGHT(fb)) {
+		return INKY_E_OUT_OF_RANGE;
+	}
 
-		return INKY_E_NOT_AVAILABLE;
+	fb->view_x = x;
+	fb->view_y = y;
 
-	}
+	view.x = x;
+	view.y = y;
 
-	return INKY_OK;
+	return inky_fb_mark_dirty(cfg, &view);
 }
 
-inky_error_state inky_update(inky_config *cfg)
+inky_error_state inky_fb_set_scale(inky_config *cfg, UINT8_t scale)
 {
-	inky_error_state ret;
-	UINT8_t height_byte_array[2];
+	inky_fb *fb = cfg->fb;
+	inky_rect view;
 
-	ret = _inky_prep(cfg, height_byte_array);
-
-	if (ret != INKY_OK) {
-		return ret;
+	if (!fb || !cfg->panel) {
+		return INKY_E_NOT_CONFIGURED;
 	}
 
-	/* Set ram X and Y  start and end */
-	ret = _spi_send_command(cfg, RAM_X_RANGE,
-				(UINT8_t[]) {0x00, (cfg->fb->width / 8) - 1},
-				2);
-	INKY_CHECK_RESULT(ret, INKY_OK);
-
-	ret = _spi_send_command(cfg, RAM_Y_RANGE,
-				(UINT8_t[]) {0x00, 0x00,
-					     height_byte_array[1],
-					     height_byte_array[0]}, 4);
-	INKY_CHECK_RESULT(ret, INKY_OK);
+	if (scale != 1 && scale != 2 && scale != 4) {
+		return INKY_E_OUT_OF_RANGE;
+	}
 
-	/* Write the framebuffer to the display */
-	for (UINT16_t i = 0; i < cfg->fb->height; i++) {
-		UINT32_t arr_addr = i * (cfg->fb->width/8);
-		UINT8_t row[cfg->fb->width/8];
-		UINT8_t row_color[cfg->fb->width/8];
-		UINT8_t sweep_color = 0;
-		UINT8_t row_addr[2];
+	_view_size(cfg->panel, fb->orientation, scale, &view.w, &view.h);
 
-		/* Write black and color rows to separate arrays */
-		for (UINT16_t j = 0; j < cfg->fb->width / 8; j++) {
-			UINT16_t data;
+	/* Bands have no pixels to keep, so are always resized */
+	if (view.w != INKY_FB_WIDTH(fb) || view.h != INKY_FB_HEIGHT(fb) ||
+	    fb->band) {
+		inky_error_state ret = _fb_resize(cfg, view.w, view.h);
 
-			data = cfg->fb->buffer[arr_addr + j * 2];
-			data = data |
-				((UINT16_t) cfg->fb->buffer[arr_addr + j * 2 + 1]
-				 << 8);
+		INKY_CHECK_RESULT(ret, INKY_OK);
+	} else {
+		memset(fb->buffer, 0, fb->bytes);
+		fb->view_x = 0;
+		fb->view_y = 0;
+	}
 
-			row[j] = 0;
-			row_color[j] = 0;
+	fb->scale = scale;
 
-			for (UINT8_t k = 0; k < 8; k++) {
-				uint8_t mask;
+	view.x = 0;
+	view.y = 0;
 
-				/* Black and white */
-				mask = data & 0x0001;
-				data = data >> 1;
+	return inky_fb_mark_dirty(cfg, &view);
+}
 
-				mask = mask << k;
+inky_error_state inky_band_setup(inky_config *cfg, UINT16_t rows,
+				 inky_band_render render, void *usrptr)
+{
+#ifdef INKY_FIXED_PRODUCT
+	/* The height of every framebuffer is built in */
+	return INKY_E_NOT_AVAILABLE;
+#else
+	inky_error_state ret;
+	inky_band *band;
+	inky_fb *fb;
 
-				row[j] = row[j] | mask;
+	if (!cfg->panel) {
+		return INKY_E_NOT_CONFIGURED;
+	}
 
-				/* Color */
-				mask = data & 0x0001;
-				data = data >> 1;
+	if (!render) {
+		return INKY_E_NULL_PTR;
+	}
 
-				mask = mask << k;
+	if (cfg->fb) {
+		return INKY_E_NOT_AVAILABLE;
+	}
 
-				row_color[j] = row_color[j] | mask;
-			}
+	/* Rows are packed 8 at a time, so a band holds whole groups */
+	if (rows == 0 || rows % 8) {
+		return INKY_E_OUT_OF_RANGE;
+	}
 
-			if (row_color[j] > 0)
-				sweep_color = 1;
+	band = malloc(sizeof(inky_band)); /* Must free with inky_free() */
 
-			/* Check to see if inverting colors will
-			 * create a white display */
-			row[j] = ~ row[j];
-			row_color[j] = ~ row_color[j];
-		}
+	if (!band) {
+		return INKY_E_OUT_OF_MEMORY;
+	}
 
-		if (!_spi_order_bytes(i, row_addr, 0))
-			return INKY_E_NULL_PTR;
+	rows = rows < cfg->panel->height ? rows : cfg->panel->height;
 
-		ret = _spi_send_command_byte(cfg, RAM_X_PTR_START, 0x00);
-		INKY_CHECK_RESULT(ret, INKY_OK);
+	if ((ret = _allocate_fb(cfg, rows)) != INKY_OK) {
+		free(band);
+		return ret;
+	}
 
-		ret = _spi_send_command(cfg, RAM_Y_PTR_START, row_addr, 2);
-		INKY_CHECK_RESULT(ret, INKY_OK);
+	/* The band takes the rows allocated, the framebuffer keeps the
+	 * size of the whole picture and no pixels */
+	fb = cfg->fb;
+	band->fb = *fb;
+	band->fb.height = rows;
+	band->area.x = 0;
+	band->area.y = 0;
+	band->area.w = 0;
+	band->area.h = 0;
+	band->rows = rows;
+	band->render = render;
+	band->usrptr = usrptr;
+
+	fb->buffer = NULL;
+	fb->bytes = 0;
+	fb->band = band;
 
-		/* Write black/white row */
-		ret = _spi_send_command(cfg, WRITE_PIXEL_BLACK, row,
-					cfg->fb->width/8);
-		INKY_CHECK_RESULT(ret, INKY_OK);
+	return INKY_OK;
+#endif /* #ifdef INKY_FIXED_PRODUCT */
+}
 
-		/* Write color row if it exists */
-		if (sweep_color | 1) {
-			_spi_send_command_byte(cfg, RAM_X_PTR_START, 0x00);
-			_spi_send_command(cfg, RAM_Y_PTR_START, row_addr, 2);
+inky_error_state inky_fb_set_pixel(inky_config *cfg, UINT16_t x,
+				   UINT16_t y, inky_color c)
+{
+	inky_error_state ret;
 
-			_spi_send_command(cfg, WRITE_PIXEL_COLOR, row,
-					  cfg->fb->width/8);
-		}
+	/* Check for ranging issues */
+	if ((ret = pixfmt_fb_check(cfg->fb)) != INKY_OK) {
+		return ret;
 	}
 
-	/* Trigger the refresh and write operation on display */
-	ret = _spi_send_command_byte(cfg, UPDATE_SEQUENCE, 0xC7);
-	INKY_CHECK_RESULT(ret, INKY_OK);
-
-	ret = _spi_send_command(cfg, TRIGGER_UPDATE, NULL, 0);
-	INKY_CHECK_RESULT(ret, INKY_OK);
+	if (x >= INKY_FB_WIDTH(cfg->fb)) {
+		return INKY_E_OUT_OF_RANGE;
+	}
 
-	ret = cfg->delay_us_cb(50, cfg->intf_ptr);
-	INKY_CHECK_RESULT(ret, INKY_OK);
+	if (y >= INKY_FB_HEIGHT(cfg->fb)) {
+		return INKY_E_OUT_OF_RANGE;
+	}
 
-	ret = _busy_wait(cfg);
-	INKY_CHECK_RESULT(ret, INKY_OK);
+	if (!INKY_HAS_COLOR(cfg, c)) {
+		return INKY_E_NOT_AVAILABLE;
+	}
 
-	/* Put display to sleep */
-	ret = _spi_send_command_byte(cfg, ENTER_DEEP_SLEEP, 0x01);
-	INKY_CHECK_RESULT(ret, INKY_OK);
+	/*
+	 * Address the desired pixel.
+	 *
+	 * Pixel flow is as follows:
+	 *
+	 * 0                   399
+	 * *--------------------->
+	 *                    .
+	 *                 .
+	 *              .
+	 *           .
+	 *        .
+	 *   | .
+	 *   |___
+	 * *--------------------->
+	 * 400                 799
+	 */
+	inky_fb_set_pixel_unchecked(cfg->fb, x, y, c);
 
 	return INKY_OK;
 }
 
-inky_error_state inky_update_by_mode(inky_config *cfg,
-				     inky_fb_type update_type)
-{
-	/** @todo Implement function to update, overriding configure
-	 * mode */
-}
-
-inky_error_state inky_clear(inky_config *cfg)
+inky_error_state inky_fb_get_pixel(inky_config *cfg, UINT16_t x,
+				   UINT16_t y, inky_color *out)
 {
 	inky_error_state ret;
+	UINT32_t bit_addr;
 
-	/* Write zeros to all pixels */
-	for (UINT16_t h = 0; h < cfg->fb->height; h++) {
-
-		for (UINT16_t w = 0; w < cfg->fb->width; w++) {
-
-			ret = inky_fb_set_pixel(cfg, w, h, INKY_COLOR_WHITE);
-			INKY_CHECK_RESULT(ret, INKY_OK);
+	if ((ret = pixfmt_fb_check(cfg->fb)) != INKY_OK) {
+		return ret;
+	}
 
-		}
+	if (!out) {
+		return INKY_E_NULL_PTR;
+	}
 
+	if (x >= INKY_FB_WIDTH(cfg->fb) || y >= INKY_FB_HEIGHT(cfg->fb)) {
+		return INKY_E_OUT_OF_RANGE;
 	}
 
-	/* Write zeroed framebuffer to display */
-	ret = inky_update(cfg);
-	INKY_CHECK_RESULT(ret, INKY_OK);
+	bit_addr = (INKY_FB_STRIDE(cfg->fb) * y) * 8 +
+		(UINT32_t) x * INKY_FB_BPP(cfg->fb);
+
+	*out = pixfmt_decode(&cfg->fb->fmt, cfg->color,
+			     (UINT8_t) pixfmt_read_bits(cfg->fb->buffer,
+							bit_addr,
+							INKY_FB_BPP(cfg->fb)));
 
 	return INKY_OK;
 }
 
-/*
-**********************************************************************
-************************* INTERNAL API *******************************
-**********************************************************************
-*/
-
-static inky_error_state _spi_send_data(inky_config *cfg,
-				       const UINT8_t *data,
-				       UINT32_t len)
+inky_error_state inky_fb_fill(inky_config *cfg, inky_color c)
 {
 	inky_error_state ret;
 
-	/* Set DC pin to HIGH to signal the start of data */
-	ret = cfg->gpio_output_cb(INKY_PIN_DC, INKY_PINSTATE_HIGH,
-				  cfg->intf_ptr);
-
-	if (ret != INKY_OK) {
+	if ((ret = pixfmt_fb_check(cfg->fb)) != INKY_OK) {
 		return ret;
 	}
 
-	return cfg->spi_write_cb(data, len, cfg->intf_ptr);
+	if (!INKY_HAS_COLOR(cfg, c)) {
+		return INKY_E_NOT_AVAILABLE;
+	}
+
+	/* Row padding is don't-care, so fill the buffer as one run */
+	pixfmt_get_ops(&cfg->fb->fmt)->fill(cfg->fb->buffer, 0,
+					    cfg->fb->bytes * 8 /
+					    INKY_FB_BPP(cfg->fb),
+					    inky_pixfmt_encode(INKY_FB_BPP(cfg->fb),
+							       c));
+
+	return INKY_OK;
 }
 
-static inky_error_state _spi_send_command(inky_config *cfg, dcommand cmd,
-					  const UINT8_t *data, UINT32_t len)
+inky_error_state inky_fb_hline(inky_config *cfg, UINT16_t x,
+			       UINT16_t y, UINT16_t len, inky_color c)
 {
 	inky_error_state ret;
+	UINT8_t *row;
 
-	/* Set DC pin to LOW to signal the command byte */
-	ret = cfg->gpio_output_cb(INKY_PIN_DC, INKY_PINSTATE_LOW,
-				  cfg->intf_ptr);
-
-	if (ret != INKY_OK) {
+	if ((ret = pixfmt_fb_check(cfg->fb)) != INKY_OK) {
 		return ret;
 	}
 
-	ret = cfg->spi_write_cb((UINT8_t*) &cmd, 1, cfg->intf_ptr);
+	if (y >= INKY_FB_HEIGHT(cfg->fb) ||
+	    (UINT32_t) x + len > INKY_FB_WIDTH(cfg->fb)) {
+		return INKY_E_OUT_OF_RANGE;
+	}
 
-	if (ret != INKY_OK) {
-		return ret;
+	if (!INKY_HAS_COLOR(cfg, c)) {
+		return INKY_E_NOT_AVAILABLE;
+	}
+
+	row = &cfg->fb->buffer[INKY_FB_STRIDE(cfg->fb) * y];
+
+	pixfmt_get_ops(&cfg->fb->fmt)->fill(row, x, len,
+					    inky_pixfmt_encode(INKY_FB_BPP(cfg->fb),
+							       c));
+
+	return INKY_OK;
+}
+
+inky_error_state inky_fb_write_row(inky_config *cfg, UINT16_t y,
+				   const inky_color *src, UINT16_t n)
+{
+	inky_error_state ret;
+	UINT8_t bpp;
+	UINT8_t avail = 0;
+	UINT8_t *row;
+	UINT8_t acc = 0;
+	UINT8_t shift = 0;
+
+	if ((ret = pixfmt_fb_check(cfg->fb)) != INKY_OK) {
+		return ret;
+	}
+
+	if (!src) {
+		return INKY_E_NULL_PTR;
+	}
+
+	if (y >= INKY_FB_HEIGHT(cfg->fb) || n > INKY_FB_WIDTH(cfg->fb)) {
+		return INKY_E_OUT_OF_RANGE;
+	}
+
+	/* Look up the available colors once, not once per pixel */
+	for (UINT8_t c = INKY_COLOR_WHITE; c <= INKY_COLOR_YELLOW; c++) {
+		if (INKY_HAS_COLOR(cfg, (inky_color) c)) {
+			avail = avail | (1 << c);
+		}
+	}
+
+	for (UINT16_t i = 0; i < n; i++) {
+		if ((UINT32_t) src[i] > INKY_COLOR_YELLOW ||
+		    !(avail & (1 << src[i]))) {
+			return INKY_E_NOT_AVAILABLE;
+		}
+	}
+
+	bpp = INKY_FB_BPP(cfg->fb);
+	row = &cfg->fb->buffer[INKY_FB_STRIDE(cfg->fb) * y];
+
+	/* Rows start on a byte boundary, so whole bytes are assembled
+	 * and stored without reading back the framebuffer */
+	for (UINT16_t i = 0; i < n; i++) {
+		acc = acc | (inky_pixfmt_encode(bpp, src[i]) << shift);
+		shift = shift + bpp;
+
+		if (shift == 8) {
+			*row++ = acc;
+			acc = 0;
+			shift = 0;
+		}
+	}
+
+	/* Keep the pixels after n in a partial last byte */
+	if (shift) {
+		UINT8_t mask = (UINT8_t) ((1 << shift) - 1);
+
+		*row = (*row & ~mask) | acc;
+	}
+
+	return INKY_OK;
+}
+
+inky_error_state inky_fb_set_pixels(inky_config *cfg,
+				    const inky_point *pts, UINT32_t n,
+				    inky_color c)
+{
+	inky_error_state ret;
+
+	if ((ret = pixfmt_fb_check(cfg->fb)) != INKY_OK) {
+		return ret;
+	}
+
+	if (!pts && n) {
+		return INKY_E_NULL_PTR;
+	}
+
+	if (!INKY_HAS_COLOR(cfg, c)) {
+		return INKY_E_NOT_AVAILABLE;
+	}
+
+	for (UINT32_t i = 0; i < n; i++) {
+		if (pts[i].x >= INKY_FB_WIDTH(cfg->fb) ||
+		    pts[i].y >= INKY_FB_HEIGHT(cfg->fb)) {
+			return INKY_E_OUT_OF_RANGE;
+		}
+	}
+
+	for (UINT32_t i = 0; i < n; i++) {
+		inky_fb_set_pixel_unchecked(cfg->fb, pts[i].x, pts[i].y, c);
+	}
+
+	return INKY_OK;
+}
+
+inky_error_state inky_update(inky_config *cfg)
+{
+	inky_error_state ret;
+
+	ret = _op_run(cfg, INKY_OP_UPDATE, NULL);
+	INKY_CHECK_RESULT(ret, INKY_OK);
+
+	/* The panel now shows the whole framebuffer and its layers */
+	_dirty_reset(cfg);
+
+	return INKY_OK;
+}
+
+inky_error_state inky_fb_mark_dirty(inky_config *cfg, const inky_rect *area)
+{
+	inky_rect *d;
+	UINT16_t x1;
+	UINT16_t y1;
+
+	if (!cfg->fb) {
+		return INKY_E_NOT_CONFIGURED;
+	}
+
+	if (!area) {
+		return INKY_E_NULL_PTR;
+	}
+
+	d = &cfg->fb->dirty;
+
+	if (area->w == 0 || area->h == 0 ||
+	    area->x >= INKY_FB_WIDTH(cfg->fb) ||
+	    area->y >= INKY_FB_HEIGHT(cfg->fb)) {
+		return INKY_OK;
+	}
+
+	x1 = area->x + area->w < INKY_FB_WIDTH(cfg->fb) ?
+		area->x + area->w : INKY_FB_WIDTH(cfg->fb);
+	y1 = area->y + area->h < INKY_FB_HEIGHT(cfg->fb) ?
+		area->y + area->h : INKY_FB_HEIGHT(cfg->fb);
+
+	/* Union with the current rectangle, if any */
+	if (d->w && d->h) {
+		x1 = d->x + d->w > x1 ? d->x + d->w : x1;
+		y1 = d->y + d->h > y1 ? d->y + d->h : y1;
+		d->x = d->x < area->x ? d->x : area->x;
+		d->y = d->y < area->y ? d->y : area->y;
+	} else {
+		d->x = area->x;
+		d->y = area->y;
+	}
+
+	d->w = x1 - d->x;
+	d->h = y1 - d->y;
+
+	return INKY_OK;
+}
+
+inky_error_state inky_update_dirty(inky_config *cfg)
+{
+	inky_error_state ret;
+	inky_rect view;
+
+	if (!cfg->fb) {
+		return INKY_E_NOT_CONFIGURED;
+	}
+
+	inky_layer_collect_dirty(cfg);
+
+	if (cfg->fb->dirty.w == 0 || cfg->fb->dirty.h == 0) {
+		return INKY_OK;
+	}
+
+	/* Changes off the viewport are sent when it moves over them */
+	if (_view_clip(cfg, &cfg->fb->dirty, &view)) {
+		ret = inky_update_region(cfg, &cfg->fb->dirty);
+		INKY_CHECK_RESULT(ret, INKY_OK);
+	}
+
+	cfg->fb->dirty.w = 0;
+	cfg->fb->dirty.h = 0;
+
+	return INKY_OK;
+}
+
+inky_error_state inky_update_region(inky_config *cfg, const inky_rect *area)
+{
+	if (!area) {
+		return INKY_E_NULL_PTR;
+	}
+
+	return _op_run(cfg, INKY_OP_UPDATE, area);
+}
+
+inky_error_state inky_update_by_mode(inky_config *cfg,
+				     inky_fb_type update_type)
+{
+	/** @todo Implement function to update, overriding configure
+	 * mode */
+}
+
+inky_error_state inky_clear(inky_config *cfg)
+{
+	inky_error_state ret;
+
+	ret = _op_run(cfg, INKY_OP_CLEAR, NULL);
+	INKY_CHECK_RESULT(ret, INKY_OK);
+
+	/* Nothing drawn so far is left to send, the layers included */
+	_dirty_reset(cfg);
+
+	return INKY_OK;
+}
+
+inky_error_state inky_op_begin(inky_config *cfg, inky_op *op,
+			       inky_op_type type)
+{
+	if (!op) {
+		return INKY_E_NULL_PTR;
+	}
+
+	/* Stop if not configured. Resetting needs no framebuffer, so
+	 * setup can run without allocating one */
+	if (!cfg->fb && type != INKY_OP_RESET) {
+		return INKY_E_NOT_CONFIGURED;
+	}
+
+	return _op_start(cfg, op, type, NULL);
+}
+
+inky_error_state inky_op_begin_region(inky_config *cfg, inky_op *op,
+				      const inky_rect *area)
+{
+	if (!op || !area) {
+		return INKY_E_NULL_PTR;
+	}
+
+	if (!cfg->fb) {
+		return INKY_E_NOT_CONFIGURED;
+	}
+
+	if (area->w == 0 || area->h == 0 ||
+	    area->x + area->w > INKY_FB_WIDTH(cfg->fb) ||
+	    area->y + area->h > INKY_FB_HEIGHT(cfg->fb)) {
+		return INKY_E_OUT_OF_RANGE;
+	}
+
+	return _op_start(cfg, op, INKY_OP_UPDATE, area);
+}
+
+inky_error_state inky_op_step(inky_config *cfg, inky_op *op)
+{
+	inky_error_state ret;
+
+	if (!op) {
+		return INKY_E_NULL_PTR;
+	}
+
+	op->wait = INKY_WAIT_NONE;
+
+	/*
+	 * Each stage does the work that can be done without waiting,
+	 * then records what it is waiting on and which stage follows.
+	 *
+	 * RESET:	ASSERT -> RELEASE -> SOFT -> DONE
+	 * UPDATE:	RESET... -> REFRESH -> SLEEP -> DONE
+	 * CLEAR:	Same as UPDATE, with a white framebuffer
+	 */
+	switch ((_op_stage) op->stage) {
+	case _OP_RESET_ASSERT:
+
+		ret = cfg->gpio_output_cb(INKY_PIN_RESET, INKY_PINSTATE_LOW,
+					  cfg->intf_ptr);
+		INKY_CHECK_RESULT(ret, INKY_OK);
+
+		return _op_wait(op, _OP_RESET_RELEASE, INKY_WAIT_DELAY,
+				100000);
+
+	case _OP_RESET_RELEASE:
+
+		ret = cfg->gpio_output_cb(INKY_PIN_RESET, INKY_PINSTATE_HIGH,
+					  cfg->intf_ptr);
+		INKY_CHECK_RESULT(ret, INKY_OK);
+
+		return _op_wait(op, _OP_RESET_SOFT, INKY_WAIT_DELAY, 100000);
+
+	case _OP_RESET_SOFT:
+
+		ret = _spi_send_command(cfg, SOFT_RESET, NULL, 0);
+		INKY_CHECK_RESULT(ret, INKY_OK);
+
+		return _op_wait(op, _OP_RESET_DONE, INKY_WAIT_BUSY,
+				INKY_BUSY_TIMEOUT_US);
+
+	case _OP_RESET_DONE:
+
+		if (op->type == INKY_OP_RESET) {
+			op->stage = _OP_DONE;
+			return INKY_OK;
+		}
+
+		ret = _inky_transfer(cfg, &op->area,
+				     op->type == INKY_OP_CLEAR);
+		INKY_CHECK_RESULT(ret, INKY_OK);
+
+		return _op_wait(op, _OP_UPDATE_REFRESH, INKY_WAIT_DELAY, 50);
+
+	case _OP_UPDATE_REFRESH:
+
+		return _op_wait(op, _OP_UPDATE_SLEEP, INKY_WAIT_BUSY,
+				INKY_BUSY_TIMEOUT_US);
+
+	case _OP_UPDATE_SLEEP:
+
+		/* Put display to sleep */
+		op->stage = _OP_DONE;
+
+		return _spi_send_command_byte(cfg, ENTER_DEEP_SLEEP, 0x01);
+
+	case _OP_DONE:
+
+		return INKY_OK;
+
+	default:
+
+		return INKY_E_FAILURE;
+
+	}
+}
+
+/*
+**********************************************************************
+************************* INTERNAL API *******************************
+**********************************************************************
+*/
+
+static inky_error_state _spi_send_data(inky_config *cfg,
+				       const UINT8_t *data,
+				       UINT32_t len)
+{
+	inky_error_state ret;
+
+	/* Set DC pin to HIGH to signal the start of data */
+	ret = cfg->gpio_output_cb(INKY_PIN_DC, INKY_PINSTATE_HIGH,
+				  cfg->intf_ptr);
+
+	if (ret != INKY_OK) {
+		return ret;
+	}
+
+	return cfg->spi_write_cb(data, len, cfg->intf_ptr);
+}
+
+static inky_error_state _spi_send_command(inky_config *cfg, dcommand cmd,
+					  const UINT8_t *data, UINT32_t len)
+{
+	inky_error_state ret;
+
+	/* Set DC pin to LOW to signal the command byte */
+	ret = cfg->gpio_output_cb(INKY_PIN_DC, INKY_PINSTATE_LOW,
+				  cfg->intf_ptr);
+
+	if (ret != INKY_OK) {
+		return ret;
+	}
+
+	ret = cfg->spi_write_cb((UINT8_t*) &cmd, 1, cfg->intf_ptr);
+
+	if (ret != INKY_OK) {
+		return ret;
 	}
 
 	if (data) {
@@ -505,75 +1114,161 @@ static inky_error_state _spi_send_command_byte(inky_config *cfg,
 	return ret;
 }
 
-static inky_error_state _reset(inky_config *cfg)
+static inky_error_state _op_wait(inky_op *op, _op_stage next,
+				 inky_wait wait, UINT32_t delay_us)
+{
+	op->stage = next;
+	op->wait = wait;
+	op->delay_us = delay_us;
+
+	return INKY_OK;
+}
+
+static inky_error_state _op_start(inky_config *cfg, inky_op *op,
+				  inky_op_type type, const inky_rect *area)
 {
 	inky_error_state ret;
 
-	if (!cfg->fb) {
-		/* Stop if not configured */
-		return INKY_E_NOT_CONFIGURED;
+	op->type = type;
+	op->stage = _OP_RESET_ASSERT;
+	op->wait = INKY_WAIT_NONE;
+	op->delay_us = 0;
+
+	if (area) {
+		op->area = *area;
+	} else if (cfg->fb) {
+		op->area.x = cfg->fb->view_x;
+		op->area.y = cfg->fb->view_y;
+		_view_size(cfg->panel, cfg->fb->orientation, cfg->fb->scale,
+			   &op->area.w, &op->area.h);
 	}
 
-	ret = cfg->gpio_output_cb(INKY_PIN_RESET, INKY_PINSTATE_LOW,
-				  cfg->intf_ptr);
+	switch (type) {
+	case INKY_OP_CLEAR:
 
-	if (ret != INKY_OK) {
-		return ret;
-	}
+		/* Bands are cleared as they are sent */
+		if (cfg->fb->band) {
+			break;
+		}
 
-	cfg->delay_us_cb(100000, cfg->intf_ptr);
-	cfg->gpio_output_cb(INKY_PIN_RESET, INKY_PINSTATE_HIGH,
-			    cfg->intf_ptr);
+		/* Write zeros to all pixels */
+		ret = inky_fb_fill(cfg, INKY_COLOR_WHITE);
+		INKY_CHECK_RESULT(ret, INKY_OK);
 
-	if (ret != INKY_OK) {
-		return ret;
+		break;
+	case INKY_OP_RESET:
+	case INKY_OP_UPDATE:
+		break;
+	default:
+		return INKY_E_NOT_AVAILABLE;
+		break;
 	}
 
-	cfg->delay_us_cb(100000, cfg->intf_ptr);
+	return inky_op_step(cfg, op);
+}
+
+static inky_error_state _op_run(inky_config *cfg, inky_op_type type,
+				const inky_rect *area)
+{
+	inky_error_state ret;
+	inky_op op;
 
-	/* Send soft reset */
-	if ((ret =_spi_send_command(cfg, SOFT_RESET, NULL, 0)) != INKY_OK) {
-		return ret;
+	if (area) {
+		ret = inky_op_begin_region(cfg, &op, area);
+	} else {
+		ret = inky_op_begin(cfg, &op, type);
 	}
 
-	/* Poll the busy pin, blocking until it returns */
-	if ((ret = _busy_wait(cfg)) != INKY_OK) {
-		return ret;
+	while (ret == INKY_OK && op.wait != INKY_WAIT_NONE) {
+		if (op.wait == INKY_WAIT_DELAY) {
+			ret = cfg->delay_us_cb(op.delay_us, cfg->intf_ptr);
+		} else {
+			ret = _busy_wait(cfg);
+		}
+
+		INKY_CHECK_RESULT(ret, INKY_OK);
+
+		ret = inky_op_step(cfg, &op);
 	}
 
-	return INKY_OK;
+	return ret;
+}
+
+static inky_error_state _reset(inky_config *cfg)
+{
+	/* Blocks until polling BUSY_PIN returns, or times out */
+	return _op_run(cfg, INKY_OP_RESET, NULL);
 }
 
 static inky_error_state _busy_wait(inky_config *cfg)
 {
-	return cfg->gpio_poll_cb(INKY_PIN_BUSY, 30000000, cfg->intf_ptr);
+	return cfg->gpio_poll_cb(INKY_PIN_BUSY, INKY_BUSY_TIMEOUT_US,
+				 cfg->intf_ptr);
+}
+
+static inky_error_state _select_panel(inky_config *cfg)
+{
+#ifdef INKY_FIXED_PRODUCT
+	if (cfg->pdt != INKY_FIXED_PRODUCT) {
+		return INKY_E_NOT_AVAILABLE;
+	}
+
+	/* Geometry is compiled in, so only the built-in panel fits */
+	cfg->panel = inky_panel_get(INKY_FIXED_PRODUCT);
+#else
+	if (INKY_PRODUCT(cfg) != INKY_CUSTOM) {
+		cfg->panel = inky_panel_get(INKY_PRODUCT(cfg));
+	}
+#endif /* #ifdef INKY_FIXED_PRODUCT */
+
+	if (!cfg->panel) {
+		/* INKY_CUSTOM needs inky_panel_register() */
+		return INKY_E_NOT_CONFIGURED;
+	}
+
+	return INKY_OK;
 }
 
-static inky_error_state _allocate_fb(inky_config *cfg)
+static inky_error_state _allocate_fb(inky_config *cfg, UINT16_t rows)
 {
-	struct _display_res *dr;
+	const inky_panel *panel = cfg->panel;
+	const inky_pixfmt *fmt;
+	inky_pixel_format format;
 
 	if (cfg->fb) {
 		return INKY_OK;
 	}
 
 	/*
-	 * Check the inky product name
-	 */
-	/** @todo Does this really belong in frame buffer allocation?
+	 * Choose the pixel format. Panels without red or yellow only
+	 * need one bit per pixel
 	 */
-	switch (cfg->pdt) {
-	case INKY_WHAT:
-		dr = &_inky_what;
-		break;
-	case INKY_PHAT:
-		dr = &_inky_phat;
-		break;
-	default:
+	format = cfg->fb_format;
+
+	if (format == INKY_PIXFMT_AUTO) {
+		format = (INKY_HAS_COLOR(cfg, INKY_COLOR_RED) ||
+			  INKY_HAS_COLOR(cfg, INKY_COLOR_YELLOW)) ?
+			INKY_PIXFMT_2BPP : INKY_PIXFMT_1BPP;
+	}
+
+	fmt = pixfmt_describe(format);
+
+	if (!fmt) {
 		return INKY_E_NOT_AVAILABLE;
-		break;
 	}
 
+	/* Check the format holds every color and matches any fixed build */
+	if (fmt->bpp == 1 && (INKY_HAS_COLOR(cfg, INKY_COLOR_RED) ||
+			      INKY_HAS_COLOR(cfg, INKY_COLOR_YELLOW))) {
+		return INKY_E_NOT_AVAILABLE;
+	}
+
+#ifdef INKY_FIXED_COLOR
+	if (fmt->bpp != (INKY_FIXED_COLOR == INKY_COLOR_BLACK ? 1 : 2)) {
+		return INKY_E_NOT_AVAILABLE;
+	}
+#endif /* #ifdef INKY_FIXED_COLOR */
+
 	cfg->fb = malloc(sizeof(inky_fb)); /* Must free with inky_free() */
 
 	if (!cfg->fb) {
@@ -581,10 +1276,12 @@ static inky_error_state _allocate_fb(inky_config *cfg)
 	}
 
 	/*
-	 * Frame buffer size will be dependent on the resolution
+	 * Frame buffer size will be dependent on the resolution and
+	 * the pixel format
 	 *
 	 * As a pixel is typical white, black, or one of red/yellow,
-	 * we need two bits to address each pixel
+	 * we need two bits to address each pixel, or one bit for
+	 * panels without a color
 	 *
 	 * Pixel addressing is as follows:
 	 *
@@ -592,11 +1289,13 @@ static inky_error_state _allocate_fb(inky_config *cfg)
 	 *	Black:	1
 	 *	Color:	2
 	 *
-	 * The framebuffer will be allocated with the minimum number
-	 * of bytes required to contain height * width * 2 bits. This
-	 * size will then be stored in fb->bytes
+	 * Each row of width * bpp bits is padded to a whole 32 bit
+	 * word, stored in fb->stride, so rows can be worked on a word
+	 * at a time and odd widths such as the pHAT's 122 pixels need
+	 * no special cases. The framebuffer holds height rows, and its
+	 * size is stored in fb->bytes
 	 *
-	 * Pixels are encoded as such:
+	 * Pixels are encoded as such for 2bpp:
 	 *
 	 *        Byte 0   Byte 1
 	 *       xxxxxxxx xxxxxxxx
@@ -605,13 +1304,23 @@ static inky_error_state _allocate_fb(inky_config *cfg)
 	 * |Col3|B/W3|Col2|B/W2|Col1|B/W1|Col0|B/W0|
 	 *  ---------------------------------------
 	 *
-	 * Then Byte 1 would start with B/W4 as the rightmost bit
+	 * Then Byte 1 would start with B/W4 as the rightmost bit. 1bpp
+	 * and 4bpp also store pixel 0 of each row in the lowest bits of
+	 * the row's first byte.
 	 */
 
-	cfg->fb->width = dr->width;
-	cfg->fb->height = dr->height;
+	cfg->fb->width = panel->width;
+	cfg->fb->height = panel->height;
+	cfg->fb->fmt = *fmt;
+	cfg->fb->orientation = INKY_ORIENT_0;
+	cfg->fb->scale = 1;
+	cfg->fb->view_x = 0;
+	cfg->fb->view_y = 0;
+	cfg->fb->layers = NULL;
+	cfg->fb->band = NULL;
 
-	cfg->fb->bytes = cfg->fb->height * cfg->fb->width * 2 / 8;
+	cfg->fb->stride = INKY_ROW_STRIDE(cfg->fb->width, fmt->bpp);
+	cfg->fb->bytes = cfg->fb->stride * (rows ? rows : cfg->fb->height);
 
 	cfg->fb->buffer = malloc(cfg->fb->bytes); /* Must free with inky_free() */
 
@@ -620,9 +1329,13 @@ static inky_error_state _allocate_fb(inky_config *cfg)
 	}
 
 	/* Initialize framebuffer with zeros */
-	for (UINT16_t i = 0; i < cfg->fb->bytes; i++) {
-		cfg->fb->buffer[i] = 0;
-	}
+	memset(cfg->fb->buffer, 0, cfg->fb->bytes);
+
+	/* Nothing has been drawn yet */
+	cfg->fb->dirty.x = 0;
+	cfg->fb->dirty.y = 0;
+	cfg->fb->dirty.w = 0;
+	cfg->fb->dirty.h = 0;
 
 	/*
 	 * Check config for fb related flags to set fb type
@@ -645,6 +1358,25 @@ static inky_error_state _allocate_fb(inky_config *cfg)
 	return INKY_OK;
 }
 
+#ifndef INKY_FIXED_COLOR
+static UINT8_t _color_available(const inky_color_config *color,
+				inky_color c)
+{
+	switch (c) {
+	case INKY_COLOR_WHITE:
+		return color->white;
+	case INKY_COLOR_BLACK:
+		return color->black;
+	case INKY_COLOR_RED:
+		return color->red;
+	case INKY_COLOR_YELLOW:
+		return color->yellow;
+	default:
+		return 0;
+	}
+}
+#endif /* #ifndef INKY_FIXED_COLOR */
+
 static UINT8_t* _spi_order_bytes(UINT16_t input, UINT8_t* result,
 				 UINT8_t msb_first) {
 	UINT8_t height_byte_little;
@@ -669,74 +1401,527 @@ static UINT8_t* _spi_order_bytes(UINT16_t input, UINT8_t* result,
 	return result;
 }
 
-static inky_error_state _inky_prep(inky_config *cfg, 
-				   UINT8_t *height_byte_array)
+static inky_error_state _run_init(inky_config *cfg, const UINT8_t *prog,
+				  UINT32_t len)
 {
 	inky_error_state ret;
+	UINT8_t skip = 0;
+	UINT32_t i = 0;
+
+	while (i < len) {
+		UINT8_t cmd = prog[i++];
+		UINT8_t n;
+
+		switch (cmd) {
+		case INKY_INIT_IF_RED:
+			skip = !INKY_HAS_COLOR(cfg, INKY_COLOR_RED);
+			continue;
+		case INKY_INIT_IF_YELLOW:
+			skip = !INKY_HAS_COLOR(cfg, INKY_COLOR_YELLOW);
+			continue;
+		case INKY_INIT_LUTS:
+			ret = _send_luts(cfg);
+			INKY_CHECK_RESULT(ret, INKY_OK);
+			skip = 0;
+			continue;
+		default:
+			break;
+		}
 
-	if ((ret = _reset(cfg))) {
-		return ret;
-	}
+		/* Command byte, data length, then data */
+		if (i >= len || i + prog[i] + 1 > len) {
+			return INKY_E_OUT_OF_RANGE;
+		}
 
-	if (!_spi_order_bytes(cfg->fb->height, height_byte_array, 1))
-		return INKY_E_NULL_PTR;
+		n = prog[i++];
 
-	/* Use command sequence from Pimoroni's Inky library */
-	_spi_send_command_byte(cfg, ANALOG_BLOCK_CONTROL, 0x54);
-	_spi_send_command_byte(cfg, DIGITAL_BLOCK_CONTROL, 0x3b);
-	_spi_send_command(cfg, GATE_SETTING,
-			  (UINT8_t[]) {
-				  height_byte_array[1],
-				  height_byte_array[0],
-				  0x00
-			  }, 3);
-	_spi_send_command_byte(cfg, GATE_DRIVING_VOLTAGE, 0x17);
-	_spi_send_command(cfg, SOURCE_DRIVING_VOLTAGE,
-			  (UINT8_t[]) {0x41, 0xac, 0x32}, 3);
-	_spi_send_command_byte(cfg, DUMMY_LINE_PERIOD, 0x07);
-	_spi_send_command_byte(cfg, GATE_LINE_WIDTH, 0x04);
-	_spi_send_command_byte(cfg, DATA_ENTRY_MODE, 0x03);
-	_spi_send_command_byte(cfg, VCOM_REGISTER, 0x3c);
+		if (!skip) {
+			ret = _spi_send_command(cfg, (dcommand) cmd,
+						n ? &prog[i] : NULL, n);
+			INKY_CHECK_RESULT(ret, INKY_OK);
+		}
 
-	/* Set border config to white */
-	_spi_send_command_byte(cfg, GS_TRANSITION_DEFINE, 0x00);
-	_spi_send_command_byte(cfg, GS_TRANSITION_DEFINE, 0x31);
+		skip = 0;
+		i = i + n;
+	}
+
+	return INKY_OK;
+}
 
-	if (cfg->color->yellow) {
-		_spi_send_command(cfg, SOURCE_DRIVING_VOLTAGE,
-				  (UINT8_t[]) {0x07, 0xac, 0x32},
-				  3);
+static inky_error_state _send_luts(inky_config *cfg)
+{
+	const inky_panel *panel = cfg->panel;
+	const UINT8_t *lut;
+
+	if (INKY_HAS_COLOR(cfg, INKY_COLOR_YELLOW)) {
+		lut = panel->lut_yellow;
+	} else if (INKY_HAS_COLOR(cfg, INKY_COLOR_RED)) {
+		lut = panel->lut_red;
+	} else {
+		lut = panel->lut_black;
 	}
 
-	if (cfg->color->red && (cfg->pdt == INKY_WHAT)) {
-		_spi_send_command(cfg, SOURCE_DRIVING_VOLTAGE,
-				  (UINT8_t[]) {0x30, 0xac, 0x22},
-				  3);
+	if (!lut) {
+		return INKY_E_NOT_AVAILABLE;
 	}
 
+	return _spi_send_command(cfg, SET_LUTS, lut, panel->lut_len);
+}
+
+static inky_error_state _inky_prep(inky_config *cfg)
+{
 	/* Support for different update modes will be added later */
 	switch (cfg->fb->fb_type) {
 	case INKY_FB_REFRESH_ALWAYS:
-		if (cfg->color->yellow) {
-			_spi_send_command(cfg, SET_LUTS,
-					  lut_yellow_refresh,
-					  sizeof(lut_yellow_refresh));
-		} else if (cfg->color->red) {
-			_spi_send_command(cfg, SET_LUTS,
-					  lut_red_refresh,
-					  sizeof(lut_red_refresh));
-		}
-		else {
-			_spi_send_command(cfg, SET_LUTS,
-					  lut_black_refresh,
-					  sizeof(lut_black_refresh));
-		}
-
 		break;
 	default:
 		return INKY_E_NOT_AVAILABLE;
 		break;
 	}
 
+	return _run_init(cfg, cfg->panel->init, cfg->panel->init_len);
+}
+
+static inky_error_state _inky_transfer(inky_config *cfg,
+				       const inky_rect *area, UINT8_t blank)
+{
+	inky_error_state ret;
+	const inky_panel *panel = cfg->panel;
+	UINT16_t stride = INKY_PANEL_STRIDE(panel);
+	UINT8_t flags = _orient_flags(cfg->fb->orientation);
+	UINT8_t scale = cfg->fb->scale;
+	UINT8_t height_byte_array[2];
+	UINT8_t x_range[2] = { 0x00, (UINT8_t) (stride - 1) };
+	UINT8_t bw[8 * stride];
+	UINT8_t color[8 * stride];
+	UINT8_t wide[stride];
+	UINT8_t wide_color[stride];
+	UINT8_t rev[stride];
+	UINT8_t rev_color[stride];
+	UINT16_t band = 0;
+	inky_rect view;
+	UINT16_t c0, c1;
+	UINT16_t r0, r1;
+	UINT16_t first;
+	UINT16_t len;
+	UINT8_t x_ptr;
+
+	ret = _inky_prep(cfg);
+	INKY_CHECK_RESULT(ret, INKY_OK);
+
+	if (!_spi_order_bytes(panel->height, height_byte_array, 1))
+		return INKY_E_NULL_PTR;
+
+	/* Mirroring is left to the controller: X decrements while rows
+	 * are written, and the gates scan from the bottom */
+	if (flags & _ORIENT_FLIP_X) {
+		ret = _spi_send_command_byte(cfg, DATA_ENTRY_MODE, 0x02);
+		INKY_CHECK_RESULT(ret, INKY_OK);
+
+		x_range[0] = (UINT8_t) (stride - 1);
+		x_range[1] = 0x00;
+	}
+
+	if (flags & _ORIENT_FLIP_Y) {
+		ret = _spi_send_command(cfg, GATE_SETTING,
+					(UINT8_t[]) {height_byte_array[1],
+						     height_byte_array[0],
+						     0x01}, 3);
+		INKY_CHECK_RESULT(ret, INKY_OK);
+	}
+
+	/* Set ram X and Y  start and end */
+	ret = _spi_send_command(cfg, RAM_X_RANGE, x_range, 2);
+	INKY_CHECK_RESULT(ret, INKY_OK);
+
+	ret = _spi_send_command(cfg, RAM_Y_RANGE,
+				(UINT8_t[]) {0x00, 0x00,
+					     height_byte_array[1],
+					     height_byte_array[0]}, 4);
+	INKY_CHECK_RESULT(ret, INKY_OK);
+
+	/* Panel columns and rows of the part of area in the viewport */
+	_view_clip(cfg, area, &view);
+
+	/* The picture may have changed since the last band was drawn */
+	if (cfg->fb->band) {
+		cfg->fb->band->area.h = 0;
+	}
+
+	if (flags & _ORIENT_TRANSPOSE) {
+		c0 = view.y * scale;
+		c1 = (view.y + view.h) * scale;
+		r0 = view.x * scale;
+		r1 = (view.x + view.w) * scale;
+	} else {
+		c0 = view.x * scale;
+		c1 = (view.x + view.w) * scale;
+		r0 = view.y * scale;
+		r1 = (view.y + view.h) * scale;
+	}
+
+	c1 = c1 < panel->width ? c1 : panel->width;
+	r1 = r1 < panel->height ? r1 : panel->height;
+
+	/* Bytes of each row holding the columns of area, counted in the
+	 * order they are sent, all of them when the area spans the panel
+	 * so padding columns are cleared */
+	if (c0 == 0 && c1 == panel->width) {
+		first = 0;
+		len = stride;
+	} else if (flags & _ORIENT_FLIP_X) {
+		UINT16_t pad = stride * 8 - panel->width;
+
+		first = (c0 + pad) / 8;
+		len = (c1 + pad + 7) / 8 - first;
+	} else {
+		first = c0 / 8;
+		len = (c1 + 7) / 8 - first;
+	}
+
+	x_ptr = (UINT8_t) (flags & _ORIENT_FLIP_X ? stride - 1 - first :
+			   first);
+
+	/* Write the rows of area to the display. Framebuffer lines are
+	 * packed 8 at a time, and each is sent as scale panel rows */
+	for (UINT16_t i = r0; i < r1; i++) {
+		UINT16_t line = i / scale;
+		UINT8_t *row;
+		UINT8_t *row_color;
+		UINT8_t row_addr[2];
+
+		if (i == r0 || line >= band + 8) {
+			UINT16_t end = (r1 - 1) / scale + 1;
+
+			band = line & ~7;
+
+			if (cfg->fb->band) {
+				ret = _band_render(cfg, band, blank);
+				INKY_CHECK_RESULT(ret, INKY_OK);
+			}
+
+			_pack_band(cfg, flags, band, line,
+				   band + 8 < end ? band + 8 : end, stride,
+				   blank, bw, color);
+		}
+
+		row = &bw[(line - band) * stride];
+		row_color = &color[(line - band) * stride];
+
+		if (scale > 1) {
+			pixfmt_widen(wide, row, stride, scale);
+			pixfmt_widen(wide_color, row_color, stride, scale);
+
+			/* Clear the columns past the last pixel */
+			if (panel->width % 8) {
+				UINT8_t pad = 0xff >> (panel->width % 8);
+
+				wide[panel->width / 8] |= pad;
+				wide_color[panel->width / 8] &= ~pad;
+			}
+
+			row = wide;
+			row_color = wide_color;
+		}
+
+		if (flags & _ORIENT_FLIP_X) {
+			_mirror_row(row, rev, stride, panel->width, 0xff);
+			_mirror_row(row_color, rev_color, stride,
+				    panel->width, 0x00);
+			row = rev;
+			row_color = rev_color;
+		}
+
+		if (!_spi_order_bytes(i, row_addr, 0))
+			return INKY_E_NULL_PTR;
+
+		ret = _spi_send_command_byte(cfg, RAM_X_PTR_START, x_ptr);
+		INKY_CHECK_RESULT(ret, INKY_OK);
+
+		ret = _spi_send_command(cfg, RAM_Y_PTR_START, row_addr, 2);
+		INKY_CHECK_RESULT(ret, INKY_OK);
+
+		/* Write black/white row */
+		ret = _spi_send_command(cfg, WRITE_PIXEL_BLACK, &row[first],
+					len);
+		INKY_CHECK_RESULT(ret, INKY_OK);
+
+		/* Write color row, clearing stale color on black panels */
+		ret = _spi_send_command_byte(cfg, RAM_X_PTR_START, x_ptr);
+		INKY_CHECK_RESULT(ret, INKY_OK);
+
+		ret = _spi_send_command(cfg, RAM_Y_PTR_START, row_addr, 2);
+		INKY_CHECK_RESULT(ret, INKY_OK);
+
+		ret = _spi_send_command(cfg, WRITE_PIXEL_COLOR,
+					&row_color[first], len);
+		INKY_CHECK_RESULT(ret, INKY_OK);
+	}
+
+	/* Trigger the refresh and write operation on display */
+	ret = _spi_send_command_byte(cfg, UPDATE_SEQUENCE, 0xC7);
+	INKY_CHECK_RESULT(ret, INKY_OK);
+
+	ret = _spi_send_command(cfg, TRIGGER_UPDATE, NULL, 0);
+	INKY_CHECK_RESULT(ret, INKY_OK);
+
 	return INKY_OK;
 }
+
+static UINT8_t _orient_flags(UINT8_t orientation)
+{
+	static const UINT8_t turns[] = {
+		0,
+		_ORIENT_TRANSPOSE | _ORIENT_FLIP_X,
+		_ORIENT_FLIP_X | _ORIENT_FLIP_Y,
+		_ORIENT_TRANSPOSE | _ORIENT_FLIP_Y
+	};
+	UINT8_t flags = turns[orientation & INKY_ORIENT_270];
+
+	/* Mirroring framebuffer columns flips whichever panel direction
+	 * they run along */
+	if (orientation & INKY_ORIENT_MIRROR) {
+		flags ^= flags & _ORIENT_TRANSPOSE ? _ORIENT_FLIP_Y :
+			_ORIENT_FLIP_X;
+	}
+
+	return flags;
+}
+
+static void _pack_band(inky_config *cfg, UINT8_t flags, UINT16_t band,
+		       UINT16_t r0, UINT16_t r1, UINT16_t stride,
+		       UINT8_t blank, UINT8_t *bw, UINT8_t *color)
+{
+	const inky_fb *fb = cfg->fb;
+	const pixfmt_ops *ops = pixfmt_get_ops(&fb->fmt);
+	const inky_fb *src = fb->band ? &fb->band->fb : fb;
+	/* A clear sends the white canvas alone */
+	UINT8_t compose = fb->layers && !blank;
+	UINT8_t line[compose ? INKY_FB_STRIDE(fb) : 1];
+	UINT16_t w, h, n;
+
+	_view_size(cfg->panel, fb->orientation, fb->scale, &w, &h);
+
+	/* Split each row into black and color planes, padding any extra
+	 * RAM columns with white. Rows are packed straight from the
+	 * viewport of the canvas or from the band in memory, or composed
+	 * with the layers over it first */
+	if (!(flags & _ORIENT_TRANSPOSE)) {
+		for (UINT16_t i = r0; i < r1; i++) {
+			UINT8_t *row = &bw[(i - band) * stride];
+			UINT8_t *row_color = &color[(i - band) * stride];
+			UINT32_t y = fb->band ? i - fb->band->area.y :
+				fb->view_y + i;
+
+			memset(row, 0xff, stride);
+			memset(row_color, 0x00, stride);
+
+			if (compose) {
+				inky_layer_compose_row(fb, fb->view_y + i,
+						       fb->view_x, w, line);
+				ops->pack(line, 0, w, row, row_color);
+				continue;
+			}
+
+			ops->pack(&src->buffer[INKY_FB_STRIDE(src) * y],
+				  fb->view_x, w, row, row_color);
+		}
+
+		return;
+	}
+
+	/* Lines band to band + 7 are framebuffer columns: pack those 8
+	 * columns of 8 framebuffer rows at a time and transpose them into
+	 * one byte of each line */
+	n = w - band < 8 ? w - band : 8;
+
+	for (UINT16_t k = 0; k < stride; k++) {
+		UINT8_t blk[8];
+		UINT8_t blk_color[8];
+
+		for (UINT8_t j = 0; j < 8; j++) {
+			UINT16_t y = k * 8 + j;
+
+			blk[j] = 0xff;
+			blk_color[j] = 0x00;
+
+			if (y >= h) {
+				continue;
+			}
+
+			if (compose) {
+				inky_layer_compose_row(fb, fb->view_y + y,
+						       fb->view_x + band, n,
+						       line);
+				ops->pack(line, 0, n, &blk[j], &blk_color[j]);
+				continue;
+			}
+
+			ops->pack(&fb->buffer[INKY_FB_STRIDE(fb) *
+					      (fb->view_y + y)],
+				  fb->view_x + band, n, &blk[j], &blk_color[j]);
+		}
+
+		pixfmt_transpose8(&bw[k], stride, blk, 1);
+		pixfmt_transpose8(&color[k], stride, blk_color, 1);
+	}
+}
+
+static inky_error_state _band_render(inky_config *cfg, UINT16_t line,
+				     UINT8_t blank)
+{
+	inky_fb *fb = cfg->fb;
+	inky_band *band = fb->band;
+	inky_error_state ret;
+	UINT16_t y = line - line % band->rows;
+
+	if (band->area.h && band->area.y == y) {
+		return INKY_OK;
+	}
+
+	band->area.x = 0;
+	band->area.y = y;
+	band->area.w = INKY_FB_WIDTH(fb);
+	band->area.h = INKY_FB_HEIGHT(fb) - y < band->rows ?
+		INKY_FB_HEIGHT(fb) - y : band->rows;
+
+	band->fb.width = band->area.w;
+	band->fb.height = band->area.h;
+	band->fb.dirty.w = 0;
+	band->fb.dirty.h = 0;
+
+	memset(band->fb.buffer, 0, band->fb.bytes);
+
+	if (blank) {
+		return INKY_OK;
+	}
+
+	/* Drawing goes into the band until render returns */
+	cfg->fb = &band->fb;
+	ret = band->render(cfg, &band->area, band->usrptr);
+	cfg->fb = fb;
+
+	return ret;
+}
+
+static void _dirty_reset(inky_config *cfg)
+{
+	cfg->fb->dirty.w = 0;
+	cfg->fb->dirty.h = 0;
+
+	for (inky_layer *l = cfg->fb->layers; l; l = l->next) {
+		l->fb.dirty.w = 0;
+		l->fb.dirty.h = 0;
+	}
+}
+
+static void _view_size(const inky_panel *panel, UINT8_t orientation,
+		       UINT8_t scale, UINT16_t *w, UINT16_t *h)
+{
+	UINT8_t turned = orientation & INKY_ORIENT_90;
+	UINT16_t pw = turned ? panel->height : panel->width;
+	UINT16_t ph = turned ? panel->width : panel->height;
+
+	*w = (pw + scale - 1) / scale;
+	*h = (ph + scale - 1) / scale;
+}
+
+static UINT8_t _view_clip(const inky_config *cfg, const inky_rect *area,
+			  inky_rect *out)
+{
+	const inky_fb *fb = cfg->fb;
+	UINT32_t x0, y0, x1, y1;
+	UINT16_t w, h;
+
+	_view_size(cfg->panel, fb->orientation, fb->scale, &w, &h);
+
+	x0 = area->x > fb->view_x ? area->x : fb->view_x;
+	y0 = area->y > fb->view_y ? area->y : fb->view_y;
+	x1 = (UINT32_t) area->x + area->w;
+	y1 = (UINT32_t) area->y + area->h;
+	x1 = x1 < (UINT32_t) fb->view_x + w ? x1 : (UINT32_t) fb->view_x + w;
+	y1 = y1 < (UINT32_t) fb->view_y + h ? y1 : (UINT32_t) fb->view_y + h;
+
+	if (x0 >= x1 || y0 >= y1) {
+		out->x = 0;
+		out->y = 0;
+		out->w = 0;
+		out->h = 0;
+
+		return 0;
+	}
+
+	out->x = x0 - fb->view_x;
+	out->y = y0 - fb->view_y;
+	out->w = x1 - x0;
+	out->h = y1 - y0;
+
+	return 1;
+}
+
+static inky_error_state _fb_resize(inky_config *cfg, UINT16_t w,
+				   UINT16_t h)
+{
+#ifdef INKY_FIXED_PRODUCT
+	/* The size is built into every access */
+	return INKY_E_NOT_AVAILABLE;
+#else
+	inky_fb *fb = cfg->fb;
+	UINT32_t stride = INKY_ROW_STRIDE(w, fb->fmt.bpp);
+	UINT32_t bytes = stride * h;
+
+	/* Bands are only ever narrower than the panel rows they were
+	 * allocated for */
+	if (fb->band) {
+		fb->width = w;
+		fb->height = h;
+		fb->stride = stride;
+		fb->dirty.w = 0;
+		fb->dirty.h = 0;
+
+		return INKY_OK;
+	}
+
+	if (bytes > fb->bytes) {
+		UINT8_t *buffer = realloc(fb->buffer, bytes);
+
+		if (!buffer) {
+			return INKY_E_OUT_OF_MEMORY;
+		}
+
+		fb->buffer = buffer;
+	}
+
+	fb->width = w;
+	fb->height = h;
+	fb->stride = stride;
+	fb->bytes = bytes;
+	fb->view_x = 0;
+	fb->view_y = 0;
+
+	/* Nothing outside the new size is left to send */
+	fb->dirty.w = 0;
+	fb->dirty.h = 0;
+
+	memset(fb->buffer, 0, bytes);
+
+	return INKY_OK;
+#endif /* #ifdef INKY_FIXED_PRODUCT */
+}
+
+static void _mirror_row(const UINT8_t *src, UINT8_t *dst, UINT16_t stride,
+			UINT16_t w, UINT8_t fill)
+{
+	UINT16_t pad = stride * 8 - w;
+	UINT16_t q = pad / 8;
+	UINT8_t r = pad % 8;
+
+	/* Shift the row right by pad pixels, then reverse each byte */
+	for (UINT16_t k = 0; k < stride; k++) {
+		UINT8_t hi = k >= q ? src[k - q] : fill;
+		UINT8_t lo = k >= q + 1 ? src[k - q - 1] : fill;
+		UINT8_t v = r ? (UINT8_t) ((hi >> r) | (lo << (8 - r))) : hi;
+
+		dst[k] = pixfmt_rev8(v);
+	}
+}
@@ -0,0 +1,420 @@
+#include "pixfmt.h"
+
+#include <inky-layer.h>
+
+#include <stdlib.h>
+#include <string.h>
+
+/*
+**********************************************************************
+*********************** Layer Definitions ****************************
+**********************************************************************
+*/
+
+/** @brief Grow cfg's dirty rectangle over area of a layer, moved onto
+ * the canvas and clipped to it */
+static void _mark(inky_config *cfg, const inky_layer *layer,
+		  const inky_rect *area);
+
+/** @brief Grow cfg's dirty rectangle over all of a layer */
+static void _mark_all(inky_config *cfg, const inky_layer *layer);
+
+/** @brief Link to a layer in cfg's stack, NULL when it is not in it */
+static inky_layer **_find(inky_config *cfg, const inky_layer *layer);
+
+/** @brief Copy n bits of src from bit sbit over dst from bit dbit,
+ * leaving the pixels of the key pattern out */
+static void _copy_keyed(UINT8_t *dst, UINT32_t dbit, const UINT8_t *src,
+			UINT32_t sbit, UINT32_t n, UINT8_t bpp,
+			UINT32_t key_pattern);
+
+/*
+**********************************************************************
+************************** API Functions *****************************
+**********************************************************************
+*/
+
+inky_error_state inky_layer_create(inky_config *cfg, inky_layer *layer,
+				   UINT16_t width, UINT16_t height,
+				   const inky_color *key)
+{
+	inky_fb *fb;
+	UINT8_t bpp;
+	UINT8_t fill;
+
+	if (!cfg->fb) {
+		return INKY_E_NOT_CONFIGURED;
+	}
+
+	if (!layer) {
+		return INKY_E_NULL_PTR;
+	}
+
+	if (width == 0 || height == 0) {
+		return INKY_E_OUT_OF_RANGE;
+	}
+
+	/* Layers are composed over rows of the framebuffer in memory */
+	if (cfg->fb->band) {
+		return INKY_E_NOT_AVAILABLE;
+	}
+
+	if (key && !inky_color_available(cfg, *key)) {
+		return INKY_E_NOT_AVAILABLE;
+	}
+
+#ifdef INKY_FIXED_PRODUCT
+	if (width != INKY_FB_WIDTH(cfg->fb) ||
+	    height != INKY_FB_HEIGHT(cfg->fb)) {
+		return INKY_E_NOT_AVAILABLE;
+	}
+#endif /* #ifdef INKY_FIXED_PRODUCT */
+
+	bpp = INKY_FB_BPP(cfg->fb);
+	fb = &layer->fb;
+
+	fb->width = width;
+	fb->height = height;
+	fb->fmt = cfg->fb->fmt;
+	fb->fb_type = cfg->fb->fb_type;
+	fb->stride = INKY_ROW_STRIDE(width, bpp);
+	fb->bytes = fb->stride * height;
+	fb->dirty.x = 0;
+	fb->dirty.y = 0;
+	fb->dirty.w = 0;
+	fb->dirty.h = 0;
+	fb->orientation = INKY_ORIENT_0;
+	fb->scale = 1;
+	fb->view_x = 0;
+	fb->view_y = 0;
+	fb->layers = NULL;
+	fb->band = NULL;
+	fb->usrptr1 = NULL;
+	fb->usrptr2 = NULL;
+
+	fb->buffer = malloc(fb->bytes); /* Must free with inky_layer_free() */
+
+	if (!fb->buffer) {
+		return INKY_E_OUT_OF_MEMORY;
+	}
+
+	layer->x = 0;
+	layer->y = 0;
+	layer->z = 0;
+	layer->visible = 1;
+	layer->keyed = key != NULL;
+	layer->key = inky_pixfmt_encode(bpp, key ? *key : INKY_COLOR_WHITE) &
+		fb->fmt.mask;
+	layer->base = NULL;
+	layer->next = NULL;
+
+	/* Start out see-through, or white */
+	fill = (UINT8_t) pixfmt_pattern32(bpp, layer->key);
+	memset(fb->buffer, fill, fb->bytes);
+
+	return INKY_OK;
+}
+
+inky_error_state inky_layer_free(inky_layer *layer)
+{
+	if (!layer) {
+		return INKY_E_NULL_PTR;
+	}
+
+	free(layer->fb.buffer);
+	layer->fb.buffer = NULL;
+
+	return INKY_OK;
+}
+
+inky_error_state inky_layer_add(inky_config *cfg, inky_layer *layer,
+				INT8_t z)
+{
+	inky_layer **at;
+
+	if (!cfg->fb) {
+		return INKY_E_NOT_CONFIGURED;
+	}
+
+	if (!layer || !layer->fb.buffer) {
+		return INKY_E_NULL_PTR;
+	}
+
+	at = _find(cfg, layer);
+
+	if (at) {
+		*at = layer->next;
+	}
+
+	/* The stack runs bottom up */
+	at = &cfg->fb->layers;
+
+	while (*at && (*at)->z <= z) {
+		at = &(*at)->next;
+	}
+
+	layer->z = z;
+	layer->next = *at;
+	*at = layer;
+
+	if (layer->visible) {
+		_mark_all(cfg, layer);
+	}
+
+	return INKY_OK;
+}
+
+inky_error_state inky_layer_remove(inky_config *cfg, inky_layer *layer)
+{
+	inky_layer **at;
+
+	if (!cfg->fb) {
+		return INKY_E_NOT_CONFIGURED;
+	}
+
+	if (!layer) {
+		return INKY_E_NULL_PTR;
+	}
+
+	at = _find(cfg, layer);
+
+	if (!at) {
+		return INKY_E_OUT_OF_RANGE;
+	}
+
+	*at = layer->next;
+	layer->next = NULL;
+
+	if (layer->visible) {
+		_mark_all(cfg, layer);
+	}
+
+	return INKY_OK;
+}
+
+inky_error_state inky_layer_move(inky_config *cfg, inky_layer *layer,
+				 INT16_t x, INT16_t y)
+{
+	UINT8_t shown;
+
+	if (!cfg->fb) {
+		return INKY_E_NOT_CONFIGURED;
+	}
+
+	if (!layer) {
+		return INKY_E_NULL_PTR;
+	}
+
+	shown = layer->visible && _find(cfg, layer);
+
+	if (shown) {
+		_mark_all(cfg, layer);
+	}
+
+	layer->x = x;
+	layer->y = y;
+
+	if (shown) {
+		_mark_all(cfg, layer);
+	}
+
+	return INKY_OK;
+}
+
+inky_error_state inky_layer_show(inky_config *cfg, inky_layer *layer,
+				 UINT8_t visible)
+{
+	if (!cfg->fb) {
+		return INKY_E_NOT_CONFIGURED;
+	}
+
+	if (!layer) {
+		return INKY_E_NULL_PTR;
+	}
+
+	visible = visible ? 1 : 0;
+
+	if (layer->visible != visible) {
+		layer->visible = visible;
+
+		if (_find(cfg, layer)) {
+			_mark_all(cfg, layer);
+		}
+	}
+
+	return INKY_OK;
+}
+
+inky_error_state inky_layer_begin(inky_config *cfg, inky_layer *layer)
+{
+	if (!cfg->fb) {
+		return INKY_E_NOT_CONFIGURED;
+	}
+
+	if (!layer || !layer->fb.buffer) {
+		return INKY_E_NULL_PTR;
+	}
+
+	if (layer->base) {
+		return INKY_E_OUT_OF_RANGE;
+	}
+
+	layer->base = cfg->fb;
+	cfg->fb = &layer->fb;
+
+	return INKY_OK;
+}
+
+inky_error_state inky_layer_end(inky_config *cfg, inky_layer *layer)
+{
+	if (!layer) {
+		return INKY_E_NULL_PTR;
+	}
+
+	if (!layer->base || cfg->fb != &layer->fb) {
+		return INKY_E_OUT_OF_RANGE;
+	}
+
+	cfg->fb = layer->base;
+	layer->base = NULL;
+
+	return INKY_OK;
+}
+
+void inky_layer_compose_row(const inky_fb *fb, UINT16_t y, UINT16_t x,
+			    UINT16_t n, UINT8_t *out)
+{
+	const pixfmt_ops *ops = pixfmt_get_ops(&fb->fmt);
+	UINT8_t bpp = INKY_FB_BPP(fb);
+
+	ops->blit(out, 0, &fb->buffer[INKY_FB_STRIDE(fb) * y], x, n);
+
+	for (const inky_layer *l = fb->layers; l; l = l->next) {
+		INT32_t ly = (INT32_t) y - l->y;
+		INT32_t r = l->x + (INT32_t) INKY_FB_WIDTH(&l->fb);
+		INT32_t a = x > l->x ? x : l->x;
+		INT32_t b = x + n < r ? x + n : r;
+		const UINT8_t *src;
+
+		/* Only the span of the row the layer covers */
+		if (!l->visible || ly < 0 || ly >= INKY_FB_HEIGHT(&l->fb) ||
+		    a >= b) {
+			continue;
+		}
+
+		src = &l->fb.buffer[INKY_FB_STRIDE(&l->fb) * ly];
+
+		if (!l->keyed) {
+			ops->blit(out, a - x, src, a - l->x, b - a);
+			continue;
+		}
+
+		_copy_keyed(out, (UINT32_t) (a - x) * bpp, src,
+			    (UINT32_t) (a - l->x) * bpp,
+			    (UINT32_t) (b - a) * bpp, bpp,
+			    pixfmt_pattern32(bpp, l->key));
+	}
+}
+
+inky_error_state inky_layer_collect_dirty(inky_config *cfg)
+{
+	if (!cfg->fb) {
+		return INKY_E_NOT_CONFIGURED;
+	}
+
+	for (inky_layer *l = cfg->fb->layers; l; l = l->next) {
+		/* Changes to hidden layers show when they are shown */
+		if (l->visible && l->fb.dirty.w && l->fb.dirty.h) {
+			_mark(cfg, l, &l->fb.dirty);
+		}
+
+		l->fb.dirty.w = 0;
+		l->fb.dirty.h = 0;
+	}
+
+	return INKY_OK;
+}
+
+/*
+**********************************************************************
+************************* INTERNAL API *******************************
+**********************************************************************
+*/
+
+static void _mark(inky_config *cfg, const inky_layer *layer,
+		  const inky_rect *area)
+{
+	INT32_t x0 = layer->x + (INT32_t) area->x;
+	INT32_t y0 = layer->y + (INT32_t) area->y;
+	INT32_t x1 = x0 + area->w;
+	INT32_t y1 = y0 + area->h;
+	inky_rect d;
+
+	x0 = x0 > 0 ? x0 : 0;
+	y0 = y0 > 0 ? y0 : 0;
+	x1 = x1 < INKY_FB_WIDTH(cfg->fb) ? x1 : INKY_FB_WIDTH(cfg->fb);
+	y1 = y1 < INKY_FB_HEIGHT(cfg->fb) ? y1 : INKY_FB_HEIGHT(cfg->fb);
+
+	if (x0 >= x1 || y0 >= y1) {
+		return;
+	}
+
+	d.x = x0;
+	d.y = y0;
+	d.w = x1 - x0;
+	d.h = y1 - y0;
+
+	inky_fb_mark_dirty(cfg, &d);
+}
+
+static void _mark_all(inky_config *cfg, const inky_layer *layer)
+{
+	inky_rect all;
+
+	all.x = 0;
+	all.y = 0;
+	all.w = INKY_FB_WIDTH(&layer->fb);
+	all.h = INKY_FB_HEIGHT(&layer->fb);
+
+	_mark(cfg, layer, &all);
+}
+
+static inky_layer **_find(inky_config *cfg, const inky_layer *layer)
+{
+	for (inky_layer **at = &cfg->fb->layers; *at; at = &(*at)->next) {
+		if (*at == layer) {
+			return at;
+		}
+	}
+
+	return NULL;
+}
+
+static void _copy_keyed(UINT8_t *dst, UINT32_t dbit, const UINT8_t *src,
+			UINT32_t sbit, UINT32_t n, UINT8_t bpp,
+			UINT32_t key_pattern)
+{
+	UINT32_t end = dbit + n;
+	UINT32_t first = dbit / 32;
+	UINT32_t last = (end + 31) / 32;
+	UINT8_t tmp[(last - first) * 4];
+
+	/* As inky_fb_blit(): bring the span to the bit phase of dst, then
+	 * merge a word at a time */
+	memset(tmp, 0, sizeof(tmp));
+	pixfmt_copy_bits(tmp, dbit % 32, src, sbit, n);
+
+	for (UINT32_t i = first; i < last; i++) {
+		UINT32_t lo = i == first ? dbit % 32 : 0;
+		UINT32_t hi = i == last - 1 ? end - i * 32 : 32;
+		UINT32_t s = pixfmt_load32(&tmp[(i - first) * 4]);
+		UINT32_t d = pixfmt_load32(&dst[i * 4]);
+		UINT32_t mask;
+
+		mask = (hi == 32 ? 0xffffffffu : (1u << hi) - 1) &
+			~((1u << lo) - 1);
+		mask = mask & pixfmt_differs32(bpp, s, key_pattern);
+
+		pixfmt_store32(&dst[i * 4], (d & ~mask) | (s & mask));
+	}
+}
@@ -0,0 +1,496 @@
+#include "pixfmt.h"
+
+#include <string.h>
+
+/*
+**********************************************************************
+*********************** Format Definitions ***************************
+**********************************************************************
+*/
+
+/*
+ * Framebuffer codes for each format:
+ *
+ *	1bpp:	White 0, Black 1
+ *	2bpp:	White 0, Black 1, Red or Yellow 2
+ *	4bpp:	The inky_color value
+ */
+static const inky_pixfmt _pixfmt_1bpp = {
+	.format = INKY_PIXFMT_1BPP,
+	.bpp = 1,
+	.mask = 0x01
+}, _pixfmt_2bpp = {
+	.format = INKY_PIXFMT_2BPP,
+	.bpp = 2,
+	.mask = 0x03
+}, _pixfmt_4bpp = {
+	.format = INKY_PIXFMT_4BPP,
+	.bpp = 4,
+	.mask = 0x0f
+};
+
+static void _fill_1bpp(UINT8_t *row, UINT32_t x, UINT32_t n, UINT8_t px);
+
+static void _fill_2bpp(UINT8_t *row, UINT32_t x, UINT32_t n, UINT8_t px);
+
+static void _fill_4bpp(UINT8_t *row, UINT32_t x, UINT32_t n, UINT8_t px);
+
+static void _blit_1bpp(UINT8_t *dst, UINT32_t dx, const UINT8_t *src,
+		       UINT32_t sx, UINT32_t n);
+
+static void _blit_2bpp(UINT8_t *dst, UINT32_t dx, const UINT8_t *src,
+		       UINT32_t sx, UINT32_t n);
+
+static void _blit_4bpp(UINT8_t *dst, UINT32_t dx, const UINT8_t *src,
+		       UINT32_t sx, UINT32_t n);
+
+static void _pack_1bpp(const UINT8_t *row, UINT32_t x, UINT32_t n,
+		       UINT8_t *bw, UINT8_t *color);
+
+static void _pack_2bpp(const UINT8_t *row, UINT32_t x, UINT32_t n,
+		       UINT8_t *bw, UINT8_t *color);
+
+static void _pack_4bpp(const UINT8_t *row, UINT32_t x, UINT32_t n,
+		       UINT8_t *bw, UINT8_t *color);
+
+/** @brief Red, green and blue of each inky_color */
+static const UINT8_t _rgb[4][3] = {
+	{ 0xff, 0xff, 0xff },
+	{ 0x00, 0x00, 0x00 },
+	{ 0xff, 0x00, 0x00 },
+	{ 0xff, 0xff, 0x00 },
+};
+
+static const pixfmt_ops _ops_1bpp = {
+	.fill = _fill_1bpp,
+	.blit = _blit_1bpp,
+	.pack = _pack_1bpp
+}, _ops_2bpp = {
+	.fill = _fill_2bpp,
+	.blit = _blit_2bpp,
+	.pack = _pack_2bpp
+}, _ops_4bpp = {
+	.fill = _fill_4bpp,
+	.blit = _blit_4bpp,
+	.pack = _pack_4bpp
+};
+
+/** @brief Mask of bits lo to hi - 1 of a byte */
+static inline UINT8_t _byte_mask(UINT8_t lo, UINT8_t hi);
+
+/** @brief Gather the even bits of a 16 bit word into a byte */
+static inline UINT8_t _even_bits(UINT16_t w);
+
+/*
+**********************************************************************
+********************** Format Implementation *************************
+**********************************************************************
+*/
+
+const inky_pixfmt *pixfmt_describe(inky_pixel_format format)
+{
+	switch (format) {
+	case INKY_PIXFMT_1BPP:
+		return &_pixfmt_1bpp;
+	case INKY_PIXFMT_2BPP:
+		return &_pixfmt_2bpp;
+	case INKY_PIXFMT_4BPP:
+		return &_pixfmt_4bpp;
+	default:
+		return NULL;
+	}
+}
+
+const pixfmt_ops *pixfmt_get_ops(const inky_pixfmt *fmt)
+{
+	switch (fmt->format) {
+	case INKY_PIXFMT_1BPP:
+		return &_ops_1bpp;
+	case INKY_PIXFMT_2BPP:
+		return &_ops_2bpp;
+	case INKY_PIXFMT_4BPP:
+		return &_ops_4bpp;
+	default:
+		return NULL;
+	}
+}
+
+inky_color pixfmt_decode(const inky_pixfmt *fmt,
+			 const inky_color_config *color, UINT8_t px)
+{
+	if (fmt->bpp == 4) {
+		return (inky_color) px;
+	}
+
+	switch (px) {
+	case 0x00:
+		return INKY_COLOR_WHITE;
+	case 0x01:
+		return INKY_COLOR_BLACK;
+	default:
+		return (color && color->yellow) ? INKY_COLOR_YELLOW :
+			INKY_COLOR_RED;
+	}
+}
+
+const UINT8_t *pixfmt_color_rgb(inky_color c)
+{
+	return _rgb[c <= INKY_COLOR_YELLOW ? c : INKY_COLOR_WHITE];
+}
+
+UINT32_t pixfmt_distance(inky_color c, UINT8_t r, UINT8_t g, UINT8_t b)
+{
+	const UINT8_t *p = pixfmt_color_rgb(c);
+	INT32_t dr = (INT32_t) r - p[0];
+	INT32_t dg = (INT32_t) g - p[1];
+	INT32_t db = (INT32_t) b - p[2];
+
+	return 3 * dr * dr + 4 * dg * dg + 2 * db * db;
+}
+
+UINT8_t pixfmt_nearest(const inky_color *colors, UINT8_t n, UINT8_t r,
+		       UINT8_t g, UINT8_t b)
+{
+	UINT32_t best_d = 0xffffffff;
+	UINT8_t best = 0;
+
+	for (UINT8_t i = 0; i < n; i++) {
+		UINT32_t d = pixfmt_distance(colors[i], r, g, b);
+
+		if (d < best_d) {
+			best = i;
+			best_d = d;
+		}
+	}
+
+	return best;
+}
+
+void pixfmt_writer_begin(pixfmt_writer *w, UINT8_t *row, UINT32_t x,
+			 const inky_pixfmt *fmt)
+{
+	w->p = &row[x * fmt->bpp / 8];
+	w->bpp = fmt->bpp;
+	w->mask = fmt->mask;
+	w->shift = (x * fmt->bpp) % 8;
+	w->acc = 0;
+	w->set = 0;
+	w->n = 0;
+	w->first = 1;
+	w->last = 0;
+}
+
+void pixfmt_writer_end(pixfmt_writer *w)
+{
+	if (w->set) {
+		*w->p = (*w->p & ~w->set) | w->acc;
+	}
+}
+
+UINT32_t pixfmt_read_bits(const UINT8_t *buf, UINT32_t bit, UINT8_t n)
+{
+	UINT64_t v = 0;
+	UINT32_t first;
+	UINT32_t last;
+
+	if (n == 0) {
+		return 0;
+	}
+
+	/* Only touch the bytes that hold the requested bits */
+	first = bit / 8;
+	last = (bit + n - 1) / 8;
+
+	for (UINT32_t i = first; i <= last; i++) {
+		v = v | ((UINT64_t) buf[i] << ((i - first) * 8));
+	}
+
+	return (UINT32_t) ((v >> (bit % 8)) & ((1ull << n) - 1));
+}
+
+void pixfmt_fill_bits(UINT8_t *buf, UINT32_t bit, UINT32_t end,
+		      UINT8_t rep)
+{
+	UINT32_t first = bit / 8;
+	UINT32_t last = end / 8;
+	UINT8_t mask;
+
+	if (bit >= end) {
+		return;
+	}
+
+	if (first == last) {
+		mask = _byte_mask(bit % 8, end % 8);
+		buf[first] = (buf[first] & ~mask) | (rep & mask);
+		return;
+	}
+
+	/* Partial leading byte, whole bytes, then partial trailing byte */
+	if (bit % 8) {
+		mask = _byte_mask(bit % 8, 8);
+		buf[first] = (buf[first] & ~mask) | (rep & mask);
+		first++;
+	}
+
+	memset(&buf[first], rep, last - first);
+
+	if (end % 8) {
+		mask = _byte_mask(0, end % 8);
+		buf[last] = (buf[last] & ~mask) | (rep & mask);
+	}
+}
+
+void pixfmt_copy_bits(UINT8_t *dst, UINT32_t dbit, const UINT8_t *src,
+		      UINT32_t sbit, UINT32_t n)
+{
+	UINT8_t mask;
+
+	if (n == 0) {
+		return;
+	}
+
+	if (dbit % 8 == sbit % 8) {
+		UINT32_t head = (8 - dbit % 8) % 8;
+		UINT32_t tail;
+
+		/* Same phase: fix up the edges, move whole bytes */
+		if (head > n) {
+			head = n;
+		}
+
+		if (head) {
+			mask = _byte_mask(dbit % 8, dbit % 8 + head);
+			dst[dbit / 8] = (dst[dbit / 8] & ~mask) |
+				(src[sbit / 8] & mask);
+			dbit = dbit + head;
+			sbit = sbit + head;
+			n = n - head;
+		}
+
+		memmove(&dst[dbit / 8], &src[sbit / 8], n / 8);
+
+		tail = n % 8;
+
+		if (tail) {
+			UINT32_t d = dbit / 8 + n / 8;
+			UINT32_t s = sbit / 8 + n / 8;
+
+			mask = _byte_mask(0, tail);
+			dst[d] = (dst[d] & ~mask) | (src[s] & mask);
+		}
+
+		return;
+	}
+
+	/* Different phase: assemble each destination byte by shifting */
+	while (n) {
+		UINT8_t off = dbit % 8;
+		UINT8_t cnt = 8 - off;
+		UINT8_t v;
+
+		if (cnt > n) {
+			cnt = n;
+		}
+
+		v = (UINT8_t) pixfmt_read_bits(src, sbit, cnt);
+		mask = _byte_mask(off, off + cnt);
+		dst[dbit / 8] = (dst[dbit / 8] & ~mask) | ((v << off) & mask);
+
+		dbit = dbit + cnt;
+		sbit = sbit + cnt;
+		n = n - cnt;
+	}
+}
+
+void pixfmt_transpose8(UINT8_t *dst, UINT32_t dst_step, const UINT8_t *src,
+		       UINT32_t src_step)
+{
+	UINT32_t x = 0;
+	UINT32_t y = 0;
+	UINT32_t t;
+
+	for (UINT8_t i = 0; i < 4; i++) {
+		x = (x << 8) | src[src_step * i];
+		y = (y << 8) | src[src_step * (i + 4)];
+	}
+
+	/* Swap bits across 2x2, then 2 bit pairs across 4x4 blocks within
+	 * each half, then 4x4 blocks between the halves */
+	t = (x ^ (x >> 7)) & 0x00aa00aa;
+	x = x ^ t ^ (t << 7);
+	t = (y ^ (y >> 7)) & 0x00aa00aa;
+	y = y ^ t ^ (t << 7);
+	t = (x ^ (x >> 14)) & 0x0000cccc;
+	x = x ^ t ^ (t << 14);
+	t = (y ^ (y >> 14)) & 0x0000cccc;
+	y = y ^ t ^ (t << 14);
+	t = (x & 0xf0f0f0f0) | ((y >> 4) & 0x0f0f0f0f);
+	y = ((x << 4) & 0xf0f0f0f0) | (y & 0x0f0f0f0f);
+	x = t;
+
+	for (UINT8_t i = 0; i < 4; i++) {
+		dst[dst_step * i] = (UINT8_t) (x >> (24 - 8 * i));
+		dst[dst_step * (i + 4)] = (UINT8_t) (y >> (24 - 8 * i));
+	}
+}
+
+void pixfmt_widen(UINT8_t *dst, const UINT8_t *src, UINT32_t n,
+		  UINT8_t scale)
+{
+	/* Nibble to byte, and bit pair to byte */
+	static const UINT8_t twice[16] = {
+		0x00, 0x03, 0x0c, 0x0f, 0x30, 0x33, 0x3c, 0x3f,
+		0xc0, 0xc3, 0xcc, 0xcf, 0xf0, 0xf3, 0xfc, 0xff
+	};
+	static const UINT8_t four[4] = { 0x00, 0x0f, 0xf0, 0xff };
+
+	for (UINT32_t k = 0; k < n; k++) {
+		UINT8_t b = src[k / scale];
+
+		if (scale == 2) {
+			dst[k] = twice[k & 1 ? b & 0x0f : b >> 4];
+		} else if (scale == 4) {
+			dst[k] = four[(b >> (6 - 2 * (k & 3))) & 0x03];
+		} else {
+			dst[k] = b;
+		}
+	}
+}
+
+UINT32_t pixfmt_isqrt64(UINT64_t v)
+{
+	UINT64_t r = 0;
+	UINT64_t bit = (UINT64_t) 1 << 62;
+
+	while (bit > v) {
+		bit >>= 2;
+	}
+
+	while (bit) {
+		if (v >= r + bit) {
+			v -= r + bit;
+			r = (r >> 1) + bit;
+		} else {
+			r >>= 1;
+		}
+
+		bit >>= 2;
+	}
+
+	return (UINT32_t) r;
+}
+
+/*
+**********************************************************************
+************************* INTERNAL API *******************************
+**********************************************************************
+*/
+
+static void _fill_1bpp(UINT8_t *row, UINT32_t x, UINT32_t n, UINT8_t px)
+{
+	pixfmt_fill_bits(row, x, x + n, px ? 0xff : 0x00);
+}
+
+static void _fill_2bpp(UINT8_t *row, UINT32_t x, UINT32_t n, UINT8_t px)
+{
+	pixfmt_fill_bits(row, x * 2, (x + n) * 2, (px & 0x03) * 0x55);
+}
+
+static void _fill_4bpp(UINT8_t *row, UINT32_t x, UINT32_t n, UINT8_t px)
+{
+	pixfmt_fill_bits(row, x * 4, (x + n) * 4, (px & 0x0f) * 0x11);
+}
+
+static void _blit_1bpp(UINT8_t *dst, UINT32_t dx, const UINT8_t *src,
+		       UINT32_t sx, UINT32_t n)
+{
+	pixfmt_copy_bits(dst, dx, src, sx, n);
+}
+
+static void _blit_2bpp(UINT8_t *dst, UINT32_t dx, const UINT8_t *src,
+		       UINT32_t sx, UINT32_t n)
+{
+	pixfmt_copy_bits(dst, dx * 2, src, sx * 2, n * 2);
+}
+
+static void _blit_4bpp(UINT8_t *dst, UINT32_t dx, const UINT8_t *src,
+		       UINT32_t sx, UINT32_t n)
+{
+	pixfmt_copy_bits(dst, dx * 4, src, sx * 4, n * 4);
+}
+
+static void _pack_1bpp(const UINT8_t *row, UINT32_t x, UINT32_t n,
+		       UINT8_t *bw, UINT8_t *color)
+{
+	for (UINT32_t i = 0; i < n; i = i + 8) {
+		UINT8_t cnt = (n - i) < 8 ? (n - i) : 8;
+		UINT8_t black;
+
+		/* Bit k set when pixel k is black */
+		black = (UINT8_t) pixfmt_read_bits(row, x + i, cnt);
+
+		*bw++ = ~ pixfmt_rev8(black);
+		*color++ = 0x00;
+	}
+}
+
+static void _pack_2bpp(const UINT8_t *row, UINT32_t x, UINT32_t n,
+		       UINT8_t *bw, UINT8_t *color)
+{
+	for (UINT32_t i = 0; i < n; i = i + 8) {
+		UINT8_t cnt = (n - i) < 8 ? (n - i) : 8;
+		UINT16_t data;
+		UINT8_t lo;
+		UINT8_t hi;
+
+		/* Split the B/W and color bits of eight pixels */
+		data = (UINT16_t) pixfmt_read_bits(row, (x + i) * 2, cnt * 2);
+		lo = _even_bits(data);
+		hi = _even_bits(data >> 1);
+
+		*bw++ = ~ pixfmt_rev8(lo & ~hi);
+		*color++ = pixfmt_rev8(hi);
+	}
+}
+
+static void _pack_4bpp(const UINT8_t *row, UINT32_t x, UINT32_t n,
+		       UINT8_t *bw, UINT8_t *color)
+{
+	for (UINT32_t i = 0; i < n; i = i + 8) {
+		UINT8_t cnt = (n - i) < 8 ? (n - i) : 8;
+		UINT32_t data;
+		UINT8_t black = 0;
+		UINT8_t col = 0;
+
+		data = pixfmt_read_bits(row, (x + i) * 4, cnt * 4);
+
+		for (UINT8_t k = 0; k < cnt; k++) {
+			UINT8_t px = (data >> (k * 4)) & 0x0f;
+
+			if (px == INKY_COLOR_BLACK) {
+				black = black | (0x80 >> k);
+			} else if (px == INKY_COLOR_RED ||
+				   px == INKY_COLOR_YELLOW) {
+				col = col | (0x80 >> k);
+			}
+		}
+
+		*bw++ = ~ black;
+		*color++ = col;
+	}
+}
+
+static inline UINT8_t _byte_mask(UINT8_t lo, UINT8_t hi)
+{
+	return (UINT8_t) (((1u << (hi - lo)) - 1) << lo);
+}
+
+static inline UINT8_t _even_bits(UINT16_t w)
+{
+	w = w & 0x5555;
+	w = (w | (w >> 1)) & 0x3333;
+	w = (w | (w >> 2)) & 0x0f0f;
+	w = (w | (w >> 4)) & 0x00ff;
+
+	return (UINT8_t) w;
+}
@@ -0,0 +1,210 @@
+/* Internal pixel format routines for the Pimoroni Inky driver */
+#ifndef PIXFMT_H
+#define PIXFMT_H
+
+#include <inky-api.h>
+
+/*
+ * Packed rows are addressed by a byte pointer and a pixel offset, so
+ * the same routines serve any row layout. Within a byte, pixel 0 is
+ * in the lowest bits.
+ */
+
+/** @brief Routines specialized for one pixel format */
+typedef struct pixfmt_opsnode {
+	/** @brief Set n pixels from pixel x to framebuffer code px */
+	void (*fill)(UINT8_t *row, UINT32_t x, UINT32_t n, UINT8_t px);
+
+	/** @brief Copy n pixels from pixel sx of src to pixel dx of
+	 * dst, both in this format */
+	void (*blit)(UINT8_t *dst, UINT32_t dx, const UINT8_t *src,
+		     UINT32_t sx, UINT32_t n);
+
+	/** @brief Convert n pixels from pixel x into the panel's black
+	 * plane (1 = not black) and color plane (1 = color), MSB first,
+	 * padding the last byte with white */
+	void (*pack)(const UINT8_t *row, UINT32_t x, UINT32_t n,
+		     UINT8_t *bw, UINT8_t *color);
+} pixfmt_ops;
+
+/** @brief Row of framebuffer codes being written a pixel at a time and
+ * stored a byte at a time, with the first and last of the pixels put
+ * that changed (first > last while none did) */
+typedef struct pixfmt_writernode {
+	UINT8_t *p;
+	UINT8_t bpp;
+	UINT8_t mask;
+	UINT8_t shift;
+	UINT8_t acc;
+	UINT8_t set;
+	UINT32_t n;
+	UINT32_t first;
+	UINT32_t last;
+} pixfmt_writer;
+
+/** @brief Descriptor for a format, NULL for unknown formats */
+const inky_pixfmt *pixfmt_describe(inky_pixel_format format);
+
+/** @brief Routines for the format of a descriptor */
+const pixfmt_ops *pixfmt_get_ops(const inky_pixfmt *fmt);
+
+/** @brief Framebuffer code of a pixel to inky_color */
+inky_color pixfmt_decode(const inky_pixfmt *fmt,
+			 const inky_color_config *color, UINT8_t px);
+
+/** @brief Red, green and blue of a panel color */
+const UINT8_t *pixfmt_color_rgb(inky_color c);
+
+/** @brief Squared distance from a panel color to r, g, b, weighing
+ * green over red over blue roughly as the eye does */
+UINT32_t pixfmt_distance(inky_color c, UINT8_t r, UINT8_t g, UINT8_t b);
+
+/** @brief Index of the entry of colors closest to r, g, b, the first
+ * of equally close ones */
+UINT8_t pixfmt_nearest(const inky_color *colors, UINT8_t n, UINT8_t r,
+		       UINT8_t g, UINT8_t b);
+
+/** @brief Start writing row from pixel x */
+void pixfmt_writer_begin(pixfmt_writer *w, UINT8_t *row, UINT32_t x,
+			 const inky_pixfmt *fmt);
+
+/** @brief Code the next pixel had before writing started */
+static inline UINT8_t pixfmt_writer_get(const pixfmt_writer *w)
+{
+	return (*w->p >> w->shift) & w->mask;
+}
+
+/** @brief Write the next pixel */
+static inline void pixfmt_writer_put(pixfmt_writer *w, UINT8_t code)
+{
+	if (pixfmt_writer_get(w) != code) {
+		if (w->first > w->last) {
+			w->first = w->n;
+		}
+
+		w->last = w->n;
+	}
+
+	w->n++;
+	w->acc |= code << w->shift;
+	w->set |= w->mask << w->shift;
+	w->shift += w->bpp;
+
+	if (w->shift == 8) {
+		*w->p = (*w->p & ~w->set) | w->acc;
+		w->p++;
+		w->shift = 0;
+		w->acc = 0;
+		w->set = 0;
+	}
+}
+
+/** @brief Store the pixels of the last, partial byte */
+void pixfmt_writer_end(pixfmt_writer *w);
+
+/** @brief Read up to 32 bits starting at any bit of buf */
+UINT32_t pixfmt_read_bits(const UINT8_t *buf, UINT32_t bit, UINT8_t n);
+
+/** @brief Set bits bit to end - 1 of buf from the repeating pattern
+ * rep */
+void pixfmt_fill_bits(UINT8_t *buf, UINT32_t bit, UINT32_t end,
+		      UINT8_t rep);
+
+/** @brief Copy n bits between any bit offsets of two buffers */
+void pixfmt_copy_bits(UINT8_t *dst, UINT32_t dbit, const UINT8_t *src,
+		      UINT32_t sbit, UINT32_t n);
+
+/** @brief Framebuffer code pattern repeated over a word */
+static inline UINT32_t pixfmt_pattern32(UINT8_t bpp, UINT8_t code)
+{
+	switch (bpp) {
+	case 1:
+		return code ? 0xffffffffu : 0;
+	case 2:
+		return code * 0x55555555u;
+	default:
+		return code * 0x11111111u;
+	}
+}
+
+/** @brief Mask of the pixels of a word that differ from a pattern */
+static inline UINT32_t pixfmt_differs32(UINT8_t bpp, UINT32_t v,
+					UINT32_t pattern)
+{
+	UINT32_t t = v ^ pattern;
+
+	/* Collapse the bits of each pixel into its lowest bit, then
+	 * spread the result back over the pixel */
+	switch (bpp) {
+	case 1:
+		return t;
+	case 2:
+		t = (t | (t >> 1)) & 0x55555555u;
+		return t * 0x3;
+	default:
+		t = t | (t >> 1);
+		t = (t | (t >> 2)) & 0x11111111u;
+		return t * 0xf;
+	}
+}
+
+/* Little endian access keeps bit k of a word on pixel bit k on any
+ * host */
+static inline UINT32_t pixfmt_load32(const UINT8_t *b)
+{
+	return (UINT32_t) b[0] | ((UINT32_t) b[1] << 8) |
+		((UINT32_t) b[2] << 16) | ((UINT32_t) b[3] << 24);
+}
+
+static inline void pixfmt_store32(UINT8_t *b, UINT32_t v)
+{
+	b[0] = (UINT8_t) v;
+	b[1] = (UINT8_t) (v >> 8);
+	b[2] = (UINT8_t) (v >> 16);
+	b[3] = (UINT8_t) (v >> 24);
+}
+
+/** @brief Check fb holds pixels to draw into or read
+ *
+ * @return INKY_E_NOT_CONFIGURED without a framebuffer, and
+ * INKY_E_NOT_AVAILABLE when it is rendered in bands and holds none,
+ * see inky_band_setup()
+ */
+static inline inky_error_state pixfmt_fb_check(const inky_fb *fb)
+{
+	if (!fb) {
+		return INKY_E_NOT_CONFIGURED;
+	}
+
+	if (fb->band && !fb->buffer) {
+		return INKY_E_NOT_AVAILABLE;
+	}
+
+	return INKY_OK;
+}
+
+/** @brief Reverse the bit order of a byte */
+static inline UINT8_t pixfmt_rev8(UINT8_t b)
+{
+	b = (UINT8_t) (((b & 0xf0) >> 4) | ((b & 0x0f) << 4));
+	b = (UINT8_t) (((b & 0xcc) >> 2) | ((b & 0x33) << 2));
+	b = (UINT8_t) (((b & 0xaa) >> 1) | ((b & 0x55) << 1));
+
+	return b;
+}
+
+/** @brief Transpose an 8 by 8 block of bits, MSB first: bit 7 - j of
+ * byte i of src, bytes src_step apart, becomes bit 7 - i of byte j of
+ * dst, bytes dst_step apart */
+void pixfmt_transpose8(UINT8_t *dst, UINT32_t dst_step, const UINT8_t *src,
+		       UINT32_t src_step);
+
+/** @brief Repeat every bit of MSB first src scale times, 1, 2 or 4,
+ * into n bytes of dst */
+void pixfmt_widen(UINT8_t *dst, const UINT8_t *src, UINT32_t n,
+		  UINT8_t scale);
+
+/** @brief Integer square root of v, rounded down */
+UINT32_t pixfmt_isqrt64(UINT64_t v);
+
+#endif /* #ifndef PIXFMT_H */
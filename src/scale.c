@@ -0,0 +1,355 @@
+#include <inky-scale.h>
+
+#include <stdlib.h>
+#include <string.h>
+
+/*
+**********************************************************************
+************************ Scale Definitions ***************************
+**********************************************************************
+*/
+
+/** @brief Scaling in progress
+    @var sw, sh Source size, sh the rows left to decode
+    @var step_x, step_y Source pixels per pixel, in 16.16 fixed point
+    @var *src Decoded row
+    @var *prev, *cur Last two source rows scaled across, cur the newest
+    @var *out Row blended from prev and cur, for INKY_SCALE_BILINEAR and
+    INKY_SCALE_BOX
+    @var *acc Sums of the source rows covering the next row, in 1/h of
+    a row, for INKY_SCALE_BOX
+    @var next Next row to draw, counted in decoding order
+    @var flip Rows decode bottom up
+**/
+typedef struct _scalernode {
+	inky_scale_filter filter;
+	UINT16_t sw;
+	UINT16_t sh;
+	UINT16_t w;
+	UINT16_t h;
+	UINT32_t step_x;
+	UINT32_t step_y;
+	UINT8_t *src;
+	UINT8_t *prev;
+	UINT8_t *cur;
+	UINT8_t *out;
+	UINT32_t *acc;
+	UINT16_t next;
+	INT16_t x;
+	INT16_t y;
+	UINT8_t flip;
+	inky_dither d;
+} _scaler;
+
+/** @brief Source pixel i of n steps of step from the centre of pixel
+ * 0 lands on, and the fraction of the way to the next, in 1/256 */
+static UINT16_t _bilinear_at(UINT32_t step, UINT32_t i, UINT16_t n,
+			     UINT8_t *f);
+
+/** @brief Scale the decoded row across into s->cur */
+static void _across(_scaler *s);
+
+/** @brief Draw the rows that source row r, just scaled across, completes */
+static inky_error_state _down(inky_config *cfg, _scaler *s, UINT32_t r);
+
+/** @brief Draw the next row, rows counted in decoding order */
+static inky_error_state _emit(inky_config *cfg, _scaler *s,
+			      const UINT8_t *rgb);
+
+static void _scaler_free(_scaler *s);
+
+/*
+**********************************************************************
+************************** API Functions *****************************
+**********************************************************************
+*/
+
+void inky_scale_fit(UINT16_t sw, UINT16_t sh, UINT16_t bw, UINT16_t bh,
+		    UINT16_t *w, UINT16_t *h)
+{
+	UINT32_t fw = bw;
+	UINT32_t fh = bh;
+
+	if (!w || !h) {
+		return;
+	}
+
+	if (sw && sh) {
+		/* Full width unless that is too tall, then full height */
+		if ((UINT64_t) sh * bw <= (UINT64_t) sw * bh) {
+			fh = ((UINT64_t) sh * bw + sw / 2) / sw;
+		} else {
+			fw = ((UINT64_t) sw * bh + sh / 2) / sh;
+		}
+	}
+
+	*w = fw ? fw : 1;
+	*h = fh ? fh : 1;
+}
+
+inky_error_state inky_fb_draw_scaled(inky_config *cfg, inky_image *img,
+				     INT16_t x, INT16_t y, UINT16_t w,
+				     UINT16_t h, inky_scale_filter filter,
+				     inky_dither_mode mode, UINT8_t hysteresis)
+{
+	inky_error_state ret;
+	UINT16_t row;
+	_scaler s;
+
+	if (!img) {
+		return INKY_E_NULL_PTR;
+	}
+
+	if (filter > INKY_SCALE_BILINEAR || h == 0) {
+		return INKY_E_OUT_OF_RANGE;
+	}
+
+	ret = inky_dither_init(cfg, &s.d, mode, w);
+
+	if (ret != INKY_OK) {
+		return ret;
+	}
+
+	s.d.hysteresis = hysteresis;
+	s.filter = filter;
+	s.sw = img->width;
+	s.sh = img->height - img->rows;
+	s.w = w;
+	s.h = h;
+	s.step_x = ((UINT32_t) s.sw << 16) / w;
+	s.step_y = ((UINT32_t) s.sh << 16) / h;
+	s.next = 0;
+	s.x = x;
+	s.y = y;
+	s.flip = img->bottom_up;
+	s.src = malloc((UINT32_t) s.sw * 3);
+	s.prev = filter == INKY_SCALE_BILINEAR ?
+		malloc((UINT32_t) w * 3) : NULL;
+	s.cur = malloc((UINT32_t) w * 3);
+	s.out = filter != INKY_SCALE_NEAREST ?
+		malloc((UINT32_t) w * 3) : NULL;
+	s.acc = filter == INKY_SCALE_BOX ?
+		calloc((UINT32_t) w * 3, sizeof(*s.acc)) : NULL;
+
+	if ((s.sw && !s.src) || !s.cur ||
+	    (filter == INKY_SCALE_BILINEAR && !s.prev) ||
+	    (filter != INKY_SCALE_NEAREST && !s.out) ||
+	    (filter == INKY_SCALE_BOX && !s.acc)) {
+		_scaler_free(&s);
+		return INKY_E_OUT_OF_MEMORY;
+	}
+
+	/* Rows outside the framebuffer are still decoded and scaled, as
+	 * rows below them may need them */
+	for (UINT32_t r = 0; s.sw; r++) {
+		ret = inky_image_read_row(img, s.src, &row);
+
+		if (ret != INKY_OK) {
+			break;
+		}
+
+		if (s.prev) {
+			UINT8_t *t = s.prev;
+
+			s.prev = s.cur;
+			s.cur = t;
+		}
+
+		_across(&s);
+		ret = _down(cfg, &s, r);
+
+		if (ret != INKY_OK) {
+			break;
+		}
+	}
+
+	_scaler_free(&s);
+
+	return ret == INKY_E_OUT_OF_RANGE ? INKY_OK : ret;
+}
+
+/*
+**********************************************************************
+************************* INTERNAL API *******************************
+**********************************************************************
+*/
+
+static UINT16_t _bilinear_at(UINT32_t step, UINT32_t i, UINT16_t n,
+			     UINT8_t *f)
+{
+	/* Centres are half a pixel in on both sides */
+	UINT32_t p = step / 2 + i * step;
+
+	*f = 0;
+
+	if (p < 0x8000) {
+		return 0;
+	}
+
+	p -= 0x8000;
+
+	if (p >> 16 >= n - 1U) {
+		return n - 1;
+	}
+
+	*f = (p >> 8) & 0xff;
+
+	return p >> 16;
+}
+
+static void _across(_scaler *s)
+{
+	const UINT8_t *src = s->src;
+	UINT8_t *dst = s->cur;
+
+	switch (s->filter) {
+	case INKY_SCALE_NEAREST:
+		for (UINT32_t i = 0, p = s->step_x / 2; i < s->w;
+		     i++, p += s->step_x) {
+			memcpy(&dst[3 * i], &src[3 * (p >> 16)], 3);
+		}
+		break;
+
+	case INKY_SCALE_BOX: {
+		/* Pixel i covers sw * i to sw * (i + 1) and source pixel
+		 * k covers w * k to w * (k + 1), in 1/w of a source
+		 * pixel, so every weight is exact */
+		UINT32_t k = 0;
+		UINT32_t at = 0;
+
+		for (UINT32_t i = 0; i < s->w; i++) {
+			UINT32_t end = at + s->sw;
+			UINT32_t sum[3] = { 0, 0, 0 };
+
+			while (at < end) {
+				UINT32_t edge = (k + 1) * s->w;
+				UINT32_t to = edge < end ? edge : end;
+
+				for (UINT8_t c = 0; c < 3; c++) {
+					sum[c] += (to - at) * src[3 * k + c];
+				}
+
+				at = to;
+				k += to == edge;
+			}
+
+			for (UINT8_t c = 0; c < 3; c++) {
+				dst[3 * i + c] = (sum[c] + s->sw / 2) / s->sw;
+			}
+		}
+		break;
+	}
+
+	case INKY_SCALE_BILINEAR:
+		for (UINT32_t i = 0; i < s->w; i++) {
+			UINT8_t f;
+			UINT16_t k = _bilinear_at(s->step_x, i, s->sw, &f);
+			const UINT8_t *a = &src[3 * k];
+			const UINT8_t *b = f ? a + 3 : a;
+
+			for (UINT8_t c = 0; c < 3; c++) {
+				dst[3 * i + c] = (a[c] * (256 - f) + b[c] * f +
+						  128) >> 8;
+			}
+		}
+		break;
+	}
+}
+
+static inky_error_state _down(inky_config *cfg, _scaler *s, UINT32_t r)
+{
+	inky_error_state ret = INKY_OK;
+
+	switch (s->filter) {
+	case INKY_SCALE_NEAREST:
+		while (s->next < s->h && ret == INKY_OK &&
+		       (s->step_y / 2 + s->next * s->step_y) >> 16 <= r) {
+			ret = _emit(cfg, s, s->cur);
+		}
+		break;
+
+	case INKY_SCALE_BOX: {
+		/* As across, in 1/h of a source row */
+		UINT32_t at = r * s->h;
+		UINT32_t edge = at + s->h;
+
+		while (s->next < s->h && ret == INKY_OK) {
+			UINT32_t lo = (UINT32_t) s->next * s->sh;
+			UINT32_t end = lo + s->sh;
+			UINT32_t from = lo > at ? lo : at;
+			UINT32_t to = end < edge ? end : edge;
+
+			for (UINT32_t k = 0; k < 3 * (UINT32_t) s->w; k++) {
+				s->acc[k] += (to - from) * s->cur[k];
+			}
+
+			if (end > edge) {
+				break;
+			}
+
+			for (UINT32_t k = 0; k < 3 * (UINT32_t) s->w; k++) {
+				s->out[k] = (s->acc[k] + s->sh / 2) / s->sh;
+				s->acc[k] = 0;
+			}
+
+			ret = _emit(cfg, s, s->out);
+
+			if (end == edge) {
+				break;
+			}
+
+			at = end;
+		}
+		break;
+	}
+
+	case INKY_SCALE_BILINEAR:
+		while (s->next < s->h && ret == INKY_OK) {
+			UINT8_t f;
+			UINT16_t k = _bilinear_at(s->step_y, s->next, s->sh, &f);
+
+			/* Rows between k and k + 1 wait for row k + 1 */
+			if (k + (f ? 1U : 0U) > r) {
+				break;
+			}
+
+			if (!f) {
+				ret = _emit(cfg, s, s->cur);
+				continue;
+			}
+
+			for (UINT32_t c = 0; c < 3 * (UINT32_t) s->w; c++) {
+				s->out[c] = (s->prev[c] * (256 - f) +
+					     s->cur[c] * f + 128) >> 8;
+			}
+
+			ret = _emit(cfg, s, s->out);
+		}
+		break;
+	}
+
+	return ret;
+}
+
+static inky_error_state _emit(inky_config *cfg, _scaler *s,
+			      const UINT8_t *rgb)
+{
+	UINT16_t j = s->next++;
+	INT32_t fy = s->y + (s->flip ? s->h - 1 - j : j);
+
+	if (fy > 0x7fff) {
+		return INKY_OK;
+	}
+
+	return inky_dither_row(cfg, &s->d, rgb, s->x, (INT16_t) fy);
+}
+
+static void _scaler_free(_scaler *s)
+{
+	free(s->src);
+	free(s->prev);
+	free(s->cur);
+	free(s->out);
+	free(s->acc);
+	inky_dither_free(&s->d);
+}
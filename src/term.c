@@ -0,0 +1,621 @@
+#include "pixfmt.h"
+
+#include <inky-term.h>
+
+#include <stdlib.h>
+#include <string.h>
+
+/*
+**********************************************************************
+************************ Terminal Definitions ************************
+**********************************************************************
+*/
+
+/* States of the escape sequence parser */
+typedef enum {
+	_TERM_GROUND,		/**< Printing characters */
+	_TERM_ESC,		/**< After ESC */
+	_TERM_CSI		/**< After ESC [, reading parameters */
+} _term_state;
+
+#define _TERM_TAB	8
+
+/** @brief Set a cell, damaging it only if it changes */
+static void _term_put(inky_term *term, UINT16_t col, UINT16_t row,
+		      UINT32_t cp, inky_color fg, inky_color bg);
+
+/** @brief Blank cells [first, last) of the grid, in row order */
+static void _term_erase(inky_term *term, UINT32_t first, UINT32_t last);
+
+/** @brief Move the cursor down a row, scrolling at the bottom */
+static void _term_linefeed(inky_term *term);
+
+/** @brief Reset colors, cursor and parser, and blank the grid */
+static void _term_reset(inky_term *term);
+
+/** @brief Act on the final byte of a CSI sequence */
+static void _term_csi(inky_config *cfg, inky_term *term, UINT32_t final);
+
+/** @brief Apply an SGR parameter */
+static void _term_sgr(inky_config *cfg, inky_term *term, UINT16_t p);
+
+/** @brief Draw one cell from the font */
+static inky_error_state _term_draw_cell(inky_config *cfg,
+					const inky_term *term,
+					UINT16_t col, UINT16_t row);
+
+/*
+**********************************************************************
+************************** API Functions *****************************
+**********************************************************************
+*/
+
+inky_error_state inky_term_create(inky_config *cfg, inky_term *term,
+				  const inky_font *font,
+				  const inky_rect *area,
+				  inky_color fg, inky_color bg)
+{
+	const inky_glyph *g;
+	inky_rect r;
+	UINT32_t n;
+
+	if (!cfg->fb) {
+		return INKY_E_NOT_CONFIGURED;
+	}
+
+	if (!term || !font || !font->glyphs || !font->bitmap) {
+		return INKY_E_NULL_PTR;
+	}
+
+	if (!inky_color_available(cfg, fg) || !inky_color_available(cfg, bg)) {
+		return INKY_E_NOT_AVAILABLE;
+	}
+
+	if (area) {
+		r = *area;
+	} else {
+		r.x = 0;
+		r.y = 0;
+		r.w = INKY_FB_WIDTH(cfg->fb);
+		r.h = INKY_FB_HEIGHT(cfg->fb);
+	}
+
+	if (r.x + r.w > INKY_FB_WIDTH(cfg->fb) ||
+	    r.y + r.h > INKY_FB_HEIGHT(cfg->fb)) {
+		return INKY_E_OUT_OF_RANGE;
+	}
+
+	g = inky_font_find(font, ' ');
+
+	if (!g) {
+		g = inky_font_find(font, font->fallback);
+	}
+
+	if (!g || g->advance == 0 || font->height == 0 ||
+	    r.w < g->advance || r.h < font->height) {
+		return INKY_E_OUT_OF_RANGE;
+	}
+
+	term->font = font;
+	term->x = r.x;
+	term->y = r.y;
+	term->cell_w = g->advance;
+	term->cell_h = font->height;
+	term->cols = r.w / term->cell_w;
+	term->rows = r.h / term->cell_h;
+	term->def_fg = fg;
+	term->def_bg = bg;
+
+	n = (UINT32_t) term->cols * term->rows;
+
+	term->cells = calloc(n, sizeof(inky_term_cell));
+	term->damage = malloc((n + 7) / 8);
+
+	if (!term->cells || !term->damage) {
+		inky_term_free(term);
+		return INKY_E_OUT_OF_MEMORY;
+	}
+
+	_term_reset(term);
+
+	/* Nothing has been drawn yet */
+	memset(term->damage, 0xff, (n + 7) / 8);
+
+	return INKY_OK;
+}
+
+inky_error_state inky_term_free(inky_term *term)
+{
+	if (!term) {
+		return INKY_E_NULL_PTR;
+	}
+
+	free(term->cells);
+	free(term->damage);
+
+	term->cells = NULL;
+	term->damage = NULL;
+
+	return INKY_OK;
+}
+
+inky_error_state inky_term_write(inky_config *cfg, inky_term *term,
+				 const char *utf8)
+{
+	UINT32_t cp;
+
+	if (!term || !term->cells || !utf8) {
+		return INKY_E_NULL_PTR;
+	}
+
+	while ((cp = inky_utf8_next(&utf8))) {
+		switch ((_term_state) term->state) {
+		case _TERM_ESC:
+
+			if (cp == '[') {
+				term->state = _TERM_CSI;
+				term->n_params = 0;
+				memset(term->params, 0, sizeof(term->params));
+				continue;
+			}
+
+			if (cp == 'c') {
+				_term_reset(term);
+			}
+
+			term->state = _TERM_GROUND;
+			continue;
+
+		case _TERM_CSI:
+
+			if (cp >= '0' && cp <= '9') {
+				UINT8_t i = term->n_params ?
+					term->n_params - 1 : 0;
+
+				if (term->n_params == 0) {
+					term->n_params = 1;
+				}
+
+				if (i < INKY_TERM_MAX_PARAMS &&
+				    term->params[i] < 10000) {
+					term->params[i] = term->params[i] * 10 +
+						(cp - '0');
+				}
+
+				continue;
+			}
+
+			if (cp == ';') {
+				/* An empty first parameter still counts */
+				if (term->n_params == 0) {
+					term->n_params = 1;
+				}
+
+				if (term->n_params < 255) {
+					term->n_params++;
+				}
+
+				continue;
+			}
+
+			/* Private markers and intermediates are skipped */
+			if (cp < 0x40 || cp > 0x7e) {
+				continue;
+			}
+
+			_term_csi(cfg, term, cp);
+			term->state = _TERM_GROUND;
+			continue;
+
+		case _TERM_GROUND:
+		default:
+			break;
+		}
+
+		switch (cp) {
+		case 0x1b:
+			term->state = _TERM_ESC;
+			break;
+		case '\r':
+			term->col = 0;
+			break;
+		case '\n':
+			term->col = 0;
+			_term_linefeed(term);
+			break;
+		case '\b':
+			if (term->col >= term->cols) {
+				term->col = term->cols - 1;
+			}
+
+			if (term->col > 0) {
+				term->col--;
+			}
+			break;
+		case '\t':
+			term->col = (term->col / _TERM_TAB + 1) * _TERM_TAB;
+
+			if (term->col > term->cols - 1) {
+				term->col = term->cols - 1;
+			}
+			break;
+		default:
+			/* Other control characters are ignored */
+			if (cp < 0x20 || cp == 0x7f) {
+				break;
+			}
+
+			/* Wrap on the first character past the last column */
+			if (term->col >= term->cols) {
+				term->col = 0;
+				_term_linefeed(term);
+			}
+
+			_term_put(term, term->col, term->row, cp, term->fg,
+				  term->bg);
+			term->col++;
+			break;
+		}
+	}
+
+	return INKY_OK;
+}
+
+inky_error_state inky_term_render(inky_config *cfg, inky_term *term,
+				  inky_rect *dirty)
+{
+	inky_error_state ret;
+	UINT16_t c0 = 0xffff;
+	UINT16_t r0 = 0xffff;
+	UINT16_t c1 = 0;
+	UINT16_t r1 = 0;
+	UINT32_t n;
+
+	if ((ret = pixfmt_fb_check(cfg->fb)) != INKY_OK) {
+		return ret;
+	}
+
+	if (!term || !term->cells) {
+		return INKY_E_NULL_PTR;
+	}
+
+	n = (UINT32_t) term->cols * term->rows;
+
+	for (UINT32_t i = 0; i < n; i++) {
+		UINT16_t col = i % term->cols;
+		UINT16_t row = i / term->cols;
+
+		/* Skip clean cells a byte at a time */
+		if (i % 8 == 0 && term->damage[i / 8] == 0) {
+			i += 7;
+			continue;
+		}
+
+		if (!(term->damage[i / 8] & (1 << (i % 8)))) {
+			continue;
+		}
+
+		ret = _term_draw_cell(cfg, term, col, row);
+
+		if (ret != INKY_OK) {
+			return ret;
+		}
+
+		term->damage[i / 8] &= ~(1 << (i % 8));
+
+		c0 = col < c0 ? col : c0;
+		r0 = row < r0 ? row : r0;
+		c1 = col + 1 > c1 ? col + 1 : c1;
+		r1 = row + 1 > r1 ? row + 1 : r1;
+	}
+
+	if (!dirty) {
+		return INKY_OK;
+	}
+
+	if (c1 == 0) {
+		dirty->x = term->x;
+		dirty->y = term->y;
+		dirty->w = 0;
+		dirty->h = 0;
+		return INKY_OK;
+	}
+
+	dirty->x = term->x + c0 * term->cell_w;
+	dirty->y = term->y + r0 * term->cell_h;
+	dirty->w = (c1 - c0) * term->cell_w;
+	dirty->h = (r1 - r0) * term->cell_h;
+
+	return INKY_OK;
+}
+
+inky_error_state inky_term_update(inky_config *cfg, inky_term *term)
+{
+	inky_error_state ret;
+	inky_rect dirty;
+
+	ret = inky_term_render(cfg, term, &dirty);
+
+	if (ret != INKY_OK) {
+		return ret;
+	}
+
+	if (dirty.w == 0) {
+		return INKY_OK;
+	}
+
+	return inky_update_region(cfg, &dirty);
+}
+
+/*
+**********************************************************************
+************************* INTERNAL API *******************************
+**********************************************************************
+*/
+
+static void _term_put(inky_term *term, UINT16_t col, UINT16_t row,
+		      UINT32_t cp, inky_color fg, inky_color bg)
+{
+	UINT32_t i = (UINT32_t) row * term->cols + col;
+	inky_term_cell *cell = &term->cells[i];
+
+	if (cell->cp == cp && cell->fg == fg && cell->bg == bg) {
+		return;
+	}
+
+	cell->cp = cp;
+	cell->fg = fg;
+	cell->bg = bg;
+
+	term->damage[i / 8] |= 1 << (i % 8);
+}
+
+static void _term_erase(inky_term *term, UINT32_t first, UINT32_t last)
+{
+	for (UINT32_t i = first; i < last; i++) {
+		_term_put(term, i % term->cols, i / term->cols, ' ',
+			  term->fg, term->bg);
+	}
+}
+
+static void _term_linefeed(inky_term *term)
+{
+	if (term->row + 1 < term->rows) {
+		term->row++;
+		return;
+	}
+
+	/* Shift the grid up a row, damaging only cells that change */
+	for (UINT16_t j = 0; j + 1 < term->rows; j++) {
+		for (UINT16_t i = 0; i < term->cols; i++) {
+			const inky_term_cell *below =
+				&term->cells[(UINT32_t) (j + 1) *
+					     term->cols + i];
+
+			_term_put(term, i, j, below->cp, below->fg,
+				  below->bg);
+		}
+	}
+
+	_term_erase(term, (UINT32_t) (term->rows - 1) * term->cols,
+		    (UINT32_t) term->rows * term->cols);
+}
+
+static void _term_reset(inky_term *term)
+{
+	UINT32_t n = (UINT32_t) term->cols * term->rows;
+
+	term->fg = term->def_fg;
+	term->bg = term->def_bg;
+	term->reverse = 0;
+	term->col = 0;
+	term->row = 0;
+	term->state = _TERM_GROUND;
+	term->n_params = 0;
+
+	/* Give every cell a value _term_put() will see as changed */
+	for (UINT32_t i = 0; i < n; i++) {
+		if (term->cells[i].cp != ' ' ||
+		    term->cells[i].fg != term->fg ||
+		    term->cells[i].bg != term->bg) {
+			term->damage[i / 8] |= 1 << (i % 8);
+		}
+
+		term->cells[i].cp = ' ';
+		term->cells[i].fg = term->fg;
+		term->cells[i].bg = term->bg;
+	}
+}
+
+static void _term_csi(inky_config *cfg, inky_term *term, UINT32_t final)
+{
+	UINT16_t p0 = term->params[0];
+	UINT16_t n = p0 ? p0 : 1;
+	UINT32_t cursor;
+
+	/* Finish a pending wrap before moving relative to the cursor */
+	if (term->col >= term->cols) {
+		term->col = term->cols - 1;
+	}
+
+	cursor = (UINT32_t) term->row * term->cols + term->col;
+
+	switch (final) {
+	case 'A':
+		term->row = term->row > n ? term->row - n : 0;
+		break;
+	case 'B':
+		term->row = term->row + n < term->rows ? term->row + n :
+			term->rows - 1;
+		break;
+	case 'C':
+		term->col = term->col + n < term->cols ? term->col + n :
+			term->cols - 1;
+		break;
+	case 'D':
+		term->col = term->col > n ? term->col - n : 0;
+		break;
+	case 'H':
+	case 'f':
+		/* 1-based row;col, clamped to the grid */
+		term->row = p0 ? p0 - 1 : 0;
+		term->col = term->params[1] ? term->params[1] - 1 : 0;
+
+		if (term->row >= term->rows) {
+			term->row = term->rows - 1;
+		}
+
+		if (term->col >= term->cols) {
+			term->col = term->cols - 1;
+		}
+		break;
+	case 'J':
+		if (p0 == 0) {
+			_term_erase(term, cursor,
+				    (UINT32_t) term->rows * term->cols);
+		} else if (p0 == 1) {
+			_term_erase(term, 0, cursor + 1);
+		} else if (p0 == 2) {
+			_term_erase(term, 0,
+				    (UINT32_t) term->rows * term->cols);
+		}
+		break;
+	case 'K':
+		if (p0 == 0) {
+			_term_erase(term, cursor, cursor - term->col +
+				    term->cols);
+		} else if (p0 == 1) {
+			_term_erase(term, cursor - term->col, cursor + 1);
+		} else if (p0 == 2) {
+			_term_erase(term, cursor - term->col, cursor -
+				    term->col + term->cols);
+		}
+		break;
+	case 'm':
+		if (term->n_params == 0) {
+			_term_sgr(cfg, term, 0);
+		}
+
+		for (UINT8_t i = 0; i < term->n_params &&
+			     i < INKY_TERM_MAX_PARAMS; i++) {
+			_term_sgr(cfg, term, term->params[i]);
+		}
+		break;
+	default:
+		break;
+	}
+}
+
+static void _term_sgr(inky_config *cfg, inky_term *term, UINT16_t p)
+{
+	inky_color fg = term->reverse ? term->bg : term->fg;
+	inky_color bg = term->reverse ? term->fg : term->bg;
+	inky_color c;
+
+	switch (p) {
+	case 0:
+		term->reverse = 0;
+		term->fg = term->def_fg;
+		term->bg = term->def_bg;
+		return;
+	case 7:
+	case 27:
+		term->reverse = p == 7;
+		break;
+	case 39:
+		fg = term->def_fg;
+		break;
+	case 49:
+		bg = term->def_bg;
+		break;
+	default:
+		switch (p % 10) {
+		case 0:
+			c = INKY_COLOR_BLACK;
+			break;
+		case 1:
+			c = INKY_COLOR_RED;
+			break;
+		case 3:
+			c = INKY_COLOR_YELLOW;
+			break;
+		case 7:
+			c = INKY_COLOR_WHITE;
+			break;
+		default:
+			return;
+		}
+
+		if ((p / 10 != 3 && p / 10 != 4) ||
+		    !inky_color_available(cfg, c)) {
+			return;
+		}
+
+		if (p / 10 == 3) {
+			fg = c;
+		} else {
+			bg = c;
+		}
+		break;
+	}
+
+	/* fg and bg are the colors before any reversal */
+	term->fg = term->reverse ? bg : fg;
+	term->bg = term->reverse ? fg : bg;
+}
+
+static inky_error_state _term_draw_cell(inky_config *cfg,
+					const inky_term *term,
+					UINT16_t col, UINT16_t row)
+{
+	inky_error_state ret;
+	const inky_term_cell *cell =
+		&term->cells[(UINT32_t) row * term->cols + col];
+	const inky_font *font = term->font;
+	const inky_glyph *g = inky_font_find(font, cell->cp);
+	UINT16_t x = term->x + col * term->cell_w;
+	UINT16_t y = term->y + row * term->cell_h;
+
+	if (!g) {
+		g = inky_font_find(font, font->fallback);
+	}
+
+	/* Each glyph row is drawn as runs of one color */
+	for (UINT8_t j = 0; j < term->cell_h; j++) {
+		const UINT8_t *bits = NULL;
+		UINT16_t start = 0;
+		UINT8_t ink = 0;
+
+		if (g) {
+			bits = &font->bitmap[g->offset +
+					     (UINT32_t) j * ((g->width + 7) / 8)];
+		}
+
+		/* One past the last column flushes the run, so i must count
+		 * past the widest cell */
+		for (UINT16_t i = 0; i <= term->cell_w; i++) {
+			UINT8_t next = 2;
+
+			if (i < term->cell_w) {
+				next = g && i < g->width &&
+					((bits[i / 8] >> (i % 8)) & 1);
+			}
+
+			if (i > 0 && next != ink) {
+				ret = inky_fb_hline(cfg, x + start, y + j,
+						    i - start,
+						    ink ? cell->fg : cell->bg);
+
+				if (ret != INKY_OK) {
+					return ret;
+				}
+
+				start = i;
+			}
+
+			ink = next;
+		}
+	}
+
+	return INKY_OK;
+}
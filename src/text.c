@@ -0,0 +1,347 @@
+#include "pixfmt.h"
+
+#include <inky-text.h>
+
+#include <stdlib.h>
+#include <string.h>
+
+/*
+**********************************************************************
+************************ Text Definitions ****************************
+**********************************************************************
+*/
+
+/** @brief Glyph drawn for a code point, falling back to the font's
+ * fallback glyph */
+static const inky_glyph *_glyph_or_fallback(const inky_font *font,
+					    UINT32_t cp);
+
+/** @brief Encode glyph g as sprite spr, widened to its advance when the
+ * cell has a background */
+static inky_error_state _glyph_sprite(inky_config *cfg,
+				      const inky_font *font,
+				      const inky_glyph *g, inky_sprite *spr,
+				      inky_color fg, const inky_color *bg);
+
+/*
+**********************************************************************
+************************** API Functions *****************************
+**********************************************************************
+*/
+
+UINT32_t inky_utf8_next(const char **s)
+{
+	const UINT8_t *p = (const UINT8_t*) *s;
+	UINT32_t cp;
+	UINT8_t n;
+
+	if (p[0] == 0) {
+		return 0;
+	}
+
+	if (p[0] < 0x80) {
+		*s += 1;
+		return p[0];
+	}
+
+	if ((p[0] & 0xe0) == 0xc0) {
+		cp = p[0] & 0x1f;
+		n = 1;
+	} else if ((p[0] & 0xf0) == 0xe0) {
+		cp = p[0] & 0x0f;
+		n = 2;
+	} else if ((p[0] & 0xf8) == 0xf0) {
+		cp = p[0] & 0x07;
+		n = 3;
+	} else {
+		*s += 1;
+		return INKY_UTF8_INVALID;
+	}
+
+	for (UINT8_t i = 1; i <= n; i++) {
+		/* A NUL also stops here, so the string is never overrun */
+		if ((p[i] & 0xc0) != 0x80) {
+			*s += 1;
+			return INKY_UTF8_INVALID;
+		}
+
+		cp = (cp << 6) | (p[i] & 0x3f);
+	}
+
+	/* Overlong forms, surrogates and code points past Unicode */
+	if ((n == 1 && cp < 0x80) || (n == 2 && cp < 0x800) ||
+	    (n == 3 && cp < 0x10000) || cp > 0x10ffff ||
+	    (cp >= 0xd800 && cp <= 0xdfff)) {
+		*s += 1;
+		return INKY_UTF8_INVALID;
+	}
+
+	*s += n + 1;
+
+	return cp;
+}
+
+const inky_glyph *inky_font_find(const inky_font *font, UINT32_t cp)
+{
+	UINT32_t lo = 0;
+	UINT32_t hi;
+
+	if (!font || !font->glyphs) {
+		return NULL;
+	}
+
+	hi = font->n_glyphs;
+
+	while (lo < hi) {
+		UINT32_t mid = (lo + hi) / 2;
+
+		if (font->glyphs[mid].codepoint < cp) {
+			lo = mid + 1;
+		} else {
+			hi = mid;
+		}
+	}
+
+	if (lo < font->n_glyphs && font->glyphs[lo].codepoint == cp) {
+		return &font->glyphs[lo];
+	}
+
+	return NULL;
+}
+
+UINT32_t inky_text_width(const inky_font *font, const char *utf8)
+{
+	UINT32_t widest = 0;
+	UINT32_t width = 0;
+	UINT32_t cp;
+
+	if (!font || !utf8) {
+		return 0;
+	}
+
+	while ((cp = inky_utf8_next(&utf8))) {
+		const inky_glyph *g;
+
+		if (cp == '\n') {
+			width = 0;
+			continue;
+		}
+
+		g = _glyph_or_fallback(font, cp);
+
+		if (g) {
+			width += g->advance;
+		}
+
+		if (width > widest) {
+			widest = width;
+		}
+	}
+
+	return widest;
+}
+
+inky_error_state inky_text_atlas_create(inky_config *cfg,
+					inky_text_atlas *atlas,
+					const inky_font *font,
+					inky_color fg,
+					const inky_color *bg)
+{
+	inky_error_state ret;
+
+	if (!cfg->fb) {
+		return INKY_E_NOT_CONFIGURED;
+	}
+
+	if (!atlas || !font || !font->glyphs || !font->bitmap) {
+		return INKY_E_NULL_PTR;
+	}
+
+	if (!inky_color_available(cfg, fg) ||
+	    (bg && !inky_color_available(cfg, *bg))) {
+		return INKY_E_NOT_AVAILABLE;
+	}
+
+	atlas->font = font;
+	atlas->glyphs = calloc(font->n_glyphs ? font->n_glyphs : 1,
+			       sizeof(inky_sprite));
+
+	if (!atlas->glyphs) {
+		return INKY_E_OUT_OF_MEMORY;
+	}
+
+	for (UINT16_t i = 0; i < font->n_glyphs; i++) {
+		ret = _glyph_sprite(cfg, font, &font->glyphs[i],
+				    &atlas->glyphs[i], fg, bg);
+
+		if (ret != INKY_OK) {
+			inky_text_atlas_free(atlas);
+			return ret;
+		}
+	}
+
+	return INKY_OK;
+}
+
+inky_error_state inky_text_atlas_free(inky_text_atlas *atlas)
+{
+	if (!atlas) {
+		return INKY_E_NULL_PTR;
+	}
+
+	if (atlas->glyphs) {
+		for (UINT16_t i = 0; i < atlas->font->n_glyphs; i++) {
+			inky_sprite_free(&atlas->glyphs[i]);
+		}
+	}
+
+	free(atlas->glyphs);
+
+	atlas->glyphs = NULL;
+
+	return INKY_OK;
+}
+
+inky_error_state inky_text_draw(inky_config *cfg,
+				const inky_text_atlas *atlas,
+				INT16_t x, INT16_t y, const char *utf8,
+				const inky_rect *clip)
+{
+	inky_error_state ret;
+	INT32_t right;
+	INT32_t pen_x = x;
+	INT32_t pen_y = y;
+	UINT32_t cp;
+
+	if ((ret = pixfmt_fb_check(cfg->fb)) != INKY_OK) {
+		return ret;
+	}
+
+	if (!atlas || !atlas->glyphs || !utf8) {
+		return INKY_E_NULL_PTR;
+	}
+
+	right = INKY_FB_WIDTH(cfg->fb);
+
+	if (clip && clip->x + clip->w < right) {
+		right = clip->x + clip->w;
+	}
+
+	while ((cp = inky_utf8_next(&utf8))) {
+		const inky_glyph *g;
+		const inky_sprite *spr;
+
+		if (cp == '\n') {
+			pen_x = x;
+			pen_y += atlas->font->height;
+			continue;
+		}
+
+		/* Nothing more of this line can show */
+		if (pen_x >= right || pen_y >= INKY_FB_HEIGHT(cfg->fb)) {
+			continue;
+		}
+
+		g = _glyph_or_fallback(atlas->font, cp);
+
+		if (!g) {
+			continue;
+		}
+
+		spr = &atlas->glyphs[g - atlas->font->glyphs];
+
+		/* Skipping glyphs left of or above the framebuffer keeps
+		 * the pen in range of INT16_t */
+		if (spr->pixels && pen_x + spr->width > 0 &&
+		    pen_y + spr->height > 0) {
+			ret = inky_fb_draw_sprite_clip(cfg, spr,
+						       (INT16_t) pen_x,
+						       (INT16_t) pen_y, clip);
+
+			if (ret != INKY_OK) {
+				return ret;
+			}
+		}
+
+		pen_x += g->advance;
+	}
+
+	return INKY_OK;
+}
+
+/*
+**********************************************************************
+************************* INTERNAL API *******************************
+**********************************************************************
+*/
+
+static const inky_glyph *_glyph_or_fallback(const inky_font *font,
+					    UINT32_t cp)
+{
+	const inky_glyph *g = inky_font_find(font, cp);
+
+	if (!g) {
+		g = inky_font_find(font, font->fallback);
+	}
+
+	return g;
+}
+
+static inky_error_state _glyph_sprite(inky_config *cfg,
+				      const inky_font *font,
+				      const inky_glyph *g, inky_sprite *spr,
+				      inky_color fg, const inky_color *bg)
+{
+	inky_error_state ret;
+	inky_bitmap bm;
+	UINT8_t *cell = NULL;
+	UINT32_t stride = (g->width + 7) / 8;
+
+	bm.type = INKY_BITMAP_MASK;
+	bm.format = cfg->fb->fmt.format;
+	bm.width = g->width;
+	bm.height = font->height;
+	bm.stride = stride;
+	bm.data = &font->bitmap[g->offset];
+	bm.color = NULL;
+
+	/* Copy the glyph into a cell of its advance, so the gap to the
+	 * next glyph is drawn in bg too */
+	if (bg && g->advance > g->width) {
+		UINT32_t cell_stride = (g->advance + 7) / 8;
+
+		cell = calloc(font->height ? font->height : 1, cell_stride);
+
+		if (!cell) {
+			return INKY_E_OUT_OF_MEMORY;
+		}
+
+		for (UINT8_t j = 0; j < font->height; j++) {
+			UINT8_t *row = &cell[cell_stride * j];
+
+			memcpy(row, &bm.data[stride * j], stride);
+
+			if (g->width % 8) {
+				row[stride - 1] &= (1 << (g->width % 8)) - 1;
+			}
+		}
+
+		bm.width = g->advance;
+		bm.stride = cell_stride;
+		bm.data = cell;
+	}
+
+	/* Empty glyphs, such as a transparent space, need no sprite */
+	if (bm.width == 0 || bm.height == 0) {
+		spr->pixels = NULL;
+		spr->mask = NULL;
+		free(cell);
+		return INKY_OK;
+	}
+
+	ret = inky_sprite_create_mask(cfg, spr, &bm, NULL, fg, bg);
+
+	free(cell);
+
+	return ret;
+}
@@ -0,0 +1,528 @@
+#include "pixfmt.h"
+
+#include <inky-widget.h>
+#include <inky-draw.h>
+
+#include <string.h>
+
+/*
+**********************************************************************
+************************* Widget Definitions *************************
+**********************************************************************
+*/
+
+/** @brief Repaint widget if damaged or force, then its children,
+ * growing box over what was repainted */
+static inky_error_state _render(inky_config *cfg, inky_draw *draw,
+				inky_widget *widget, UINT8_t force,
+				inky_rect *box);
+
+/** @brief Draw a widget inside the top clip of draw */
+static inky_error_state _paint(inky_config *cfg, const inky_draw *draw,
+			       const inky_widget *widget);
+
+static inky_error_state _paint_bar(inky_config *cfg, const inky_draw *draw,
+				   const inky_widget *widget);
+
+static inky_error_state _paint_sparkline(inky_config *cfg,
+					 const inky_draw *draw,
+					 const inky_widget *widget);
+
+/** @brief Blit the part of a bitmap widget inside clip */
+static inky_error_state _paint_bitmap(inky_config *cfg,
+				      const inky_widget *widget,
+				      const inky_rect *clip);
+
+/** @brief Grow box over r, box being empty while w is 0 */
+static void _grow(inky_rect *box, const inky_rect *r);
+
+/*
+**********************************************************************
+************************** API Functions *****************************
+**********************************************************************
+*/
+
+inky_error_state inky_widget_init(inky_widget *widget,
+				  inky_widget_type type,
+				  const inky_rect *bounds)
+{
+	if (!widget || !bounds) {
+		return INKY_E_NULL_PTR;
+	}
+
+	if (type > INKY_WIDGET_SPARKLINE) {
+		return INKY_E_OUT_OF_RANGE;
+	}
+
+	memset(widget, 0, sizeof(*widget));
+
+	widget->type = type;
+	widget->bounds = *bounds;
+	widget->fg = INKY_COLOR_BLACK;
+	widget->bg = INKY_COLOR_WHITE;
+	widget->max = 100;
+	widget->damaged = 1;
+
+	return INKY_OK;
+}
+
+inky_error_state inky_widget_add(inky_widget *parent, inky_widget *child)
+{
+	inky_widget **at;
+
+	if (!parent || !child) {
+		return INKY_E_NULL_PTR;
+	}
+
+	if (child->parent || child == parent) {
+		return INKY_E_OUT_OF_RANGE;
+	}
+
+	at = &parent->child;
+
+	while (*at) {
+		at = &(*at)->next;
+	}
+
+	*at = child;
+	child->parent = parent;
+	child->next = NULL;
+	child->damaged = 1;
+
+	return INKY_OK;
+}
+
+inky_error_state inky_widget_set_value(inky_widget *widget, INT32_t value)
+{
+	if (!widget) {
+		return INKY_E_NULL_PTR;
+	}
+
+	/* Every sample moves a sparkline along */
+	if (widget->type == INKY_WIDGET_SPARKLINE && widget->samples) {
+		widget->samples[widget->head] = value;
+		widget->head = (widget->head + 1) % widget->n_samples;
+		widget->count += widget->count < widget->n_samples;
+		widget->damaged = 1;
+	}
+
+	if (widget->value != value) {
+		widget->value = value;
+		widget->damaged |= widget->type == INKY_WIDGET_RECT ||
+			widget->type == INKY_WIDGET_BAR;
+	}
+
+	return INKY_OK;
+}
+
+inky_error_state inky_widget_set_range(inky_widget *widget, INT32_t min,
+				       INT32_t max)
+{
+	if (!widget) {
+		return INKY_E_NULL_PTR;
+	}
+
+	if (max < min) {
+		return INKY_E_OUT_OF_RANGE;
+	}
+
+	if (widget->min != min || widget->max != max) {
+		widget->min = min;
+		widget->max = max;
+		widget->damaged = 1;
+	}
+
+	return INKY_OK;
+}
+
+inky_error_state inky_widget_set_samples(inky_widget *widget,
+					 INT32_t *samples, UINT16_t n)
+{
+	if (!widget || !samples) {
+		return INKY_E_NULL_PTR;
+	}
+
+	if (n < 2) {
+		return INKY_E_OUT_OF_RANGE;
+	}
+
+	widget->samples = samples;
+	widget->n_samples = n;
+	widget->count = 0;
+	widget->head = 0;
+	widget->damaged = 1;
+
+	return INKY_OK;
+}
+
+inky_error_state inky_widget_set_text(inky_widget *widget,
+				      const inky_text_atlas *atlas,
+				      const char *utf8)
+{
+	size_t len;
+
+	if (!widget || !atlas || !utf8) {
+		return INKY_E_NULL_PTR;
+	}
+
+	len = strlen(utf8);
+
+	if (len >= INKY_WIDGET_MAX_TEXT) {
+		return INKY_E_OUT_OF_RANGE;
+	}
+
+	if (widget->atlas != atlas || strcmp(widget->text, utf8) != 0) {
+		memcpy(widget->text, utf8, len + 1);
+		widget->atlas = atlas;
+		widget->damaged = 1;
+	}
+
+	return INKY_OK;
+}
+
+inky_error_state inky_widget_set_bitmap(inky_widget *widget,
+					const inky_bitmap *bitmap)
+{
+	if (!widget || !bitmap) {
+		return INKY_E_NULL_PTR;
+	}
+
+	if (widget->bitmap != bitmap) {
+		widget->bitmap = bitmap;
+		widget->damaged = 1;
+	}
+
+	return INKY_OK;
+}
+
+inky_error_state inky_widget_set_colors(inky_widget *widget,
+					inky_color fg, inky_color bg)
+{
+	if (!widget) {
+		return INKY_E_NULL_PTR;
+	}
+
+	if (widget->fg != fg || widget->bg != bg) {
+		widget->fg = fg;
+		widget->bg = bg;
+		widget->damaged = 1;
+	}
+
+	return INKY_OK;
+}
+
+inky_error_state inky_widget_set_bounds(inky_widget *widget,
+					const inky_rect *bounds)
+{
+	if (!widget || !bounds) {
+		return INKY_E_NULL_PTR;
+	}
+
+	if (memcmp(&widget->bounds, bounds, sizeof(*bounds)) != 0) {
+		widget->bounds = *bounds;
+		widget->damaged = 1;
+
+		if (widget->parent) {
+			widget->parent->damaged = 1;
+		}
+	}
+
+	return INKY_OK;
+}
+
+inky_error_state inky_widget_damage(inky_widget *widget)
+{
+	if (!widget) {
+		return INKY_E_NULL_PTR;
+	}
+
+	widget->damaged = 1;
+
+	return INKY_OK;
+}
+
+inky_error_state inky_widget_render(inky_config *cfg, inky_widget *root,
+				    inky_rect *dirty)
+{
+	inky_error_state ret;
+	inky_draw draw;
+	inky_rect box = { 0, 0, 0, 0 };
+
+	if ((ret = pixfmt_fb_check(cfg->fb)) != INKY_OK) {
+		return ret;
+	}
+
+	if (!root) {
+		return INKY_E_NULL_PTR;
+	}
+
+	ret = inky_draw_init(cfg, &draw);
+
+	if (ret != INKY_OK) {
+		return ret;
+	}
+
+	ret = _render(cfg, &draw, root, 0, &box);
+
+	if (dirty) {
+		*dirty = box;
+	}
+
+	return ret;
+}
+
+inky_error_state inky_widget_update(inky_config *cfg, inky_widget *root)
+{
+	inky_error_state ret;
+	inky_rect dirty;
+
+	ret = inky_widget_render(cfg, root, &dirty);
+
+	if (ret != INKY_OK) {
+		return ret;
+	}
+
+	if (dirty.w == 0) {
+		return INKY_OK;
+	}
+
+	/* Sending the framebuffer's dirty rectangle leaves it clean, so
+	 * the widgets are not sent again by the next update */
+	ret = inky_fb_mark_dirty(cfg, &dirty);
+
+	if (ret != INKY_OK) {
+		return ret;
+	}
+
+	return inky_update_dirty(cfg);
+}
+
+/*
+**********************************************************************
+************************* INTERNAL API *******************************
+**********************************************************************
+*/
+
+static inky_error_state _render(inky_config *cfg, inky_draw *draw,
+				inky_widget *widget, UINT8_t force,
+				inky_rect *box)
+{
+	inky_error_state ret;
+	const inky_rect *clip;
+
+	ret = inky_draw_push_clip(draw, &widget->bounds);
+
+	if (ret != INKY_OK) {
+		return ret;
+	}
+
+	clip = &draw->clip[draw->depth - 1];
+
+	/* Children of a repainted widget were painted over */
+	if (force || widget->damaged) {
+		if (clip->w && clip->h) {
+			ret = _paint(cfg, draw, widget);
+			_grow(box, clip);
+		}
+
+		widget->damaged = ret != INKY_OK;
+		force = 1;
+	}
+
+	for (inky_widget *c = widget->child; c && ret == INKY_OK;
+	     c = c->next) {
+		ret = _render(cfg, draw, c, force, box);
+	}
+
+	inky_draw_pop_clip(draw);
+
+	return ret;
+}
+
+static inky_error_state _paint(inky_config *cfg, const inky_draw *draw,
+			       const inky_widget *widget)
+{
+	inky_error_state ret;
+	const inky_rect *b = &widget->bounds;
+
+	ret = inky_draw_fill_rect(cfg, draw, b->x, b->y, b->w, b->h,
+				  widget->bg);
+
+	if (ret != INKY_OK) {
+		return ret;
+	}
+
+	switch (widget->type) {
+	case INKY_WIDGET_RECT:
+		if (widget->value) {
+			return inky_draw_fill_rect(cfg, draw, b->x, b->y, b->w,
+						   b->h, widget->fg);
+		}
+
+		return inky_draw_rect(cfg, draw, b->x, b->y, b->w, b->h,
+				      widget->fg);
+
+	case INKY_WIDGET_TEXT:
+		if (!widget->atlas) {
+			return INKY_OK;
+		}
+
+		return inky_text_draw(cfg, widget->atlas, b->x, b->y,
+				      widget->text,
+				      &draw->clip[draw->depth - 1]);
+
+	case INKY_WIDGET_BITMAP:
+		return _paint_bitmap(cfg, widget,
+				     &draw->clip[draw->depth - 1]);
+
+	case INKY_WIDGET_BAR:
+		return _paint_bar(cfg, draw, widget);
+
+	default:
+		return _paint_sparkline(cfg, draw, widget);
+	}
+}
+
+static inky_error_state _paint_bar(inky_config *cfg, const inky_draw *draw,
+				   const inky_widget *widget)
+{
+	inky_error_state ret;
+	const inky_rect *b = &widget->bounds;
+	INT64_t v = widget->value;
+	INT64_t range = (INT64_t) widget->max - widget->min;
+	UINT8_t up = b->h > b->w;
+	INT64_t span = (up ? b->h : b->w) - 2;
+	UINT16_t n;
+
+	ret = inky_draw_rect(cfg, draw, b->x, b->y, b->w, b->h, widget->fg);
+
+	if (ret != INKY_OK || span <= 0 || b->w < 3 || b->h < 3) {
+		return ret;
+	}
+
+	v = v < widget->min ? widget->min : v;
+	v = v > widget->max ? widget->max : v;
+	n = range ? (v - widget->min) * span / range : span;
+
+	if (n == 0) {
+		return INKY_OK;
+	}
+
+	if (up) {
+		return inky_draw_fill_rect(cfg, draw, b->x + 1,
+					   b->y + 1 + span - n, b->w - 2, n,
+					   widget->fg);
+	}
+
+	return inky_draw_fill_rect(cfg, draw, b->x + 1, b->y + 1, n,
+				   b->h - 2, widget->fg);
+}
+
+static inky_error_state _paint_sparkline(inky_config *cfg,
+					 const inky_draw *draw,
+					 const inky_widget *widget)
+{
+	inky_error_state ret = INKY_OK;
+	const inky_rect *b = &widget->bounds;
+	INT32_t lo = widget->min;
+	INT32_t hi = widget->max;
+	UINT16_t first;
+	INT32_t px = 0;
+	INT32_t py = 0;
+
+	if (!widget->samples || widget->count == 0 || b->w == 0 ||
+	    b->h == 0) {
+		return INKY_OK;
+	}
+
+	first = (widget->head + widget->n_samples - widget->count) %
+		widget->n_samples;
+
+	/* Scale to the samples shown without a range */
+	if (lo == hi) {
+		lo = INT32_MAX;
+		hi = INT32_MIN;
+
+		for (UINT16_t i = 0; i < widget->count; i++) {
+			INT32_t s = widget->samples[(first + i) %
+						    widget->n_samples];
+
+			lo = s < lo ? s : lo;
+			hi = s > hi ? s : hi;
+		}
+	}
+
+	for (UINT16_t i = 0; i < widget->count && ret == INKY_OK; i++) {
+		INT64_t s = widget->samples[(first + i) % widget->n_samples];
+		UINT16_t back = widget->count - 1 - i;
+		INT32_t x, y;
+
+		s = s < lo ? lo : s;
+		s = s > hi ? hi : s;
+
+		/* The newest sample sits on the right edge */
+		x = b->x + b->w - 1 - (INT32_t) back * (b->w - 1) /
+			(widget->n_samples - 1);
+		y = b->y + b->h - 1 - (hi > lo ? (s - lo) * (b->h - 1) /
+				       ((INT64_t) hi - lo) : 0);
+
+		ret = inky_draw_line(cfg, draw, i ? px : x, i ? py : y, x, y,
+				     widget->fg);
+		px = x;
+		py = y;
+	}
+
+	return ret;
+}
+
+static inky_error_state _paint_bitmap(inky_config *cfg,
+				      const inky_widget *widget,
+				      const inky_rect *clip)
+{
+	const inky_bitmap *bm = widget->bitmap;
+	const inky_rect *b = &widget->bounds;
+	INT32_t x0, y0, x1, y1;
+	inky_rect area;
+
+	if (!bm) {
+		return INKY_OK;
+	}
+
+	x0 = b->x > clip->x ? b->x : clip->x;
+	y0 = b->y > clip->y ? b->y : clip->y;
+	x1 = b->x + bm->width;
+	y1 = b->y + bm->height;
+	x1 = x1 < clip->x + clip->w ? x1 : clip->x + clip->w;
+	y1 = y1 < clip->y + clip->h ? y1 : clip->y + clip->h;
+
+	if (x0 >= x1 || y0 >= y1) {
+		return INKY_OK;
+	}
+
+	area.x = x0 - b->x;
+	area.y = y0 - b->y;
+	area.w = x1 - x0;
+	area.h = y1 - y0;
+
+	return inky_fb_blit(cfg, bm, &area, x0, y0, INKY_ROP_COPY,
+			    widget->fg, widget->bg);
+}
+
+static void _grow(inky_rect *box, const inky_rect *r)
+{
+	UINT32_t x1, y1;
+
+	if (box->w == 0) {
+		*box = *r;
+		return;
+	}
+
+	x1 = (UINT32_t) box->x + box->w;
+	y1 = (UINT32_t) box->y + box->h;
+	x1 = x1 > (UINT32_t) r->x + r->w ? x1 : (UINT32_t) r->x + r->w;
+	y1 = y1 > (UINT32_t) r->y + r->h ? y1 : (UINT32_t) r->y + r->h;
+	box->x = box->x < r->x ? box->x : r->x;
+	box->y = box->y < r->y ? box->y : r->y;
+	box->w = x1 - box->x;
+	box->h = y1 - box->y;
+}
@@ -0,0 +1,392 @@
+/**
+ * @file binarize-test.c
+ *
+ * Unit testing for the adaptive threshold binarization of the Pimoroni
+ * Inky driver
+ */
+
+#include "inky.h"
+
+#include <munit/munit.h>
+
+#include "test-device.h"
+
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+/**
+ * @defgroup pimoroni-inky-binarize-tests Pimoroni Inky binarization
+ * testing suites
+ * @{
+ */
+
+/*
+**********************************************************************
+************************** TESTS DEFINITIONS *************************
+**********************************************************************
+*/
+
+#define PIC_W	41
+#define PIC_H	23
+
+/** @brief Bytes per picture row, with some padding after the pixels */
+#define PIC_STRIDE	(PIC_W + 7)
+
+static uint64_t ref_isqrt(uint64_t v)
+{
+	uint64_t r = 0;
+
+	while ((r + 1) * (r + 1) <= v) {
+		r++;
+	}
+
+	return r;
+}
+
+/** @brief Whether pixel u of row v of a w by h picture is black, from a
+ * w + 1 by h + 1 integral image of the picture and of its squares */
+static int ref_black(const uint64_t *in, const uint64_t *in2,
+		     const uint8_t *pic, int w, int h, int u, int v,
+		     inky_binarize_mode mode, int radius, int level)
+{
+	int l = u - radius < 0 ? 0 : u - radius;
+	int t = v - radius < 0 ? 0 : v - radius;
+	int r = u + radius + 1 > w ? w : u + radius + 1;
+	int b = v + radius + 1 > h ? h : v + radius + 1;
+	int64_t n = (int64_t) (r - l) * (b - t);
+	int64_t p = pic[PIC_STRIDE * v + u];
+	int64_t sum = in[(w + 1) * b + r] - in[(w + 1) * t + r] -
+		in[(w + 1) * b + l] + in[(w + 1) * t + l];
+	int64_t sq = in2[(w + 1) * b + r] - in2[(w + 1) * t + r] -
+		in2[(w + 1) * b + l] + in2[(w + 1) * t + l];
+	int64_t dev;
+
+	if (mode == INKY_BINARIZE_BRADLEY) {
+		return p * n * 100 < sum * (100 - level);
+	}
+
+	dev = ref_isqrt(sq * n - sum * sum);
+
+	return p * n * n * 12800 < sum * (12800 * n + level * (dev - 128 * n));
+}
+
+/**
+ * @defgroup binarize-test Streamed output against whole-picture windows
+ * @{
+ */
+
+static MunitResult binarize_test(const MunitParameter params[],
+				 void *user_data)
+{
+	INTF(user_data);
+	inky_config *dev = &intf->dev;
+	static uint8_t pic[PIC_H * PIC_STRIDE];
+	static uint64_t in[(PIC_H + 1) * (PIC_W + 1)];
+	static uint64_t in2[(PIC_H + 1) * (PIC_W + 1)];
+	inky_config ref_dev;
+	inky_fb ref;
+	inky_fb *fb;
+
+	munit_assert_int8(inky_setup(dev), ==, INKY_OK);
+
+	fb = dev->fb;
+	ref = *fb;
+	ref.buffer = malloc(fb->bytes);
+	munit_assert_not_null(ref.buffer);
+	ref_dev = *dev;
+	ref_dev.fb = &ref;
+
+	for (int i = 0; i < 40; i++) {
+		inky_binarize_mode mode = (inky_binarize_mode) (i % 2);
+		int w = munit_rand_int_range(1, PIC_W);
+		int h = munit_rand_int_range(1, PIC_H);
+		int radius = munit_rand_int_range(1, 30);
+		int level = munit_rand_int_range(0, 100);
+		int16_t x = munit_rand_int_range(-PIC_W, fb->width);
+		int16_t y = munit_rand_int_range(-PIC_H, fb->height);
+		uint32_t x0 = UINT32_MAX, y0 = UINT32_MAX, x1 = 0, y1 = 0;
+
+		/* Blocks of similar gray, so that windows are not all alike */
+		for (int v = 0; v < PIC_H; v++) {
+			for (int u = 0; u < PIC_STRIDE; u++) {
+				pic[PIC_STRIDE * v + u] =
+					((u / 5 + v / 4) * 53 + (i * 31)) % 200 +
+					munit_rand_int_range(0, 55);
+			}
+		}
+
+		if (i % 5 == 0) {
+			memset(pic, i % 10 ? 0xff : 0, sizeof(pic));
+		}
+
+		if (i % 3 == 0) {
+			x = munit_rand_uint32() % (fb->width - PIC_W);
+			y = munit_rand_uint32() % (fb->height - PIC_H);
+		}
+
+		for (int v = 0; v <= h; v++) {
+			for (int u = 0; u <= w; u++) {
+				uint64_t p, s = 0, s2 = 0;
+
+				if (u == 0 || v == 0) {
+					in[(w + 1) * v + u] = 0;
+					in2[(w + 1) * v + u] = 0;
+					continue;
+				}
+
+				for (int k = 0; k < u; k++) {
+					p = pic[PIC_STRIDE * (v - 1) + k];
+					s += p;
+					s2 += p * p;
+				}
+
+				in[(w + 1) * v + u] = in[(w + 1) * (v - 1) + u] + s;
+				in2[(w + 1) * v + u] =
+					in2[(w + 1) * (v - 1) + u] + s2;
+			}
+		}
+
+		for (uint32_t k = 0; k < fb->bytes; k++) {
+			fb->buffer[k] = munit_rand_uint32() & 0x55;
+		}
+
+		memcpy(ref.buffer, fb->buffer, fb->bytes);
+		fb->dirty.w = 0;
+		fb->dirty.h = 0;
+
+		for (int v = 0; v < h; v++) {
+			for (int u = 0; u < w; u++) {
+				if (x + u < 0 || y + v < 0 ||
+				    x + u >= fb->width ||
+				    y + v >= fb->height) {
+					continue;
+				}
+
+				inky_fb_set_pixel(&ref_dev, x + u, y + v,
+						  ref_black(in, in2, pic, w, h,
+							    u, v, mode, radius,
+							    level) ?
+						  INKY_COLOR_BLACK :
+						  INKY_COLOR_WHITE);
+			}
+		}
+
+		/* Bounds of the pixels whose code changes */
+		for (uint32_t v = 0; v < fb->height; v++) {
+			for (uint32_t u = 0; u < fb->width; u++) {
+				uint32_t bit = u * fb->fmt.bpp;
+				uint32_t k = fb->stride * v + bit / 8;
+				uint8_t m = fb->fmt.mask << (bit % 8);
+
+				if (!((fb->buffer[k] ^ ref.buffer[k]) & m)) {
+					continue;
+				}
+
+				x0 = u < x0 ? u : x0;
+				y0 = v < y0 ? v : y0;
+				x1 = u + 1 > x1 ? u + 1 : x1;
+				y1 = v + 1 > y1 ? v + 1 : y1;
+			}
+		}
+
+		if (i % 2) {
+			munit_assert_int8(inky_binarize_rect(dev, mode, pic,
+							     PIC_STRIDE, w, h,
+							     radius, level, x,
+							     y), ==, INKY_OK);
+		} else {
+			inky_binarize b;
+
+			munit_assert_int8(inky_binarize_begin(dev, &b, mode, w,
+							      radius, level, x,
+							      y), ==, INKY_OK);
+
+			for (int v = 0; v < h; v++) {
+				munit_assert_int8(inky_binarize_row(dev, &b,
+								    &pic[PIC_STRIDE * v]),
+						  ==, INKY_OK);
+			}
+
+			munit_assert_int8(inky_binarize_end(dev, &b), ==,
+					  INKY_OK);
+			munit_assert_null(b.ring);
+		}
+
+		munit_assert_memory_equal(fb->bytes, fb->buffer, ref.buffer);
+
+		/* Exactly the changed pixels are dirty */
+		if (x0 == UINT32_MAX) {
+			munit_assert_uint16(fb->dirty.w, ==, 0);
+		} else {
+			munit_assert_uint16(fb->dirty.x, ==, x0);
+			munit_assert_uint16(fb->dirty.y, ==, y0);
+			munit_assert_uint32(fb->dirty.x + fb->dirty.w, ==, x1);
+			munit_assert_uint32(fb->dirty.y + fb->dirty.h, ==, y1);
+		}
+	}
+
+	free(ref.buffer);
+
+	return MUNIT_OK;
+}
+
+/**
+ * @}
+ * defgroup binarize-test
+ */
+
+/**
+ * @defgroup binarize-lighting-test Text under uneven lighting
+ * @{
+ */
+
+static MunitResult binarize_lighting_test(const MunitParameter params[],
+					  void *user_data)
+{
+	INTF(user_data);
+	inky_config *dev = &intf->dev;
+	static uint8_t pic[PIC_H * PIC_STRIDE];
+	static uint8_t text[PIC_H * PIC_STRIDE];
+
+	munit_assert_int8(inky_setup(dev), ==, INKY_OK);
+
+	/* Paper from gray on the left to white on the right, darker than
+	 * the ink at the right, so no global threshold separates them */
+	for (int v = 0; v < PIC_H; v++) {
+		for (int u = 0; u < PIC_W; u++) {
+			uint8_t paper = 120 + u * 135 / (PIC_W - 1);
+
+			text[PIC_STRIDE * v + u] = (u * 7 + v * 3) % 11 == 0;
+			pic[PIC_STRIDE * v + u] = text[PIC_STRIDE * v + u] ?
+				paper / 2 : paper;
+		}
+	}
+
+	for (int mode = INKY_BINARIZE_BRADLEY; mode <= INKY_BINARIZE_SAUVOLA;
+	     mode++) {
+		munit_assert_int8(inky_binarize_rect(dev, mode, pic, PIC_STRIDE,
+						     PIC_W, PIC_H, 7,
+						     mode ? 20 : 15, 3, 2), ==,
+				  INKY_OK);
+
+		for (int v = 0; v < PIC_H; v++) {
+			for (int u = 0; u < PIC_W; u++) {
+				inky_color c;
+
+				inky_fb_get_pixel(dev, 3 + u, 2 + v, &c);
+				munit_assert_int(c, ==,
+						 text[PIC_STRIDE * v + u] ?
+						 INKY_COLOR_BLACK :
+						 INKY_COLOR_WHITE);
+			}
+		}
+	}
+
+	return MUNIT_OK;
+}
+
+/**
+ * @}
+ * defgroup binarize-lighting-test
+ */
+
+/**
+ * @defgroup binarize-args-test Bad arguments
+ * @{
+ */
+
+static MunitResult binarize_args_test(const MunitParameter params[],
+				      void *user_data)
+{
+	INTF(user_data);
+	inky_config *dev = &intf->dev;
+	uint8_t row[4] = { 0 };
+	inky_binarize b;
+
+	munit_assert_int8(inky_setup(dev), ==, INKY_OK);
+
+	munit_assert_int8(inky_binarize_begin(dev, &b, INKY_BINARIZE_SAUVOLA + 1,
+					      4, 2, 15, 0, 0), ==,
+			  INKY_E_OUT_OF_RANGE);
+	munit_assert_int8(inky_binarize_begin(dev, &b, INKY_BINARIZE_BRADLEY,
+					      0, 2, 15, 0, 0), ==,
+			  INKY_E_OUT_OF_RANGE);
+	munit_assert_int8(inky_binarize_begin(dev, &b, INKY_BINARIZE_BRADLEY,
+					      4, 0, 15, 0, 0), ==,
+			  INKY_E_OUT_OF_RANGE);
+	munit_assert_int8(inky_binarize_begin(dev, &b, INKY_BINARIZE_BRADLEY,
+					      4, INKY_BINARIZE_MAX_RADIUS + 1,
+					      15, 0, 0), ==,
+			  INKY_E_OUT_OF_RANGE);
+	munit_assert_int8(inky_binarize_begin(dev, &b, INKY_BINARIZE_BRADLEY,
+					      4, 2, 101, 0, 0), ==,
+			  INKY_E_OUT_OF_RANGE);
+	munit_assert_int8(inky_binarize_begin(dev, NULL, INKY_BINARIZE_BRADLEY,
+					      4, 2, 15, 0, 0), ==,
+			  INKY_E_NULL_PTR);
+	munit_assert_int8(inky_binarize_rect(dev, INKY_BINARIZE_BRADLEY, NULL,
+					     4, 4, 1, 2, 15, 0, 0), ==,
+			  INKY_E_NULL_PTR);
+
+	munit_assert_int8(inky_binarize_begin(dev, &b, INKY_BINARIZE_SAUVOLA,
+					      4, 2, 30, 0, 0), ==, INKY_OK);
+	munit_assert_not_null(b.sq);
+	munit_assert_int8(inky_binarize_row(dev, &b, NULL), ==,
+			  INKY_E_NULL_PTR);
+	inky_binarize_free(&b);
+	munit_assert_null(b.ring);
+	munit_assert_int8(inky_binarize_row(dev, &b, row), ==,
+			  INKY_E_NULL_PTR);
+	munit_assert_int8(inky_binarize_end(dev, &b), ==, INKY_E_NULL_PTR);
+
+	return MUNIT_OK;
+}
+
+/**
+ * @}
+ * defgroup binarize-args-test
+ */
+
+MunitTest binarize_tests[] = {
+	{
+		.name = "/binarize-test",
+		.test = binarize_test,
+		.setup = device_setup,
+		.tear_down = device_tear_down,
+		.options = MUNIT_TEST_OPTION_NONE,
+		.parameters = fb_test_params
+	},
+
+	{
+		.name = "/binarize-lighting-test",
+		.test = binarize_lighting_test,
+		.setup = device_setup,
+		.tear_down = device_tear_down,
+		.options = MUNIT_TEST_OPTION_NONE,
+		.parameters = fb_test_params
+	},
+
+	{
+		.name = "/binarize-args-test",
+		.test = binarize_args_test,
+		.setup = device_setup,
+		.tear_down = device_tear_down,
+		.options = MUNIT_TEST_OPTION_NONE,
+		.parameters = fb_test_params
+	},
+
+	{
+		.name = NULL,
+		.test = NULL,
+		.setup = NULL,
+		.tear_down = NULL,
+		.options = MUNIT_TEST_OPTION_NONE,
+		.parameters = NULL
+	}
+};
+
+/**
+ * @}
+ * defgroup pimoroni-inky-binarize-tests
+ */
@@ -0,0 +1,692 @@
+/**
+ * @file blit-test.c
+ *
+ * Unit testing for the raster-op blitter and sprites of the Pimoroni
+ * Inky driver
+ */
+
+#include "inky.h"
+
+#include <munit/munit.h>
+
+#include "test-device.h"
+
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+/**
+ * @defgroup pimoroni-inky-blit-tests Pimoroni Inky blitter testing
+ * suites
+ * @{
+ */
+
+/*
+**********************************************************************
+************************** TESTS DEFINITIONS *************************
+**********************************************************************
+*/
+
+#define BLIT_SRC_W	37
+#define BLIT_SRC_H	23
+
+/** @brief Source image in every layout inky_fb_blit() reads */
+struct blit_source {
+	inky_color colors[BLIT_SRC_W * BLIT_SRC_H];
+	uint8_t mask[BLIT_SRC_H][8];
+	uint8_t packed[BLIT_SRC_H][BLIT_SRC_W / 2 + 1];
+	uint8_t black[BLIT_SRC_H][8];
+	uint8_t color[BLIT_SRC_H][8];
+};
+
+/** @brief Raw framebuffer code of a pixel */
+static uint8_t fb_code(const inky_fb *fb, uint16_t x, uint16_t y)
+{
+	uint32_t bit = (uint32_t) x * fb->fmt.bpp;
+	uint8_t b = fb->buffer[fb->stride * y + bit / 8];
+
+	return (b >> (bit % 8)) & fb->fmt.mask;
+}
+
+/** @brief Fill every layout of src from random colors of a palette */
+static void make_source(struct blit_source *src, const inky_color *palette,
+			uint8_t n_colors, inky_pixel_format format)
+{
+	uint8_t bpp = format == INKY_PIXFMT_4BPP ? 4 :
+		format == INKY_PIXFMT_2BPP ? 2 : 1;
+
+	memset(src, 0, sizeof(*src));
+
+	for (uint16_t y = 0; y < BLIT_SRC_H; y++) {
+		for (uint16_t x = 0; x < BLIT_SRC_W; x++) {
+			inky_color c = palette[munit_rand_int_range(0,
+								    n_colors - 1)];
+			uint32_t bit = (uint32_t) x * bpp;
+
+			src->colors[y * BLIT_SRC_W + x] = c;
+
+			if (munit_rand_int_range(0, 1)) {
+				src->mask[y][x / 8] |= 1 << (x % 8);
+			}
+
+			src->packed[y][bit / 8] |=
+				inky_pixfmt_encode(bpp, c) << (bit % 8);
+
+			if (c != INKY_COLOR_BLACK) {
+				src->black[y][x / 8] |= 0x80 >> (x % 8);
+			}
+
+			if (c == INKY_COLOR_RED || c == INKY_COLOR_YELLOW) {
+				src->color[y][x / 8] |= 0x80 >> (x % 8);
+			}
+		}
+	}
+}
+
+/** @brief Framebuffer code after combining d and s with rop */
+static uint8_t apply_rop(inky_rop rop, uint8_t d, uint8_t s, uint8_t key)
+{
+	switch (rop) {
+	case INKY_ROP_OR:
+		return d | s;
+	case INKY_ROP_AND:
+		return d & s;
+	case INKY_ROP_XOR:
+		return d ^ s;
+	case INKY_ROP_TRANSPARENT:
+		return s == key ? d : s;
+	default:
+		return s;
+	}
+}
+
+/** @brief Blit src at random places with every rop and compare each
+ * pixel to a reference computed one pixel at a time */
+static void check_blits(inky_config *dev, const inky_bitmap *src,
+			const inky_color *colors, const uint8_t *mask,
+			inky_color fg, const inky_color *palette,
+			uint8_t n_colors)
+{
+	inky_fb *fb = dev->fb;
+	uint8_t bpp = fb->fmt.bpp;
+	uint8_t *before = malloc(fb->bytes);
+	inky_fb ref = *fb;
+
+	munit_assert_not_null(before);
+
+	for (int i = 0; i < 6; i++) {
+		inky_rop rop = (inky_rop) munit_rand_int_range(INKY_ROP_COPY,
+							       INKY_ROP_TRANSPARENT);
+		inky_color key = palette[munit_rand_int_range(0, n_colors - 1)];
+		inky_rect area;
+		int16_t dx = munit_rand_int_range(-BLIT_SRC_W, fb->width);
+		int16_t dy = munit_rand_int_range(-BLIT_SRC_H, fb->height);
+		uint8_t key_code = inky_pixfmt_encode(bpp, key) & fb->fmt.mask;
+
+		area.x = munit_rand_int_range(0, BLIT_SRC_W - 1);
+		area.y = munit_rand_int_range(0, BLIT_SRC_H - 1);
+		area.w = munit_rand_int_range(0, BLIT_SRC_W - area.x);
+		area.h = munit_rand_int_range(0, BLIT_SRC_H - area.y);
+
+		memcpy(before, fb->buffer, fb->bytes);
+		ref.buffer = before;
+		fb->dirty.w = 0;
+		fb->dirty.h = 0;
+
+		munit_assert_int8(inky_fb_blit(dev, src, &area, dx, dy, rop,
+					       fg, key), ==, INKY_OK);
+		check_dirty(fb, before, 0);
+
+		for (uint16_t y = 0; y < fb->height; y++) {
+			for (uint16_t x = 0; x < fb->width; x++) {
+				int32_t sx = x - dx + area.x;
+				int32_t sy = y - dy + area.y;
+				uint8_t d = fb_code(&ref, x, y);
+				uint8_t expect = d;
+
+				if (x >= dx && y >= dy &&
+				    x < dx + area.w && y < dy + area.h) {
+					inky_color c;
+					uint8_t s;
+
+					if (mask) {
+						c = (mask[sy * 8 + sx / 8] >>
+						     (sx % 8)) & 1 ? fg :
+							INKY_COLOR_WHITE;
+					} else {
+						c = colors[sy * BLIT_SRC_W + sx];
+					}
+
+					s = inky_pixfmt_encode(bpp, c) &
+						fb->fmt.mask;
+					expect = apply_rop(rop, d, s, key_code) &
+						fb->fmt.mask;
+				}
+
+				munit_assert_uint8(fb_code(fb, x, y), ==,
+						   expect);
+			}
+		}
+	}
+
+	free(before);
+}
+
+/*
+**********************************************************************
+********************** TESTS IMPLEMENTATION **************************
+**********************************************************************
+*/
+
+/**
+ * @defgroup blit-rop-test Compare blits to single pixel writes
+ * @{
+ */
+
+static void *blit_setup(const MunitParameter params[], void *user_data)
+{
+	INTF(user_data);
+
+	device_setup(params, user_data);
+
+	intf->buf = malloc(sizeof(struct blit_source));
+
+	return user_data;
+}
+
+/** @brief Run every source layout against the current framebuffer */
+static void check_layouts(inky_config *dev, struct blit_source *src,
+			  inky_color panel_color)
+{
+	inky_color palette[3] = {
+		INKY_COLOR_WHITE, INKY_COLOR_BLACK, panel_color
+	};
+	uint8_t n_colors = dev->fb->fmt.bpp == 1 ? 2 : 3;
+	inky_bitmap bm;
+
+	munit_assert_int8(inky_fb_fill(dev, INKY_COLOR_WHITE), ==, INKY_OK);
+
+	/* Packed in the framebuffer format and in another format */
+	make_source(src, palette, n_colors, dev->fb->fmt.format);
+
+	bm.type = INKY_BITMAP_PACKED;
+	bm.format = dev->fb->fmt.format;
+	bm.width = BLIT_SRC_W;
+	bm.height = BLIT_SRC_H;
+	bm.stride = sizeof(src->packed[0]);
+	bm.data = &src->packed[0][0];
+	bm.color = NULL;
+
+	check_blits(dev, &bm, src->colors, NULL, INKY_COLOR_BLACK, palette,
+		    n_colors);
+
+	bm.format = dev->fb->fmt.format == INKY_PIXFMT_4BPP ?
+		INKY_PIXFMT_2BPP : INKY_PIXFMT_4BPP;
+	make_source(src, palette, n_colors, bm.format);
+
+	check_blits(dev, &bm, src->colors, NULL, INKY_COLOR_BLACK, palette,
+		    n_colors);
+
+	/* Panel RAM planes */
+	bm.type = INKY_BITMAP_PLANAR;
+	bm.stride = sizeof(src->black[0]);
+	bm.data = &src->black[0][0];
+	bm.color = &src->color[0][0];
+
+	check_blits(dev, &bm, src->colors, NULL, INKY_COLOR_BLACK, palette,
+		    n_colors);
+
+	/* Masks in every available color */
+	bm.type = INKY_BITMAP_MASK;
+	bm.data = &src->mask[0][0];
+	bm.color = NULL;
+
+	for (uint8_t i = 0; i < n_colors; i++) {
+		check_blits(dev, &bm, NULL, &src->mask[0][0], palette[i],
+			    palette, n_colors);
+	}
+}
+
+static MunitResult blit_rop_test(const MunitParameter params[],
+				 void *user_data)
+{
+	INTF(user_data);
+	inky_config *dev = &intf->dev;
+	struct blit_source *src = (struct blit_source*) intf->buf;
+	inky_color c;
+
+	munit_assert_not_null(src);
+
+	c = color_from_char(munit_parameters_get(params, "color"));
+
+	munit_assert_int8(inky_setup(dev), ==, INKY_OK);
+
+	check_layouts(dev, src, c);
+
+#ifndef INKY_FIXED_COLOR
+	/* Again with the 4bpp format */
+	munit_assert_int8(inky_free(dev), ==, INKY_OK);
+
+	dev->fb_format = INKY_PIXFMT_4BPP;
+
+	munit_assert_int8(inky_setup(dev), ==, INKY_OK);
+
+	check_layouts(dev, src, c);
+#endif /* #ifndef INKY_FIXED_COLOR */
+
+	return MUNIT_OK;
+}
+
+/**
+ * @}
+ */
+
+/**
+ * @defgroup blit-check-test Test blit argument checks
+ * @{
+ */
+
+static MunitResult blit_check_test(const MunitParameter params[],
+				   void *user_data)
+{
+	INTF(user_data);
+	inky_config *dev = &intf->dev;
+	inky_bitmap bm;
+	inky_rect area = {0, 0, 8, 8};
+	uint8_t mask[8] = {0xff};
+	uint8_t *copy;
+
+	memset(&bm, 0, sizeof(bm));
+
+	munit_assert_int8(inky_fb_blit(dev, &bm, NULL, 0, 0, INKY_ROP_COPY,
+				       INKY_COLOR_BLACK, INKY_COLOR_WHITE),
+			  ==, INKY_E_NOT_CONFIGURED);
+
+	munit_assert_int8(inky_setup(dev), ==, INKY_OK);
+	munit_assert_int8(inky_bitmap_from_fb(dev->fb, &bm), ==, INKY_OK);
+	munit_assert_uint32(bm.stride, ==, dev->fb->stride);
+
+	bm.type = INKY_BITMAP_MASK;
+	bm.width = 8;
+	bm.height = 8;
+	bm.stride = 1;
+	bm.data = mask;
+
+	/* Area outside the source */
+	area.x = 1;
+	munit_assert_int8(inky_fb_blit(dev, &bm, &area, 0, 0, INKY_ROP_COPY,
+				       INKY_COLOR_BLACK, INKY_COLOR_WHITE),
+			  ==, INKY_E_OUT_OF_RANGE);
+
+	/* Foreground not on the panel */
+	munit_assert_int8(inky_fb_blit(dev, &bm, NULL, 0, 0, INKY_ROP_COPY,
+				       dev->color->yellow ? INKY_COLOR_RED :
+				       INKY_COLOR_YELLOW, INKY_COLOR_WHITE),
+			  ==, INKY_E_NOT_AVAILABLE);
+
+	/* Entirely off screen is not an error and writes nothing */
+	copy = malloc(dev->fb->bytes);
+	munit_assert_not_null(copy);
+	memcpy(copy, dev->fb->buffer, dev->fb->bytes);
+
+	munit_assert_int8(inky_fb_blit(dev, &bm, NULL, -8, 0, INKY_ROP_COPY,
+				       INKY_COLOR_BLACK, INKY_COLOR_WHITE),
+			  ==, INKY_OK);
+	munit_assert_int8(inky_fb_blit(dev, &bm, NULL, 0, dev->fb->height,
+				       INKY_ROP_COPY, INKY_COLOR_BLACK,
+				       INKY_COLOR_WHITE), ==, INKY_OK);
+	munit_assert_memory_equal(dev->fb->bytes, copy, dev->fb->buffer);
+
+	free(copy);
+
+	bm.data = NULL;
+	munit_assert_int8(inky_fb_blit(dev, &bm, NULL, 0, 0, INKY_ROP_COPY,
+				       INKY_COLOR_BLACK, INKY_COLOR_WHITE),
+			  ==, INKY_E_NULL_PTR);
+
+	return MUNIT_OK;
+}
+
+/**
+ * @}
+ */
+
+/**
+ * @defgroup sprite-test Compare sprites to blits
+ * @{
+ */
+
+/** @brief Draw spr and blit bm at the same random places, comparing
+ * every pixel of the two framebuffers */
+static void check_sprite(inky_config *dev, const inky_sprite *spr,
+			 const inky_bitmap *bm, inky_color fg,
+			 const inky_color *key)
+{
+	inky_fb *fb = dev->fb;
+	inky_fb ref = *fb;
+	uint8_t *before = malloc(fb->bytes);
+
+	ref.buffer = malloc(fb->bytes);
+	munit_assert_not_null(ref.buffer);
+	munit_assert_not_null(before);
+
+	for (int i = 0; i < 12; i++) {
+		int16_t x = munit_rand_int_range(-BLIT_SRC_W, fb->width);
+		int16_t y = munit_rand_int_range(-BLIT_SRC_H, fb->height);
+		inky_config ref_dev = *dev;
+
+		memcpy(ref.buffer, fb->buffer, fb->bytes);
+		memcpy(before, fb->buffer, fb->bytes);
+		ref_dev.fb = &ref;
+		fb->dirty.w = 0;
+		fb->dirty.h = 0;
+
+		munit_assert_int8(inky_fb_blit(&ref_dev, bm, NULL, x, y,
+					       key ? INKY_ROP_TRANSPARENT :
+					       INKY_ROP_COPY, fg,
+					       key ? *key : INKY_COLOR_WHITE),
+				  ==, INKY_OK);
+		munit_assert_int8(inky_fb_draw_sprite(dev, spr, x, y), ==,
+				  INKY_OK);
+
+		/* Padding included */
+		munit_assert_memory_equal(fb->bytes, fb->buffer, ref.buffer);
+		check_dirty(fb, before, 0);
+	}
+
+	free(before);
+	free(ref.buffer);
+}
+
+static MunitResult sprite_test(const MunitParameter params[],
+			       void *user_data)
+{
+	INTF(user_data);
+	inky_config *dev = &intf->dev;
+	struct blit_source *src = (struct blit_source*) intf->buf;
+	inky_color palette[3];
+	inky_color key = INKY_COLOR_WHITE;
+	uint8_t n_colors;
+	inky_sprite spr;
+	inky_bitmap bm;
+
+	munit_assert_not_null(src);
+
+	palette[0] = INKY_COLOR_WHITE;
+	palette[1] = INKY_COLOR_BLACK;
+	palette[2] = color_from_char(munit_parameters_get(params, "color"));
+
+	munit_assert_int8(inky_setup(dev), ==, INKY_OK);
+
+	n_colors = dev->fb->fmt.bpp == 1 ? 2 : 3;
+	make_source(src, palette, n_colors, dev->fb->fmt.format);
+
+	/* Start from noise so opaque and keyed pixels both show */
+	for (uint32_t i = 0; i < dev->fb->bytes; i++) {
+		dev->fb->buffer[i] = munit_rand_uint32() & 0x55;
+	}
+
+	bm.type = INKY_BITMAP_PACKED;
+	bm.format = dev->fb->fmt.format;
+	bm.width = BLIT_SRC_W;
+	bm.height = BLIT_SRC_H;
+	bm.stride = sizeof(src->packed[0]);
+	bm.data = &src->packed[0][0];
+	bm.color = NULL;
+
+	munit_assert_int8(inky_sprite_create(dev, &spr, &bm, NULL,
+					     INKY_COLOR_BLACK, NULL),
+			  ==, INKY_OK);
+	munit_assert_uint8(spr.phases, ==, 8 / dev->fb->fmt.bpp);
+
+	check_sprite(dev, &spr, &bm, INKY_COLOR_BLACK, NULL);
+
+	munit_assert_int8(inky_sprite_free(&spr), ==, INKY_OK);
+	munit_assert_null(spr.pixels);
+
+	munit_assert_int8(inky_sprite_create(dev, &spr, &bm, NULL,
+					     INKY_COLOR_BLACK, &key),
+			  ==, INKY_OK);
+
+	check_sprite(dev, &spr, &bm, INKY_COLOR_BLACK, &key);
+
+	inky_sprite_free(&spr);
+
+	/* Keyed mask glyph in the panel's last color */
+	bm.type = INKY_BITMAP_MASK;
+	bm.stride = sizeof(src->mask[0]);
+	bm.data = &src->mask[0][0];
+
+	munit_assert_int8(inky_sprite_create(dev, &spr, &bm, NULL,
+					     palette[n_colors - 1], &key),
+			  ==, INKY_OK);
+
+	check_sprite(dev, &spr, &bm, palette[n_colors - 1], &key);
+
+	inky_sprite_free(&spr);
+
+	return MUNIT_OK;
+}
+
+/**
+ * @}
+ */
+
+/**
+ * @defgroup scroll-test Compare scrolls and copies to pixel moves
+ * @{
+ */
+
+/** @brief Random rectangle inside the framebuffer */
+static inky_rect random_rect(const inky_fb *fb)
+{
+	inky_rect r;
+
+	r.x = munit_rand_int_range(0, fb->width - 1);
+	r.y = munit_rand_int_range(0, fb->height - 1);
+	/* munit_rand_int_range() cannot take an empty range */
+	r.w = 1 + munit_rand_uint32() % (fb->width - r.x);
+	r.h = 1 + munit_rand_uint32() % (fb->height - r.y);
+
+	/* Often make it full rows, the memmove fast path */
+	if (munit_rand_int_range(0, 3) == 0) {
+		r.x = 0;
+		r.w = fb->width;
+	}
+
+	return r;
+}
+
+/** @brief Assert the framebuffer matches the codes of ref shifted by
+ * dx, dy inside area, where exposed pixels are fill and pixels
+ * outside area are unchanged */
+static void check_move(const inky_fb *fb, const inky_fb *ref,
+		       const inky_rect *area, int dx, int dy, int fill)
+{
+	for (int v = 0; v < fb->height; v++) {
+		for (int u = 0; u < fb->width; u++) {
+			int su = u - dx;
+			int sv = v - dy;
+			uint8_t want;
+
+			if (u < area->x || v < area->y ||
+			    u >= area->x + area->w || v >= area->y + area->h) {
+				want = fb_code(ref, u, v);
+			} else if (fill >= 0 &&
+				   (su < area->x || sv < area->y ||
+				    su >= area->x + area->w ||
+				    sv >= area->y + area->h)) {
+				want = fill;
+			} else {
+				want = fb_code(ref, su, sv);
+			}
+
+			munit_assert_uint8(fb_code(fb, u, v), ==, want);
+		}
+	}
+}
+
+static MunitResult scroll_test(const MunitParameter params[],
+			       void *user_data)
+{
+	INTF(user_data);
+	inky_config *dev = &intf->dev;
+	inky_fb *fb;
+	inky_fb ref;
+	inky_rect area;
+	inky_rect dst;
+
+	munit_assert_int8(inky_setup(dev), ==, INKY_OK);
+
+	fb = dev->fb;
+	ref = *fb;
+	ref.buffer = malloc(fb->bytes);
+	munit_assert_not_null(ref.buffer);
+
+	munit_assert_uint16(fb->dirty.w, ==, 0);
+
+	for (int i = 0; i < 12; i++) {
+		int dx = munit_rand_int_range(-20, 20);
+		int dy = munit_rand_int_range(-20, 20);
+		inky_color fill = munit_rand_int_range(0, 1) ?
+			INKY_COLOR_BLACK : INKY_COLOR_WHITE;
+
+		for (uint32_t k = 0; k < fb->bytes; k++) {
+			fb->buffer[k] = munit_rand_uint32() & 0x55;
+		}
+
+		memcpy(ref.buffer, fb->buffer, fb->bytes);
+		fb->dirty.w = 0;
+
+		area = random_rect(fb);
+
+		/* Sometimes a pure vertical or horizontal scroll */
+		if (i % 3 == 1) {
+			dx = 0;
+		} else if (i % 3 == 2) {
+			dy = 0;
+		}
+
+		munit_assert_int8(inky_fb_scroll(dev, &area, dx, dy, fill),
+				  ==, INKY_OK);
+		check_move(fb, &ref, &area, dx, dy,
+			   inky_pixfmt_encode(fb->fmt.bpp, fill));
+
+		munit_assert_uint16(fb->dirty.x, ==, area.x);
+		munit_assert_uint16(fb->dirty.y, ==, area.y);
+		munit_assert_uint16(fb->dirty.w, ==, area.w);
+		munit_assert_uint16(fb->dirty.h, ==, area.h);
+
+		/* Copies land anywhere, clipped to the framebuffer */
+		memcpy(ref.buffer, fb->buffer, fb->bytes);
+
+		area = random_rect(fb);
+		dx = munit_rand_int_range(-area.w / 2, fb->width - area.w / 2);
+		dy = munit_rand_int_range(-area.h / 2, fb->height - area.h / 2);
+
+		munit_assert_int8(inky_fb_copy_rect(dev, &area, dx, dy), ==,
+				  INKY_OK);
+
+		dst.x = dx < 0 ? 0 : dx;
+		dst.y = dy < 0 ? 0 : dy;
+		dst.w = (dx + area.w < fb->width ? dx + area.w : fb->width) -
+			dst.x;
+		dst.h = (dy + area.h < fb->height ? dy + area.h : fb->height) -
+			dst.y;
+
+		check_move(fb, &ref, &dst, dx - area.x, dy - area.y, -1);
+	}
+
+	/* Everything scrolled away, and bad arguments */
+	area.x = 0;
+	area.y = 0;
+	area.w = fb->width;
+	area.h = fb->height;
+
+	munit_assert_int8(inky_fb_scroll(dev, &area, 0, -fb->height,
+					 INKY_COLOR_WHITE), ==, INKY_OK);
+
+	for (uint16_t v = 0; v < fb->height; v++) {
+		for (uint16_t u = 0; u < fb->width; u++) {
+			munit_assert_uint8(fb_code(fb, u, v), ==, 0);
+		}
+	}
+
+	munit_assert_int8(inky_update_dirty(dev), ==, INKY_OK);
+	munit_assert_uint16(fb->dirty.w, ==, 0);
+
+	area.h = fb->height + 1;
+	munit_assert_int8(inky_fb_scroll(dev, &area, 0, 1, INKY_COLOR_WHITE),
+			  ==, INKY_E_OUT_OF_RANGE);
+	munit_assert_int8(inky_fb_copy_rect(dev, &area, 0, 1), ==,
+			  INKY_E_OUT_OF_RANGE);
+	munit_assert_int8(inky_fb_scroll(dev, NULL, 0, 1, INKY_COLOR_WHITE),
+			  ==, INKY_E_NULL_PTR);
+
+	if (fb->fmt.bpp == 1) {
+		area.h = fb->height;
+		munit_assert_int8(inky_fb_scroll(dev, &area, 0, 1,
+						 INKY_COLOR_RED),
+				  ==, INKY_E_NOT_AVAILABLE);
+	}
+
+	free(ref.buffer);
+
+	return MUNIT_OK;
+}
+
+/**
+ * @}
+ */
+
+MunitTest blit_tests[] = {
+	{
+		.name = "/blit-rop-test",
+		.test = blit_rop_test,
+		.setup = blit_setup,
+		.tear_down = device_tear_down,
+		.options = MUNIT_TEST_OPTION_NONE,
+		.parameters = fb_test_params
+	},
+
+	{
+		.name = "/blit-check-test",
+		.test = blit_check_test,
+		.setup = blit_setup,
+		.tear_down = device_tear_down,
+		.options = MUNIT_TEST_OPTION_NONE,
+		.parameters = fb_test_params
+	},
+
+	{
+		.name = "/scroll-test",
+		.test = scroll_test,
+		.setup = blit_setup,
+		.tear_down = device_tear_down,
+		.options = MUNIT_TEST_OPTION_NONE,
+		.parameters = fb_test_params
+	},
+
+	{
+		.name = "/sprite-test",
+		.test = sprite_test,
+		.setup = blit_setup,
+		.tear_down = device_tear_down,
+		.options = MUNIT_TEST_OPTION_NONE,
+		.parameters = fb_test_params
+	},
+
+	{
+		.name = NULL,
+		.test = NULL,
+		.setup = NULL,
+		.tear_down = NULL,
+		.options = MUNIT_TEST_OPTION_NONE,
+		.parameters = NULL
+	}
+};
+
+/**
+ * @}
+ * defgroup pimoroni-inky-blit-tests
+ */
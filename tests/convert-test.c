@@ -0,0 +1,309 @@
+/**
+ * @file convert-test.c
+ *
+ * Unit testing for the bulk pixel format converters of the Pimoroni
+ * Inky driver
+ */
+
+#include "inky.h"
+
+#include <munit/munit.h>
+
+#include "test-device.h"
+
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+/**
+ * @defgroup pimoroni-inky-convert-tests Pimoroni Inky conversion testing
+ * suites
+ * @{
+ */
+
+/*
+**********************************************************************
+************************** TESTS DEFINITIONS *************************
+**********************************************************************
+*/
+
+#define SRC_W	29
+#define SRC_H	9
+
+/** @brief Bytes per source row, with some padding after the pixels */
+#define SRC_STRIDE	(SRC_W * 4 + 12)
+
+/** @brief Widen a 5 or 6 bit channel to 8 bits */
+static uint8_t widen(uint8_t v, int bits)
+{
+	return (v << (8 - bits)) | (v >> (2 * bits - 8));
+}
+
+/** @brief Color pixel u of row v of src should convert to */
+static inky_color expect_color(inky_config *dev, inky_convert_format format,
+			       const uint8_t *src, int u, int v)
+{
+	const uint8_t *row = &src[SRC_STRIDE * v];
+	uint8_t r, g, b;
+	uint16_t px;
+
+	switch (format) {
+	case INKY_CONVERT_GRAY8:
+		return inky_image_nearest(dev, row[u], row[u], row[u]);
+
+	case INKY_CONVERT_RGB565:
+		memcpy(&px, &row[2 * u], 2);
+		break;
+
+	case INKY_CONVERT_ARGB8888: {
+		uint32_t argb;
+		uint8_t a;
+
+		memcpy(&argb, &row[4 * u], 4);
+		a = argb >> 24;
+		r = ((argb >> 16 & 0xff) * a + 255 * (255 - a) + 127) / 255;
+		g = ((argb >> 8 & 0xff) * a + 255 * (255 - a) + 127) / 255;
+		b = ((argb & 0xff) * a + 255 * (255 - a) + 127) / 255;
+		px = (r >> 3) << 11 | (g >> 2) << 5 | b >> 3;
+		break;
+	}
+
+	default:
+		r = row[3 * u];
+		g = row[3 * u + 1];
+		b = row[3 * u + 2];
+		px = (r >> 3) << 11 | (g >> 2) << 5 | b >> 3;
+		break;
+	}
+
+	return inky_image_nearest(dev, widen(px >> 11, 5),
+				  widen(px >> 5 & 0x3f, 6),
+				  widen(px & 0x1f, 5));
+}
+
+/**
+ * @defgroup convert-test Every format against the nearest color
+ * @{
+ */
+
+static MunitResult convert_test(const MunitParameter params[],
+				void *user_data)
+{
+	INTF(user_data);
+	inky_config *dev = &intf->dev;
+	static uint32_t src_words[SRC_H * SRC_STRIDE / 4];
+	uint8_t *src = (uint8_t *) src_words;
+	inky_config ref_dev;
+	inky_convert cv;
+	inky_fb ref;
+	inky_fb *fb;
+
+	munit_assert_int8(inky_setup(dev), ==, INKY_OK);
+	munit_assert_int8(inky_convert_init(dev, &cv), ==, INKY_OK);
+
+	fb = dev->fb;
+	ref = *fb;
+	ref.buffer = malloc(fb->bytes);
+	munit_assert_not_null(ref.buffer);
+	ref_dev = *dev;
+	ref_dev.fb = &ref;
+
+	for (int i = 0; i < 48; i++) {
+		inky_convert_format format = (inky_convert_format) (i % 4);
+		int16_t x = munit_rand_int_range(-SRC_W, fb->width);
+		int16_t y = munit_rand_int_range(-SRC_H, fb->height);
+		uint32_t x0 = UINT32_MAX, y0 = UINT32_MAX, x1 = 0, y1 = 0;
+
+		for (uint32_t k = 0; k < sizeof(src_words); k++) {
+			src[k] = munit_rand_uint32() & 0xff;
+		}
+
+		/* Some opaque and clear ARGB pixels */
+		for (int k = 0; i % 8 == 2 && k < SRC_H * SRC_W / 4; k++) {
+			uint32_t at = munit_rand_uint32() % SRC_H * SRC_STRIDE +
+				munit_rand_uint32() % SRC_W * 4;
+
+			src[at + 3] = k % 2 ? 0xff : 0;
+		}
+
+		if (i % 3 == 0) {
+			x = munit_rand_uint32() % (fb->width - SRC_W);
+		}
+
+		for (uint32_t k = 0; k < fb->bytes; k++) {
+			fb->buffer[k] = munit_rand_uint32() & 0x55;
+		}
+
+		memcpy(ref.buffer, fb->buffer, fb->bytes);
+		fb->dirty.w = 0;
+		fb->dirty.h = 0;
+
+		for (int v = 0; v < SRC_H; v++) {
+			for (int u = 0; u < SRC_W; u++) {
+				inky_color c;
+
+				if (x + u < 0 || y + v < 0 ||
+				    x + u >= fb->width ||
+				    y + v >= fb->height) {
+					continue;
+				}
+
+				c = expect_color(dev, format, src, u, v);
+				inky_fb_set_pixel(&ref_dev, x + u, y + v, c);
+			}
+		}
+
+		/* Bounds of the pixels whose code changes */
+		for (uint32_t v = 0; v < fb->height; v++) {
+			for (uint32_t u = 0; u < fb->width; u++) {
+				uint32_t bit = u * fb->fmt.bpp;
+				uint32_t k = fb->stride * v + bit / 8;
+				uint8_t m = fb->fmt.mask << (bit % 8);
+
+				if (!((fb->buffer[k] ^ ref.buffer[k]) & m)) {
+					continue;
+				}
+
+				x0 = u < x0 ? u : x0;
+				y0 = v < y0 ? v : y0;
+				x1 = u + 1 > x1 ? u + 1 : x1;
+				y1 = v + 1 > y1 ? v + 1 : y1;
+			}
+		}
+
+		munit_assert_int8(inky_convert_rect(dev, &cv, format, src,
+						    SRC_STRIDE, SRC_W, SRC_H,
+						    x, y), ==, INKY_OK);
+		munit_assert_memory_equal(fb->bytes, fb->buffer, ref.buffer);
+
+		/* Exactly the changed pixels are dirty */
+		if (x0 == UINT32_MAX) {
+			munit_assert_uint16(fb->dirty.w, ==, 0);
+		} else {
+			munit_assert_uint16(fb->dirty.x, ==, x0);
+			munit_assert_uint16(fb->dirty.y, ==, y0);
+			munit_assert_uint32(fb->dirty.x + fb->dirty.w, ==, x1);
+			munit_assert_uint32(fb->dirty.y + fb->dirty.h, ==, y1);
+		}
+	}
+
+	inky_convert_free(&cv);
+	munit_assert_null(cv.lut);
+	free(ref.buffer);
+
+	return MUNIT_OK;
+}
+
+/**
+ * @}
+ * defgroup convert-test
+ */
+
+/**
+ * @defgroup convert-colors-test Panel colors and bad arguments
+ * @{
+ */
+
+static MunitResult convert_colors_test(const MunitParameter params[],
+				       void *user_data)
+{
+	INTF(user_data);
+	inky_config *dev = &intf->dev;
+	/* White, black, red and yellow in each format */
+	static const uint8_t rgb[4][3] = {
+		{ 0xff, 0xff, 0xff }, { 0, 0, 0 }, { 0xff, 0, 0 },
+		{ 0xff, 0xff, 0 }
+	};
+	static const uint16_t rgb565[4] = { 0xffff, 0, 0xf800, 0xffe0 };
+	static const uint32_t argb[4] = {
+		0xffffffff, 0xff000000, 0xffff0000, 0xffffff00
+	};
+	inky_convert cv;
+
+	munit_assert_int8(inky_setup(dev), ==, INKY_OK);
+	munit_assert_int8(inky_convert_init(dev, &cv), ==, INKY_OK);
+
+	for (int c = INKY_COLOR_WHITE; c <= INKY_COLOR_YELLOW; c++) {
+		inky_color expect = inky_color_available(dev, c) ?
+			(inky_color) c : inky_image_nearest(dev, rgb[c][0],
+							    rgb[c][1],
+							    rgb[c][2]);
+		inky_color out;
+
+		munit_assert_int8(inky_convert_rect(dev, &cv,
+						    INKY_CONVERT_RGB888,
+						    rgb[c], 3, 1, 1, 0, 0), ==,
+				  INKY_OK);
+		inky_fb_get_pixel(dev, 0, 0, &out);
+		munit_assert_int(out, ==, expect);
+
+		munit_assert_int8(inky_convert_rect(dev, &cv,
+						    INKY_CONVERT_RGB565,
+						    &rgb565[c], 2, 1, 1, 1, 0), ==,
+				  INKY_OK);
+		inky_fb_get_pixel(dev, 1, 0, &out);
+		munit_assert_int(out, ==, expect);
+
+		munit_assert_int8(inky_convert_rect(dev, &cv,
+						    INKY_CONVERT_ARGB8888,
+						    &argb[c], 4, 1, 1, 2, 0), ==,
+				  INKY_OK);
+		inky_fb_get_pixel(dev, 2, 0, &out);
+		munit_assert_int(out, ==, expect);
+	}
+
+	munit_assert_int8(inky_convert_rect(dev, &cv, INKY_CONVERT_GRAY8 + 1,
+					    argb, 4, 1, 1, 0, 0), ==,
+			  INKY_E_OUT_OF_RANGE);
+	munit_assert_int8(inky_convert_rect(dev, &cv, INKY_CONVERT_GRAY8,
+					    NULL, 1, 1, 1, 0, 0), ==,
+			  INKY_E_NULL_PTR);
+
+	inky_convert_free(&cv);
+
+	munit_assert_int8(inky_convert_rect(dev, &cv, INKY_CONVERT_GRAY8,
+					    argb, 1, 1, 1, 0, 0), ==,
+			  INKY_E_NULL_PTR);
+	munit_assert_int8(inky_convert_init(dev, NULL), ==, INKY_E_NULL_PTR);
+
+	return MUNIT_OK;
+}
+
+/**
+ * @}
+ * defgroup convert-colors-test
+ */
+
+MunitTest convert_tests[] = {
+	{
+		.name = "/convert-test",
+		.test = convert_test,
+		.setup = device_setup,
+		.tear_down = device_tear_down,
+		.options = MUNIT_TEST_OPTION_NONE,
+		.parameters = fb_test_params
+	},
+
+	{
+		.name = "/convert-colors-test",
+		.test = convert_colors_test,
+		.setup = device_setup,
+		.tear_down = device_tear_down,
+		.options = MUNIT_TEST_OPTION_NONE,
+		.parameters = fb_test_params
+	},
+
+	{
+		.name = NULL,
+		.test = NULL,
+		.setup = NULL,
+		.tear_down = NULL,
+		.options = MUNIT_TEST_OPTION_NONE,
+		.parameters = NULL
+	}
+};
+
+/**
+ * @}
+ * defgroup pimoroni-inky-convert-tests
+ */
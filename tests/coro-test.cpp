@@ -0,0 +1,372 @@
+/**
+ * @file coro-test.cpp
+ *
+ * Unit testing for the C++20 coroutine interface of the Pimoroni Inky
+ * driver
+ */
+
+#include "inky.h"
+#include "inky-coro.hpp"
+
+#include <munit/munit.h>
+
+#include <cstdint>
+#include <deque>
+#include <vector>
+
+/**
+ * @defgroup pimoroni-inky-coro-tests Pimoroni Inky coroutine testing
+ * suites
+ * @{
+ */
+
+/*
+**********************************************************************
+************************** TESTS DEFINITIONS *************************
+**********************************************************************
+*/
+
+struct test_panel {
+	inky_color_config color;
+	inky_config dev;
+	uint32_t n_delays;
+	uint32_t n_polls;
+	uint32_t n_bytes_out;
+};
+
+/** @brief Single threaded executor resuming handles in FIFO order */
+struct test_executor {
+	std::deque<std::coroutine_handle<>> ready;
+	uint32_t n_delays = 0;
+	uint32_t n_busy = 0;
+	bool time_out = false;
+
+	void schedule_after(std::uint32_t us, std::coroutine_handle<> h)
+	{
+		n_delays++;
+		ready.push_back(h);
+	}
+
+	void schedule_on_busy(inky_config *cfg, std::uint32_t timeout_us,
+			      std::coroutine_handle<> h,
+			      inky_error_state *result)
+	{
+		n_busy++;
+
+		if (time_out) {
+			*result = INKY_E_TIMEOUT;
+		}
+
+		ready.push_back(h);
+	}
+
+	void run()
+	{
+		while (!ready.empty()) {
+			std::coroutine_handle<> h = ready.front();
+
+			ready.pop_front();
+			h.resume();
+		}
+	}
+};
+
+static_assert(inky::executor<test_executor>);
+
+/*
+**********************************************************************
+********************** TESTS IMPLEMENTATION **************************
+**********************************************************************
+*/
+
+static inky_error_state coro_gpio_initialize(void *intf_ptr)
+{
+	return INKY_OK;
+}
+
+static inky_error_state coro_gpio_setup_pin(inky_pin gpin,
+					    inky_gpio_direction gdir,
+					    inky_pin_state gstate,
+					    inky_gpio_pull_up_down gcfg,
+					    void *intf_ptr)
+{
+	return INKY_OK;
+}
+
+static inky_error_state coro_gpio_output_state(inky_pin gpin,
+					       inky_pin_state gstate,
+					       void *intf_ptr)
+{
+	return INKY_OK;
+}
+
+static inky_error_state coro_gpio_input_state(inky_pin gpin,
+					      inky_pin_state *out,
+					      void *intf_ptr)
+{
+	return INKY_OK;
+}
+
+static inky_error_state coro_gpio_poll_pin(inky_pin gpin, UINT64_t timeout,
+					   void *intf_ptr)
+{
+	static_cast<test_panel*>(intf_ptr)->n_polls++;
+
+	return INKY_OK;
+}
+
+static inky_error_state coro_spi_setup(void *intf_ptr)
+{
+	return INKY_OK;
+}
+
+static inky_error_state coro_delay(uint32_t delay_us, void *intf_ptr)
+{
+	static_cast<test_panel*>(intf_ptr)->n_delays++;
+
+	return INKY_OK;
+}
+
+static inky_error_state coro_spi_write(const uint8_t *buf, uint32_t len,
+				       void *intf_ptr)
+{
+	static_cast<test_panel*>(intf_ptr)->n_bytes_out += len;
+
+	return INKY_OK;
+}
+
+static inky_error_state coro_spi_write16(const uint16_t *buf, uint32_t len,
+					 void *intf_ptr)
+{
+	static_cast<test_panel*>(intf_ptr)->n_bytes_out += len * 2;
+
+	return INKY_OK;
+}
+
+static void initialize_test_panel(test_panel *p, inky_product product)
+{
+	inky_config *dev = &p->dev;
+
+	*p = test_panel{};
+
+	p->color.white = 1;
+	p->color.black = 1;
+	p->color.red = 1;
+
+	dev->pdt = product;
+	dev->color = &p->color;
+	dev->intf_ptr = p;
+
+	dev->gpio_init_cb = coro_gpio_initialize;
+	dev->gpio_setup_pin_cb = coro_gpio_setup_pin;
+	dev->gpio_output_cb = coro_gpio_output_state;
+	dev->gpio_input_cb = coro_gpio_input_state;
+	dev->gpio_poll_cb = coro_gpio_poll_pin;
+	dev->spi_setup_cb = coro_spi_setup;
+	dev->spi_write_cb = coro_spi_write;
+	dev->spi_write16_cb = coro_spi_write16;
+	dev->delay_us_cb = coro_delay;
+
+	munit_assert_int8(inky_setup(dev), ==, INKY_OK);
+
+	/* Only count what the coroutines do */
+	p->n_delays = 0;
+	p->n_polls = 0;
+	p->n_bytes_out = 0;
+}
+
+/**
+ * @defgroup coro-update-test Test awaitable update
+ * @{
+ */
+
+static inky::task update_then_clear(inky::display<test_executor> &d,
+				    inky_error_state *clear_ret)
+{
+	inky_error_state ret;
+
+	ret = co_await d.update();
+
+	if (ret != INKY_OK) {
+		co_return ret;
+	}
+
+	*clear_ret = co_await d.clear();
+
+	co_return ret;
+}
+
+static MunitResult coro_update_test(const MunitParameter params[],
+				    void *user_data)
+{
+	test_panel p;
+	test_executor ex;
+	inky_error_state clear_ret = INKY_E_FAILURE;
+
+	initialize_test_panel(&p, INKY_WHAT);
+
+	inky::display<test_executor> d(p.dev, ex);
+	inky::task t = update_then_clear(d, &clear_ret);
+
+	t.start();
+	munit_assert_false(t.done());
+
+	ex.run();
+
+	munit_assert_true(t.done());
+	munit_assert_int8(t.result(), ==, INKY_OK);
+	munit_assert_int8(clear_ret, ==, INKY_OK);
+
+	/* Each update: two reset delays plus the refresh delay, and
+	 * BUSY waits after soft reset and refresh */
+	munit_assert_uint32(ex.n_delays, ==, 6);
+	munit_assert_uint32(ex.n_busy, ==, 4);
+
+	/* The blocking callbacks must never be used */
+	munit_assert_uint32(p.n_delays, ==, 0);
+	munit_assert_uint32(p.n_polls, ==, 0);
+	munit_assert_uint32(p.n_bytes_out, >, 0);
+
+	inky_free(&p.dev);
+
+	return MUNIT_OK;
+}
+
+/**
+ * @}
+ */
+
+/**
+ * @defgroup coro-interleave-test Test many displays on one thread
+ * @{
+ */
+
+static MunitResult coro_interleave_test(const MunitParameter params[],
+					void *user_data)
+{
+	const int n_panels = 8;
+	std::vector<test_panel> panels(n_panels);
+	std::vector<inky::display<test_executor>> displays;
+	std::vector<inky::task> tasks;
+	test_executor ex;
+
+	for (test_panel &p : panels) {
+		initialize_test_panel(&p, INKY_PHAT);
+		displays.emplace_back(p.dev, ex);
+	}
+
+	for (inky::display<test_executor> &d : displays) {
+		tasks.push_back(d.update());
+		tasks.back().start();
+	}
+
+	/* Every panel is suspended in its first reset delay */
+	munit_assert_size(ex.ready.size(), ==, n_panels);
+
+	ex.run();
+
+	for (const inky::task &t : tasks) {
+		munit_assert_true(t.done());
+		munit_assert_int8(t.result(), ==, INKY_OK);
+	}
+
+	for (test_panel &p : panels) {
+		munit_assert_uint32(p.n_bytes_out, ==, panels[0].n_bytes_out);
+		inky_free(&p.dev);
+	}
+
+	return MUNIT_OK;
+}
+
+/**
+ * @}
+ */
+
+/**
+ * @defgroup coro-timeout-test Test BUSY timeout propagation
+ * @{
+ */
+
+static MunitResult coro_timeout_test(const MunitParameter params[],
+				     void *user_data)
+{
+	test_panel p;
+	test_executor ex;
+
+	initialize_test_panel(&p, INKY_WHAT);
+
+	inky::display<test_executor> d(p.dev, ex);
+	inky::task t = d.reset();
+
+	ex.time_out = true;
+
+	t.start();
+	ex.run();
+
+	munit_assert_true(t.done());
+	munit_assert_int8(t.result(), ==, INKY_E_TIMEOUT);
+
+	inky_free(&p.dev);
+
+	return MUNIT_OK;
+}
+
+/**
+ * @}
+ */
+
+static MunitTest coro_tests[] = {
+	{
+		.name = (char*) "/coro-update-test",
+		.test = coro_update_test,
+		.setup = NULL,
+		.tear_down = NULL,
+		.options = MUNIT_TEST_OPTION_NONE,
+		.parameters = NULL
+	},
+
+	{
+		.name = (char*) "/coro-interleave-test",
+		.test = coro_interleave_test,
+		.setup = NULL,
+		.tear_down = NULL,
+		.options = MUNIT_TEST_OPTION_NONE,
+		.parameters = NULL
+	},
+
+	{
+		.name = (char*) "/coro-timeout-test",
+		.test = coro_timeout_test,
+		.setup = NULL,
+		.tear_down = NULL,
+		.options = MUNIT_TEST_OPTION_NONE,
+		.parameters = NULL
+	},
+
+	{
+		.name = NULL,
+		.test = NULL,
+		.setup = NULL,
+		.tear_down = NULL,
+		.options = MUNIT_TEST_OPTION_NONE,
+		.parameters = NULL
+	}
+};
+
+static const MunitSuite coro_suite = {
+	(char*) "/inky-coro-test-suite",
+	coro_tests,
+	NULL,
+	1,
+	MUNIT_SUITE_OPTION_NONE
+};
+
+int main(int argc, char *const argv[])
+{
+	return munit_suite_main(&coro_suite, NULL, argc, argv);
+}
+
+/**
+ * @}
+ * defgroup pimoroni-inky-coro-tests
+ */
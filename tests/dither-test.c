@@ -0,0 +1,712 @@
+/**
+ * @file dither-test.c
+ *
+ * Unit testing for the dithering of the Pimoroni Inky driver
+ */
+
+#include "inky.h"
+
+#include <munit/munit.h>
+
+#include "test-device.h"
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+/**
+ * @defgroup pimoroni-inky-dither-tests Pimoroni Inky dithering testing
+ * suites
+ * @{
+ */
+
+/*
+**********************************************************************
+************************** TESTS DEFINITIONS *************************
+**********************************************************************
+*/
+
+#define SRC_W	37
+#define SRC_H	11
+
+/** @brief Red, green and blue of each inky_color */
+static const uint8_t test_rgb[4][3] = {
+	{ 0xff, 0xff, 0xff },
+	{ 0x00, 0x00, 0x00 },
+	{ 0xff, 0x00, 0x00 },
+	{ 0xff, 0xff, 0x00 },
+};
+
+static uint8_t clamp8(int32_t v)
+{
+	return v < 0 ? 0 : v > 255 ? 255 : v;
+}
+
+/** @brief Rank of x, y in the 8x8 Bayer matrix, from the bits of
+ * x ^ y and y interleaved, lowest first */
+static uint8_t bayer_rank(uint32_t x, uint32_t y)
+{
+	uint32_t a = x ^ y;
+	uint8_t r = 0;
+
+	for (int b = 2; b >= 0; b--) {
+		r = (r << 2) | (((a >> (2 - b)) & 1) << 1) |
+			((y >> (2 - b)) & 1);
+	}
+
+	return r;
+}
+
+/** @brief a / 16 rounded to the nearest, halves up */
+static int32_t round16(int32_t a)
+{
+	return (int32_t) ((a + 8 + 16 * 65536) / 16) - 65536;
+}
+
+static uint32_t dist(inky_color c, const uint8_t *p)
+{
+	int32_t dr = p[0] - test_rgb[c][0];
+	int32_t dg = p[1] - test_rgb[c][1];
+	int32_t db = p[2] - test_rgb[c][2];
+
+	return 3 * dr * dr + 4 * dg * dg + 2 * db * db;
+}
+
+/** @brief Color of the panel pixel x, y of ref holds, or -1 when its
+ * code is none of the panel's */
+static int ref_color(inky_config *ref, int32_t x, int32_t y)
+{
+	inky_fb *fb = ref->fb;
+	uint32_t bit = (uint32_t) x * fb->fmt.bpp;
+	uint8_t code = (fb->buffer[fb->stride * y + bit / 8] >> (bit % 8)) &
+		fb->fmt.mask;
+
+	for (int c = INKY_COLOR_WHITE; c <= INKY_COLOR_YELLOW; c++) {
+		if (inky_color_available(ref, c) &&
+		    (inky_pixfmt_encode(fb->fmt.bpp, c) & fb->fmt.mask) ==
+		    code) {
+			return c;
+		}
+	}
+
+	return -1;
+}
+
+/** @brief Dither src pixel by pixel into ref with the whole error of
+ * the picture held at once */
+static void ref_dither(inky_config *dev, inky_config *ref,
+		       inky_dither_mode mode, uint8_t hysteresis,
+		       const uint8_t *src, int32_t x, int32_t y)
+{
+	static int32_t err[SRC_H + 2][SRC_W][3];
+
+	memset(err, 0, sizeof(err));
+
+	for (int32_t v = 0; v < SRC_H; v++) {
+		for (int32_t u = 0; u < SRC_W; u++) {
+			const uint8_t *s = &src[(v * SRC_W + u) * 3];
+			int32_t fx = x + u;
+			int32_t fy = y + v;
+			int32_t t = 0;
+			uint8_t p[3];
+			inky_color c;
+
+			if (mode == INKY_DITHER_BAYER) {
+				t = bayer_rank(fx & 7, fy & 7) * 4 + 2 - 128;
+			}
+
+			for (int ch = 0; ch < 3; ch++) {
+				p[ch] = clamp8(s[ch] + t +
+					       round16(err[v][u][ch]));
+			}
+
+			int visible = fx >= 0 && fy >= 0 &&
+				fx < ref->fb->width && fy < ref->fb->height;
+			int prev = visible && hysteresis ?
+				ref_color(ref, fx, fy) : -1;
+
+			c = inky_image_nearest(dev, p[0], p[1], p[2]);
+
+			if (prev >= 0 && dist(prev, p) <= dist(c, p) +
+			    hysteresis * 18 * 255) {
+				c = prev;
+			}
+
+			for (int ch = 0; ch < 3; ch++) {
+				int32_t e = p[ch] - test_rgb[c][ch];
+				/* Neighbours right, then below left to
+				 * right, then two along and two below */
+				static const int8_t fs[6] = { 7, 3, 5, 1, 0, 0 };
+				static const int8_t at[6] = { 2, 2, 2, 2, 2, 2 };
+				const int8_t *w = mode == INKY_DITHER_ATKINSON ?
+					at : fs;
+				const int8_t du[6] = { 1, -1, 0, 1, 2, 0 };
+				const int8_t dv[6] = { 0, 1, 1, 1, 0, 2 };
+
+				if (mode < INKY_DITHER_FLOYD_STEINBERG) {
+					break;
+				}
+
+				for (int k = 0; k < 6; k++) {
+					int32_t nu = u + du[k];
+
+					if (nu >= 0 && nu < SRC_W) {
+						err[v + dv[k]][nu][ch] +=
+							w[k] * e;
+					}
+				}
+			}
+
+			if (visible) {
+				inky_fb_set_pixel(ref, fx, fy, c);
+			}
+		}
+	}
+}
+
+/**
+ * @defgroup modes-test Each mode against a reference
+ * @{
+ */
+
+static MunitResult modes_test(const MunitParameter params[],
+			      void *user_data)
+{
+	INTF(user_data);
+	inky_config *dev = &intf->dev;
+	static uint8_t src[SRC_H * SRC_W * 3];
+	inky_config ref_dev;
+	uint8_t *before;
+	inky_fb ref;
+	inky_fb *fb;
+
+	munit_assert_int8(inky_setup(dev), ==, INKY_OK);
+
+	fb = dev->fb;
+	ref = *fb;
+	ref.buffer = malloc(fb->bytes);
+	before = malloc(fb->bytes);
+	munit_assert_not_null(ref.buffer);
+	munit_assert_not_null(before);
+	ref_dev = *dev;
+	ref_dev.fb = &ref;
+
+	for (int i = 0; i < 60; i++) {
+		inky_dither_mode mode = (inky_dither_mode) (i % 5);
+		uint8_t hysteresis = (i / 5) % 2 ?
+			munit_rand_uint32() % 64 + 1 : 0;
+		int16_t x = munit_rand_int_range(-SRC_W, fb->width);
+		int16_t y = munit_rand_int_range(-SRC_H, fb->height);
+		inky_dither d;
+
+		/* Smooth gradients with some noise, or random pixels */
+		for (int v = 0; v < SRC_H; v++) {
+			for (int u = 0; u < SRC_W; u++) {
+				uint8_t *p = &src[(v * SRC_W + u) * 3];
+
+				for (int ch = 0; ch < 3; ch++) {
+					p[ch] = i % 3 ? clamp8(u * 7 + v * 9 *
+							       ch - 10 +
+							       munit_rand_uint32() %
+							       20) :
+						munit_rand_uint32() & 0xff;
+				}
+			}
+		}
+
+		/* Keep some rows whole in the framebuffer */
+		if (i % 4 == 0) {
+			x = munit_rand_uint32() % (fb->width - SRC_W);
+		}
+
+		for (uint32_t k = 0; k < fb->bytes; k++) {
+			fb->buffer[k] = munit_rand_uint32() & 0x55;
+		}
+
+		memcpy(ref.buffer, fb->buffer, fb->bytes);
+		memcpy(before, fb->buffer, fb->bytes);
+		fb->dirty.w = 0;
+		fb->dirty.h = 0;
+
+		if (mode != INKY_DITHER_BLUE_NOISE) {
+			ref_dither(dev, &ref_dev, mode, hysteresis, src, x, y);
+		}
+
+		munit_assert_int8(inky_dither_init(dev, &d, mode, SRC_W), ==,
+				  INKY_OK);
+		d.hysteresis = hysteresis;
+
+		for (int v = 0; v < SRC_H; v++) {
+			munit_assert_int8(inky_dither_row(dev, &d,
+							  &src[v * SRC_W * 3],
+							  x, y + v), ==,
+					  INKY_OK);
+		}
+
+		inky_dither_free(&d);
+		munit_assert_null(d.err);
+
+		if (mode != INKY_DITHER_BLUE_NOISE) {
+			munit_assert_memory_equal(fb->bytes, fb->buffer,
+						  ref.buffer);
+		}
+
+		check_dirty(fb, before, 1);
+	}
+
+	free(ref.buffer);
+	free(before);
+
+	return MUNIT_OK;
+}
+
+/**
+ * @}
+ * defgroup modes-test
+ */
+
+/**
+ * @defgroup levels-test Shades of gray come out as the right share of
+ * black
+ * @{
+ */
+
+/** @brief Black pixels in w by h pixels at x, y */
+static uint32_t count_black(inky_config *dev, uint16_t x, uint16_t y,
+			    uint16_t w, uint16_t h)
+{
+	uint32_t n = 0;
+
+	for (uint16_t v = y; v < y + h; v++) {
+		for (uint16_t u = x; u < x + w; u++) {
+			inky_color c;
+
+			munit_assert_int8(inky_fb_get_pixel(dev, u, v, &c), ==,
+					  INKY_OK);
+			munit_assert_int(c, !=, INKY_COLOR_RED);
+			munit_assert_int(c, !=, INKY_COLOR_YELLOW);
+			n += c == INKY_COLOR_BLACK;
+		}
+	}
+
+	return n;
+}
+
+static MunitResult levels_test(const MunitParameter params[],
+			       void *user_data)
+{
+	INTF(user_data);
+	inky_config *dev = &intf->dev;
+	/* Black pixels of the last, darker shade with Atkinson */
+	uint32_t atkinson = UINT32_MAX;
+	uint8_t *row;
+	inky_fb *fb;
+
+	munit_assert_int8(inky_setup(dev), ==, INKY_OK);
+
+	fb = dev->fb;
+	row = malloc(fb->width * 3);
+	munit_assert_not_null(row);
+
+	for (int level = 0; level <= 256; level += 32) {
+		uint8_t g = level > 255 ? 255 : level;
+
+		memset(row, g, fb->width * 3);
+
+		for (inky_dither_mode mode = INKY_DITHER_THRESHOLD;
+		     mode <= INKY_DITHER_ATKINSON; mode++) {
+			/* Whole tiles of the ordered masks */
+			uint16_t w = 96;
+			uint16_t h = 96;
+			uint32_t black;
+			uint32_t expect;
+			inky_dither d;
+
+			munit_assert_int8(inky_dither_init(dev, &d, mode,
+							   fb->width), ==,
+					  INKY_OK);
+
+			for (int16_t y = 0; y < h; y++) {
+				munit_assert_int8(inky_dither_row(dev, &d, row,
+								  0, y), ==,
+						  INKY_OK);
+			}
+
+			inky_dither_free(&d);
+
+			black = count_black(dev, 0, 0, w, h);
+			expect = (uint32_t) (255 - g) * w * h / 255;
+
+			switch (mode) {
+			case INKY_DITHER_THRESHOLD:
+				munit_assert_uint32(black, ==,
+						    g < 128 ? w * h : 0);
+				break;
+
+			case INKY_DITHER_BLUE_NOISE:
+				/* Black where the threshold is at most
+				 * 255 - g, in each 16x16 tile */
+				munit_assert_uint32(black, ==,
+						    (256 - (uint32_t) g) *
+						    w * h / 256);
+				break;
+
+			case INKY_DITHER_BAYER:
+				munit_assert_uint32(black, ==,
+						    g > 253 ? 0 :
+						    (uint32_t) ((253 - g) / 4
+								+ 1) *
+						    w * h / 64);
+				break;
+
+			case INKY_DITHER_FLOYD_STEINBERG:
+				munit_assert_uint32(black, <=,
+						    expect + w * h / 100);
+				munit_assert_uint32(black + w * h / 100, >=,
+						    expect);
+				break;
+
+			case INKY_DITHER_ATKINSON:
+				/* The dropped quarter of the error pushes
+				 * shades towards the ends, keeping their
+				 * order */
+				munit_assert_uint32(black, <=, atkinson);
+				atkinson = black;
+
+				if (g >= 96 && g <= 160) {
+					munit_assert_uint32(black, <=,
+							    expect +
+							    w * h / 16);
+					munit_assert_uint32(black +
+							    w * h / 16, >=,
+							    expect);
+				}
+				break;
+			}
+		}
+	}
+
+	free(row);
+
+	return MUNIT_OK;
+}
+
+/**
+ * @}
+ * defgroup levels-test
+ */
+
+/**
+ * @defgroup stable-test Redraws with hysteresis flip few pixels
+ * @{
+ */
+
+#define PIC_W	120
+#define PIC_H	60
+
+/** @brief Dither a PIC_W by PIC_H picture to the top left of the
+ * framebuffer */
+static void dither_picture(inky_config *dev, const uint8_t *pic,
+			   inky_dither_mode mode, uint8_t hysteresis)
+{
+	inky_dither d;
+
+	munit_assert_int8(inky_dither_init(dev, &d, mode, PIC_W), ==,
+			  INKY_OK);
+	d.hysteresis = hysteresis;
+
+	for (int v = 0; v < PIC_H; v++) {
+		munit_assert_int8(inky_dither_row(dev, &d,
+						  &pic[v * PIC_W * 3], 0, v),
+				  ==, INKY_OK);
+	}
+
+	inky_dither_free(&d);
+}
+
+/** @brief Pixels of the framebuffer that differ from before outside
+ * the w by h area at x, y */
+static uint32_t count_flips(inky_config *dev, const uint8_t *before,
+			    uint16_t x, uint16_t y, uint16_t w, uint16_t h)
+{
+	inky_fb *fb = dev->fb;
+	uint32_t n = 0;
+
+	for (uint32_t v = 0; v < fb->height; v++) {
+		for (uint32_t u = 0; u < fb->width; u++) {
+			uint32_t bit = u * fb->fmt.bpp;
+			uint32_t i = fb->stride * v + bit / 8;
+			uint8_t m = fb->fmt.mask << (bit % 8);
+
+			if (u >= x && u < x + w && v >= y && v < y + h) {
+				continue;
+			}
+
+			n += (fb->buffer[i] & m) != (before[i] & m);
+		}
+	}
+
+	return n;
+}
+
+static MunitResult stable_test(const MunitParameter params[],
+			       void *user_data)
+{
+	INTF(user_data);
+	inky_config *dev = &intf->dev;
+	static uint8_t pic[PIC_H * PIC_W * 3];
+	uint8_t *before;
+	uint8_t *last;
+	inky_fb *fb;
+
+	munit_assert_int8(inky_setup(dev), ==, INKY_OK);
+
+	fb = dev->fb;
+	before = malloc(fb->bytes);
+	last = malloc(fb->bytes);
+	munit_assert_not_null(before);
+	munit_assert_not_null(last);
+
+	for (inky_dither_mode mode = INKY_DITHER_THRESHOLD;
+	     mode <= INKY_DITHER_ATKINSON; mode++) {
+		uint32_t plain, stable;
+
+		/* Soft gradients in every channel */
+		for (int v = 0; v < PIC_H; v++) {
+			for (int u = 0; u < PIC_W; u++) {
+				uint8_t *p = &pic[(v * PIC_W + u) * 3];
+
+				p[0] = 40 + u + v;
+				p[1] = 30 + u + v / 2;
+				p[2] = 60 + u / 2 + v;
+			}
+		}
+
+		munit_assert_int8(inky_fb_fill(dev, INKY_COLOR_WHITE), ==,
+				  INKY_OK);
+		dither_picture(dev, pic, mode, 0);
+
+		/* The same picture again changes nothing */
+		memcpy(last, fb->buffer, fb->bytes);
+		fb->dirty.w = 0;
+		fb->dirty.h = 0;
+		dither_picture(dev, pic, mode, INKY_DITHER_STABLE);
+		munit_assert_memory_equal(fb->bytes, fb->buffer, last);
+		munit_assert_uint16(fb->dirty.w, ==, 0);
+
+		/* A small change, like a gauge needle moving */
+		for (int v = 26; v < 34; v++) {
+			memset(&pic[(v * PIC_W + 56) * 3], 0, 8 * 3);
+		}
+
+		dither_picture(dev, pic, mode, 0);
+		plain = count_flips(dev, last, 56, 26, 8, 8);
+
+		memcpy(fb->buffer, last, fb->bytes);
+		fb->dirty.w = 0;
+		fb->dirty.h = 0;
+		memcpy(before, fb->buffer, fb->bytes);
+		dither_picture(dev, pic, mode, INKY_DITHER_STABLE);
+		stable = count_flips(dev, last, 56, 26, 8, 8);
+		check_dirty(fb, before, 1);
+
+		/* Ordered modes never depend on other pixels. Error
+		 * diffusion spreads the change to the rest of the picture
+		 * unless the old pixels are kept */
+		if (mode < INKY_DITHER_FLOYD_STEINBERG) {
+			munit_assert_uint32(plain, ==, 0);
+			munit_assert_uint32(stable, ==, 0);
+		} else {
+			munit_assert_uint32(stable * 20, <=, plain);
+		}
+	}
+
+	/* Kept pixels pass their error on, so shades drawn over an
+	 * unrelated frame still come out right */
+	for (int g = 64; g < 256; g += 64) {
+		uint32_t expect = (255 - g) * PIC_W * PIC_H / 255;
+		uint32_t black = 0;
+
+		memset(pic, g, sizeof(pic));
+
+		for (uint32_t k = 0; k < fb->bytes; k++) {
+			fb->buffer[k] = munit_rand_uint32() & 0x55;
+		}
+
+		dither_picture(dev, pic, INKY_DITHER_FLOYD_STEINBERG,
+			       INKY_DITHER_STABLE);
+
+		for (uint16_t v = 0; v < PIC_H; v++) {
+			for (uint16_t u = 0; u < PIC_W; u++) {
+				inky_color c;
+
+				inky_fb_get_pixel(dev, u, v, &c);
+				black += c == INKY_COLOR_BLACK;
+			}
+		}
+
+		munit_assert_uint32(black, <=, expect + PIC_W * PIC_H / 100);
+		munit_assert_uint32(black + PIC_W * PIC_H / 100, >=, expect);
+	}
+
+	free(before);
+	free(last);
+
+	return MUNIT_OK;
+}
+
+/**
+ * @}
+ * defgroup stable-test
+ */
+
+/**
+ * @defgroup dither-image-test Dither a decoded image
+ * @{
+ */
+
+static MunitResult dither_image_test(const MunitParameter params[],
+				     void *user_data)
+{
+	INTF(user_data);
+	inky_config *dev = &intf->dev;
+	static uint8_t src[SRC_H * SRC_W * 3];
+	static uint8_t pnm[sizeof(src) + 32];
+	inky_fb ref;
+	inky_fb *fb;
+	uint32_t size;
+	inky_dither d;
+	inky_image img;
+
+	munit_assert_int8(inky_setup(dev), ==, INKY_OK);
+
+	fb = dev->fb;
+	ref = *fb;
+	ref.buffer = malloc(fb->bytes);
+	munit_assert_not_null(ref.buffer);
+
+	for (uint32_t k = 0; k < sizeof(src); k++) {
+		src[k] = munit_rand_uint32() & 0xff;
+	}
+
+	size = sprintf((char *) pnm, "P6\n%d %d\n255\n", SRC_W, SRC_H);
+	memcpy(&pnm[size], src, sizeof(src));
+	size += sizeof(src);
+
+	for (inky_dither_mode mode = INKY_DITHER_THRESHOLD;
+	     mode <= INKY_DITHER_ATKINSON; mode++) {
+		int16_t x = munit_rand_int_range(-SRC_W, fb->width);
+		int16_t y = munit_rand_int_range(-SRC_H, fb->height);
+
+		for (uint32_t k = 0; k < fb->bytes; k++) {
+			fb->buffer[k] = munit_rand_uint32() & 0x55;
+		}
+
+		/* Row by row gives the same picture */
+		munit_assert_int8(inky_dither_init(dev, &d, mode, SRC_W), ==,
+				  INKY_OK);
+
+		for (int v = 0; v < SRC_H; v++) {
+			munit_assert_int8(inky_dither_row(dev, &d,
+							  &src[v * SRC_W * 3],
+							  x, y + v), ==,
+					  INKY_OK);
+		}
+
+		inky_dither_free(&d);
+		memcpy(ref.buffer, fb->buffer, fb->bytes);
+
+		munit_assert_int8(inky_image_open_memory(&img, pnm, size), ==,
+				  INKY_OK);
+		/* Hysteresis keeps the same picture as it is */
+		munit_assert_int8(inky_dither_image(dev, &img, x, y, mode,
+						    mode % 2 ?
+						    INKY_DITHER_STABLE : 0), ==,
+				  INKY_OK);
+		munit_assert_memory_equal(fb->bytes, fb->buffer, ref.buffer);
+	}
+
+	/* Bad arguments */
+	munit_assert_int8(inky_dither_init(dev, &d, INKY_DITHER_ATKINSON + 1,
+					   SRC_W), ==, INKY_E_OUT_OF_RANGE);
+	munit_assert_int8(inky_dither_init(dev, &d, INKY_DITHER_BAYER, 0), ==,
+			  INKY_E_OUT_OF_RANGE);
+	munit_assert_int8(inky_dither_init(dev, NULL, INKY_DITHER_BAYER,
+					   SRC_W), ==, INKY_E_NULL_PTR);
+	munit_assert_int8(inky_dither_init(dev, &d, INKY_DITHER_BAYER,
+					   SRC_W), ==, INKY_OK);
+	munit_assert_int8(inky_dither_row(dev, &d, NULL, 0, 0), ==,
+			  INKY_E_NULL_PTR);
+	munit_assert_int8(inky_dither_image(dev, NULL, 0, 0,
+					    INKY_DITHER_BAYER, 0), ==,
+			  INKY_E_NULL_PTR);
+
+	/* A truncated image draws its whole rows, then fails */
+	munit_assert_int8(inky_image_open_memory(&img, pnm, size - 5), ==,
+			  INKY_OK);
+	munit_assert_int8(inky_dither_image(dev, &img, 0, 0,
+					    INKY_DITHER_FLOYD_STEINBERG, 0), ==,
+			  INKY_E_BAD_DATA);
+
+	free(ref.buffer);
+
+	return MUNIT_OK;
+}
+
+/**
+ * @}
+ * defgroup dither-image-test
+ */
+
+MunitTest dither_tests[] = {
+	{
+		.name = "/modes-test",
+		.test = modes_test,
+		.setup = device_setup,
+		.tear_down = device_tear_down,
+		.options = MUNIT_TEST_OPTION_NONE,
+		.parameters = fb_test_params
+	},
+
+	{
+		.name = "/levels-test",
+		.test = levels_test,
+		.setup = device_setup,
+		.tear_down = device_tear_down,
+		.options = MUNIT_TEST_OPTION_NONE,
+		.parameters = fb_test_params
+	},
+
+	{
+		.name = "/stable-test",
+		.test = stable_test,
+		.setup = device_setup,
+		.tear_down = device_tear_down,
+		.options = MUNIT_TEST_OPTION_NONE,
+		.parameters = fb_test_params
+	},
+
+	{
+		.name = "/dither-image-test",
+		.test = dither_image_test,
+		.setup = device_setup,
+		.tear_down = device_tear_down,
+		.options = MUNIT_TEST_OPTION_NONE,
+		.parameters = fb_test_params
+	},
+
+	{
+		.name = NULL,
+		.test = NULL,
+		.setup = NULL,
+		.tear_down = NULL,
+		.options = MUNIT_TEST_OPTION_NONE,
+		.parameters = NULL
+	}
+};
+
+/**
+ * @}
+ * defgroup pimoroni-inky-dither-tests
+ */
@@ -0,0 +1,566 @@
+/**
+ * @file draw-test.c
+ *
+ * Unit testing for the drawing primitives of the Pimoroni Inky driver
+ */
+
+#include "inky.h"
+
+#include <munit/munit.h>
+
+#include "test-device.h"
+
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+/**
+ * @defgroup pimoroni-inky-draw-tests Pimoroni Inky drawing testing suites
+ * @{
+ */
+
+/*
+**********************************************************************
+************************** TESTS DEFINITIONS *************************
+**********************************************************************
+*/
+
+/**
+ * @defgroup clip-test Push and pop clip rectangles
+ * @{
+ */
+
+static MunitResult clip_test(const MunitParameter params[],
+			     void *user_data)
+{
+	INTF(user_data);
+	inky_config *dev = &intf->dev;
+	inky_draw draw;
+	inky_rect a = { 10, 20, 30, 40 };
+	inky_rect b = { 0, 50, 25, 100 };
+	inky_rect far = { 60, 0, 5, 5 };
+	inky_rect big = { 0, 0, 0xffff, 0xffff };
+
+	munit_assert_int8(inky_draw_init(dev, &draw), ==,
+			  INKY_E_NOT_CONFIGURED);
+
+	munit_assert_int8(inky_setup(dev), ==, INKY_OK);
+	munit_assert_int8(inky_draw_init(dev, &draw), ==, INKY_OK);
+
+	munit_assert_uint8(draw.depth, ==, 1);
+	munit_assert_uint16(draw.clip[0].w, ==, dev->fb->width);
+	munit_assert_uint16(draw.clip[0].h, ==, dev->fb->height);
+
+	/* Only the bottom is left */
+	munit_assert_int8(inky_draw_pop_clip(&draw), ==,
+			  INKY_E_OUT_OF_RANGE);
+
+	munit_assert_int8(inky_draw_push_clip(&draw, &a), ==, INKY_OK);
+	munit_assert_int8(inky_draw_push_clip(&draw, &b), ==, INKY_OK);
+
+	munit_assert_uint16(draw.clip[2].x, ==, 10);
+	munit_assert_uint16(draw.clip[2].y, ==, 50);
+	munit_assert_uint16(draw.clip[2].w, ==, 15);
+	munit_assert_uint16(draw.clip[2].h, ==, 10);
+
+	/* Disjoint rectangles leave nothing */
+	munit_assert_int8(inky_draw_push_clip(&draw, &far), ==, INKY_OK);
+	munit_assert_uint16(draw.clip[3].w, ==, 0);
+	munit_assert_uint16(draw.clip[3].h, ==, 0);
+
+	munit_assert_int8(inky_draw_pop_clip(&draw), ==, INKY_OK);
+	munit_assert_int8(inky_draw_pop_clip(&draw), ==, INKY_OK);
+	munit_assert_uint8(draw.depth, ==, 2);
+
+	/* Larger than the framebuffer, without overflowing */
+	munit_assert_int8(inky_draw_pop_clip(&draw), ==, INKY_OK);
+	munit_assert_int8(inky_draw_push_clip(&draw, &big), ==, INKY_OK);
+	munit_assert_uint16(draw.clip[1].w, ==, dev->fb->width);
+	munit_assert_uint16(draw.clip[1].h, ==, dev->fb->height);
+
+	while (draw.depth < INKY_DRAW_MAX_CLIP) {
+		munit_assert_int8(inky_draw_push_clip(&draw, &a), ==,
+				  INKY_OK);
+	}
+
+	munit_assert_int8(inky_draw_push_clip(&draw, &a), ==,
+			  INKY_E_OUT_OF_RANGE);
+
+	munit_assert_int8(inky_draw_push_clip(NULL, &a), ==,
+			  INKY_E_NULL_PTR);
+	munit_assert_int8(inky_draw_push_clip(&draw, NULL), ==,
+			  INKY_E_NULL_PTR);
+
+	return MUNIT_OK;
+}
+
+/**
+ * @}
+ */
+
+/**
+ * @defgroup primitives-test Compare primitives to per-pixel references
+ * @{
+ */
+
+/** @brief Framebuffer copy the references draw into */
+struct ref_fb {
+	inky_config dev;
+	inky_fb fb;
+	const inky_rect *clip;
+};
+
+static void ref_plot(struct ref_fb *ref, int32_t x, int32_t y,
+		     inky_color c)
+{
+	const inky_rect *clip = ref->clip;
+
+	if (x < clip->x || y < clip->y || x >= clip->x + clip->w ||
+	    y >= clip->y + clip->h || x >= ref->fb.width ||
+	    y >= ref->fb.height) {
+		return;
+	}
+
+	munit_assert_int8(inky_fb_set_pixel(&ref->dev, x, y, c), ==,
+			  INKY_OK);
+}
+
+static void ref_line(struct ref_fb *ref, int32_t x0, int32_t y0,
+		     int32_t x1, int32_t y1, inky_color c)
+{
+	int32_t dx = abs(x1 - x0);
+	int32_t dy = -abs(y1 - y0);
+	int32_t sx = x0 < x1 ? 1 : -1;
+	int32_t sy = y0 < y1 ? 1 : -1;
+	int32_t err = dx + dy;
+
+	for (;;) {
+		int32_t e2 = 2 * err;
+
+		ref_plot(ref, x0, y0, c);
+
+		if (x0 == x1 && y0 == y1) {
+			return;
+		}
+
+		if (e2 >= dy) {
+			err += dy;
+			x0 += sx;
+		}
+
+		if (e2 <= dx) {
+			err += dx;
+			y0 += sy;
+		}
+	}
+}
+
+/** @brief Box of w by h at x, y with elliptical corners of radii rx,
+ * ry: inside when the offset from the nearest corner center is inside
+ * an ellipse of radii rx + 1/2, ry + 1/2 */
+struct shape {
+	int32_t x, y, w, h, rx, ry;
+};
+
+static int shape_inside(const struct shape *s, int32_t px, int32_t py)
+{
+	int64_t dx = 0;
+	int64_t dy = 0;
+	uint64_t a = (uint64_t) (2 * s->rx + 1) * (2 * s->rx + 1);
+	uint64_t b = (uint64_t) (2 * s->ry + 1) * (2 * s->ry + 1);
+
+	if (px < s->x || py < s->y || px >= s->x + s->w ||
+	    py >= s->y + s->h) {
+		return 0;
+	}
+
+	if (px < s->x + s->rx) {
+		dx = s->x + s->rx - px;
+	} else if (px > s->x + s->w - 1 - s->rx) {
+		dx = px - (s->x + s->w - 1 - s->rx);
+	}
+
+	if (py < s->y + s->ry) {
+		dy = s->y + s->ry - py;
+	} else if (py > s->y + s->h - 1 - s->ry) {
+		dy = py - (s->y + s->h - 1 - s->ry);
+	}
+
+	return 4 * dx * dx * b + 4 * dy * dy * a <= a * b;
+}
+
+static void ref_shape(struct ref_fb *ref, const struct shape *s,
+		      int fill, inky_color c)
+{
+	for (int32_t py = s->y; py < s->y + s->h; py++) {
+		for (int32_t px = s->x; px < s->x + s->w; px++) {
+			if (!shape_inside(s, px, py)) {
+				continue;
+			}
+
+			if (fill || !shape_inside(s, px - 1, py) ||
+			    !shape_inside(s, px + 1, py) ||
+			    !shape_inside(s, px, py - 1) ||
+			    !shape_inside(s, px, py + 1)) {
+				ref_plot(ref, px, py, c);
+			}
+		}
+	}
+}
+
+/** @brief Even-odd fill sampling pixel centers, counting the edges
+ * crossed left of each */
+static void ref_polygon(struct ref_fb *ref, const inky_point *pts,
+			uint16_t n, inky_color c)
+{
+	for (int32_t py = 0; py < ref->fb.height; py++) {
+		for (int32_t px = 0; px < ref->fb.width; px++) {
+			int inside = 0;
+
+			for (uint16_t i = 0; i < n && n >= 3; i++) {
+				const inky_point *p = &pts[i];
+				const inky_point *q = &pts[(i + 1) % n];
+				int64_t num, den;
+
+				if ((py < p->y) == (py < q->y)) {
+					continue;
+				}
+
+				/* Crossing at x = p.x + num / den */
+				num = (int64_t) (2 * py + 1 - 2 * p->y) *
+					(q->x - p->x);
+				den = 2 * (int64_t) (q->y - p->y);
+
+				if (den < 0) {
+					num = -num;
+					den = -den;
+				}
+
+				if (2 * p->x * den + 2 * num <=
+				    (2 * (int64_t) px + 1) * den) {
+					inside ^= 1;
+				}
+			}
+
+			if (inside) {
+				ref_plot(ref, px, py, c);
+			}
+		}
+	}
+}
+
+static int32_t rand_coord(uint16_t size)
+{
+	return munit_rand_int_range(-size / 4, size + size / 4);
+}
+
+static MunitResult primitives_test(const MunitParameter params[],
+				   void *user_data)
+{
+	INTF(user_data);
+	inky_config *dev = &intf->dev;
+	inky_color panel = color_from_char(munit_parameters_get(params,
+								 "color"));
+	struct ref_fb ref;
+	uint8_t *before;
+	inky_draw draw;
+	inky_fb *fb;
+
+	munit_assert_int8(inky_setup(dev), ==, INKY_OK);
+	munit_assert_int8(inky_draw_init(dev, &draw), ==, INKY_OK);
+
+	fb = dev->fb;
+	ref.dev = *dev;
+	ref.fb = *fb;
+	ref.fb.buffer = malloc(fb->bytes);
+	ref.dev.fb = &ref.fb;
+	before = malloc(fb->bytes);
+	munit_assert_not_null(ref.fb.buffer);
+	munit_assert_not_null(before);
+
+	for (uint32_t i = 0; i < fb->bytes; i++) {
+		fb->buffer[i] = munit_rand_uint32() & 0x55;
+	}
+
+	for (int i = 0; i < 160; i++) {
+		inky_color c = (i % 3 == 0) ? INKY_COLOR_WHITE :
+			(i % 3 == 1 || fb->fmt.bpp == 1) ?
+			INKY_COLOR_BLACK : panel;
+		int32_t x0 = rand_coord(fb->width);
+		int32_t y0 = rand_coord(fb->height);
+		int32_t x1 = rand_coord(fb->width);
+		int32_t y1 = rand_coord(fb->height);
+		uint16_t w = munit_rand_uint32() % (fb->width / 2);
+		uint16_t h = munit_rand_uint32() % (fb->height / 2);
+		uint16_t r = munit_rand_uint32() % 40;
+		inky_point pts[12];
+		uint16_t n = 3 + munit_rand_uint32() % 10;
+		struct shape s;
+		inky_rect clip;
+
+		/* A random clip every other primitive */
+		while (draw.depth > 1) {
+			inky_draw_pop_clip(&draw);
+		}
+
+		if (i % 2) {
+			clip.x = munit_rand_uint32() % fb->width;
+			clip.y = munit_rand_uint32() % fb->height;
+			clip.w = munit_rand_uint32() % fb->width;
+			clip.h = munit_rand_uint32() % fb->height;
+
+			munit_assert_int8(inky_draw_push_clip(&draw, &clip),
+					  ==, INKY_OK);
+		}
+
+		ref.clip = &draw.clip[draw.depth - 1];
+
+		memcpy(before, fb->buffer, fb->bytes);
+		memcpy(ref.fb.buffer, fb->buffer, fb->bytes);
+		fb->dirty.w = 0;
+		fb->dirty.h = 0;
+
+		for (uint16_t k = 0; k < n; k++) {
+			pts[k].x = munit_rand_uint32() % fb->width;
+			pts[k].y = munit_rand_uint32() % fb->height;
+		}
+
+		switch ((i / 2) % 8) {
+		case 0:
+			/* Mostly shallow or steep, sometimes straight */
+			if (i % 5 == 0) {
+				y1 = y0;
+			} else if (i % 5 == 1) {
+				x1 = x0;
+			}
+
+			ref_line(&ref, x0, y0, x1, y1, c);
+			munit_assert_int8(inky_draw_line(dev, &draw, x0, y0,
+							 x1, y1, c),
+					  ==, INKY_OK);
+			break;
+
+		case 1:
+			s = (struct shape) { x0, y0, w, h, 0, 0 };
+			ref_shape(&ref, &s, 0, c);
+			munit_assert_int8(inky_draw_rect(dev, &draw, x0, y0,
+							 w, h, c),
+					  ==, INKY_OK);
+			break;
+
+		case 2:
+			s = (struct shape) { x0, y0, w, h, 0, 0 };
+			ref_shape(&ref, &s, 1, c);
+			munit_assert_int8(inky_draw_fill_rect(dev, &draw, x0,
+							      y0, w, h, c),
+					  ==, INKY_OK);
+			break;
+
+		case 3:
+		case 4:
+			s = (struct shape) { x0, y0, w, h, r, r };
+
+			/* The limit on the radius */
+			if (w && h && r > ((w < h ? w : h) - 1) / 2) {
+				s.rx = s.ry = ((w < h ? w : h) - 1) / 2;
+			}
+
+			ref_shape(&ref, &s, i % 4 == 0, c);
+
+			if (i % 4 == 0) {
+				munit_assert_int8(inky_draw_fill_round_rect(dev,
+									    &draw,
+									    x0,
+									    y0,
+									    w, h,
+									    r, c),
+						  ==, INKY_OK);
+			} else {
+				munit_assert_int8(inky_draw_round_rect(dev,
+								       &draw,
+								       x0, y0,
+								       w, h, r,
+								       c),
+						  ==, INKY_OK);
+			}
+			break;
+
+		case 5:
+		case 6:
+			w /= 2;
+			h = i % 4 == 0 ? w : h / 2;
+
+			s = (struct shape) { x0 - w, y0 - h, 2 * w + 1,
+				2 * h + 1, w, h };
+			ref_shape(&ref, &s, i % 4 != 0, c);
+
+			if (i % 4 == 0) {
+				munit_assert_int8(inky_draw_circle(dev, &draw,
+								   x0, y0, w,
+								   c),
+						  ==, INKY_OK);
+			} else {
+				munit_assert_int8(inky_draw_fill_ellipse(dev,
+									 &draw,
+									 x0,
+									 y0,
+									 w, h,
+									 c),
+						  ==, INKY_OK);
+			}
+			break;
+
+		case 7:
+			ref_polygon(&ref, pts, n, c);
+			munit_assert_int8(inky_draw_fill_polygon(dev, &draw,
+								 pts, n, c),
+					  ==, INKY_OK);
+			break;
+		}
+
+		munit_assert_memory_equal(fb->bytes, fb->buffer,
+					  ref.fb.buffer);
+
+		check_dirty(fb, before, 0);
+	}
+
+	free(before);
+	free(ref.fb.buffer);
+
+	return MUNIT_OK;
+}
+
+/**
+ * @}
+ */
+
+/**
+ * @defgroup polygon-test Exact polygon edges and argument checks
+ * @{
+ */
+
+static MunitResult polygon_test(const MunitParameter params[],
+				void *user_data)
+{
+	INTF(user_data);
+	inky_config *dev = &intf->dev;
+	inky_point square[] = { { 2, 3 }, { 12, 3 }, { 12, 13 }, { 2, 13 } };
+	inky_point diamond[] = { { 20, 10 }, { 30, 20 }, { 20, 30 },
+		{ 10, 20 } };
+	inky_point many[INKY_DRAW_MAX_POINTS + 1];
+	inky_color c;
+	inky_draw draw;
+	inky_fb *fb;
+
+	munit_assert_int8(inky_setup(dev), ==, INKY_OK);
+	munit_assert_int8(inky_draw_init(dev, &draw), ==, INKY_OK);
+
+	fb = dev->fb;
+	fb->dirty.w = 0;
+	fb->dirty.h = 0;
+
+	/* Points are pixel corners */
+	munit_assert_int8(inky_draw_fill_polygon(dev, &draw, square, 4,
+						 INKY_COLOR_BLACK),
+			  ==, INKY_OK);
+
+	for (uint16_t y = 0; y < 16; y++) {
+		for (uint16_t x = 0; x < 16; x++) {
+			munit_assert_int8(inky_fb_get_pixel(dev, x, y, &c), ==,
+					  INKY_OK);
+			munit_assert_int(c, ==,
+					 x >= 2 && x < 12 && y >= 3 &&
+					 y < 13 ? INKY_COLOR_BLACK :
+					 INKY_COLOR_WHITE);
+		}
+	}
+
+	munit_assert_uint16(fb->dirty.x, ==, 2);
+	munit_assert_uint16(fb->dirty.y, ==, 3);
+	munit_assert_uint16(fb->dirty.w, ==, 10);
+	munit_assert_uint16(fb->dirty.h, ==, 10);
+
+	/* The outline of the diamond meets at its corners */
+	munit_assert_int8(inky_draw_polygon(dev, &draw, diamond, 4,
+					    INKY_COLOR_BLACK),
+			  ==, INKY_OK);
+
+	for (uint16_t i = 0; i < 4; i++) {
+		inky_fb_get_pixel(dev, diamond[i].x, diamond[i].y, &c);
+		munit_assert_int(c, ==, INKY_COLOR_BLACK);
+	}
+
+	inky_fb_get_pixel(dev, 20, 20, &c);
+	munit_assert_int(c, ==, INKY_COLOR_WHITE);
+
+	/* Fewer than three points fill nothing */
+	memset(many, 0, sizeof(many));
+	munit_assert_int8(inky_draw_fill_polygon(dev, &draw, many, 2,
+						 INKY_COLOR_BLACK),
+			  ==, INKY_OK);
+	munit_assert_int8(inky_draw_fill_polygon(dev, &draw, many,
+						 INKY_DRAW_MAX_POINTS + 1,
+						 INKY_COLOR_BLACK),
+			  ==, INKY_E_OUT_OF_RANGE);
+	munit_assert_int8(inky_draw_fill_polygon(dev, &draw, NULL, 3,
+						 INKY_COLOR_BLACK),
+			  ==, INKY_E_NULL_PTR);
+	munit_assert_int8(inky_draw_line(dev, NULL, 0, 0, 1, 1,
+					 INKY_COLOR_BLACK),
+			  ==, INKY_E_NULL_PTR);
+
+	if (fb->fmt.bpp == 1) {
+		munit_assert_int8(inky_draw_fill_circle(dev, &draw, 5, 5, 3,
+							INKY_COLOR_RED),
+				  ==, INKY_E_NOT_AVAILABLE);
+	}
+
+	return MUNIT_OK;
+}
+
+/**
+ * @}
+ */
+
+MunitTest draw_tests[] = {
+	{
+		.name = "/clip-test",
+		.test = clip_test,
+		.setup = device_setup,
+		.tear_down = device_tear_down,
+		.options = MUNIT_TEST_OPTION_NONE,
+		.parameters = fb_test_params
+	},
+
+	{
+		.name = "/primitives-test",
+		.test = primitives_test,
+		.setup = device_setup,
+		.tear_down = device_tear_down,
+		.options = MUNIT_TEST_OPTION_NONE,
+		.parameters = fb_test_params
+	},
+
+	{
+		.name = "/polygon-test",
+		.test = polygon_test,
+		.setup = device_setup,
+		.tear_down = device_tear_down,
+		.options = MUNIT_TEST_OPTION_NONE,
+		.parameters = fb_test_params
+	},
+
+	{
+		.name = NULL,
+		.test = NULL,
+		.setup = NULL,
+		.tear_down = NULL,
+		.options = MUNIT_TEST_OPTION_NONE,
+		.parameters = NULL
+	}
+};
+
+/**
+ * @}
+ * defgroup pimoroni-inky-draw-tests
+ */
@@ -8,6 +8,8 @@
 
 #include <munit/munit.h>
 
+#include "test-device.h"
+
 #include <stdint.h>
 #include <string.h>
 
@@ -23,34 +25,20 @@
 **********************************************************************
 */
 
-#define INTF(ptr)				\
-	struct test_intf *intf = (struct test_intf*) ptr;
-
-struct test_intf {
-	uint8_t *last_bytes_out;
-	uint32_t n_bytes_out;
-	uint8_t *last_bytes_in;
-	uint32_t n_bytes_in;
-	inky_color_config color;
-	inky_config dev;
-	void *usrptr;
-	uint8_t *buf;
-};
-
-static char* inky_color_params[] = {
+char* inky_color_params[] = {
 	"black",
 	"red",
 	"yellow",
 	NULL
 };
 
-static char* inky_pdt_params[] = {
+char* inky_pdt_params[] = {
 	"what",
 	"phat",
 	NULL
 };
 
-static MunitParameterEnum fb_test_params[] = {
+MunitParameterEnum fb_test_params[] = {
 	{
 		.name = "color",
 		.values = inky_color_params
@@ -67,19 +55,6 @@ static MunitParameterEnum fb_test_params[] = {
 	}
 };
 
-inky_color color_from_char(const char* color);
-
-inky_product pdt_from_char(const char* pdt);
-
-void deinitialize_test_device(struct test_intf *intf);
-
-void initialize_test_device(struct test_intf *intf, inky_color color_type,
-			    inky_product product);
-
-void destroy_random_image(uint8_t *img_buf);
-
-uint32_t create_random_image(struct test_intf * intf);
-
 /*
 **********************************************************************
 ********************** TESTS IMPLEMENTATION **************************
@@ -220,6 +195,8 @@ void initialize_test_device(struct test_intf *intf, inky_color color_type,
 	dev->fb = NULL;
 	dev->active_fb = NULL;
 	dev->exclude_flags = 0;
+	dev->fb_format = INKY_PIXFMT_AUTO;
+	dev->panel = NULL;
 	dev->usrptr1 = NULL;
 	dev->usrptr2 = NULL;
 	intf->usrptr = NULL;
@@ -235,7 +212,8 @@ void deinitialize_test_device(struct test_intf *intf)
 uint32_t create_random_image(struct test_intf * intf)
 {
 	uint8_t cdepth;
-	uint64_t len_pixels;
+	uint8_t bpp;
+	uint32_t stride;
 	uint32_t len_bytes;
 
 	inky_config *dev = &intf->dev;
@@ -246,10 +224,11 @@ uint32_t create_random_image(struct test_intf * intf)
 	munit_assert_ptr_not_null(dev->fb);
 
 	cdepth = dev->color->red || dev->color->yellow ? 2 : 1;
+	bpp = dev->fb->fmt.bpp;
 
-	/* Allocate fake image buffer */
-	len_pixels = dev->fb->width * dev->fb->height;
-	len_bytes = len_pixels * 2 / 8;
+	/* Allocate fake image buffer with the fb row layout */
+	stride = dev->fb->stride;
+	len_bytes = stride * dev->fb->height;
 	intf->buf = malloc(len_bytes);
 
 	if (!intf->buf) {
@@ -259,12 +238,17 @@ uint32_t create_random_image(struct test_intf * intf)
 	for (uint32_t i = 0; i < len_bytes; i++) {
 		intf->buf[i] = 0;
 
-		for (uint8_t j = 0; j < 8; j = j + 2) {
+		for (uint8_t j = 0; j < 8; j = j + bpp) {
 			uint8_t pixel;
 
+			/* Row padding stays white */
+			if (((i % stride) * 8 + j) / bpp >= dev->fb->width) {
+				break;
+			}
+
 			/* Generate random color */
 			pixel = (uint8_t) munit_rand_int_range(0, cdepth);
-			pixel = (pixel & 0x03) << j;
+			pixel = (pixel & dev->fb->fmt.mask) << j;
 
 			/* Assign bits to image */
 			intf->buf[i] = intf->buf[i] | pixel;
@@ -321,6 +305,73 @@ inky_product pdt_from_char(const char* pdt)
 	return INKY_CUSTOM;
 }
 
+void *device_setup(const MunitParameter params[], void *user_data)
+{
+	INTF(user_data);
+	inky_color c;
+	inky_product p;
+
+	c = color_from_char(munit_parameters_get(params, "color"));
+	p = pdt_from_char(munit_parameters_get(params, "product"));
+
+	initialize_test_device(intf, c, p);
+
+	return user_data;
+}
+
+void device_tear_down(void *fixture)
+{
+	INTF(fixture);
+
+	free(intf->buf);
+
+	inky_free(&intf->dev);
+
+	deinitialize_test_device(intf);
+}
+
+void check_dirty(const inky_fb *fb, const uint8_t *before, uint8_t exact)
+{
+	uint32_t x0 = UINT32_MAX, y0 = UINT32_MAX, x1 = 0, y1 = 0;
+
+	for (uint32_t y = 0; y < fb->height; y++) {
+		for (uint32_t x = 0; x < fb->width; x++) {
+			uint32_t bit = x * fb->fmt.bpp;
+			uint32_t i = fb->stride * y + bit / 8;
+			uint8_t m = fb->fmt.mask << (bit % 8);
+
+			if ((fb->buffer[i] & m) == (before[i] & m)) {
+				continue;
+			}
+
+			x0 = x < x0 ? x : x0;
+			y0 = y < y0 ? y : y0;
+			x1 = x + 1 > x1 ? x + 1 : x1;
+			y1 = y + 1 > y1 ? y + 1 : y1;
+		}
+	}
+
+	if (x0 == UINT32_MAX) {
+		if (exact) {
+			munit_assert_uint16(fb->dirty.w, ==, 0);
+		}
+
+		return;
+	}
+
+	if (exact) {
+		munit_assert_uint16(fb->dirty.x, ==, x0);
+		munit_assert_uint16(fb->dirty.y, ==, y0);
+		munit_assert_uint32(fb->dirty.x + fb->dirty.w, ==, x1);
+		munit_assert_uint32(fb->dirty.y + fb->dirty.h, ==, y1);
+	} else {
+		munit_assert_uint16(fb->dirty.x, <=, x0);
+		munit_assert_uint16(fb->dirty.y, <=, y0);
+		munit_assert_uint32(fb->dirty.x + fb->dirty.w, >=, x1);
+		munit_assert_uint32(fb->dirty.y + fb->dirty.h, >=, y1);
+	}
+}
+
 /**
  * @defgroup inky-init-test Test inky initialization
  * @{
@@ -533,16 +584,21 @@ MunitResult random_fb_test(const MunitParameter params[],
 	munit_assert_uint32(buf_len, ==, (uint32_t) dev->fb->bytes);
 
 	for (uint32_t i = 0; i < buf_len; i++) {
-		for (uint8_t j = 0; j < 8; j = j + 2) {
+		for (uint8_t j = 0; j < 8; j = j + dev->fb->fmt.bpp) {
 			inky_color c;
-			uint8_t pixel = (intf->buf[i] >> j) & 0x03;
-			uint64_t addr = (i * 8 + j) / 2;
+			uint8_t pixel = (intf->buf[i] >> j) & dev->fb->fmt.mask;
+			uint32_t addr = ((i % dev->fb->stride) * 8 + j) /
+				dev->fb->fmt.bpp;
 
-			uint16_t y = addr / dev->fb->width;
-			uint16_t x = addr % dev->fb->width;
+			uint16_t y = i / dev->fb->stride;
+			uint16_t x = addr;
+
+			if (x >= dev->fb->width) {
+				break;
+			}
 
 			munit_logf(MUNIT_LOG_DEBUG,
-				   "Writing color %d at addr %lu "
+				   "Writing color %d at addr %u "
 				   "to (%u,%u)",
 				   pixel, addr, x, y);
 
@@ -579,6 +635,448 @@ MunitResult random_fb_test(const MunitParameter params[],
 	return MUNIT_OK;
 }
 
+/**
+ * @}
+ */
+
+/**
+ * @defgroup unchecked-pixel-test Compare unchecked and checked pixel
+ * writes
+ * @{
+ */
+
+MunitResult unchecked_pixel_test(const MunitParameter params[],
+				 void *user_data)
+{
+	INTF(user_data);
+	inky_config *dev = &intf->dev;
+	inky_color palette[3];
+
+	palette[0] = INKY_COLOR_WHITE;
+	palette[1] = INKY_COLOR_BLACK;
+	palette[2] = color_from_char(munit_parameters_get(params, "color"));
+
+	munit_assert_int8(inky_setup(dev), ==, INKY_OK);
+
+	intf->buf = malloc(dev->fb->bytes);
+	munit_assert_not_null(intf->buf);
+
+	for (uint32_t i = 0; i < 10000; i++) {
+		uint16_t x = munit_rand_int_range(0, dev->fb->width - 1);
+		uint16_t y = munit_rand_int_range(0, dev->fb->height - 1);
+		inky_color c = palette[munit_rand_int_range(0, 2)];
+
+		munit_assert_int8(inky_fb_set_pixel(dev, x, y, c), ==, INKY_OK);
+
+		/* Same write again, unchecked, must not change anything */
+		memcpy(intf->buf, dev->fb->buffer, dev->fb->bytes);
+		inky_fb_set_pixel_unchecked(dev->fb, x, y, c);
+
+		munit_assert_memory_equal(dev->fb->bytes, intf->buf,
+					  dev->fb->buffer);
+	}
+
+	/* Range and color checks still apply to the checked setter */
+	munit_assert_int8(inky_fb_set_pixel(dev, dev->fb->width, 0,
+					    INKY_COLOR_BLACK),
+			  ==, INKY_E_OUT_OF_RANGE);
+
+	munit_assert_int8(inky_fb_set_pixel(dev, 0, 0,
+					    palette[2] == INKY_COLOR_YELLOW ?
+					    INKY_COLOR_RED : INKY_COLOR_YELLOW),
+			  ==, INKY_E_NOT_AVAILABLE);
+
+	return MUNIT_OK;
+}
+
+/**
+ * @}
+ */
+
+/**
+ * @defgroup pixfmt-test Test framebuffer pixel formats
+ * @{
+ */
+
+static char* inky_pixfmt_params[] = {
+	"auto",
+	"2bpp",
+	"4bpp",
+	NULL
+};
+
+static MunitParameterEnum pixfmt_test_params[] = {
+	{
+		.name = "color",
+		.values = inky_color_params
+	},
+
+	{
+		.name = "product",
+		.values = inky_pdt_params
+	},
+
+	{
+		.name = "format",
+		.values = inky_pixfmt_params
+	},
+
+	{
+		.name = NULL,
+		.values = NULL
+	}
+};
+
+static void *pixfmt_setup(const MunitParameter params[], void *user_data)
+{
+	INTF(user_data);
+	const char *format;
+	inky_color c;
+	inky_product p;
+
+	c = color_from_char(munit_parameters_get(params, "color"));
+	p = pdt_from_char(munit_parameters_get(params, "product"));
+	format = munit_parameters_get(params, "format");
+
+	initialize_test_device(intf, c, p);
+
+	if (strcmp(format, "2bpp") == 0) {
+		intf->dev.fb_format = INKY_PIXFMT_2BPP;
+	} else if (strcmp(format, "4bpp") == 0) {
+		intf->dev.fb_format = INKY_PIXFMT_4BPP;
+	}
+
+	return user_data;
+}
+
+static void pixfmt_tear_down(void *fixture)
+{
+	INTF(fixture);
+
+	inky_free(&intf->dev);
+
+	deinitialize_test_device(intf);
+}
+
+MunitResult pixfmt_test(const MunitParameter params[], void *user_data)
+{
+	INTF(user_data);
+	inky_config *dev = &intf->dev;
+	inky_color palette[3];
+	uint8_t expected_bpp;
+	inky_color out;
+
+	palette[0] = INKY_COLOR_WHITE;
+	palette[1] = INKY_COLOR_BLACK;
+	palette[2] = color_from_char(munit_parameters_get(params, "color"));
+
+	switch (dev->fb_format) {
+	case INKY_PIXFMT_2BPP:
+		expected_bpp = 2;
+		break;
+	case INKY_PIXFMT_4BPP:
+		expected_bpp = 4;
+		break;
+	default:
+		/* Black-only panels get half the memory */
+		expected_bpp = palette[2] == INKY_COLOR_BLACK ? 1 : 2;
+		break;
+	}
+
+#ifdef INKY_FIXED_COLOR
+	/* Fixed builds only support the format chosen by the color */
+	if (expected_bpp != INKY_FB_BPP(dev->fb)) {
+		munit_assert_int8(inky_setup(dev), ==, INKY_E_NOT_AVAILABLE);
+
+		return MUNIT_OK;
+	}
+#endif /* #ifdef INKY_FIXED_COLOR */
+
+	munit_assert_int8(inky_setup(dev), ==, INKY_OK);
+
+	munit_assert_uint8(dev->fb->fmt.bpp, ==, expected_bpp);
+	/* Rows are padded to whole 32 bit words */
+	munit_assert_uint32(dev->fb->stride % 4, ==, 0);
+	munit_assert_uint32(dev->fb->stride * 8, >=,
+			    (uint32_t) dev->fb->width * expected_bpp);
+	munit_assert_uint32(dev->fb->stride * 8, <,
+			    (uint32_t) dev->fb->width * expected_bpp + 32);
+	munit_assert_uint32(dev->fb->bytes, ==,
+			    dev->fb->stride * dev->fb->height);
+
+	/* The last column of a row does not alias the next row */
+	munit_assert_int8(inky_fb_set_pixel(dev, dev->fb->width - 1, 0,
+					    INKY_COLOR_BLACK), ==, INKY_OK);
+	munit_assert_int8(inky_fb_get_pixel(dev, 0, 1, &out), ==, INKY_OK);
+	munit_assert_int(out, ==, INKY_COLOR_WHITE);
+
+	/* Fill, then read back random writes */
+	munit_assert_int8(inky_fb_fill(dev, palette[2]), ==, INKY_OK);
+
+	for (uint32_t i = 0; i < 2000; i++) {
+		uint16_t x = munit_rand_int_range(0, dev->fb->width - 1);
+		uint16_t y = munit_rand_int_range(0, dev->fb->height - 1);
+		inky_color c = palette[munit_rand_int_range(0, 2)];
+
+		munit_assert_int8(inky_fb_set_pixel(dev, x, y, c), ==, INKY_OK);
+		munit_assert_int8(inky_fb_get_pixel(dev, x, y, &out), ==,
+				  INKY_OK);
+		munit_assert_int(out, ==, c);
+	}
+
+	munit_assert_int8(inky_update(dev), ==, INKY_OK);
+
+	/* Clearing leaves every pixel white */
+	munit_assert_int8(inky_clear(dev), ==, INKY_OK);
+
+	for (uint32_t i = 0; i < dev->fb->bytes; i++) {
+		munit_assert_uint8(dev->fb->buffer[i], ==, 0x00);
+	}
+
+	return MUNIT_OK;
+}
+
+/**
+ * @}
+ */
+
+/**
+ * @defgroup custom-panel-test Test registered panel descriptors
+ * @{
+ */
+
+static const uint8_t custom_init[] = {
+	0x12, 0,		/* Soft reset, no data */
+	0x01, 3, 0xdf, 0x01, 0x00,	/* Gate setting for 480 rows */
+	INKY_INIT_IF_RED, 0x04, 3, 0x30, 0xac, 0x22,
+	INKY_INIT_IF_YELLOW, 0x04, 3, 0x07, 0xac, 0x32,
+	INKY_INIT_LUTS
+};
+
+static const uint8_t custom_lut[70] = {0};
+
+static MunitParameterEnum custom_panel_params[] = {
+	{
+		.name = "color",
+		.values = inky_color_params
+	},
+
+	{
+		.name = NULL,
+		.values = NULL
+	}
+};
+
+static const inky_panel custom_panel = {
+	.width = 800,
+	.height = 480,
+	.row_stride = 0,
+	.init = custom_init,
+	.init_len = sizeof(custom_init),
+	.lut_black = custom_lut,
+	.lut_red = custom_lut,
+	.lut_yellow = custom_lut,
+	.lut_len = sizeof(custom_lut)
+};
+
+static void *custom_panel_setup(const MunitParameter params[],
+				void *user_data)
+{
+	INTF(user_data);
+	inky_color c;
+
+	c = color_from_char(munit_parameters_get(params, "color"));
+
+	initialize_test_device(intf, c, INKY_CUSTOM);
+
+	return user_data;
+}
+
+static void custom_panel_tear_down(void *fixture)
+{
+	INTF(fixture);
+
+	inky_free(&intf->dev);
+
+	deinitialize_test_device(intf);
+}
+
+MunitResult custom_panel_test(const MunitParameter params[],
+			      void *user_data)
+{
+	INTF(user_data);
+	inky_config *dev = &intf->dev;
+	inky_panel bad = custom_panel;
+	inky_color c;
+	inky_color out;
+
+#ifdef INKY_FIXED_PRODUCT
+	/* Fixed builds always drive the built-in panel */
+	return MUNIT_SKIP;
+#endif /* #ifdef INKY_FIXED_PRODUCT */
+
+	c = color_from_char(munit_parameters_get(params, "color"));
+
+	/* Custom products cannot be set up without a descriptor */
+	munit_assert_int8(inky_setup(dev), ==, INKY_E_NOT_CONFIGURED);
+	munit_assert_null(dev->fb);
+
+	bad.row_stride = 99;
+	munit_assert_int8(inky_panel_register(dev, &bad), ==,
+			  INKY_E_OUT_OF_RANGE);
+
+	bad.row_stride = 0;
+	bad.height = 0;
+	munit_assert_int8(inky_panel_register(dev, &bad), ==,
+			  INKY_E_OUT_OF_RANGE);
+
+	munit_assert_int8(inky_panel_register(dev, &custom_panel), ==,
+			  INKY_OK);
+	munit_assert_int8(inky_setup(dev), ==, INKY_OK);
+
+	munit_assert_uint16(dev->fb->width, ==, 800);
+	munit_assert_uint16(dev->fb->height, ==, 480);
+
+	/* Larger than 16 bit addressing allows */
+	munit_assert_uint32(dev->fb->bytes, ==,
+			    800 * 480 * dev->fb->fmt.bpp / 8);
+	munit_assert_uint32(dev->fb->stride, ==, 800 * dev->fb->fmt.bpp / 8);
+
+	munit_assert_int8(inky_fb_set_pixel(dev, 799, 479, c), ==, INKY_OK);
+	munit_assert_int8(inky_fb_get_pixel(dev, 799, 479, &out), ==,
+			  INKY_OK);
+	munit_assert_int(out, ==, c);
+
+	munit_assert_int8(inky_fb_get_pixel(dev, 798, 479, &out), ==,
+			  INKY_OK);
+	munit_assert_int(out, ==, INKY_COLOR_WHITE);
+
+	munit_assert_int8(inky_update(dev), ==, INKY_OK);
+
+	munit_assert_ptr_equal(dev->panel, &custom_panel);
+	munit_assert_not_null(inky_panel_get(INKY_WHAT));
+	munit_assert_null(inky_panel_get(INKY_CUSTOM));
+
+	return MUNIT_OK;
+}
+
+/**
+ * @}
+ */
+
+/**
+ * @defgroup bulk-write-test Compare span, row and point writes to
+ * single pixels
+ * @{
+ */
+
+MunitResult bulk_write_test(const MunitParameter params[],
+			    void *user_data)
+{
+	INTF(user_data);
+	inky_config *dev = &intf->dev;
+	inky_color palette[3];
+	inky_color *row;
+	inky_point pts[64];
+	uint16_t w;
+	uint16_t h;
+
+	palette[0] = INKY_COLOR_WHITE;
+	palette[1] = INKY_COLOR_BLACK;
+	palette[2] = color_from_char(munit_parameters_get(params, "color"));
+
+	munit_assert_int8(inky_setup(dev), ==, INKY_OK);
+
+	w = dev->fb->width;
+	h = dev->fb->height;
+
+	/* Reference image, one color per byte */
+	intf->buf = calloc((uint32_t) w * h, 1);
+	munit_assert_not_null(intf->buf);
+
+	row = malloc(w * sizeof(*row));
+	munit_assert_not_null(row);
+
+	for (uint32_t i = 0; i < 300; i++) {
+		uint16_t y = munit_rand_int_range(0, h - 1);
+		inky_color c = palette[munit_rand_int_range(0, 2)];
+
+		switch (i % 3) {
+		case 0: {
+			uint16_t x = munit_rand_int_range(0, w - 1);
+			uint16_t len = munit_rand_int_range(0, w - x);
+
+			munit_assert_int8(inky_fb_hline(dev, x, y, len, c),
+					  ==, INKY_OK);
+
+			memset(&intf->buf[(uint32_t) y * w + x], c, len);
+			break;
+		}
+		case 1: {
+			uint16_t n = munit_rand_int_range(0, w);
+
+			for (uint16_t x = 0; x < n; x++) {
+				row[x] = palette[munit_rand_int_range(0, 2)];
+				intf->buf[(uint32_t) y * w + x] = row[x];
+			}
+
+			munit_assert_int8(inky_fb_write_row(dev, y, row, n),
+					  ==, INKY_OK);
+			break;
+		}
+		default:
+			for (uint16_t k = 0; k < 64; k++) {
+				pts[k].x = munit_rand_int_range(0, w - 1);
+				pts[k].y = munit_rand_int_range(0, h - 1);
+				intf->buf[(uint32_t) pts[k].y * w + pts[k].x] = c;
+			}
+
+			munit_assert_int8(inky_fb_set_pixels(dev, pts, 64, c),
+					  ==, INKY_OK);
+			break;
+		}
+	}
+
+	for (uint16_t y = 0; y < h; y++) {
+		for (uint16_t x = 0; x < w; x++) {
+			inky_color out;
+
+			munit_assert_int8(inky_fb_get_pixel(dev, x, y, &out),
+					  ==, INKY_OK);
+			munit_assert_int(out, ==,
+					 intf->buf[(uint32_t) y * w + x]);
+		}
+	}
+
+	/* Rejected calls leave the framebuffer untouched */
+	memcpy(intf->buf, dev->fb->buffer, dev->fb->bytes);
+
+	munit_assert_int8(inky_fb_hline(dev, 1, 0, w, INKY_COLOR_BLACK),
+			  ==, INKY_E_OUT_OF_RANGE);
+	munit_assert_int8(inky_fb_write_row(dev, h, row, 1),
+			  ==, INKY_E_OUT_OF_RANGE);
+
+	row[0] = INKY_COLOR_BLACK;
+	row[1] = palette[2] == INKY_COLOR_YELLOW ? INKY_COLOR_RED :
+		INKY_COLOR_YELLOW;
+	munit_assert_int8(inky_fb_write_row(dev, 0, row, 2),
+			  ==, INKY_E_NOT_AVAILABLE);
+
+	pts[0].x = 0;
+	pts[0].y = 0;
+	pts[1].x = w;
+	pts[1].y = 0;
+	munit_assert_int8(inky_fb_set_pixels(dev, pts, 2, INKY_COLOR_BLACK),
+			  ==, INKY_E_OUT_OF_RANGE);
+
+	munit_assert_memory_equal(dev->fb->bytes, intf->buf,
+				  dev->fb->buffer);
+
+	free(row);
+
+	return MUNIT_OK;
+}
+
 /**
  * @}
  */
@@ -620,6 +1118,42 @@ MunitTest fb_tests[] = {
 		.parameters = fb_test_params
 	},
 
+	{
+		.name = "/unchecked-pixel-test",
+		.test = unchecked_pixel_test,
+		.setup = device_setup,
+		.tear_down = device_tear_down,
+		.options = MUNIT_TEST_OPTION_NONE,
+		.parameters = fb_test_params
+	},
+
+	{
+		.name = "/pixfmt-test",
+		.test = pixfmt_test,
+		.setup = pixfmt_setup,
+		.tear_down = pixfmt_tear_down,
+		.options = MUNIT_TEST_OPTION_NONE,
+		.parameters = pixfmt_test_params
+	},
+
+	{
+		.name = "/custom-panel-test",
+		.test = custom_panel_test,
+		.setup = custom_panel_setup,
+		.tear_down = custom_panel_tear_down,
+		.options = MUNIT_TEST_OPTION_NONE,
+		.parameters = custom_panel_params
+	},
+
+	{
+		.name = "/bulk-write-test",
+		.test = bulk_write_test,
+		.setup = device_setup,
+		.tear_down = device_tear_down,
+		.options = MUNIT_TEST_OPTION_NONE,
+		.parameters = fb_test_params
+	},
+
 	{
 		.name = NULL,
 		.test = NULL,
@@ -630,10 +1164,116 @@ MunitTest fb_tests[] = {
 	}
 };
 
+static MunitSuite inky_sub_suites[] = {
+	{
+		"/blit",
+		blit_tests,
+		NULL,
+		1,
+		MUNIT_SUITE_OPTION_NONE
+	},
+
+	{
+		"/text",
+		text_tests,
+		NULL,
+		1,
+		MUNIT_SUITE_OPTION_NONE
+	},
+
+	{
+		"/term",
+		term_tests,
+		NULL,
+		1,
+		MUNIT_SUITE_OPTION_NONE
+	},
+
+	{
+		"/draw",
+		draw_tests,
+		NULL,
+		1,
+		MUNIT_SUITE_OPTION_NONE
+	},
+
+	{
+		"/image",
+		image_tests,
+		NULL,
+		1,
+		MUNIT_SUITE_OPTION_NONE
+	},
+
+	{
+		"/dither",
+		dither_tests,
+		NULL,
+		1,
+		MUNIT_SUITE_OPTION_NONE
+	},
+
+	{
+		"/convert",
+		convert_tests,
+		NULL,
+		1,
+		MUNIT_SUITE_OPTION_NONE
+	},
+
+	{
+		"/binarize",
+		binarize_tests,
+		NULL,
+		1,
+		MUNIT_SUITE_OPTION_NONE
+	},
+
+	{
+		"/scale",
+		scale_tests,
+		NULL,
+		1,
+		MUNIT_SUITE_OPTION_NONE
+	},
+
+	{
+		"/orient",
+		orient_tests,
+		NULL,
+		1,
+		MUNIT_SUITE_OPTION_NONE
+	},
+
+	{
+		"/layer",
+		layer_tests,
+		NULL,
+		1,
+		MUNIT_SUITE_OPTION_NONE
+	},
+
+	{
+		"/widget",
+		widget_tests,
+		NULL,
+		1,
+		MUNIT_SUITE_OPTION_NONE
+	},
+
+	{
+		NULL,
+		NULL,
+		NULL,
+		0,
+		MUNIT_SUITE_OPTION_NONE
+	}
+};
+
 static const MunitSuite inky_suite = {
 	"/inky-test-suite",
 	fb_tests,
-	NULL,
+	inky_sub_suites,
 	5,
 	MUNIT_SUITE_OPTION_NONE
 };
@@ -0,0 +1,788 @@
+/**
+ * @file image-test.c
+ *
+ * Unit testing for the streaming image decoders of the Pimoroni Inky
+ * driver
+ */
+
+#include "inky.h"
+
+#include <munit/munit.h>
+
+#include "test-device.h"
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+/**
+ * @defgroup pimoroni-inky-image-tests Pimoroni Inky image testing suites
+ * @{
+ */
+
+/*
+**********************************************************************
+************************** TESTS DEFINITIONS *************************
+**********************************************************************
+*/
+
+#define IMG_W	13
+#define IMG_H	7
+
+/** @brief Colors of the indexed test images */
+static const uint8_t test_palette[6][3] = {
+	{ 0xff, 0xff, 0xff },
+	{ 0x00, 0x00, 0x00 },
+	{ 0xe0, 0x10, 0x20 },
+	{ 0xf0, 0xe0, 0x10 },
+	{ 0x80, 0x80, 0x80 },
+	{ 0x20, 0x40, 0xc0 },
+};
+
+/** @brief Source image: RGBA pixels and palette indices */
+struct src_img {
+	uint8_t rgba[IMG_H][IMG_W][4];
+	uint8_t idx[IMG_H][IMG_W];
+};
+
+/** @brief Encoded image and what decoding it must give */
+struct enc_img {
+	uint8_t data[4096];
+	uint32_t size;
+	uint8_t expect[IMG_H][IMG_W][3];
+};
+
+/** @brief Fill a source image with runs of palette colors on even rows
+ * and gradients on odd ones, steep enough for a QOI luma op or gentle
+ * enough for a diff op. With alpha, some pixels are transparent */
+static void make_src(struct src_img *s, int alpha)
+{
+	for (int y = 0; y < IMG_H; y++) {
+		uint8_t i = munit_rand_uint32() % 6;
+
+		for (int x = 0; x < IMG_W; x++) {
+			uint8_t *p = s->rgba[y][x];
+
+			if (munit_rand_uint32() % 3 == 0) {
+				i = munit_rand_uint32() % 6;
+			}
+
+			s->idx[y][x] = i;
+
+			if (y % 2 == 0) {
+				memcpy(p, test_palette[i], 3);
+			} else if (y % 4 == 1) {
+				p[0] = 100 + x * 4 + y;
+				p[1] = 150 - x * 2;
+				p[2] = 60 + x % 3;
+			} else {
+				p[0] = 30 + x % 2;
+				p[1] = 80 + x % 3;
+				p[2] = 200 - x / 2;
+			}
+
+			p[3] = alpha && x % 4 == 1 ? munit_rand_uint32() : 0xff;
+		}
+	}
+}
+
+static uint8_t blend_white(uint8_t c, uint8_t a)
+{
+	return (c * a + 255 * (255 - a) + 127) / 255;
+}
+
+static void put(struct enc_img *e, const void *p, uint32_t n)
+{
+	munit_assert_uint32(e->size + n, <=, sizeof(e->data));
+	memcpy(&e->data[e->size], p, n);
+	e->size += n;
+}
+
+static void put_u8(struct enc_img *e, uint8_t v)
+{
+	put(e, &v, 1);
+}
+
+static void put_le(struct enc_img *e, uint32_t v, int n)
+{
+	for (int i = 0; i < n; i++) {
+		put_u8(e, v >> (8 * i));
+	}
+}
+
+static void put_str(struct enc_img *e, const char *s)
+{
+	put(e, s, strlen(s));
+}
+
+static uint8_t gray(const uint8_t *p)
+{
+	return (p[0] + p[1] + p[2]) / 3;
+}
+
+/** @brief Netpbm file of type kind with samples up to maxval */
+static void enc_pnm(struct enc_img *e, const struct src_img *s, int kind,
+		    uint32_t maxval)
+{
+	char hdr[64];
+	int ch = kind % 3 == 0 ? 3 : 1;
+
+	e->size = 0;
+
+	snprintf(hdr, sizeof(hdr), "P%d\n# made by image-test\n%d %d\n",
+		 kind, IMG_W, IMG_H);
+	put_str(e, hdr);
+
+	if (kind % 3 != 1) {
+		snprintf(hdr, sizeof(hdr), "%u\n", maxval);
+		put_str(e, hdr);
+	}
+
+	for (int y = 0; y < IMG_H; y++) {
+		uint8_t bits = 0;
+
+		for (int x = 0; x < IMG_W; x++) {
+			const uint8_t *p = s->rgba[y][x];
+			uint8_t *out = e->expect[y][x];
+
+			if (kind % 3 == 1) {
+				int black = gray(p) < 128;
+
+				memset(out, black ? 0 : 255, 3);
+
+				if (kind == 1) {
+					/* Digits may run together */
+					put_str(e, black ? "1" : "0");
+
+					if (y % 2) {
+						put_str(e, " ");
+					}
+				} else {
+					bits |= black << (7 - x % 8);
+
+					if (x % 8 == 7 || x == IMG_W - 1) {
+						put_u8(e, bits);
+						bits = 0;
+					}
+				}
+
+				continue;
+			}
+
+			for (int c = 0; c < ch; c++) {
+				uint8_t v8 = ch == 3 ? p[c] : gray(p);
+				uint32_t v = (v8 * maxval + 127) / 255;
+				uint8_t dec = (v * 255 + maxval / 2) / maxval;
+
+				if (ch == 3) {
+					out[c] = dec;
+				} else {
+					memset(out, dec, 3);
+				}
+
+				if (kind <= 3) {
+					snprintf(hdr, sizeof(hdr), "%u ", v);
+					put_str(e, hdr);
+				} else if (maxval > 255) {
+					put_u8(e, v >> 8);
+					put_u8(e, v);
+				} else {
+					put_u8(e, v);
+				}
+			}
+		}
+
+		if (kind <= 3) {
+			put_str(e, "\n");
+		}
+	}
+}
+
+/** @brief BMP file of bpp bits with a header of dib bytes */
+static void enc_bmp(struct enc_img *e, const struct src_img *s, int bpp,
+		    int dib, int top_down)
+{
+	uint32_t colors = bpp == 1 ? 2 : bpp <= 8 ? 6 : 0;
+	uint32_t entry = dib == 12 ? 3 : 4;
+	uint32_t row = ((IMG_W * bpp + 31) / 32) * 4;
+	uint32_t masks = bpp == 32 && dib == 40 ? 12 : 0;
+	uint32_t offset = 14 + dib + masks + colors * entry + 3;
+
+	e->size = 0;
+
+	put_str(e, "BM");
+	put_le(e, offset + row * IMG_H, 4);
+	put_le(e, 0, 4);
+	put_le(e, offset, 4);
+	put_le(e, dib, 4);
+
+	if (dib == 12) {
+		put_le(e, IMG_W, 2);
+		put_le(e, IMG_H, 2);
+		put_le(e, 1, 2);
+		put_le(e, bpp, 2);
+	} else {
+		put_le(e, IMG_W, 4);
+		put_le(e, top_down ? -IMG_H : IMG_H, 4);
+		put_le(e, 1, 2);
+		put_le(e, bpp, 2);
+		put_le(e, bpp == 32 ? 3 : 0, 4);
+		put_le(e, row * IMG_H, 4);
+		put_le(e, 2835, 4);
+		put_le(e, 2835, 4);
+		put_le(e, colors, 4);
+		put_le(e, 0, 4);
+
+		/* Masks, in a v4 header or after a plain one */
+		if (bpp == 32) {
+			put_le(e, 0xff000000, 4);
+			put_le(e, 0x00ff0000, 4);
+			put_le(e, 0x0000ff00, 4);
+
+			if (dib >= 56) {
+				put_le(e, 0x000000ff, 4);
+			}
+		}
+
+		for (uint32_t i = masks ? 40 : 40 + (bpp == 32 ? 16 : 0);
+		     i < (uint32_t) dib; i++) {
+			put_u8(e, 0);
+		}
+	}
+
+	for (uint32_t i = 0; i < colors; i++) {
+		put_u8(e, test_palette[i][2]);
+		put_u8(e, test_palette[i][1]);
+		put_u8(e, test_palette[i][0]);
+
+		if (entry == 4) {
+			put_u8(e, 0);
+		}
+	}
+
+	/* A gap before the pixels */
+	put_str(e, "gap");
+
+	for (int j = 0; j < IMG_H; j++) {
+		int y = top_down ? j : IMG_H - 1 - j;
+		uint32_t start = e->size;
+		uint8_t bits = 0;
+
+		for (int x = 0; x < IMG_W; x++) {
+			const uint8_t *p = s->rgba[y][x];
+			uint8_t *out = e->expect[y][x];
+			uint8_t i = bpp == 1 ? s->idx[y][x] % 2 : s->idx[y][x];
+			uint16_t v;
+
+			switch (bpp) {
+			case 1:
+			case 4:
+			case 8:
+				memcpy(out, test_palette[i], 3);
+				bits = bpp == 8 ? i : (bits << bpp) | i;
+
+				if (bpp == 8 || (x + 1) % (8 / bpp) == 0) {
+					put_u8(e, bits);
+					bits = 0;
+				} else if (x == IMG_W - 1) {
+					put_u8(e, bits << (8 - bpp *
+							   ((x + 1) %
+							    (8 / bpp))));
+				}
+				break;
+
+			case 16:
+				v = ((p[0] >> 3) << 10) | ((p[1] >> 3) << 5) |
+					(p[2] >> 3);
+				put_le(e, v, 2);
+
+				for (int c = 0; c < 3; c++) {
+					out[c] = ((p[c] >> 3) * 255 + 15) / 31;
+				}
+				break;
+
+			case 24:
+				put_u8(e, p[2]);
+				put_u8(e, p[1]);
+				put_u8(e, p[0]);
+				memcpy(out, p, 3);
+				break;
+
+			case 32:
+				/* Stored as A, B, G, R by the masks above */
+				put_u8(e, dib >= 56 ? p[3] : 0xff);
+				put_u8(e, p[2]);
+				put_u8(e, p[1]);
+				put_u8(e, p[0]);
+
+				for (int c = 0; c < 3; c++) {
+					out[c] = dib >= 56 ?
+						blend_white(p[c], p[3]) : p[c];
+				}
+				break;
+			}
+		}
+
+		while (e->size - start < row) {
+			put_u8(e, 0);
+		}
+	}
+}
+
+/** @brief QOI file, the way the reference encoder writes it */
+static void enc_qoi(struct enc_img *e, const struct src_img *s,
+		    int channels)
+{
+	uint8_t index[64][4];
+	uint8_t prev[4] = { 0, 0, 0, 0xff };
+	int run = 0;
+
+	memset(index, 0, sizeof(index));
+	e->size = 0;
+
+	put_str(e, "qoif");
+
+	for (int i = 3; i >= 0; i--) {
+		put_u8(e, IMG_W >> (8 * i));
+	}
+
+	for (int i = 3; i >= 0; i--) {
+		put_u8(e, IMG_H >> (8 * i));
+	}
+
+	put_u8(e, channels);
+	put_u8(e, 0);
+
+	for (int y = 0; y < IMG_H; y++) {
+		for (int x = 0; x < IMG_W; x++) {
+			uint8_t px[4];
+			int last = y == IMG_H - 1 && x == IMG_W - 1;
+			int h;
+
+			memcpy(px, s->rgba[y][x], 4);
+
+			if (channels == 3) {
+				px[3] = 0xff;
+			}
+
+			for (int c = 0; c < 3; c++) {
+				e->expect[y][x][c] = blend_white(px[c], px[3]);
+			}
+
+			if (!memcmp(px, prev, 4)) {
+				run++;
+
+				if (run == 62 || last) {
+					put_u8(e, 0xc0 | (run - 1));
+					run = 0;
+				}
+
+				continue;
+			}
+
+			if (run) {
+				put_u8(e, 0xc0 | (run - 1));
+				run = 0;
+			}
+
+			h = (px[0] * 3 + px[1] * 5 + px[2] * 7 + px[3] * 11) % 64;
+
+			if (!memcmp(index[h], px, 4)) {
+				put_u8(e, h);
+			} else if (px[3] == prev[3]) {
+				int8_t vr = px[0] - prev[0];
+				int8_t vg = px[1] - prev[1];
+				int8_t vb = px[2] - prev[2];
+				int8_t vgr = vr - vg;
+				int8_t vgb = vb - vg;
+
+				memcpy(index[h], px, 4);
+
+				if (vr > -3 && vr < 2 && vg > -3 && vg < 2 &&
+				    vb > -3 && vb < 2) {
+					put_u8(e, 0x40 | (vr + 2) << 4 |
+					       (vg + 2) << 2 | (vb + 2));
+				} else if (vgr > -9 && vgr < 8 && vg > -33 &&
+					   vg < 32 && vgb > -9 && vgb < 8) {
+					put_u8(e, 0x80 | (vg + 32));
+					put_u8(e, (vgr + 8) << 4 | (vgb + 8));
+				} else {
+					put_u8(e, 0xfe);
+					put(e, px, 3);
+				}
+			} else {
+				memcpy(index[h], px, 4);
+				put_u8(e, 0xff);
+				put(e, px, 4);
+			}
+
+			memcpy(prev, px, 4);
+		}
+	}
+
+	put(e, "\0\0\0\0\0\0\0\1", 8);
+}
+
+/** @brief Read callback source handing out random sized pieces */
+struct chunky {
+	const uint8_t *data;
+	uint32_t size;
+	uint32_t pos;
+	int fail;
+};
+
+static INT32_t chunky_read(void *ctx, UINT8_t *buf, UINT32_t len)
+{
+	struct chunky *c = ctx;
+	uint32_t n = 1 + munit_rand_uint32() % len;
+
+	if (c->fail) {
+		return -1;
+	}
+
+	n = n < c->size - c->pos ? n : c->size - c->pos;
+	memcpy(buf, &c->data[c->pos], n);
+	c->pos += n;
+
+	return n;
+}
+
+/** @brief Decode e from memory and through the callback, checking
+ * every row against what it should be */
+static void check_decode(const struct enc_img *e, inky_image_format fmt,
+			 int bottom_up)
+{
+	for (int src = 0; src < 2; src++) {
+		struct chunky c = { e->data, e->size, 0, 0 };
+		uint8_t rgb[IMG_W * 3];
+		inky_image img;
+		uint16_t y;
+
+		if (src == 0) {
+			munit_assert_int8(inky_image_open_memory(&img, e->data,
+								 e->size),
+					  ==, INKY_OK);
+		} else {
+			munit_assert_int8(inky_image_open(&img, chunky_read,
+							  &c), ==, INKY_OK);
+		}
+
+		munit_assert_int(img.format, ==, fmt);
+		munit_assert_uint16(img.width, ==, IMG_W);
+		munit_assert_uint16(img.height, ==, IMG_H);
+
+		for (int j = 0; j < IMG_H; j++) {
+			munit_assert_int8(inky_image_read_row(&img, rgb, &y),
+					  ==, INKY_OK);
+			munit_assert_uint16(y, ==,
+					    bottom_up ? IMG_H - 1 - j : j);
+			munit_assert_memory_equal(sizeof(rgb), rgb,
+						  e->expect[y]);
+		}
+
+		munit_assert_int8(inky_image_read_row(&img, rgb, &y), ==,
+				  INKY_E_OUT_OF_RANGE);
+	}
+}
+
+/**
+ * @defgroup decode-test Decode every supported format
+ * @{
+ */
+
+static MunitResult decode_test(const MunitParameter params[],
+			       void *user_data)
+{
+	struct src_img s;
+	struct enc_img *e = malloc(sizeof(*e));
+
+	munit_assert_not_null(e);
+
+	make_src(&s, 0);
+
+	for (int kind = 1; kind <= 6; kind++) {
+		enc_pnm(e, &s, kind, 255);
+		check_decode(e, INKY_IMAGE_PNM, 0);
+
+		if (kind % 3 != 1) {
+			enc_pnm(e, &s, kind, 100);
+			check_decode(e, INKY_IMAGE_PNM, 0);
+
+			enc_pnm(e, &s, kind, 65535);
+			check_decode(e, INKY_IMAGE_PNM, 0);
+		}
+	}
+
+	for (int bpp = 1; bpp <= 32; bpp *= 2) {
+		if (bpp == 2) {
+			continue;
+		}
+
+		enc_bmp(e, &s, bpp, 40, 0);
+		check_decode(e, INKY_IMAGE_BMP, 1);
+
+		enc_bmp(e, &s, bpp, 40, 1);
+		check_decode(e, INKY_IMAGE_BMP, 0);
+	}
+
+	enc_bmp(e, &s, 24, 40, 0);
+	check_decode(e, INKY_IMAGE_BMP, 1);
+
+	/* OS/2 core header */
+	enc_bmp(e, &s, 8, 12, 0);
+	check_decode(e, INKY_IMAGE_BMP, 1);
+
+	enc_qoi(e, &s, 3);
+	check_decode(e, INKY_IMAGE_QOI, 0);
+
+	/* Alpha, in a v4 BMP header and in QOI */
+	make_src(&s, 1);
+
+	enc_bmp(e, &s, 32, 108, 1);
+	check_decode(e, INKY_IMAGE_BMP, 0);
+
+	enc_qoi(e, &s, 4);
+	check_decode(e, INKY_IMAGE_QOI, 0);
+
+	free(e);
+
+	return MUNIT_OK;
+}
+
+/**
+ * @}
+ */
+
+/**
+ * @defgroup bad-image-test Reject unknown, corrupt and short images
+ * @{
+ */
+
+static MunitResult bad_image_test(const MunitParameter params[],
+				  void *user_data)
+{
+	struct src_img s;
+	struct enc_img *e = malloc(sizeof(*e));
+	struct chunky c;
+	uint8_t rgb[IMG_W * 3];
+	inky_image img;
+	uint16_t y;
+
+	munit_assert_not_null(e);
+
+	make_src(&s, 0);
+
+	munit_assert_int8(inky_image_open_memory(&img, (const UINT8_t*) "GIF89a",
+						 6), ==, INKY_E_BAD_DATA);
+	munit_assert_int8(inky_image_open_memory(&img, (const UINT8_t*) "P7 1 1",
+						 6), ==, INKY_E_BAD_DATA);
+	munit_assert_int8(inky_image_open_memory(&img, (const UINT8_t*) "P6 0 1 255 ",
+						 11), ==, INKY_E_BAD_DATA);
+	munit_assert_int8(inky_image_open_memory(&img, NULL, 0), ==,
+			  INKY_E_BAD_DATA);
+	munit_assert_int8(inky_image_open_memory(NULL, e->data, 1), ==,
+			  INKY_E_NULL_PTR);
+
+	/* Cut off in the last row */
+	enc_pnm(e, &s, 6, 255);
+	munit_assert_int8(inky_image_open_memory(&img, e->data, e->size - 1),
+			  ==, INKY_OK);
+
+	for (int j = 0; j < IMG_H - 1; j++) {
+		munit_assert_int8(inky_image_read_row(&img, rgb, &y), ==,
+				  INKY_OK);
+	}
+
+	munit_assert_int8(inky_image_read_row(&img, rgb, &y), ==,
+			  INKY_E_BAD_DATA);
+
+	/* A sample over maxval */
+	enc_pnm(e, &s, 5, 100);
+	e->data[e->size - 1] = 101;
+	munit_assert_int8(inky_image_open_memory(&img, e->data, e->size),
+			  ==, INKY_OK);
+
+	for (int j = 0; j < IMG_H - 1; j++) {
+		inky_image_read_row(&img, rgb, &y);
+	}
+
+	munit_assert_int8(inky_image_read_row(&img, rgb, &y), ==,
+			  INKY_E_BAD_DATA);
+
+	/* Run length compressed BMP */
+	enc_bmp(e, &s, 8, 40, 0);
+	e->data[30] = 1;
+	munit_assert_int8(inky_image_open_memory(&img, e->data, e->size),
+			  ==, INKY_E_BAD_DATA);
+
+	/* QOI with three channels and the wrong magic */
+	enc_qoi(e, &s, 3);
+	e->data[3] = 'g';
+	munit_assert_int8(inky_image_open_memory(&img, e->data, e->size),
+			  ==, INKY_E_BAD_DATA);
+
+	/* Failing callback */
+	c = (struct chunky) { e->data, e->size, 0, 1 };
+	munit_assert_int8(inky_image_open(&img, chunky_read, &c), ==,
+			  INKY_E_BAD_DATA);
+	munit_assert_int8(inky_image_open(&img, NULL, &c), ==,
+			  INKY_E_NULL_PTR);
+
+	free(e);
+
+	return MUNIT_OK;
+}
+
+/**
+ * @}
+ */
+
+/**
+ * @defgroup image-draw-test Draw images into the framebuffer
+ * @{
+ */
+
+static MunitResult image_draw_test(const MunitParameter params[],
+				   void *user_data)
+{
+	INTF(user_data);
+	inky_config *dev = &intf->dev;
+	struct src_img s;
+	struct enc_img *e = malloc(sizeof(*e));
+	inky_config ref_dev;
+	inky_fb ref;
+	inky_fb *fb;
+
+	munit_assert_not_null(e);
+	munit_assert_int8(inky_setup(dev), ==, INKY_OK);
+
+	fb = dev->fb;
+	ref = *fb;
+	ref.buffer = malloc(fb->bytes);
+	munit_assert_not_null(ref.buffer);
+	ref_dev = *dev;
+	ref_dev.fb = &ref;
+
+	/* Pure palette colors map to themselves where the panel has them */
+	munit_assert_int(inky_image_nearest(dev, 0, 0, 0), ==,
+			 INKY_COLOR_BLACK);
+	munit_assert_int(inky_image_nearest(dev, 250, 250, 250), ==,
+			 INKY_COLOR_WHITE);
+	munit_assert_int(inky_image_nearest(dev, 0xe0, 0x10, 0x20), ==,
+			 inky_color_available(dev, INKY_COLOR_RED) ?
+			 INKY_COLOR_RED : INKY_COLOR_BLACK);
+
+	for (int i = 0; i < 24; i++) {
+		int16_t x = munit_rand_int_range(-IMG_W, fb->width);
+		int16_t y = munit_rand_int_range(-IMG_H, fb->height);
+		inky_image img;
+
+		make_src(&s, 0);
+
+		if (i % 2) {
+			enc_bmp(e, &s, 24, 40, 0);
+		} else {
+			enc_pnm(e, &s, 6, 255);
+		}
+
+		for (uint32_t k = 0; k < fb->bytes; k++) {
+			fb->buffer[k] = munit_rand_uint32() & 0x55;
+		}
+
+		memcpy(ref.buffer, fb->buffer, fb->bytes);
+		fb->dirty.w = 0;
+		fb->dirty.h = 0;
+
+		for (int v = 0; v < IMG_H; v++) {
+			for (int u = 0; u < IMG_W; u++) {
+				const uint8_t *p = e->expect[v][u];
+
+				if (x + u < 0 || y + v < 0 ||
+				    x + u >= fb->width ||
+				    y + v >= fb->height) {
+					continue;
+				}
+
+				inky_fb_set_pixel(&ref_dev, x + u, y + v,
+						  inky_image_nearest(dev, p[0],
+								     p[1],
+								     p[2]));
+			}
+		}
+
+		munit_assert_int8(inky_image_open_memory(&img, e->data,
+							 e->size), ==, INKY_OK);
+		munit_assert_int8(inky_image_draw(dev, &img, x, y), ==,
+				  INKY_OK);
+
+		munit_assert_memory_equal(fb->bytes, fb->buffer, ref.buffer);
+
+		/* The visible part of the image is dirty */
+		if (x + IMG_W > 0 && y + IMG_H > 0 && x < fb->width &&
+		    y < fb->height) {
+			munit_assert_uint16(fb->dirty.x, ==, x < 0 ? 0 : x);
+			munit_assert_uint16(fb->dirty.y, ==, y < 0 ? 0 : y);
+			munit_assert_uint16(fb->dirty.x + fb->dirty.w, ==,
+					    x + IMG_W < fb->width ?
+					    x + IMG_W : fb->width);
+			munit_assert_uint16(fb->dirty.y + fb->dirty.h, ==,
+					    y + IMG_H < fb->height ?
+					    y + IMG_H : fb->height);
+		} else {
+			munit_assert_uint16(fb->dirty.w, ==, 0);
+		}
+	}
+
+	free(ref.buffer);
+	free(e);
+
+	return MUNIT_OK;
+}
+
+/**
+ * @}
+ */
+
+MunitTest image_tests[] = {
+	{
+		.name = "/decode-test",
+		.test = decode_test,
+		.setup = NULL,
+		.tear_down = NULL,
+		.options = MUNIT_TEST_OPTION_NONE,
+		.parameters = NULL
+	},
+
+	{
+		.name = "/bad-image-test",
+		.test = bad_image_test,
+		.setup = NULL,
+		.tear_down = NULL,
+		.options = MUNIT_TEST_OPTION_NONE,
+		.parameters = NULL
+	},
+
+	{
+		.name = "/image-draw-test",
+		.test = image_draw_test,
+		.setup = device_setup,
+		.tear_down = device_tear_down,
+		.options = MUNIT_TEST_OPTION_NONE,
+		.parameters = fb_test_params
+	},
+
+	{
+		.name = NULL,
+		.test = NULL,
+		.setup = NULL,
+		.tear_down = NULL,
+		.options = MUNIT_TEST_OPTION_NONE,
+		.parameters = NULL
+	}
+};
+
+/**
+ * @}
+ * defgroup pimoroni-inky-image-tests
+ */
@@ -0,0 +1,549 @@
+/**
+ * @file layer-test.c
+ *
+ * Unit testing for the framebuffer layers of the Pimoroni Inky driver
+ */
+
+#include "inky.h"
+
+#include <munit/munit.h>
+
+#include "test-device.h"
+
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+/**
+ * @defgroup pimoroni-inky-layer-tests Pimoroni Inky layer testing
+ * suites
+ * @{
+ */
+
+/*
+**********************************************************************
+************************** TESTS DEFINITIONS *************************
+**********************************************************************
+*/
+
+#define N_LAYERS	3
+
+/** @brief Raw framebuffer code of pixel x of a row */
+static uint8_t row_code(const inky_fb *fb, const uint8_t *row, uint32_t x)
+{
+	uint32_t bit = x * fb->fmt.bpp;
+
+	return (row[bit / 8] >> (bit % 8)) & fb->fmt.mask;
+}
+
+/** @brief Random panel colors over all of the framebuffer drawn to */
+static void scribble_all(inky_config *dev)
+{
+	inky_color colors[3] = {
+		INKY_COLOR_WHITE, INKY_COLOR_BLACK, INKY_COLOR_BLACK
+	};
+
+	if (inky_color_available(dev, INKY_COLOR_RED)) {
+		colors[2] = INKY_COLOR_RED;
+	} else if (inky_color_available(dev, INKY_COLOR_YELLOW)) {
+		colors[2] = INKY_COLOR_YELLOW;
+	}
+
+	for (uint16_t y = 0; y < dev->fb->height; y++) {
+		for (uint16_t x = 0; x < dev->fb->width; x++) {
+			inky_color c = colors[munit_rand_int_range(0, 2)];
+
+			munit_assert_int8(inky_fb_set_pixel(dev, x, y, c), ==,
+					  INKY_OK);
+		}
+	}
+}
+
+/** @brief Set a pixel and mark it dirty, as drawing calls do */
+static void dot(inky_config *dev, uint16_t x, uint16_t y, inky_color c)
+{
+	inky_rect r = { x, y, 1, 1 };
+
+	munit_assert_int8(inky_fb_set_pixel(dev, x, y, c), ==, INKY_OK);
+	munit_assert_int8(inky_fb_mark_dirty(dev, &r), ==, INKY_OK);
+}
+
+/** @brief Expected dirty rectangle of a layer area moved by x, y and
+ * clipped to the framebuffer, w and h 0 when nothing is left */
+static inky_rect clipped(const inky_fb *fb, int32_t x, int32_t y,
+			 int32_t w, int32_t h)
+{
+	int32_t x1 = x + w < fb->width ? x + w : fb->width;
+	int32_t y1 = y + h < fb->height ? y + h : fb->height;
+	inky_rect r = { 0, 0, 0, 0 };
+
+	x = x > 0 ? x : 0;
+	y = y > 0 ? y : 0;
+
+	if (x < x1 && y < y1) {
+		r.x = x;
+		r.y = y;
+		r.w = x1 - x;
+		r.h = y1 - y;
+	}
+
+	return r;
+}
+
+static void assert_rect(const inky_rect *r, const inky_rect *want)
+{
+	munit_assert_uint16(r->w, ==, want->w);
+	munit_assert_uint16(r->h, ==, want->h);
+
+	if (want->w) {
+		munit_assert_uint16(r->x, ==, want->x);
+		munit_assert_uint16(r->y, ==, want->y);
+	}
+}
+
+/** @brief Code of the top pixel at x, y that is not see-through, from
+ * layers in stack order over the framebuffer */
+static uint8_t top_code(const inky_fb *fb, const inky_layer *layers,
+			const uint8_t *order, uint16_t x, uint16_t y)
+{
+	uint8_t want = row_code(fb, &fb->buffer[fb->stride * y], x);
+
+	for (uint8_t k = 0; k < N_LAYERS; k++) {
+		const inky_layer *l = &layers[order[k]];
+		int32_t lx = x - l->x;
+		int32_t ly = y - l->y;
+		uint8_t c;
+
+		if (!l->visible || lx < 0 || ly < 0 || lx >= l->fb.width ||
+		    ly >= l->fb.height) {
+			continue;
+		}
+
+		c = row_code(fb, &l->fb.buffer[l->fb.stride * ly], lx);
+
+		if (!l->keyed || c != l->key) {
+			want = c;
+		}
+	}
+
+	return want;
+}
+
+/** @brief Compose random spans of every row over a stack of layers and
+ * check each pixel against the top visible opaque pixel under it */
+static void check_compose(inky_config *dev)
+{
+	static const int8_t z[N_LAYERS] = { 5, -3, 5 };
+	/* Stack order: lowest z first, equal z in the order added */
+	static const uint8_t order[N_LAYERS] = { 1, 0, 2 };
+	inky_fb *fb = dev->fb;
+	inky_layer layers[N_LAYERS];
+	inky_color keys[N_LAYERS] = {
+		INKY_COLOR_WHITE, INKY_COLOR_WHITE, INKY_COLOR_BLACK
+	};
+	uint8_t out[INKY_ROW_STRIDE(fb->width, fb->fmt.bpp)];
+
+	for (uint8_t i = 0; i < N_LAYERS; i++) {
+		inky_layer *l = &layers[i];
+		uint16_t w = fb->width;
+		uint16_t h = fb->height;
+		int16_t x, y;
+
+#ifndef INKY_FIXED_PRODUCT
+		w = munit_rand_int_range(1, fb->width + 40);
+		h = munit_rand_int_range(1, fb->height / 2);
+#endif /* #ifndef INKY_FIXED_PRODUCT */
+
+		/* Layer 0 is opaque */
+		munit_assert_int8(inky_layer_create(dev, l, w, h,
+						    i ? &keys[i] : NULL), ==,
+				  INKY_OK);
+		munit_assert_uint8(l->keyed, ==, i != 0);
+
+		munit_assert_int8(inky_layer_begin(dev, l), ==, INKY_OK);
+		scribble_all(dev);
+		munit_assert_int8(inky_layer_end(dev, l), ==, INKY_OK);
+		munit_assert_ptr_equal(dev->fb, fb);
+
+		x = munit_rand_int_range(-50, fb->width);
+		y = munit_rand_int_range(-50, fb->height);
+
+		munit_assert_int8(inky_layer_move(dev, l, x, y), ==, INKY_OK);
+		munit_assert_int8(inky_layer_add(dev, l, z[i]), ==, INKY_OK);
+	}
+
+	for (uint8_t i = 0; i < N_LAYERS; i++) {
+		munit_assert_ptr_equal(i ? layers[order[i - 1]].next :
+				       fb->layers, &layers[order[i]]);
+	}
+
+	munit_assert_null(layers[order[N_LAYERS - 1]].next);
+
+	scribble_all(dev);
+
+	for (uint8_t pass = 0; pass < 2; pass++) {
+		/* Then again with the top layer hidden */
+		if (pass) {
+			munit_assert_int8(inky_layer_show(dev, &layers[2], 0),
+					  ==, INKY_OK);
+		}
+
+		for (uint16_t y = 0; y < fb->height; y++) {
+			uint16_t x = 0;
+			uint16_t n = fb->width;
+
+			if (y % 2) {
+				x = munit_rand_int_range(0, fb->width - 2);
+				n = munit_rand_int_range(1, fb->width - x);
+			}
+
+			inky_layer_compose_row(fb, y, x, n, out);
+
+			for (uint16_t i = 0; i < n; i++) {
+				munit_assert_uint8(row_code(fb, out, i), ==,
+						   top_code(fb, layers, order,
+							    x + i, y));
+			}
+		}
+	}
+
+	for (uint8_t i = 0; i < N_LAYERS; i++) {
+		munit_assert_int8(inky_layer_remove(dev, &layers[i]), ==,
+				  INKY_OK);
+		munit_assert_int8(inky_layer_free(&layers[i]), ==, INKY_OK);
+	}
+
+	munit_assert_null(fb->layers);
+}
+
+/**
+ * @defgroup layer-compose-test
+ * @{
+ */
+
+MunitResult layer_compose_test(const MunitParameter params[],
+			       void *fixture)
+{
+	INTF(fixture);
+	inky_config *dev = &intf->dev;
+
+	munit_assert_int8(inky_setup(dev), ==, INKY_OK);
+
+	check_compose(dev);
+
+#ifndef INKY_FIXED_COLOR
+	/* Again with the 4bpp format */
+	munit_assert_int8(inky_free(dev), ==, INKY_OK);
+
+	dev->fb_format = INKY_PIXFMT_4BPP;
+
+	munit_assert_int8(inky_setup(dev), ==, INKY_OK);
+
+	check_compose(dev);
+#endif /* #ifndef INKY_FIXED_COLOR */
+
+	return MUNIT_OK;
+}
+
+/**
+ * @}
+ */
+
+/**
+ * @defgroup layer-dirty-test
+ * @{
+ */
+
+MunitResult layer_dirty_test(const MunitParameter params[], void *fixture)
+{
+	INTF(fixture);
+	inky_config *dev = &intf->dev;
+	inky_fb *fb;
+	inky_layer clock;
+	inky_color white = INKY_COLOR_WHITE;
+	inky_rect want;
+	inky_bitmap bm;
+	static const uint8_t bits[] = { 0x03, 0x03 };
+	uint8_t *background;
+	uint16_t w, h;
+
+	munit_assert_int8(inky_setup(dev), ==, INKY_OK);
+	fb = dev->fb;
+	fb->dirty.w = 0;
+	fb->dirty.h = 0;
+
+	w = fb->width;
+	h = fb->height;
+
+#ifndef INKY_FIXED_PRODUCT
+	w = 30;
+	h = 20;
+#endif /* #ifndef INKY_FIXED_PRODUCT */
+
+	munit_assert_int8(inky_layer_create(dev, &clock, w, h, &white), ==,
+			  INKY_OK);
+	munit_assert_int8(inky_layer_move(dev, &clock, 10, 5), ==, INKY_OK);
+
+	/* Moving a layer out of the stack marks nothing until it is in */
+	munit_assert_uint16(fb->dirty.w, ==, 0);
+	munit_assert_int8(inky_layer_add(dev, &clock, 1), ==, INKY_OK);
+	want = clipped(fb, 10, 5, w, h);
+	assert_rect(&fb->dirty, &want);
+
+	/* Drawing into the layer only marks the layer */
+	fb->dirty.w = 0;
+	fb->dirty.h = 0;
+
+	munit_assert_int8(inky_layer_begin(dev, &clock), ==, INKY_OK);
+	dot(dev, 3, 4, INKY_COLOR_BLACK);
+	munit_assert_int8(inky_layer_end(dev, &clock), ==, INKY_OK);
+
+	munit_assert_uint16(fb->dirty.w, ==, 0);
+	want = clipped(&clock.fb, 3, 4, 1, 1);
+	assert_rect(&clock.fb.dirty, &want);
+
+	munit_assert_int8(inky_layer_collect_dirty(dev), ==, INKY_OK);
+	want = clipped(fb, 13, 9, 1, 1);
+	assert_rect(&fb->dirty, &want);
+	munit_assert_uint16(clock.fb.dirty.w, ==, 0);
+
+	/* Blits into the layer, as text is drawn, mark it too */
+	fb->dirty.w = 0;
+	fb->dirty.h = 0;
+
+	bm.type = INKY_BITMAP_MASK;
+	bm.format = clock.fb.fmt.format;
+	bm.width = 2;
+	bm.height = 2;
+	bm.stride = 1;
+	bm.data = bits;
+	bm.color = NULL;
+
+	munit_assert_int8(inky_layer_begin(dev, &clock), ==, INKY_OK);
+	munit_assert_int8(inky_fb_blit(dev, &bm, NULL, 5, 6, INKY_ROP_COPY,
+				       INKY_COLOR_BLACK, INKY_COLOR_WHITE), ==,
+			  INKY_OK);
+	munit_assert_int8(inky_layer_end(dev, &clock), ==, INKY_OK);
+
+	munit_assert_int8(inky_layer_collect_dirty(dev), ==, INKY_OK);
+	want = clipped(fb, 15, 11, 2, 2);
+	assert_rect(&fb->dirty, &want);
+
+	/* Moving marks where it was and where it is */
+	fb->dirty.w = 0;
+	fb->dirty.h = 0;
+
+	munit_assert_int8(inky_layer_move(dev, &clock, -5, -2), ==, INKY_OK);
+	want = clipped(fb, 0, 0, 10 + w, 5 + h);
+	assert_rect(&fb->dirty, &want);
+
+	/* Changes to a hidden layer wait until it is shown */
+	fb->dirty.w = 0;
+	fb->dirty.h = 0;
+
+	munit_assert_int8(inky_layer_show(dev, &clock, 0), ==, INKY_OK);
+	want = clipped(fb, -5, -2, w, h);
+	assert_rect(&fb->dirty, &want);
+
+	fb->dirty.w = 0;
+	fb->dirty.h = 0;
+
+	munit_assert_int8(inky_layer_show(dev, &clock, 0), ==, INKY_OK);
+	munit_assert_int8(inky_layer_begin(dev, &clock), ==, INKY_OK);
+	dot(dev, 8, 8, INKY_COLOR_BLACK);
+	munit_assert_int8(inky_layer_end(dev, &clock), ==, INKY_OK);
+	munit_assert_int8(inky_layer_collect_dirty(dev), ==, INKY_OK);
+	munit_assert_uint16(fb->dirty.w, ==, 0);
+	munit_assert_uint16(clock.fb.dirty.w, ==, 0);
+
+	munit_assert_int8(inky_layer_show(dev, &clock, 1), ==, INKY_OK);
+	assert_rect(&fb->dirty, &want);
+
+	/* Updating the clock sends it without touching the background */
+	background = malloc(fb->bytes);
+	munit_assert_not_null(background);
+	memcpy(background, fb->buffer, fb->bytes);
+
+	munit_assert_int8(inky_update(dev), ==, INKY_OK);
+	munit_assert_uint16(fb->dirty.w, ==, 0);
+
+	munit_assert_int8(inky_layer_begin(dev, &clock), ==, INKY_OK);
+	dot(dev, 9, 9, INKY_COLOR_BLACK);
+	munit_assert_int8(inky_layer_end(dev, &clock), ==, INKY_OK);
+	munit_assert_int8(inky_update_dirty(dev), ==, INKY_OK);
+	munit_assert_uint16(fb->dirty.w, ==, 0);
+	munit_assert_uint16(clock.fb.dirty.w, ==, 0);
+	munit_assert_memory_equal(fb->bytes, fb->buffer, background);
+
+	/* inky_update() sends the layers too */
+	munit_assert_int8(inky_layer_begin(dev, &clock), ==, INKY_OK);
+	dot(dev, 9, 9, INKY_COLOR_WHITE);
+	munit_assert_int8(inky_layer_end(dev, &clock), ==, INKY_OK);
+	munit_assert_int8(inky_update(dev), ==, INKY_OK);
+	munit_assert_uint16(clock.fb.dirty.w, ==, 0);
+
+	free(background);
+
+	/* Removing marks its area */
+	munit_assert_int8(inky_layer_remove(dev, &clock), ==, INKY_OK);
+	assert_rect(&fb->dirty, &want);
+	munit_assert_null(fb->layers);
+	munit_assert_int8(inky_layer_free(&clock), ==, INKY_OK);
+
+	return MUNIT_OK;
+}
+
+/**
+ * @}
+ */
+
+/**
+ * @defgroup layer-args-test
+ * @{
+ */
+
+MunitResult layer_args_test(const MunitParameter params[], void *fixture)
+{
+	INTF(fixture);
+	inky_config *dev = &intf->dev;
+	inky_layer layer;
+	inky_layer other;
+	inky_color missing = INKY_COLOR_RED;
+	uint8_t out[4];
+
+	munit_assert_int8(inky_layer_create(dev, &layer, 8, 8, NULL), ==,
+			  INKY_E_NOT_CONFIGURED);
+	munit_assert_int8(inky_layer_collect_dirty(dev), ==,
+			  INKY_E_NOT_CONFIGURED);
+
+	munit_assert_int8(inky_setup(dev), ==, INKY_OK);
+
+	if (inky_color_available(dev, INKY_COLOR_RED)) {
+		missing = INKY_COLOR_YELLOW;
+	}
+
+	munit_assert_int8(inky_layer_create(dev, NULL, 8, 8, NULL), ==,
+			  INKY_E_NULL_PTR);
+	munit_assert_int8(inky_layer_create(dev, &layer, 0, 8, NULL), ==,
+			  INKY_E_OUT_OF_RANGE);
+	munit_assert_int8(inky_layer_create(dev, &layer, 8, 0, NULL), ==,
+			  INKY_E_OUT_OF_RANGE);
+	munit_assert_int8(inky_layer_create(dev, &layer, dev->fb->width,
+					    dev->fb->height, &missing), ==,
+			  INKY_E_NOT_AVAILABLE);
+
+#ifdef INKY_FIXED_PRODUCT
+	munit_assert_int8(inky_layer_create(dev, &layer, 8, 8, NULL), ==,
+			  INKY_E_NOT_AVAILABLE);
+#endif /* #ifdef INKY_FIXED_PRODUCT */
+
+	munit_assert_int8(inky_layer_create(dev, &layer, dev->fb->width,
+					    dev->fb->height, NULL), ==,
+			  INKY_OK);
+	munit_assert_int8(inky_layer_create(dev, &other, dev->fb->width,
+					    dev->fb->height, NULL), ==,
+			  INKY_OK);
+
+	/* Opaque layers start out white */
+	munit_assert_int8(inky_layer_begin(dev, &layer), ==, INKY_OK);
+
+	for (uint16_t y = 0; y < dev->fb->height; y += 7) {
+		for (uint16_t x = 0; x < dev->fb->width; x += 5) {
+			inky_color c;
+
+			munit_assert_int8(inky_fb_get_pixel(dev, x, y, &c), ==,
+					  INKY_OK);
+			munit_assert_int(c, ==, INKY_COLOR_WHITE);
+		}
+	}
+
+	munit_assert_int8(inky_layer_begin(dev, &layer), ==,
+			  INKY_E_OUT_OF_RANGE);
+	munit_assert_int8(inky_layer_end(dev, &other), ==,
+			  INKY_E_OUT_OF_RANGE);
+	munit_assert_int8(inky_layer_end(dev, &layer), ==, INKY_OK);
+	munit_assert_int8(inky_layer_end(dev, &layer), ==,
+			  INKY_E_OUT_OF_RANGE);
+
+	munit_assert_int8(inky_layer_add(dev, NULL, 0), ==, INKY_E_NULL_PTR);
+	munit_assert_int8(inky_layer_remove(dev, NULL), ==, INKY_E_NULL_PTR);
+	munit_assert_int8(inky_layer_move(dev, NULL, 0, 0), ==,
+			  INKY_E_NULL_PTR);
+	munit_assert_int8(inky_layer_show(dev, NULL, 1), ==, INKY_E_NULL_PTR);
+	munit_assert_int8(inky_layer_begin(dev, NULL), ==, INKY_E_NULL_PTR);
+	munit_assert_int8(inky_layer_end(dev, NULL), ==, INKY_E_NULL_PTR);
+	munit_assert_int8(inky_layer_free(NULL), ==, INKY_E_NULL_PTR);
+
+	munit_assert_int8(inky_layer_remove(dev, &layer), ==,
+			  INKY_E_OUT_OF_RANGE);
+
+	/* Adding twice moves the layer instead of linking it again */
+	munit_assert_int8(inky_layer_add(dev, &layer, 0), ==, INKY_OK);
+	munit_assert_int8(inky_layer_add(dev, &other, 1), ==, INKY_OK);
+	munit_assert_int8(inky_layer_add(dev, &layer, 2), ==, INKY_OK);
+	munit_assert_ptr_equal(dev->fb->layers, &other);
+	munit_assert_ptr_equal(other.next, &layer);
+	munit_assert_null(layer.next);
+
+	/* An opaque layer over the whole framebuffer hides it */
+	inky_layer_compose_row(dev->fb, 0, 0, 8, out);
+
+	for (uint8_t i = 0; i < 8; i++) {
+		munit_assert_uint8(row_code(dev->fb, out, i), ==, layer.key);
+	}
+
+	munit_assert_int8(inky_layer_remove(dev, &layer), ==, INKY_OK);
+	munit_assert_int8(inky_layer_remove(dev, &other), ==, INKY_OK);
+	munit_assert_int8(inky_layer_free(&layer), ==, INKY_OK);
+	munit_assert_int8(inky_layer_free(&other), ==, INKY_OK);
+	munit_assert_null(layer.fb.buffer);
+
+	return MUNIT_OK;
+}
+
+/**
+ * @}
+ */
+
+MunitTest layer_tests[] = {
+	{
+		.name = "/layer-compose-test",
+		.test = layer_compose_test,
+		.setup = device_setup,
+		.tear_down = device_tear_down,
+		.options = MUNIT_TEST_OPTION_NONE,
+		.parameters = fb_test_params
+	},
+
+	{
+		.name = "/layer-dirty-test",
+		.test = layer_dirty_test,
+		.setup = device_setup,
+		.tear_down = device_tear_down,
+		.options = MUNIT_TEST_OPTION_NONE,
+		.parameters = fb_test_params
+	},
+
+	{
+		.name = "/layer-args-test",
+		.test = layer_args_test,
+		.setup = device_setup,
+		.tear_down = device_tear_down,
+		.options = MUNIT_TEST_OPTION_NONE,
+		.parameters = fb_test_params
+	},
+
+	{
+		.name = NULL,
+		.test = NULL,
+		.setup = NULL,
+		.tear_down = NULL,
+		.options = MUNIT_TEST_OPTION_NONE,
+		.parameters = NULL
+	}
+};
+
+/**
+ * @}
+ * defgroup pimoroni-inky-layer-tests
+ */
@@ -0,0 +1,1494 @@
+/**
+ * @file orient-test.c
+ *
+ * Unit testing for the framebuffer orientations, viewports, scaling,
+ * layers and band rendering of the Pimoroni Inky driver
+ */
+
+#include "inky.h"
+
+#include <munit/munit.h>
+
+#include "test-device.h"
+
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+/**
+ * @defgroup pimoroni-inky-orient-tests Pimoroni Inky orientation
+ * testing suites
+ * @{
+ */
+
+/*
+**********************************************************************
+************************** TESTS DEFINITIONS *************************
+**********************************************************************
+*/
+
+/** @brief Panel RAM as the controller fills it from the commands sent
+    @var dc Level of the DC pin, low for command bytes
+    @var cmd Last command, n the data bytes since
+    @var mode Data entry mode, bit 0 set while X increments
+    @var tb Gate scan from the bottom
+    @var x, y RAM address pointers
+    @var bw, color RAM planes, stride bytes a row
+    @var bad Writes outside the RAM
+    @var writes Bytes written to the RAM planes
+    @var refreshes Display updates triggered
+**/
+struct ram {
+	uint8_t dc;
+	uint8_t cmd;
+	uint32_t n;
+	uint8_t mode;
+	uint8_t tb;
+	uint8_t x;
+	uint16_t y;
+	uint16_t width;
+	uint16_t height;
+	uint16_t stride;
+	uint8_t *bw;
+	uint8_t *color;
+	uint32_t bad;
+	uint32_t writes;
+	uint32_t refreshes;
+};
+
+static inky_error_state ram_gpio_output(inky_pin pin, inky_pin_state state,
+					void *intf_ptr)
+{
+	INTF(intf_ptr);
+	struct ram *ram = intf->usrptr;
+
+	if (pin == INKY_PIN_DC) {
+		ram->dc = state == INKY_PINSTATE_HIGH;
+	}
+
+	return INKY_OK;
+}
+
+static void ram_data(struct ram *ram, uint8_t b)
+{
+	uint8_t *plane;
+
+	switch (ram->cmd) {
+	case 0x01:
+		if (ram->n == 2) {
+			ram->tb = b & 0x01;
+		}
+		break;
+	case 0x11:
+		ram->mode = b;
+		break;
+	case 0x4e:
+		ram->x = b;
+		break;
+	case 0x4f:
+		ram->y = ram->n ? (ram->y & 0x00ff) | b << 8 :
+			(ram->y & 0xff00) | b;
+		break;
+	case 0x24:
+	case 0x26:
+		plane = ram->cmd == 0x24 ? ram->bw : ram->color;
+
+		if (ram->x >= ram->stride || ram->y >= ram->height) {
+			ram->bad++;
+		} else {
+			plane[ram->stride * ram->y + ram->x] = b;
+		}
+
+		ram->x += ram->mode & 0x01 ? 1 : -1;
+		ram->writes++;
+		break;
+	}
+
+	ram->n++;
+}
+
+static inky_error_state ram_spi_write(const uint8_t *buf, uint32_t len,
+				      void *intf_ptr)
+{
+	INTF(intf_ptr);
+	struct ram *ram = intf->usrptr;
+
+	for (uint32_t i = 0; i < len; i++) {
+		if (ram->dc) {
+			ram_data(ram, buf[i]);
+			continue;
+		}
+
+		ram->cmd = buf[i];
+		ram->n = 0;
+
+		ram->refreshes += ram->cmd == 0x20;
+
+		/* Soft reset restores the entry mode and scan direction */
+		if (ram->cmd == 0x12) {
+			ram->mode = 0x03;
+			ram->tb = 0;
+		}
+	}
+
+	return INKY_OK;
+}
+
+/** @brief Color the panel shows at px, py */
+static inky_color ram_shown(const struct ram *ram, const inky_config *dev,
+			    uint16_t px, uint16_t py)
+{
+	uint16_t row = ram->tb ? ram->height - 1 - py : py;
+	uint32_t at = (uint32_t) ram->stride * row + px / 8;
+	uint8_t bit = 0x80 >> (px % 8);
+
+	if (ram->color[at] & bit) {
+		return dev->color->red ? INKY_COLOR_RED : INKY_COLOR_YELLOW;
+	}
+
+	return ram->bw[at] & bit ? INKY_COLOR_WHITE : INKY_COLOR_BLACK;
+}
+
+/** @brief Panel pixel showing pixel x, y of a w by h framebuffer:
+ * mirrored first, then turned clockwise */
+static void panel_of(uint8_t orientation, uint16_t w, uint16_t h,
+		     uint16_t x, uint16_t y, uint16_t *px, uint16_t *py)
+{
+	uint16_t mx = orientation & INKY_ORIENT_MIRROR ? w - 1 - x : x;
+
+	switch (orientation & INKY_ORIENT_270) {
+	case INKY_ORIENT_0:
+		*px = mx;
+		*py = y;
+		break;
+	case INKY_ORIENT_90:
+		*px = h - 1 - y;
+		*py = mx;
+		break;
+	case INKY_ORIENT_180:
+		*px = w - 1 - mx;
+		*py = h - 1 - y;
+		break;
+	default:
+		*px = y;
+		*py = w - 1 - mx;
+		break;
+	}
+}
+
+/** @brief Check every panel pixel shows the pixel of the viewport its
+ * orientation and scale put there */
+static void assert_shown(struct test_intf *intf, const struct ram *ram)
+{
+	inky_config *dev = &intf->dev;
+	inky_fb *fb = dev->fb;
+	uint8_t turned = fb->orientation & INKY_ORIENT_90;
+	uint16_t w = turned ? dev->panel->height : dev->panel->width;
+	uint16_t h = turned ? dev->panel->width : dev->panel->height;
+
+	munit_assert_uint32(ram->bad, ==, 0);
+
+	for (uint16_t y = 0; y < h; y++) {
+		for (uint16_t x = 0; x < w; x++) {
+			inky_color c;
+			uint16_t px, py;
+
+			panel_of(fb->orientation, w, h, x, y, &px, &py);
+			munit_assert_int8(inky_fb_get_pixel(dev,
+							    fb->view_x +
+							    x / fb->scale,
+							    fb->view_y +
+							    y / fb->scale,
+							    &c), ==, INKY_OK);
+			munit_assert_int(ram_shown(ram, dev, px, py), ==, c);
+		}
+	}
+}
+
+/** @brief Random pixels over a rectangle of the framebuffer */
+static void scribble(inky_config *dev, const inky_rect *area)
+{
+	inky_color colors[3] = {
+		INKY_COLOR_WHITE, INKY_COLOR_BLACK, INKY_COLOR_BLACK
+	};
+
+	if (inky_color_available(dev, INKY_COLOR_RED)) {
+		colors[2] = INKY_COLOR_RED;
+	} else if (inky_color_available(dev, INKY_COLOR_YELLOW)) {
+		colors[2] = INKY_COLOR_YELLOW;
+	}
+
+	for (uint16_t y = area->y; y < area->y + area->h; y++) {
+		for (uint16_t x = area->x; x < area->x + area->w; x++) {
+			inky_color c = colors[munit_rand_int_range(0, 2)];
+
+			munit_assert_int8(inky_fb_set_pixel(dev, x, y, c), ==,
+					  INKY_OK);
+		}
+	}
+}
+
+static void *orient_setup(const MunitParameter params[], void *user_data)
+{
+	INTF(user_data);
+	struct ram *ram;
+
+	device_setup(params, user_data);
+	munit_assert_int8(inky_setup(&intf->dev), ==, INKY_OK);
+
+	ram = calloc(1, sizeof(*ram));
+	munit_assert_not_null(ram);
+
+	ram->width = intf->dev.panel->width;
+	ram->height = intf->dev.panel->height;
+	ram->stride = intf->dev.panel->row_stride ?
+		intf->dev.panel->row_stride : (ram->width + 7) / 8;
+	ram->mode = 0x03;
+	ram->bw = calloc(ram->stride, ram->height);
+	ram->color = calloc(ram->stride, ram->height);
+	munit_assert_not_null(ram->bw);
+	munit_assert_not_null(ram->color);
+
+	intf->usrptr = ram;
+	intf->dev.gpio_output_cb = ram_gpio_output;
+	intf->dev.spi_write_cb = ram_spi_write;
+
+	return user_data;
+}
+
+static void orient_tear_down(void *fixture)
+{
+	INTF(fixture);
+	struct ram *ram = intf->usrptr;
+
+	free(ram->bw);
+	free(ram->color);
+	free(ram);
+
+	device_tear_down(fixture);
+}
+
+/**
+ * @defgroup orient-test
+ * @{
+ */
+
+MunitResult orient_test(const MunitParameter params[], void *fixture)
+{
+	INTF(fixture);
+	inky_config *dev = &intf->dev;
+	struct ram *ram = intf->usrptr;
+	uint16_t pw = dev->panel->width;
+	uint16_t ph = dev->panel->height;
+
+	for (uint8_t o = 0; o <= (INKY_ORIENT_270 | INKY_ORIENT_MIRROR); o++) {
+		uint8_t turned = o & INKY_ORIENT_90;
+		inky_rect all;
+
+		dev->fb->dirty.w = 0;
+		dev->fb->dirty.h = 0;
+
+#ifdef INKY_FIXED_PRODUCT
+		if (turned) {
+			munit_assert_int8(inky_fb_set_orientation(dev, o), ==,
+					  INKY_E_NOT_AVAILABLE);
+			continue;
+		}
+#endif /* #ifdef INKY_FIXED_PRODUCT */
+
+		munit_assert_int8(inky_fb_set_orientation(dev, o), ==,
+				  INKY_OK);
+		munit_assert_uint8(dev->fb->orientation, ==, o);
+		munit_assert_uint16(dev->fb->width, ==, turned ? ph : pw);
+		munit_assert_uint16(dev->fb->height, ==, turned ? pw : ph);
+
+		/* The whole framebuffer moves on the panel */
+		munit_assert_uint16(dev->fb->dirty.w, ==, dev->fb->width);
+		munit_assert_uint16(dev->fb->dirty.h, ==, dev->fb->height);
+
+		all.x = 0;
+		all.y = 0;
+		all.w = dev->fb->width;
+		all.h = dev->fb->height;
+
+		scribble(dev, &all);
+		munit_assert_int8(inky_update(dev), ==, INKY_OK);
+		assert_shown(intf, ram);
+	}
+
+	return MUNIT_OK;
+}
+
+/**
+ * @}
+ * defgroup orient-test
+ */
+
+/**
+ * @defgroup orient-region-test
+ * @{
+ */
+
+MunitResult orient_region_test(const MunitParameter params[],
+			       void *fixture)
+{
+	INTF(fixture);
+	inky_config *dev = &intf->dev;
+	struct ram *ram = intf->usrptr;
+
+	for (uint8_t o = 0; o <= (INKY_ORIENT_270 | INKY_ORIENT_MIRROR); o++) {
+		inky_rect all;
+
+#ifdef INKY_FIXED_PRODUCT
+		if (o & INKY_ORIENT_90) {
+			continue;
+		}
+#endif /* #ifdef INKY_FIXED_PRODUCT */
+
+		munit_assert_int8(inky_fb_set_orientation(dev, o), ==,
+				  INKY_OK);
+
+		all.x = 0;
+		all.y = 0;
+		all.w = dev->fb->width;
+		all.h = dev->fb->height;
+
+		scribble(dev, &all);
+		munit_assert_int8(inky_update(dev), ==, INKY_OK);
+
+		/* Rectangles at odd offsets only resend what they cover,
+		 * whole bytes of the panel rows they cross */
+		for (uint8_t i = 0; i < 6; i++) {
+			inky_rect area;
+
+			/* munit_rand_int_range() fails when min equals max */
+			area.x = munit_rand_int_range(0, all.w - 2);
+			area.y = munit_rand_int_range(0, all.h - 2);
+			area.w = munit_rand_int_range(1, all.w - area.x);
+			area.h = munit_rand_int_range(1, all.h - area.y);
+
+			scribble(dev, &area);
+			munit_assert_int8(inky_update_region(dev, &area), ==,
+					  INKY_OK);
+			assert_shown(intf, ram);
+		}
+	}
+
+	return MUNIT_OK;
+}
+
+/**
+ * @}
+ * defgroup orient-region-test
+ */
+
+/**
+ * @defgroup orient-args-test
+ * @{
+ */
+
+MunitResult orient_args_test(const MunitParameter params[], void *fixture)
+{
+	INTF(fixture);
+	inky_config *dev = &intf->dev;
+	inky_fb *fb = dev->fb;
+	inky_color c;
+
+	munit_assert_int8(inky_fb_set_orientation(dev, 8), ==,
+			  INKY_E_OUT_OF_RANGE);
+	munit_assert_uint8(fb->orientation, ==, INKY_ORIENT_0);
+
+	/* Half turns keep the picture */
+	munit_assert_int8(inky_fb_set_pixel(dev, 3, 5, INKY_COLOR_BLACK), ==,
+			  INKY_OK);
+	munit_assert_int8(inky_fb_set_orientation(dev, INKY_ORIENT_180), ==,
+			  INKY_OK);
+	munit_assert_int8(inky_fb_get_pixel(dev, 3, 5, &c), ==, INKY_OK);
+	munit_assert_int(c, ==, INKY_COLOR_BLACK);
+
+#ifndef INKY_FIXED_PRODUCT
+	/* Quarter turns resize, clear and check in turned coordinates */
+	munit_assert_int8(inky_fb_set_orientation(dev, INKY_ORIENT_270), ==,
+			  INKY_OK);
+	munit_assert_int8(inky_fb_get_pixel(dev, 3, 5, &c), ==, INKY_OK);
+	munit_assert_int(c, ==, INKY_COLOR_WHITE);
+	munit_assert_int8(inky_fb_set_pixel(dev, dev->panel->height - 1,
+					    dev->panel->width - 1,
+					    INKY_COLOR_BLACK), ==, INKY_OK);
+	munit_assert_int8(inky_fb_set_pixel(dev, dev->panel->height, 0,
+					    INKY_COLOR_BLACK), ==,
+			  INKY_E_OUT_OF_RANGE);
+#endif /* #ifndef INKY_FIXED_PRODUCT */
+
+	inky_free(dev);
+
+	munit_assert_int8(inky_fb_set_orientation(dev, INKY_ORIENT_0), ==,
+			  INKY_E_NOT_CONFIGURED);
+
+	return MUNIT_OK;
+}
+
+/**
+ * @}
+ * defgroup orient-args-test
+ */
+
+/**
+ * @defgroup viewport-test
+ * @{
+ */
+
+MunitResult viewport_test(const MunitParameter params[], void *fixture)
+{
+	INTF(fixture);
+	inky_config *dev = &intf->dev;
+	inky_fb *fb = dev->fb;
+	struct ram *ram = intf->usrptr;
+	static const uint8_t orientations[] = {
+		INKY_ORIENT_0, INKY_ORIENT_180 | INKY_ORIENT_MIRROR,
+		INKY_ORIENT_90
+	};
+
+	for (uint8_t k = 0; k < 3; k++) {
+		uint8_t o = orientations[k];
+		uint16_t vw, vh;
+		inky_rect all;
+		uint32_t writes;
+		uint32_t refreshes;
+
+#ifdef INKY_FIXED_PRODUCT
+		if (o & INKY_ORIENT_90) {
+			continue;
+		}
+#endif /* #ifdef INKY_FIXED_PRODUCT */
+
+		munit_assert_int8(inky_fb_set_orientation(dev, o), ==,
+				  INKY_OK);
+
+		vw = o & INKY_ORIENT_90 ? dev->panel->height :
+			dev->panel->width;
+		vh = o & INKY_ORIENT_90 ? dev->panel->width :
+			dev->panel->height;
+
+#ifdef INKY_FIXED_PRODUCT
+		munit_assert_int8(inky_fb_set_canvas(dev, vw + 9, vh), ==,
+				  INKY_E_NOT_AVAILABLE);
+		munit_assert_int8(inky_fb_set_canvas(dev, vw, vh), ==,
+				  INKY_OK);
+#else
+		munit_assert_int8(inky_fb_set_canvas(dev, 2 * vw + 9,
+						     vh + 21), ==, INKY_OK);
+#endif /* #ifdef INKY_FIXED_PRODUCT */
+
+		all.x = 0;
+		all.y = 0;
+		all.w = fb->width;
+		all.h = fb->height;
+
+		scribble(dev, &all);
+
+		/* Panning only marks the new window dirty */
+		for (uint8_t i = 0; i < 4; i++) {
+			uint16_t x = 0;
+			uint16_t y = 0;
+
+			if (fb->width > vw) {
+				x = munit_rand_int_range(0, fb->width - vw);
+				y = munit_rand_int_range(0, fb->height - vh);
+			}
+
+			fb->dirty.w = 0;
+			fb->dirty.h = 0;
+
+			munit_assert_int8(inky_fb_set_viewport(dev, x, y), ==,
+					  INKY_OK);
+			munit_assert_uint16(fb->view_x, ==, x);
+			munit_assert_uint16(fb->view_y, ==, y);
+			munit_assert_uint16(fb->dirty.x, ==, x);
+			munit_assert_uint16(fb->dirty.y, ==, y);
+			munit_assert_uint16(fb->dirty.w, ==, vw);
+			munit_assert_uint16(fb->dirty.h, ==, vh);
+
+			munit_assert_int8(inky_update_dirty(dev), ==, INKY_OK);
+			assert_shown(intf, ram);
+		}
+
+		/* Changes off the viewport are not sent */
+		if (fb->view_x > 0) {
+			munit_assert_int8(inky_fb_set_pixel(dev, 0, 0,
+							    INKY_COLOR_BLACK),
+					  ==, INKY_OK);
+			all.w = 1;
+			all.h = 1;
+			munit_assert_int8(inky_fb_mark_dirty(dev, &all), ==,
+					  INKY_OK);
+
+			writes = ram->writes;
+			refreshes = ram->refreshes;
+			munit_assert_int8(inky_update_dirty(dev), ==, INKY_OK);
+			munit_assert_uint32(ram->writes, ==, writes);
+			munit_assert_uint32(ram->refreshes, ==, refreshes);
+			munit_assert_uint16(fb->dirty.w, ==, 0);
+		}
+
+		/* Regions straddling the viewport send the part inside */
+		all.x = fb->view_x > 3 ? fb->view_x - 3 : 0;
+		all.y = fb->view_y + 1;
+		all.w = vw / 2;
+		all.h = vh - 1;
+
+		scribble(dev, &all);
+		munit_assert_int8(inky_update_region(dev, &all), ==, INKY_OK);
+		assert_shown(intf, ram);
+	}
+
+	return MUNIT_OK;
+}
+
+/**
+ * @}
+ * defgroup viewport-test
+ */
+
+/**
+ * @defgroup viewport-args-test
+ * @{
+ */
+
+MunitResult viewport_args_test(const MunitParameter params[],
+			       void *fixture)
+{
+	INTF(fixture);
+	inky_config *dev = &intf->dev;
+	uint16_t pw = dev->panel->width;
+	uint16_t ph = dev->panel->height;
+	inky_color c;
+
+	/* The canvas covers at least the panel */
+	munit_assert_int8(inky_fb_set_canvas(dev, pw - 1, ph), ==,
+			  INKY_E_OUT_OF_RANGE);
+	munit_assert_int8(inky_fb_set_canvas(dev, pw, ph - 1), ==,
+			  INKY_E_OUT_OF_RANGE);
+	munit_assert_int8(inky_fb_set_viewport(dev, 1, 0), ==,
+			  INKY_E_OUT_OF_RANGE);
+	munit_assert_int8(inky_fb_set_viewport(dev, 0, 0), ==, INKY_OK);
+
+	/* Setting the canvas clears it */
+	munit_assert_int8(inky_fb_set_pixel(dev, 1, 2, INKY_COLOR_BLACK), ==,
+			  INKY_OK);
+	munit_assert_int8(inky_fb_set_canvas(dev, pw, ph), ==, INKY_OK);
+	munit_assert_int8(inky_fb_get_pixel(dev, 1, 2, &c), ==, INKY_OK);
+	munit_assert_int(c, ==, INKY_COLOR_WHITE);
+
+#ifndef INKY_FIXED_PRODUCT
+	munit_assert_int8(inky_fb_set_canvas(dev, 500, 500), ==, INKY_OK);
+	munit_assert_uint16(dev->fb->width, ==, 500);
+	munit_assert_uint16(dev->fb->height, ==, 500);
+	munit_assert_int8(inky_fb_set_pixel(dev, 499, 499, INKY_COLOR_BLACK),
+			  ==, INKY_OK);
+	munit_assert_int8(inky_fb_set_viewport(dev, 500 - pw, 500 - ph), ==,
+			  INKY_OK);
+	munit_assert_int8(inky_fb_set_viewport(dev, 501 - pw, 0), ==,
+			  INKY_E_OUT_OF_RANGE);
+	munit_assert_int8(inky_fb_set_viewport(dev, 0, 501 - ph), ==,
+			  INKY_E_OUT_OF_RANGE);
+
+	/* Turning keeps a canvas that still covers the panel, and pulls
+	 * the viewport back inside it */
+	munit_assert_int8(inky_fb_set_orientation(dev, INKY_ORIENT_90), ==,
+			  INKY_OK);
+	munit_assert_uint16(dev->fb->width, ==, 500);
+	munit_assert_int8(inky_fb_get_pixel(dev, 499, 499, &c), ==, INKY_OK);
+	munit_assert_int(c, ==, INKY_COLOR_BLACK);
+	munit_assert_uint16(dev->fb->view_x, ==,
+			    500 - pw < 500 - ph ? 500 - pw : 500 - ph);
+	munit_assert_uint16(dev->fb->view_y, ==,
+			    500 - ph < 500 - pw ? 500 - ph : 500 - pw);
+#endif /* #ifndef INKY_FIXED_PRODUCT */
+
+	inky_free(dev);
+
+	munit_assert_int8(inky_fb_set_canvas(dev, pw, ph), ==,
+			  INKY_E_NOT_CONFIGURED);
+	munit_assert_int8(inky_fb_set_viewport(dev, 0, 0), ==,
+			  INKY_E_NOT_CONFIGURED);
+
+	return MUNIT_OK;
+}
+
+/**
+ * @}
+ * defgroup viewport-args-test
+ */
+
+/**
+ * @defgroup upscale-test
+ * @{
+ */
+
+MunitResult upscale_test(const MunitParameter params[], void *fixture)
+{
+	INTF(fixture);
+	inky_config *dev = &intf->dev;
+	inky_fb *fb = dev->fb;
+	struct ram *ram = intf->usrptr;
+	static const uint8_t orientations[] = {
+		INKY_ORIENT_0, INKY_ORIENT_90 | INKY_ORIENT_MIRROR,
+		INKY_ORIENT_180, INKY_ORIENT_270
+	};
+
+	for (uint8_t scale = 1; scale <= 4; scale *= 2) {
+		for (uint8_t k = 0; k < 4; k++) {
+			uint8_t o = orientations[k];
+			uint8_t turned = o & INKY_ORIENT_90;
+			uint16_t pw = turned ? dev->panel->height :
+				dev->panel->width;
+			uint16_t ph = turned ? dev->panel->width :
+				dev->panel->height;
+			inky_rect all;
+
+#ifdef INKY_FIXED_PRODUCT
+			if (turned) {
+				continue;
+			}
+
+			if (scale > 1) {
+				munit_assert_int8(inky_fb_set_scale(dev, scale),
+						  ==, INKY_E_NOT_AVAILABLE);
+				continue;
+			}
+#endif /* #ifdef INKY_FIXED_PRODUCT */
+
+			munit_assert_int8(inky_fb_set_orientation(dev, o), ==,
+					  INKY_OK);
+			munit_assert_int8(inky_fb_set_scale(dev, scale), ==,
+					  INKY_OK);
+			munit_assert_uint16(fb->width, ==,
+					    (pw + scale - 1) / scale);
+			munit_assert_uint16(fb->height, ==,
+					    (ph + scale - 1) / scale);
+
+			all.x = 0;
+			all.y = 0;
+			all.w = fb->width;
+			all.h = fb->height;
+
+			scribble(dev, &all);
+			munit_assert_int8(inky_update(dev), ==, INKY_OK);
+			assert_shown(intf, ram);
+
+			/* Regions cover whole blocks of panel pixels */
+			for (uint8_t i = 0; i < 3; i++) {
+				inky_rect area;
+
+				area.x = munit_rand_int_range(0, all.w - 2);
+				area.y = munit_rand_int_range(0, all.h - 2);
+				area.w = munit_rand_int_range(1,
+							      all.w - area.x);
+				area.h = munit_rand_int_range(1,
+							      all.h - area.y);
+
+				scribble(dev, &area);
+				munit_assert_int8(inky_update_region(dev,
+								     &area),
+						  ==, INKY_OK);
+				assert_shown(intf, ram);
+			}
+
+#ifndef INKY_FIXED_PRODUCT
+			/* And pan over a scaled canvas */
+			munit_assert_int8(inky_fb_set_canvas(dev, all.w + 13,
+							     all.h + 7), ==,
+					  INKY_OK);
+			all.w = fb->width;
+			all.h = fb->height;
+			scribble(dev, &all);
+			munit_assert_int8(inky_fb_set_viewport(dev, 13, 5), ==,
+					  INKY_OK);
+			munit_assert_int8(inky_update_dirty(dev), ==, INKY_OK);
+			assert_shown(intf, ram);
+#endif /* #ifndef INKY_FIXED_PRODUCT */
+		}
+	}
+
+	return MUNIT_OK;
+}
+
+/**
+ * @}
+ * defgroup upscale-test
+ */
+
+/**
+ * @defgroup upscale-args-test
+ * @{
+ */
+
+MunitResult upscale_args_test(const MunitParameter params[],
+			      void *fixture)
+{
+	INTF(fixture);
+	inky_config *dev = &intf->dev;
+	inky_color c;
+
+	munit_assert_int8(inky_fb_set_scale(dev, 0), ==, INKY_E_OUT_OF_RANGE);
+	munit_assert_int8(inky_fb_set_scale(dev, 3), ==, INKY_E_OUT_OF_RANGE);
+	munit_assert_int8(inky_fb_set_scale(dev, 8), ==, INKY_E_OUT_OF_RANGE);
+	munit_assert_uint8(dev->fb->scale, ==, 1);
+
+	/* Setting the scale clears the framebuffer */
+	munit_assert_int8(inky_fb_set_pixel(dev, 1, 2, INKY_COLOR_BLACK), ==,
+			  INKY_OK);
+	munit_assert_int8(inky_fb_set_scale(dev, 1), ==, INKY_OK);
+	munit_assert_int8(inky_fb_get_pixel(dev, 1, 2, &c), ==, INKY_OK);
+	munit_assert_int(c, ==, INKY_COLOR_WHITE);
+
+#ifndef INKY_FIXED_PRODUCT
+	/* The canvas must still cover the scaled panel */
+	munit_assert_int8(inky_fb_set_scale(dev, 4), ==, INKY_OK);
+	munit_assert_int8(inky_fb_set_canvas(dev, dev->fb->width - 1,
+					     dev->fb->height), ==,
+			  INKY_E_OUT_OF_RANGE);
+	munit_assert_int8(inky_fb_set_pixel(dev, dev->fb->width, 0,
+					    INKY_COLOR_BLACK), ==,
+			  INKY_E_OUT_OF_RANGE);
+#endif /* #ifndef INKY_FIXED_PRODUCT */
+
+	inky_free(dev);
+
+	munit_assert_int8(inky_fb_set_scale(dev, 2), ==,
+			  INKY_E_NOT_CONFIGURED);
+
+	return MUNIT_OK;
+}
+
+/**
+ * @}
+ * defgroup upscale-args-test
+ */
+
+/**
+ * @defgroup layer-pack-test
+ * @{
+ */
+
+/** @brief Check the panel shows the layers of the framebuffer drawn
+ * over it in stack order with the blitter */
+static void assert_composed(struct test_intf *intf, const struct ram *ram,
+			    const inky_color *keys)
+{
+	inky_config *dev = &intf->dev;
+	inky_fb *fb = dev->fb;
+	inky_rect dirty = fb->dirty;
+	uint8_t *saved = malloc(fb->bytes);
+
+	munit_assert_not_null(saved);
+	memcpy(saved, fb->buffer, fb->bytes);
+
+	for (inky_layer *l = fb->layers; l; l = l->next) {
+		inky_bitmap bm;
+
+		if (!l->visible) {
+			continue;
+		}
+
+		munit_assert_int8(inky_bitmap_from_fb(&l->fb, &bm), ==,
+				  INKY_OK);
+		munit_assert_int8(inky_fb_blit(dev, &bm, NULL, l->x, l->y,
+					       l->keyed ? INKY_ROP_TRANSPARENT :
+					       INKY_ROP_COPY, INKY_COLOR_BLACK,
+					       keys[l->z]), ==, INKY_OK);
+	}
+
+	assert_shown(intf, ram);
+
+	memcpy(fb->buffer, saved, fb->bytes);
+	fb->dirty = dirty;
+	free(saved);
+}
+
+MunitResult layer_pack_test(const MunitParameter params[], void *fixture)
+{
+	INTF(fixture);
+	inky_config *dev = &intf->dev;
+	inky_fb *fb = dev->fb;
+	struct ram *ram = intf->usrptr;
+	inky_layer layers[2];
+	/* Layer z is its index: 0 is opaque, 1 keyed on white */
+	inky_color keys[2] = { INKY_COLOR_WHITE, INKY_COLOR_WHITE };
+	static const uint8_t orientations[] = {
+		INKY_ORIENT_0, INKY_ORIENT_90, INKY_ORIENT_180 |
+		INKY_ORIENT_MIRROR, INKY_ORIENT_270
+	};
+
+	for (uint8_t k = 0; k < 4; k++) {
+		uint8_t o = orientations[k];
+		inky_rect all;
+		inky_rect area;
+
+#ifdef INKY_FIXED_PRODUCT
+		if (o & INKY_ORIENT_90) {
+			continue;
+		}
+#endif /* #ifdef INKY_FIXED_PRODUCT */
+
+		munit_assert_int8(inky_fb_set_orientation(dev, o), ==,
+				  INKY_OK);
+
+		all.x = 0;
+		all.y = 0;
+		all.w = fb->width;
+		all.h = fb->height;
+		scribble(dev, &all);
+
+		for (uint8_t i = 0; i < 2; i++) {
+			inky_layer *l = &layers[i];
+			uint16_t w = fb->width;
+			uint16_t h = fb->height;
+			int16_t x = munit_rand_int_range(-8, 40);
+			int16_t y = munit_rand_int_range(-8, 40);
+
+#ifndef INKY_FIXED_PRODUCT
+			w = munit_rand_int_range(8, fb->width);
+			h = munit_rand_int_range(8, fb->height);
+#endif /* #ifndef INKY_FIXED_PRODUCT */
+
+			munit_assert_int8(inky_layer_create(dev, l, w, h,
+							    i ? &keys[i] :
+							    NULL), ==,
+					  INKY_OK);
+			munit_assert_int8(inky_layer_begin(dev, l), ==,
+					  INKY_OK);
+			all.w = w;
+			all.h = h;
+			scribble(dev, &all);
+			munit_assert_int8(inky_layer_end(dev, l), ==, INKY_OK);
+			munit_assert_int8(inky_layer_move(dev, l, x, y), ==,
+					  INKY_OK);
+			munit_assert_int8(inky_layer_add(dev, l, i), ==,
+					  INKY_OK);
+		}
+
+		munit_assert_int8(inky_update(dev), ==, INKY_OK);
+		assert_composed(intf, ram, keys);
+
+		/* Changes to a layer are sent with the layers around them */
+		area.x = munit_rand_int_range(0, layers[1].fb.width - 2);
+		area.y = munit_rand_int_range(0, layers[1].fb.height - 2);
+		area.w = munit_rand_int_range(1, layers[1].fb.width - area.x);
+		area.h = munit_rand_int_range(1, layers[1].fb.height - area.y);
+
+		munit_assert_int8(inky_layer_begin(dev, &layers[1]), ==,
+				  INKY_OK);
+		scribble(dev, &area);
+		munit_assert_int8(inky_fb_mark_dirty(dev, &area), ==, INKY_OK);
+		munit_assert_int8(inky_layer_end(dev, &layers[1]), ==,
+				  INKY_OK);
+
+		munit_assert_int8(inky_update_dirty(dev), ==, INKY_OK);
+		assert_composed(intf, ram, keys);
+
+		/* Moving and hiding layers uncover what is under them */
+		munit_assert_int8(inky_layer_move(dev, &layers[0], 3, 5), ==,
+				  INKY_OK);
+		munit_assert_int8(inky_layer_show(dev, &layers[1], 0), ==,
+				  INKY_OK);
+		munit_assert_int8(inky_update_dirty(dev), ==, INKY_OK);
+		assert_composed(intf, ram, keys);
+
+		for (uint8_t i = 0; i < 2; i++) {
+			munit_assert_int8(inky_layer_remove(dev, &layers[i]),
+					  ==, INKY_OK);
+			munit_assert_int8(inky_layer_free(&layers[i]), ==,
+					  INKY_OK);
+		}
+
+		munit_assert_int8(inky_update_dirty(dev), ==, INKY_OK);
+		assert_shown(intf, ram);
+	}
+
+	return MUNIT_OK;
+}
+
+/**
+ * @}
+ * defgroup layer-pack-test
+ */
+
+/**
+ * @defgroup layer-clear-test
+ * @{
+ */
+
+MunitResult layer_clear_test(const MunitParameter params[], void *fixture)
+{
+	INTF(fixture);
+	inky_config *dev = &intf->dev;
+	inky_fb *fb = dev->fb;
+	struct ram *ram = intf->usrptr;
+	uint32_t n = (uint32_t) ram->stride * ram->height;
+	inky_layer layer;
+
+	munit_assert_int8(inky_layer_create(dev, &layer, fb->width,
+					    fb->height, NULL), ==, INKY_OK);
+	munit_assert_int8(inky_layer_begin(dev, &layer), ==, INKY_OK);
+	munit_assert_int8(inky_fb_fill(dev, INKY_COLOR_BLACK), ==, INKY_OK);
+	munit_assert_int8(inky_layer_end(dev, &layer), ==, INKY_OK);
+	munit_assert_int8(inky_layer_add(dev, &layer, 0), ==, INKY_OK);
+
+	munit_assert_int8(inky_update(dev), ==, INKY_OK);
+	munit_assert_uint8(ram->bw[0], ==, 0x00);
+
+	/* The opaque black layer stays, but the panel is cleared */
+	munit_assert_int8(inky_clear(dev), ==, INKY_OK);
+	munit_assert_uint32(ram->bad, ==, 0);
+
+	for (uint32_t i = 0; i < n; i++) {
+		munit_assert_uint8(ram->bw[i], ==, 0xff);
+		munit_assert_uint8(ram->color[i], ==, 0x00);
+	}
+
+	munit_assert_uint16(fb->dirty.w, ==, 0);
+	munit_assert_uint16(layer.fb.dirty.w, ==, 0);
+
+	/* So nothing is sent until something is drawn again */
+	ram->refreshes = 0;
+	munit_assert_int8(inky_update_dirty(dev), ==, INKY_OK);
+	munit_assert_uint32(ram->refreshes, ==, 0);
+
+	munit_assert_int8(inky_layer_remove(dev, &layer), ==, INKY_OK);
+	munit_assert_int8(inky_layer_free(&layer), ==, INKY_OK);
+
+	return MUNIT_OK;
+}
+
+/**
+ * @}
+ * defgroup layer-clear-test
+ */
+
+/**
+ * @defgroup band-pack-test
+ * @{
+ */
+
+/** @brief Shapes drawn band by band
+    @var n Shapes
+    @var shape Each a filled rectangle, line or filled circle
+    @var rows Rows of each band but the last, 0 for the whole picture
+    @var calls, drawn Bands rendered, and their rows
+    @var ret What rendering returns
+**/
+struct scene {
+	uint8_t n;
+	struct {
+		uint8_t kind;
+		int16_t x;
+		int16_t y;
+		int16_t x1;
+		int16_t y1;
+		inky_color c;
+	} shape[24];
+	uint16_t rows;
+	uint32_t calls;
+	uint32_t drawn;
+	inky_error_state ret;
+};
+
+static inky_error_state scene_render(inky_config *cfg,
+				     const inky_rect *band, void *usrptr)
+{
+	struct scene *sc = usrptr;
+	inky_draw draw;
+
+	/* Bands are whole rows, rows at a time from the top */
+	munit_assert_uint16(band->x, ==, 0);
+	munit_assert_uint16(band->w, ==, cfg->fb->width);
+	munit_assert_uint16(band->h, ==, cfg->fb->height);
+
+	if (sc->rows) {
+		munit_assert_uint16(band->y % sc->rows, ==, 0);
+		munit_assert_uint16(band->h, <=, sc->rows);
+	}
+
+	sc->calls++;
+	sc->drawn += band->h;
+
+	munit_assert_int8(inky_draw_init(cfg, &draw), ==, INKY_OK);
+
+	for (uint8_t i = 0; i < sc->n; i++) {
+		int16_t x = sc->shape[i].x - band->x;
+		int16_t y = sc->shape[i].y - band->y;
+		int16_t x1 = sc->shape[i].x1 - band->x;
+		int16_t y1 = sc->shape[i].y1 - band->y;
+		inky_color c = sc->shape[i].c;
+
+		switch (sc->shape[i].kind) {
+		case 0:
+			munit_assert_int8(inky_draw_fill_rect(cfg, &draw, x, y,
+							      x1 - x, y1 - y,
+							      c), ==, INKY_OK);
+			break;
+		case 1:
+			munit_assert_int8(inky_draw_line(cfg, &draw, x, y, x1,
+							 y1, c), ==, INKY_OK);
+			break;
+		default:
+			munit_assert_int8(inky_draw_fill_circle(cfg, &draw, x,
+								y, x1 - x, c),
+					  ==, INKY_OK);
+			break;
+		}
+	}
+
+	return sc->ret;
+}
+
+/** @brief Random shapes over a w by h picture */
+static void scene_make(inky_config *dev, struct scene *sc, uint16_t w,
+		       uint16_t h)
+{
+	inky_color colors[3] = {
+		INKY_COLOR_WHITE, INKY_COLOR_BLACK, INKY_COLOR_BLACK
+	};
+
+	if (inky_color_available(dev, INKY_COLOR_RED)) {
+		colors[2] = INKY_COLOR_RED;
+	} else if (inky_color_available(dev, INKY_COLOR_YELLOW)) {
+		colors[2] = INKY_COLOR_YELLOW;
+	}
+
+	memset(sc, 0, sizeof(*sc));
+	sc->n = 24;
+
+	for (uint8_t i = 0; i < sc->n; i++) {
+		sc->shape[i].kind = munit_rand_int_range(0, 2);
+		sc->shape[i].x = munit_rand_int_range(-20, w);
+		sc->shape[i].y = munit_rand_int_range(-20, h);
+		sc->shape[i].x1 = sc->shape[i].x + munit_rand_int_range(1, 60);
+		sc->shape[i].y1 = sc->shape[i].y + munit_rand_int_range(1, 60);
+		sc->shape[i].c = colors[munit_rand_int_range(0, 2)];
+	}
+}
+
+MunitResult band_pack_test(const MunitParameter params[], void *fixture)
+{
+	INTF(fixture);
+	inky_config *dev = &intf->dev;
+	struct ram *ram = intf->usrptr;
+	uint32_t plane = (uint32_t) ram->stride * ram->height;
+	uint8_t *want = malloc(plane * 6);
+	struct scene sc[3];
+	static const uint8_t orientations[] = {
+		INKY_ORIENT_0, INKY_ORIENT_180 | INKY_ORIENT_MIRROR,
+		INKY_ORIENT_MIRROR
+	};
+	static const uint8_t scales[] = { 1, 2, 1 };
+	inky_rect all;
+
+	munit_assert_not_null(want);
+
+	/* Each picture drawn whole into the framebuffer first */
+	for (uint8_t k = 0; k < 3; k++) {
+		uint8_t *bw = &want[plane * 2 * k];
+
+		munit_assert_int8(inky_fb_set_orientation(dev,
+							  orientations[k]), ==,
+				  INKY_OK);
+#ifndef INKY_FIXED_PRODUCT
+		munit_assert_int8(inky_fb_set_scale(dev, scales[k]), ==,
+				  INKY_OK);
+#endif /* #ifndef INKY_FIXED_PRODUCT */
+
+		all.x = 0;
+		all.y = 0;
+		all.w = dev->fb->width;
+		all.h = dev->fb->height;
+
+		scene_make(dev, &sc[k], all.w, all.h);
+		munit_assert_int8(inky_fb_fill(dev, INKY_COLOR_WHITE), ==,
+				  INKY_OK);
+		munit_assert_int8(scene_render(dev, &all, &sc[k]), ==,
+				  INKY_OK);
+
+		munit_assert_int8(inky_update(dev), ==, INKY_OK);
+		memcpy(bw, ram->bw, plane);
+		memcpy(&bw[plane], ram->color, plane);
+	}
+
+	munit_assert_int8(inky_free(dev), ==, INKY_OK);
+	dev->exclude_flags |= INKY_FLAG_ALLOCATE_FB;
+	munit_assert_int8(inky_setup(dev), ==, INKY_OK);
+	munit_assert_null(dev->fb);
+
+#ifdef INKY_FIXED_PRODUCT
+	munit_assert_int8(inky_band_setup(dev, 16, scene_render, &sc[2]), ==,
+			  INKY_E_NOT_AVAILABLE);
+	munit_assert_null(dev->fb);
+	free(want);
+
+	return MUNIT_OK;
+#endif /* #ifdef INKY_FIXED_PRODUCT */
+
+	munit_assert_int8(inky_band_setup(dev, 16, scene_render, &sc[2]), ==,
+			  INKY_OK);
+	munit_assert_not_null(dev->fb);
+	munit_assert_null(dev->fb->buffer);
+	munit_assert_uint32(dev->fb->band->fb.bytes, ==,
+			    16 * dev->fb->band->fb.stride);
+
+	/* Band by band, each picture reaches the panel as it was drawn */
+	for (uint8_t k = 0; k < 3; k++) {
+		uint8_t *bw = &want[plane * 2 * k];
+		uint16_t h;
+
+		munit_assert_int8(inky_fb_set_orientation(dev,
+							  orientations[k]), ==,
+				  INKY_OK);
+		munit_assert_int8(inky_fb_set_scale(dev, scales[k]), ==,
+				  INKY_OK);
+		h = dev->fb->height;
+
+		dev->fb->band->usrptr = &sc[k];
+		sc[k].rows = 16;
+		sc[k].calls = 0;
+		sc[k].drawn = 0;
+
+		memset(ram->bw, 0, plane);
+		memset(ram->color, 0, plane);
+		munit_assert_int8(inky_update(dev), ==, INKY_OK);
+
+		munit_assert_uint32(sc[k].calls, ==, (h + 15) / 16);
+		munit_assert_uint32(sc[k].drawn, ==, h);
+
+		munit_assert_uint32(ram->bad, ==, 0);
+		munit_assert_memory_equal(plane, ram->bw, bw);
+		munit_assert_memory_equal(plane, ram->color, &bw[plane]);
+	}
+
+	/* Regions only render the bands they cross */
+	all.x = 3;
+	all.y = 20;
+	all.w = 9;
+	all.h = 17;
+	sc[2].calls = 0;
+
+	munit_assert_int8(inky_update_region(dev, &all), ==, INKY_OK);
+	munit_assert_uint32(sc[2].calls, ==, 2);
+	munit_assert_memory_equal(plane, ram->bw, &want[plane * 4]);
+	munit_assert_memory_equal(plane, ram->color, &want[plane * 5]);
+
+	free(want);
+
+	return MUNIT_OK;
+}
+
+/**
+ * @}
+ * defgroup band-pack-test
+ */
+
+/**
+ * @defgroup band-args-test
+ * @{
+ */
+
+/** @brief Check drawing into or reading a framebuffer rendered in bands
+ * fails outside the render callback */
+static void band_draw_outside(inky_config *dev)
+{
+	static const inky_point pts[2] = { { 1, 1 }, { 2, 3 } };
+	static const uint8_t rgb[8 * 3] = { 0 };
+	inky_color row[8] = { INKY_COLOR_BLACK };
+	inky_rect area = { 0, 0, 8, 8 };
+	inky_text_atlas atlas;
+	inky_binarize bin;
+	inky_convert cv;
+	inky_widget box;
+	inky_sprite spr;
+	inky_dither d;
+	inky_term term;
+	inky_bitmap bm;
+	inky_draw draw;
+	inky_color c;
+
+	munit_assert_int8(inky_fb_set_pixel(dev, 1, 1, INKY_COLOR_BLACK), ==,
+			  INKY_E_NOT_AVAILABLE);
+	munit_assert_int8(inky_fb_get_pixel(dev, 1, 1, &c), ==,
+			  INKY_E_NOT_AVAILABLE);
+	munit_assert_int8(inky_fb_fill(dev, INKY_COLOR_BLACK), ==,
+			  INKY_E_NOT_AVAILABLE);
+	munit_assert_int8(inky_fb_hline(dev, 0, 1, 8, INKY_COLOR_BLACK), ==,
+			  INKY_E_NOT_AVAILABLE);
+	munit_assert_int8(inky_fb_write_row(dev, 1, row, 8), ==,
+			  INKY_E_NOT_AVAILABLE);
+	munit_assert_int8(inky_fb_set_pixels(dev, pts, 2, INKY_COLOR_BLACK),
+			  ==, INKY_E_NOT_AVAILABLE);
+	munit_assert_int8(inky_fb_copy_rect(dev, &area, 4, 4), ==,
+			  INKY_E_NOT_AVAILABLE);
+	munit_assert_int8(inky_fb_scroll(dev, &area, 0, 2, INKY_COLOR_WHITE),
+			  ==, INKY_E_NOT_AVAILABLE);
+	munit_assert_int8(inky_bitmap_from_fb(dev->fb, &bm), ==,
+			  INKY_E_NOT_AVAILABLE);
+
+	/* Sources made from the band still cannot go anywhere */
+	munit_assert_int8(inky_bitmap_from_fb(&dev->fb->band->fb, &bm), ==,
+			  INKY_OK);
+	munit_assert_int8(inky_fb_blit(dev, &bm, &area, 0, 0, INKY_ROP_COPY,
+				       INKY_COLOR_BLACK, INKY_COLOR_WHITE), ==,
+			  INKY_E_NOT_AVAILABLE);
+	munit_assert_int8(inky_sprite_create(dev, &spr, &bm, &area,
+					     INKY_COLOR_BLACK, NULL), ==,
+			  INKY_OK);
+	munit_assert_int8(inky_fb_draw_sprite(dev, &spr, 0, 0), ==,
+			  INKY_E_NOT_AVAILABLE);
+	munit_assert_int8(inky_sprite_free(&spr), ==, INKY_OK);
+
+	munit_assert_int8(inky_draw_init(dev, &draw), ==, INKY_OK);
+	munit_assert_int8(inky_draw_line(dev, &draw, 0, 0, 9, 9,
+					 INKY_COLOR_BLACK), ==,
+			  INKY_E_NOT_AVAILABLE);
+	munit_assert_int8(inky_draw_fill_rect(dev, &draw, 0, 0, 9, 9,
+					      INKY_COLOR_BLACK), ==,
+			  INKY_E_NOT_AVAILABLE);
+
+	munit_assert_int8(inky_text_atlas_create(dev, &atlas, &inky_font_5x7,
+						 INKY_COLOR_BLACK, NULL), ==,
+			  INKY_OK);
+	munit_assert_int8(inky_text_draw(dev, &atlas, 0, 0, "band", NULL), ==,
+			  INKY_E_NOT_AVAILABLE);
+	munit_assert_int8(inky_text_atlas_free(&atlas), ==, INKY_OK);
+
+	area.w = 60;
+	area.h = 16;
+	munit_assert_int8(inky_term_create(dev, &term, &inky_font_5x7, &area,
+					   INKY_COLOR_BLACK, INKY_COLOR_WHITE),
+			  ==, INKY_OK);
+	munit_assert_int8(inky_term_render(dev, &term, NULL), ==,
+			  INKY_E_NOT_AVAILABLE);
+	munit_assert_int8(inky_term_free(&term), ==, INKY_OK);
+
+	munit_assert_int8(inky_widget_init(&box, INKY_WIDGET_RECT, &area), ==,
+			  INKY_OK);
+	munit_assert_int8(inky_widget_render(dev, &box, NULL), ==,
+			  INKY_E_NOT_AVAILABLE);
+
+	munit_assert_int8(inky_dither_init(dev, &d, INKY_DITHER_THRESHOLD, 8),
+			  ==, INKY_OK);
+	munit_assert_int8(inky_dither_row(dev, &d, rgb, 0, 0), ==,
+			  INKY_E_NOT_AVAILABLE);
+	inky_dither_free(&d);
+
+	munit_assert_int8(inky_convert_init(dev, &cv), ==, INKY_OK);
+	munit_assert_int8(inky_convert_rect(dev, &cv, INKY_CONVERT_RGB888, rgb,
+					    sizeof(rgb), 8, 1, 0, 0), ==,
+			  INKY_E_NOT_AVAILABLE);
+	inky_convert_free(&cv);
+
+	munit_assert_int8(inky_binarize_begin(dev, &bin,
+					      INKY_BINARIZE_BRADLEY, 8, 1, 15,
+					      0, 0), ==, INKY_OK);
+	munit_assert_int8(inky_binarize_row(dev, &bin, rgb), ==,
+			  INKY_E_NOT_AVAILABLE);
+	munit_assert_int8(inky_binarize_end(dev, &bin), ==,
+			  INKY_E_NOT_AVAILABLE);
+	inky_binarize_free(&bin);
+}
+
+MunitResult band_args_test(const MunitParameter params[], void *fixture)
+{
+	INTF(fixture);
+	inky_config *dev = &intf->dev;
+	struct ram *ram = intf->usrptr;
+	uint32_t plane = (uint32_t) ram->stride * ram->height;
+	struct scene sc;
+	inky_layer layer;
+
+	scene_make(dev, &sc, dev->fb->width, dev->fb->height);
+
+	/* Only in place of the framebuffer setup allocates */
+	munit_assert_int8(inky_band_setup(dev, 16, scene_render, &sc), ==,
+			  INKY_E_NOT_AVAILABLE);
+
+	munit_assert_int8(inky_free(dev), ==, INKY_OK);
+	dev->exclude_flags |= INKY_FLAG_ALLOCATE_FB;
+	munit_assert_int8(inky_setup(dev), ==, INKY_OK);
+
+#ifdef INKY_FIXED_PRODUCT
+	munit_assert_int8(inky_band_setup(dev, 16, scene_render, &sc), ==,
+			  INKY_E_NOT_AVAILABLE);
+
+	return MUNIT_OK;
+#endif /* #ifdef INKY_FIXED_PRODUCT */
+
+	munit_assert_int8(inky_band_setup(dev, 16, NULL, &sc), ==,
+			  INKY_E_NULL_PTR);
+
+	munit_assert_int8(inky_band_setup(dev, 0, scene_render, &sc), ==,
+			  INKY_E_OUT_OF_RANGE);
+	munit_assert_int8(inky_band_setup(dev, 12, scene_render, &sc), ==,
+			  INKY_E_OUT_OF_RANGE);
+	munit_assert_null(dev->fb);
+
+	/* More rows than the panel has make a single band */
+	munit_assert_int8(inky_band_setup(dev, 1024, scene_render, &sc), ==,
+			  INKY_OK);
+	munit_assert_uint16(dev->fb->band->rows, ==, dev->panel->height);
+	munit_assert_int8(inky_update(dev), ==, INKY_OK);
+	munit_assert_uint32(sc.calls, ==, 1);
+
+	munit_assert_int8(inky_band_setup(dev, 16, scene_render, &sc), ==,
+			  INKY_E_NOT_AVAILABLE);
+
+	/* Nothing needing the whole framebuffer in memory */
+	munit_assert_int8(inky_fb_set_orientation(dev, INKY_ORIENT_90), ==,
+			  INKY_E_NOT_AVAILABLE);
+	munit_assert_int8(inky_fb_set_canvas(dev, dev->fb->width,
+					     dev->fb->height), ==,
+			  INKY_E_NOT_AVAILABLE);
+	munit_assert_int8(inky_layer_create(dev, &layer, 8, 8, NULL), ==,
+			  INKY_E_NOT_AVAILABLE);
+
+	band_draw_outside(dev);
+
+	/* Failing to render stops the update */
+	sc.calls = 0;
+	sc.ret = INKY_E_FAILURE;
+	ram->refreshes = 0;
+	munit_assert_int8(inky_update(dev), ==, INKY_E_FAILURE);
+	munit_assert_uint32(sc.calls, ==, 1);
+	munit_assert_uint32(ram->refreshes, ==, 0);
+
+	/* Clearing sends white without rendering */
+	sc.calls = 0;
+	munit_assert_int8(inky_clear(dev), ==, INKY_OK);
+	munit_assert_uint32(sc.calls, ==, 0);
+	munit_assert_uint32(ram->refreshes, ==, 1);
+
+	for (uint32_t i = 0; i < plane; i++) {
+		munit_assert_uint8(ram->bw[i], ==, 0xff);
+		munit_assert_uint8(ram->color[i], ==, 0x00);
+	}
+
+	return MUNIT_OK;
+}
+
+/**
+ * @}
+ * defgroup band-args-test
+ */
+
+MunitTest orient_tests[] = {
+	{
+		.name = "/orient-test",
+		.test = orient_test,
+		.setup = orient_setup,
+		.tear_down = orient_tear_down,
+		.options = MUNIT_TEST_OPTION_NONE,
+		.parameters = fb_test_params
+	},
+
+	{
+		.name = "/orient-region-test",
+		.test = orient_region_test,
+		.setup = orient_setup,
+		.tear_down = orient_tear_down,
+		.options = MUNIT_TEST_OPTION_NONE,
+		.parameters = fb_test_params
+	},
+
+	{
+		.name = "/orient-args-test",
+		.test = orient_args_test,
+		.setup = orient_setup,
+		.tear_down = orient_tear_down,
+		.options = MUNIT_TEST_OPTION_NONE,
+		.parameters = fb_test_params
+	},
+
+	{
+		.name = "/viewport-test",
+		.test = viewport_test,
+		.setup = orient_setup,
+		.tear_down = orient_tear_down,
+		.options = MUNIT_TEST_OPTION_NONE,
+		.parameters = fb_test_params
+	},
+
+	{
+		.name = "/viewport-args-test",
+		.test = viewport_args_test,
+		.setup = orient_setup,
+		.tear_down = orient_tear_down,
+		.options = MUNIT_TEST_OPTION_NONE,
+		.parameters = fb_test_params
+	},
+
+	{
+		.name = "/upscale-test",
+		.test = upscale_test,
+		.setup = orient_setup,
+		.tear_down = orient_tear_down,
+		.options = MUNIT_TEST_OPTION_NONE,
+		.parameters = fb_test_params
+	},
+
+	{
+		.name = "/upscale-args-test",
+		.test = upscale_args_test,
+		.setup = orient_setup,
+		.tear_down = orient_tear_down,
+		.options = MUNIT_TEST_OPTION_NONE,
+		.parameters = fb_test_params
+	},
+
+	{
+		.name = "/layer-pack-test",
+		.test = layer_pack_test,
+		.setup = orient_setup,
+		.tear_down = orient_tear_down,
+		.options = MUNIT_TEST_OPTION_NONE,
+		.parameters = fb_test_params
+	},
+
+	{
+		.name = "/layer-clear-test",
+		.test = layer_clear_test,
+		.setup = orient_setup,
+		.tear_down = orient_tear_down,
+		.options = MUNIT_TEST_OPTION_NONE,
+		.parameters = fb_test_params
+	},
+
+	{
+		.name = "/band-pack-test",
+		.test = band_pack_test,
+		.setup = orient_setup,
+		.tear_down = orient_tear_down,
+		.options = MUNIT_TEST_OPTION_NONE,
+		.parameters = fb_test_params
+	},
+
+	{
+		.name = "/band-args-test",
+		.test = band_args_test,
+		.setup = orient_setup,
+		.tear_down = orient_tear_down,
+		.options = MUNIT_TEST_OPTION_NONE,
+		.parameters = fb_test_params
+	},
+
+	{
+		.name = NULL,
+		.test = NULL,
+		.setup = NULL,
+		.tear_down = NULL,
+		.options = MUNIT_TEST_OPTION_NONE,
+		.parameters = NULL
+	}
+};
+
+/**
+ * @}
+ * defgroup pimoroni-inky-orient-tests
+ */
@@ -0,0 +1,363 @@
+/**
+ * @file panel-test.cpp
+ *
+ * Unit testing for the header-only C++ panel wrapper of the Pimoroni
+ * Inky driver
+ */
+
+#include "inky.h"
+#include "inky-panel.hpp"
+
+#include <munit/munit.h>
+
+#include <cstdint>
+#include <cstring>
+#include <type_traits>
+#include <utility>
+
+/**
+ * @defgroup pimoroni-inky-panel-tests Pimoroni Inky panel wrapper
+ * testing suites
+ * @{
+ */
+
+/*
+**********************************************************************
+************************** TESTS DEFINITIONS *************************
+**********************************************************************
+*/
+
+/** @brief HAL policy counting what the driver asks of it */
+struct test_hal {
+	uint32_t *n_bytes_out;
+
+	inky_error_state gpio_initialize() { return INKY_OK; }
+
+	inky_error_state gpio_setup_pin(inky_pin, inky_gpio_direction,
+					inky_pin_state,
+					inky_gpio_pull_up_down)
+	{
+		return INKY_OK;
+	}
+
+	inky_error_state gpio_output(inky_pin, inky_pin_state)
+	{
+		return INKY_OK;
+	}
+
+	inky_error_state gpio_input(inky_pin, inky_pin_state*)
+	{
+		return INKY_OK;
+	}
+
+	inky_error_state gpio_poll(inky_pin, UINT64_t) { return INKY_OK; }
+
+	inky_error_state spi_setup() { return INKY_OK; }
+
+	inky_error_state spi_write(const UINT8_t*, UINT32_t len)
+	{
+		*n_bytes_out += len;
+
+		return INKY_OK;
+	}
+
+	inky_error_state spi_write16(const UINT16_t*, UINT32_t len)
+	{
+		*n_bytes_out += len * 2;
+
+		return INKY_OK;
+	}
+
+	inky_error_state delay_us(UINT32_t) { return INKY_OK; }
+};
+
+using what_red = inky::panel<400, 300, inky::colors::red, test_hal>;
+using phat_black = inky::panel<122, 250, inky::colors::black, test_hal>;
+
+static_assert(what_red::product == INKY_WHAT);
+static_assert(phat_black::product == INKY_PHAT);
+static_assert(!std::is_copy_constructible_v<what_red>);
+static_assert(std::is_nothrow_move_constructible_v<what_red>);
+static_assert(inky::colors::has<inky::colors::red>(INKY_COLOR_RED));
+static_assert(!inky::colors::has<inky::colors::red>(INKY_COLOR_YELLOW));
+
+/*
+**********************************************************************
+********************** TESTS IMPLEMENTATION **************************
+**********************************************************************
+*/
+
+/**
+ * @defgroup panel-pixel-test Compare wrapper pixels to the C API
+ * @{
+ */
+
+static MunitResult panel_pixel_test(const MunitParameter params[],
+				    void *user_data)
+{
+	uint32_t n_bytes_out = 0;
+	what_red p(test_hal{&n_bytes_out});
+	what_red ref(test_hal{&n_bytes_out});
+	const inky_color palette[] = {
+		INKY_COLOR_WHITE, INKY_COLOR_BLACK, INKY_COLOR_RED
+	};
+
+	munit_assert_int8(p.setup(), ==, INKY_OK);
+	munit_assert_int8(ref.setup(), ==, INKY_OK);
+	munit_assert_true(p.ready());
+	munit_assert_size(p.config().fb->bytes, ==, what_red::bytes);
+
+	for (int i = 0; i < 5000; i++) {
+		uint16_t x = munit_rand_int_range(0, what_red::width - 1);
+		uint16_t y = munit_rand_int_range(0, what_red::height - 1);
+		inky_color c = palette[munit_rand_int_range(0, 2)];
+
+		p.set(x, y, c);
+		munit_assert_int8(inky_fb_set_pixel(&ref.config(), x, y, c),
+				  ==, INKY_OK);
+		munit_assert_int(p.get(x, y), ==, c);
+	}
+
+	p.set<INKY_COLOR_RED>(0, 0);
+	inky_fb_set_pixel(&ref.config(), 0, 0, INKY_COLOR_RED);
+
+	munit_assert_memory_equal(what_red::bytes, p.data(), ref.data());
+
+	munit_assert_int8(p.update(), ==, INKY_OK);
+	munit_assert_uint32(n_bytes_out, >, 0);
+
+	return MUNIT_OK;
+}
+
+/**
+ * @}
+ */
+
+/**
+ * @defgroup panel-span-test Compare span fills to single pixels
+ * @{
+ */
+
+static MunitResult panel_span_test(const MunitParameter params[],
+				   void *user_data)
+{
+	uint32_t n_bytes_out = 0;
+	phat_black p(test_hal{&n_bytes_out});
+	phat_black ref(test_hal{&n_bytes_out});
+
+	munit_assert_int8(p.setup(), ==, INKY_OK);
+	munit_assert_int8(ref.setup(), ==, INKY_OK);
+
+	p.fill(INKY_COLOR_BLACK);
+	ref.fill(INKY_COLOR_BLACK);
+
+	/* 122 pixels leave padding at the end of every row */
+	static_assert(phat_black::stride == 16);
+
+	for (int i = 0; i < 200; i++) {
+		uint16_t y = munit_rand_int_range(0, phat_black::height - 1);
+		uint16_t x = munit_rand_int_range(0, phat_black::width - 1);
+		uint16_t len = munit_rand_int_range(0, phat_black::width - x);
+
+		p.span(x, y, len, INKY_COLOR_WHITE);
+
+		for (uint16_t j = 0; j < len; j++) {
+			ref.set<INKY_COLOR_WHITE>(x + j, y);
+		}
+	}
+
+	munit_assert_memory_equal(phat_black::bytes, p.data(), ref.data());
+
+	return MUNIT_OK;
+}
+
+/**
+ * @}
+ */
+
+/**
+ * @defgroup panel-move-test Test ownership transfer
+ * @{
+ */
+
+static MunitResult panel_move_test(const MunitParameter params[],
+				   void *user_data)
+{
+	uint32_t n_bytes_out = 0;
+	what_red a(test_hal{&n_bytes_out});
+
+	munit_assert_int8(a.setup(), ==, INKY_OK);
+
+	a.set<INKY_COLOR_BLACK>(3, 4);
+
+	what_red b(std::move(a));
+
+	munit_assert_true(b.ready());
+	munit_assert_int(b.get(3, 4), ==, INKY_COLOR_BLACK);
+
+	/* Callbacks still reach the HAL after the move */
+	munit_assert_int8(b.update(), ==, INKY_OK);
+	munit_assert_uint32(n_bytes_out, >, 0);
+
+	return MUNIT_OK;
+}
+
+/**
+ * @}
+ */
+
+/**
+ * @defgroup panel-reshape-test Follow the framebuffer once reshaped
+ * @{
+ */
+
+/** @brief Draw the same random pixels and spans through the wrapper and
+ * the C API, and compare the framebuffers */
+static void compare_draw(what_red &p, what_red &ref)
+{
+	inky_config *dev = &ref.config();
+	const inky_color palette[] = {
+		INKY_COLOR_WHITE, INKY_COLOR_BLACK, INKY_COLOR_RED
+	};
+
+	munit_assert_uint16(p.fb_width(), ==, dev->fb->width);
+	munit_assert_uint16(p.fb_height(), ==, dev->fb->height);
+
+	p.fill(INKY_COLOR_BLACK);
+	munit_assert_int8(inky_fb_fill(dev, INKY_COLOR_BLACK), ==, INKY_OK);
+
+	for (int i = 0; i < 2000; i++) {
+		uint16_t x = munit_rand_int_range(0, p.fb_width() - 1);
+		uint16_t y = munit_rand_int_range(0, p.fb_height() - 1);
+		inky_color c = palette[munit_rand_int_range(0, 2)];
+
+		p.set(x, y, c);
+		munit_assert_int8(inky_fb_set_pixel(dev, x, y, c), ==,
+				  INKY_OK);
+		munit_assert_int(p.get(x, y), ==, c);
+	}
+
+	for (int i = 0; i < 100; i++) {
+		uint16_t y = munit_rand_int_range(0, p.fb_height() - 1);
+		uint16_t x = munit_rand_int_range(0, p.fb_width() - 1);
+		uint16_t len = munit_rand_int_range(0, p.fb_width() - x);
+		inky_color c = palette[munit_rand_int_range(0, 2)];
+
+		p.span(x, y, len, c);
+		munit_assert_int8(inky_fb_hline(dev, x, y, len, c), ==,
+				  INKY_OK);
+	}
+
+	munit_assert_size(p.config().fb->bytes, ==, dev->fb->bytes);
+	munit_assert_memory_equal(dev->fb->bytes, p.data(), ref.data());
+}
+
+static MunitResult panel_reshape_test(const MunitParameter params[],
+				      void *user_data)
+{
+	uint32_t n_bytes_out = 0;
+	what_red p(test_hal{&n_bytes_out});
+	what_red ref(test_hal{&n_bytes_out});
+
+	munit_assert_int8(p.setup(), ==, INKY_OK);
+	munit_assert_int8(ref.setup(), ==, INKY_OK);
+
+	munit_assert_int8(inky_fb_set_orientation(&p.config(),
+						  INKY_ORIENT_90), ==,
+			  INKY_OK);
+	munit_assert_int8(inky_fb_set_orientation(&ref.config(),
+						  INKY_ORIENT_90), ==,
+			  INKY_OK);
+	munit_assert_uint16(p.fb_width(), ==, what_red::height);
+	compare_draw(p, ref);
+
+	munit_assert_int8(inky_fb_set_scale(&p.config(), 2), ==, INKY_OK);
+	munit_assert_int8(inky_fb_set_scale(&ref.config(), 2), ==, INKY_OK);
+	compare_draw(p, ref);
+
+	munit_assert_int8(inky_fb_set_scale(&p.config(), 1), ==, INKY_OK);
+	munit_assert_int8(inky_fb_set_scale(&ref.config(), 1), ==, INKY_OK);
+	munit_assert_int8(inky_fb_set_orientation(&p.config(),
+						  INKY_ORIENT_0), ==,
+			  INKY_OK);
+	munit_assert_int8(inky_fb_set_orientation(&ref.config(),
+						  INKY_ORIENT_0), ==,
+			  INKY_OK);
+	munit_assert_int8(inky_fb_set_canvas(&p.config(), 517, 333), ==,
+			  INKY_OK);
+	munit_assert_int8(inky_fb_set_canvas(&ref.config(), 517, 333), ==,
+			  INKY_OK);
+	munit_assert_size(INKY_FB_STRIDE(p.config().fb), !=, what_red::stride);
+	compare_draw(p, ref);
+
+	return MUNIT_OK;
+}
+
+/**
+ * @}
+ */
+
+static MunitTest panel_tests[] = {
+	{
+		.name = (char*) "/panel-pixel-test",
+		.test = panel_pixel_test,
+		.setup = NULL,
+		.tear_down = NULL,
+		.options = MUNIT_TEST_OPTION_NONE,
+		.parameters = NULL
+	},
+
+	{
+		.name = (char*) "/panel-span-test",
+		.test = panel_span_test,
+		.setup = NULL,
+		.tear_down = NULL,
+		.options = MUNIT_TEST_OPTION_NONE,
+		.parameters = NULL
+	},
+
+	{
+		.name = (char*) "/panel-move-test",
+		.test = panel_move_test,
+		.setup = NULL,
+		.tear_down = NULL,
+		.options = MUNIT_TEST_OPTION_NONE,
+		.parameters = NULL
+	},
+
+	{
+		.name = (char*) "/panel-reshape-test",
+		.test = panel_reshape_test,
+		.setup = NULL,
+		.tear_down = NULL,
+		.options = MUNIT_TEST_OPTION_NONE,
+		.parameters = NULL
+	},
+
+	{
+		.name = NULL,
+		.test = NULL,
+		.setup = NULL,
+		.tear_down = NULL,
+		.options = MUNIT_TEST_OPTION_NONE,
+		.parameters = NULL
+	}
+};
+
+static const MunitSuite panel_suite = {
+	(char*) "/inky-panel-test-suite",
+	panel_tests,
+	NULL,
+	1,
+	MUNIT_SUITE_OPTION_NONE
+};
+
+int main(int argc, char *const argv[])
+{
+	return munit_suite_main(&panel_suite, NULL, argc, argv);
+}
+
+/**
+ * @}
+ * defgroup pimoroni-inky-panel-tests
+ */
@@ -0,0 +1,475 @@
+/**
+ * @file scale-test.c
+ *
+ * Unit testing for the image scaling of the Pimoroni Inky driver
+ */
+
+#include "inky.h"
+
+#include <munit/munit.h>
+
+#include "test-device.h"
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+/**
+ * @defgroup pimoroni-inky-scale-tests Pimoroni Inky scaling testing
+ * suites
+ * @{
+ */
+
+/*
+**********************************************************************
+************************** TESTS DEFINITIONS *************************
+**********************************************************************
+*/
+
+#define SRC_W	40
+#define SRC_H	30
+#define DST_W	64
+#define DST_H	48
+
+/** @brief Raw PPM of an sw by sh picture */
+static uint32_t make_pnm(uint8_t *pnm, const uint8_t *src, int sw, int sh)
+{
+	uint32_t size = sprintf((char *) pnm, "P6\n%d %d\n255\n", sw, sh);
+
+	memcpy(&pnm[size], src, sw * sh * 3);
+
+	return size + sw * sh * 3;
+}
+
+/** @brief Bottom up 24 bit BMP of an sw by sh picture */
+static uint32_t make_bmp(uint8_t *bmp, const uint8_t *src, int sw, int sh)
+{
+	uint32_t row = (sw * 3 + 3) / 4 * 4;
+	uint32_t fields[] = {
+		54 + row * sh, 0, 54, 40, sw, sh, 1 | 24 << 16, 0, row * sh,
+		0, 0, 0, 0
+	};
+	uint32_t size = 2;
+
+	bmp[0] = 'B';
+	bmp[1] = 'M';
+
+	for (uint32_t k = 0; k < sizeof(fields) / 4; k++) {
+		for (int b = 0; b < 4; b++) {
+			bmp[size++] = fields[k] >> (8 * b);
+		}
+	}
+
+	for (int v = sh - 1; v >= 0; v--) {
+		for (uint32_t u = 0; u < row; u++) {
+			bmp[size++] = u < (uint32_t) sw * 3 ?
+				src[(v * sw + u / 3) * 3 + 2 - u % 3] : 0;
+		}
+	}
+
+	return size;
+}
+
+/** @brief Source position and fraction, in 1/256, of pixel i of n
+ * across a source of sn pixels, centres aligned */
+static int ref_bilinear(int i, int n, int sn, int *f)
+{
+	uint64_t step = ((uint64_t) sn << 16) / n;
+	int64_t p = step / 2 + i * step - 0x8000;
+
+	*f = 0;
+
+	if (p < 0) {
+		return 0;
+	}
+
+	if (p >> 16 >= sn - 1) {
+		return sn - 1;
+	}
+
+	*f = (p >> 8) & 0xff;
+
+	return p >> 16;
+}
+
+/** @brief Scale a single channel line of sn samples, d apart, to n */
+static void ref_line(const uint8_t *in, int d, int sn, uint8_t *out, int n,
+		     inky_scale_filter filter)
+{
+	uint64_t step = ((uint64_t) sn << 16) / n;
+
+	for (int i = 0; i < n; i++) {
+		if (filter == INKY_SCALE_NEAREST) {
+			out[i] = in[d * ((step / 2 + i * step) >> 16)];
+		} else if (filter == INKY_SCALE_BILINEAR) {
+			int f;
+			int k = ref_bilinear(i, n, sn, &f);
+			int b = f ? in[d * (k + 1)] : 0;
+
+			out[i] = (in[d * k] * (256 - f) + b * f + 128) >> 8;
+		} else {
+			/* Overlap of [i, i + 1) / n with [k, k + 1) / sn,
+			 * in 1/(n * sn) */
+			uint64_t sum = 0;
+
+			for (int k = 0; k < sn; k++) {
+				int64_t lo = (int64_t) i * sn > (int64_t) k * n ?
+					(int64_t) i * sn : (int64_t) k * n;
+				int64_t hi = (int64_t) (i + 1) * sn <
+					(int64_t) (k + 1) * n ?
+					(int64_t) (i + 1) * sn :
+					(int64_t) (k + 1) * n;
+
+				if (hi > lo) {
+					sum += (hi - lo) * in[d * k];
+				}
+			}
+
+			out[i] = (sum + sn / 2) / sn;
+		}
+	}
+}
+
+/** @brief Scale sw by sh RGB to w by h, across then down */
+static void ref_scale(const uint8_t *src, int sw, int sh, uint8_t *dst,
+		      int w, int h, inky_scale_filter filter)
+{
+	static uint8_t across[SRC_H * DST_W * 3];
+	static uint8_t line[SRC_H > DST_W ? SRC_H : DST_W];
+
+	for (int v = 0; v < sh; v++) {
+		for (int c = 0; c < 3; c++) {
+			ref_line(&src[v * sw * 3 + c], 3, sw, line, w, filter);
+
+			for (int i = 0; i < w; i++) {
+				across[(v * w + i) * 3 + c] = line[i];
+			}
+		}
+	}
+
+	for (int i = 0; i < w; i++) {
+		for (int c = 0; c < 3; c++) {
+			ref_line(&across[i * 3 + c], w * 3, sh, line, h,
+				 filter);
+
+			for (int j = 0; j < h; j++) {
+				dst[(j * w + i) * 3 + c] = line[j];
+			}
+		}
+	}
+}
+
+/**
+ * @defgroup scale-test Every filter against a whole-picture reference
+ * @{
+ */
+
+static MunitResult scale_test(const MunitParameter params[],
+			      void *user_data)
+{
+	INTF(user_data);
+	inky_config *dev = &intf->dev;
+	static uint8_t src[SRC_H * SRC_W * 3];
+	static uint8_t dst[DST_H * DST_W * 3];
+	static uint8_t pnm[sizeof(src) + 32];
+	inky_image img;
+	inky_fb ref;
+	inky_fb *fb;
+
+	munit_assert_int8(inky_setup(dev), ==, INKY_OK);
+
+	fb = dev->fb;
+	ref = *fb;
+	ref.buffer = malloc(fb->bytes);
+	munit_assert_not_null(ref.buffer);
+
+	for (int i = 0; i < 60; i++) {
+		inky_scale_filter filter = (inky_scale_filter) (i % 3);
+		inky_dither_mode mode = (inky_dither_mode) (i / 3 % 5);
+		int sw = munit_rand_int_range(1, SRC_W);
+		int sh = munit_rand_int_range(1, SRC_H);
+		int w = munit_rand_int_range(1, DST_W);
+		int h = munit_rand_int_range(1, DST_H);
+		int16_t x = munit_rand_int_range(-DST_W, fb->width);
+		int16_t y = munit_rand_int_range(-DST_H, fb->height);
+		uint32_t size;
+		inky_dither d;
+
+		/* Smooth areas with noise, to tell the filters apart */
+		for (int k = 0; k < sw * sh * 3; k++) {
+			src[k] = (k / 7 * 37) % 192 +
+				munit_rand_int_range(0, 63);
+		}
+
+		size = make_pnm(pnm, src, sw, sh);
+		ref_scale(src, sw, sh, dst, w, h, filter);
+
+		for (uint32_t k = 0; k < fb->bytes; k++) {
+			fb->buffer[k] = munit_rand_uint32() & 0x55;
+		}
+
+		memcpy(ref.buffer, fb->buffer, fb->bytes);
+
+		munit_assert_int8(inky_dither_init(dev, &d, mode, w), ==,
+				  INKY_OK);
+
+		for (int j = 0; j < h; j++) {
+			munit_assert_int8(inky_dither_row(dev, &d,
+							  &dst[j * w * 3], x,
+							  y + j), ==, INKY_OK);
+		}
+
+		inky_dither_free(&d);
+
+		/* ref gets the picture dithered row by row, fb the
+		 * framebuffer from before */
+		for (uint32_t k = 0; k < fb->bytes; k++) {
+			uint8_t t = fb->buffer[k];
+
+			fb->buffer[k] = ref.buffer[k];
+			ref.buffer[k] = t;
+		}
+
+		munit_assert_int8(inky_image_open_memory(&img, pnm, size), ==,
+				  INKY_OK);
+		munit_assert_int8(inky_fb_draw_scaled(dev, &img, x, y, w, h,
+						      filter, mode, 0), ==,
+				  INKY_OK);
+		munit_assert_memory_equal(fb->bytes, fb->buffer, ref.buffer);
+	}
+
+	free(ref.buffer);
+
+	return MUNIT_OK;
+}
+
+/**
+ * @}
+ * defgroup scale-test
+ */
+
+/**
+ * @defgroup scale-shapes-test Known results
+ * @{
+ */
+
+static MunitResult scale_shapes_test(const MunitParameter params[],
+				     void *user_data)
+{
+	INTF(user_data);
+	inky_config *dev = &intf->dev;
+	static uint8_t src[SRC_H * SRC_W * 3];
+	static uint8_t img_data[sizeof(src) + 64 + 4 * SRC_H];
+	uint32_t size;
+	inky_image img;
+	uint8_t *first;
+	inky_fb *fb;
+
+	munit_assert_int8(inky_setup(dev), ==, INKY_OK);
+
+	fb = dev->fb;
+
+	/* Black and white 2 by 2 checks, 8 by 6 */
+	for (int v = 0; v < 6; v++) {
+		for (int u = 0; u < 8; u++) {
+			memset(&src[(v * 8 + u) * 3], (u / 2 + v / 2) % 2 ?
+			       0 : 0xff, 3);
+		}
+	}
+
+	size = make_pnm(img_data, src, 8, 6);
+
+	for (inky_scale_filter filter = INKY_SCALE_NEAREST;
+	     filter <= INKY_SCALE_BILINEAR; filter++) {
+		/* Each check to one pixel, exactly with nearest and box */
+		munit_assert_int8(inky_image_open_memory(&img, img_data, size),
+				  ==, INKY_OK);
+		munit_assert_int8(inky_fb_draw_scaled(dev, &img, 1, 2, 4, 3,
+						      filter,
+						      INKY_DITHER_THRESHOLD, 0),
+				  ==, INKY_OK);
+
+		for (int v = 0; v < 3 && filter != INKY_SCALE_BILINEAR; v++) {
+			for (int u = 0; u < 4; u++) {
+				inky_color c;
+
+				inky_fb_get_pixel(dev, 1 + u, 2 + v, &c);
+				munit_assert_int(c, ==, (u + v) % 2 ?
+						 INKY_COLOR_BLACK :
+						 INKY_COLOR_WHITE);
+			}
+		}
+
+		/* Three times up, every source pixel to a 3 by 3 block */
+		munit_assert_int8(inky_image_open_memory(&img, img_data, size),
+				  ==, INKY_OK);
+		munit_assert_int8(inky_fb_draw_scaled(dev, &img, 10, 3, 24, 18,
+						      filter,
+						      INKY_DITHER_THRESHOLD, 0),
+				  ==, INKY_OK);
+
+		for (int v = 0; v < 18 && filter != INKY_SCALE_BILINEAR; v++) {
+			for (int u = 0; u < 24; u++) {
+				inky_color c;
+
+				inky_fb_get_pixel(dev, 10 + u, 3 + v, &c);
+				munit_assert_int(c, ==, (u / 6 + v / 6) % 2 ?
+						 INKY_COLOR_BLACK :
+						 INKY_COLOR_WHITE);
+			}
+		}
+	}
+
+	/* A bottom up BMP scales as the same picture top down. Box
+	 * weights are symmetric, so the pixels match exactly */
+	for (int k = 0; k < 23 * 17 * 3; k++) {
+		src[k] = munit_rand_uint32() & 0xff;
+	}
+
+	first = malloc(fb->bytes);
+	munit_assert_not_null(first);
+
+	size = make_pnm(img_data, src, 23, 17);
+	memset(fb->buffer, 0, fb->bytes);
+	munit_assert_int8(inky_image_open_memory(&img, img_data, size), ==,
+			  INKY_OK);
+	munit_assert_int8(inky_fb_draw_scaled(dev, &img, 0, 0, 31, 11,
+					      INKY_SCALE_BOX,
+					      INKY_DITHER_BAYER, 0), ==,
+			  INKY_OK);
+	memcpy(first, fb->buffer, fb->bytes);
+
+	size = make_bmp(img_data, src, 23, 17);
+	memset(fb->buffer, 0, fb->bytes);
+	munit_assert_int8(inky_image_open_memory(&img, img_data, size), ==,
+			  INKY_OK);
+	munit_assert_uint8(img.bottom_up, ==, 1);
+	munit_assert_int8(inky_fb_draw_scaled(dev, &img, 0, 0, 31, 11,
+					      INKY_SCALE_BOX,
+					      INKY_DITHER_BAYER, 0), ==,
+			  INKY_OK);
+	munit_assert_memory_equal(fb->bytes, fb->buffer, first);
+	free(first);
+
+	return MUNIT_OK;
+}
+
+/**
+ * @}
+ * defgroup scale-shapes-test
+ */
+
+/**
+ * @defgroup scale-args-test Fitting and bad arguments
+ * @{
+ */
+
+static MunitResult scale_args_test(const MunitParameter params[],
+				   void *user_data)
+{
+	INTF(user_data);
+	inky_config *dev = &intf->dev;
+	static uint8_t src[4 * 3 * 3];
+	static uint8_t pnm[sizeof(src) + 32];
+	uint16_t w, h;
+	uint32_t size;
+	inky_image img;
+
+	munit_assert_int8(inky_setup(dev), ==, INKY_OK);
+
+	inky_scale_fit(640, 480, 400, 300, &w, &h);
+	munit_assert_uint16(w, ==, 400);
+	munit_assert_uint16(h, ==, 300);
+	inky_scale_fit(1920, 1080, 250, 122, &w, &h);
+	munit_assert_uint16(w, ==, 217);
+	munit_assert_uint16(h, ==, 122);
+	inky_scale_fit(100, 1000, 400, 300, &w, &h);
+	munit_assert_uint16(w, ==, 30);
+	munit_assert_uint16(h, ==, 300);
+	inky_scale_fit(10000, 1, 250, 122, &w, &h);
+	munit_assert_uint16(w, ==, 250);
+	munit_assert_uint16(h, ==, 1);
+
+	size = make_pnm(pnm, src, 4, 3);
+
+	munit_assert_int8(inky_image_open_memory(&img, pnm, size), ==, INKY_OK);
+	munit_assert_int8(inky_fb_draw_scaled(dev, NULL, 0, 0, 8, 6,
+					      INKY_SCALE_BOX,
+					      INKY_DITHER_THRESHOLD, 0), ==,
+			  INKY_E_NULL_PTR);
+	munit_assert_int8(inky_fb_draw_scaled(dev, &img, 0, 0, 8, 6,
+					      INKY_SCALE_BILINEAR + 1,
+					      INKY_DITHER_THRESHOLD, 0), ==,
+			  INKY_E_OUT_OF_RANGE);
+	munit_assert_int8(inky_fb_draw_scaled(dev, &img, 0, 0, 0, 6,
+					      INKY_SCALE_BOX,
+					      INKY_DITHER_THRESHOLD, 0), ==,
+			  INKY_E_OUT_OF_RANGE);
+	munit_assert_int8(inky_fb_draw_scaled(dev, &img, 0, 0, 8, 0,
+					      INKY_SCALE_BOX,
+					      INKY_DITHER_THRESHOLD, 0), ==,
+			  INKY_E_OUT_OF_RANGE);
+	munit_assert_int8(inky_fb_draw_scaled(dev, &img, 0, 0, 8, 6,
+					      INKY_SCALE_BOX,
+					      INKY_DITHER_ATKINSON + 1, 0), ==,
+			  INKY_E_OUT_OF_RANGE);
+
+	/* A truncated image draws the rows it can, then fails */
+	munit_assert_int8(inky_image_open_memory(&img, pnm, size - 5), ==,
+			  INKY_OK);
+	munit_assert_int8(inky_fb_draw_scaled(dev, &img, 0, 0, 8, 6,
+					      INKY_SCALE_BILINEAR,
+					      INKY_DITHER_FLOYD_STEINBERG, 0),
+			  ==, INKY_E_BAD_DATA);
+
+	return MUNIT_OK;
+}
+
+/**
+ * @}
+ * defgroup scale-args-test
+ */
+
+MunitTest scale_tests[] = {
+	{
+		.name = "/scale-test",
+		.test = scale_test,
+		.setup = device_setup,
+		.tear_down = device_tear_down,
+		.options = MUNIT_TEST_OPTION_NONE,
+		.parameters = fb_test_params
+	},
+
+	{
+		.name = "/scale-shapes-test",
+		.test = scale_shapes_test,
+		.setup = device_setup,
+		.tear_down = device_tear_down,
+		.options = MUNIT_TEST_OPTION_NONE,
+		.parameters = fb_test_params
+	},
+
+	{
+		.name = "/scale-args-test",
+		.test = scale_args_test,
+		.setup = device_setup,
+		.tear_down = device_tear_down,
+		.options = MUNIT_TEST_OPTION_NONE,
+		.parameters = fb_test_params
+	},
+
+	{
+		.name = NULL,
+		.test = NULL,
+		.setup = NULL,
+		.tear_down = NULL,
+		.options = MUNIT_TEST_OPTION_NONE,
+		.parameters = NULL
+	}
+};
+
+/**
+ * @}
+ * defgroup pimoroni-inky-scale-tests
+ */
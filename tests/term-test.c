@@ -0,0 +1,491 @@
+/**
+ * @file term-test.c
+ *
+ * Unit testing for the character cell terminal of the Pimoroni Inky
+ * driver
+ */
+
+#include "inky.h"
+
+#include <munit/munit.h>
+
+#include "test-device.h"
+
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+/**
+ * @defgroup pimoroni-inky-term-tests Pimoroni Inky terminal testing
+ * suites
+ * @{
+ */
+
+/*
+**********************************************************************
+************************** TESTS DEFINITIONS *************************
+**********************************************************************
+*/
+
+/** @brief Bytes sent over SPI since the counter was last cleared */
+static uint32_t spi_bytes;
+
+static inky_error_state count_spi_write(const uint8_t *buf, uint32_t len,
+					void *intf_ptr)
+{
+	spi_bytes += len;
+
+	return INKY_OK;
+}
+
+static void *term_setup(const MunitParameter params[], void *user_data)
+{
+	INTF(user_data);
+
+	device_setup(params, user_data);
+
+	intf->buf = calloc(1, sizeof(inky_term));
+
+	return user_data;
+}
+
+static void term_tear_down(void *fixture)
+{
+	INTF(fixture);
+
+	if (intf->buf) {
+		inky_term_free((inky_term*) intf->buf);
+	}
+
+	device_tear_down(fixture);
+}
+
+/** @brief Assert the code point of every cell of a row, padded with
+ * spaces */
+static void assert_row(const inky_term *term, uint16_t row, const char *s)
+{
+	for (uint16_t i = 0; i < term->cols; i++) {
+		uint32_t cp = inky_utf8_next(&s);
+
+		munit_assert_uint32(term->cells[row * term->cols + i].cp, ==,
+				    cp ? cp : ' ');
+	}
+}
+
+/** @brief Draw every cell of term one pixel at a time into dev */
+static void draw_reference(inky_config *dev, const inky_term *term)
+{
+	const inky_font *font = term->font;
+
+	for (uint16_t r = 0; r < term->rows; r++) {
+		for (uint16_t c = 0; c < term->cols; c++) {
+			const inky_term_cell *cell =
+				&term->cells[r * term->cols + c];
+			const inky_glyph *g = inky_font_find(font, cell->cp);
+
+			if (!g) {
+				g = inky_font_find(font, font->fallback);
+			}
+
+			for (uint16_t j = 0; j < term->cell_h; j++) {
+				const uint8_t *bits =
+					&font->bitmap[g->offset + j *
+						      ((g->width + 7) / 8)];
+
+				for (uint16_t i = 0; i < term->cell_w; i++) {
+					int ink = i < g->width &&
+						((bits[i / 8] >> (i % 8)) & 1);
+
+					inky_fb_set_pixel(dev,
+							  term->x + c *
+							  term->cell_w + i,
+							  term->y + r *
+							  term->cell_h + j,
+							  ink ? cell->fg :
+							  cell->bg);
+				}
+			}
+		}
+	}
+}
+
+/**
+ * @defgroup term-write-test Parse text and escape sequences into cells
+ * @{
+ */
+
+static MunitResult term_write_test(const MunitParameter params[],
+				   void *user_data)
+{
+	INTF(user_data);
+	inky_config *dev = &intf->dev;
+	inky_term *term = (inky_term*) intf->buf;
+	inky_color panel = color_from_char(munit_parameters_get(params,
+								 "color"));
+	inky_rect area;
+	inky_rect dirty;
+
+	munit_assert_not_null(term);
+	munit_assert_int8(inky_setup(dev), ==, INKY_OK);
+
+	/* A 10 by 3 grid with a partial cell left over */
+	area.x = 3;
+	area.y = 5;
+	area.w = 10 * 6 + 4;
+	area.h = 3 * 8 + 7;
+
+	munit_assert_int8(inky_term_create(dev, term, &inky_font_5x7, &area,
+					   INKY_COLOR_BLACK, INKY_COLOR_WHITE),
+			  ==, INKY_OK);
+	munit_assert_uint16(term->cols, ==, 10);
+	munit_assert_uint16(term->rows, ==, 3);
+
+	/* Everything is damaged until first rendered */
+	munit_assert_int8(inky_term_render(dev, term, &dirty), ==, INKY_OK);
+	munit_assert_uint16(dirty.x, ==, 3);
+	munit_assert_uint16(dirty.y, ==, 5);
+	munit_assert_uint16(dirty.w, ==, 60);
+	munit_assert_uint16(dirty.h, ==, 24);
+
+	munit_assert_int8(inky_term_render(dev, term, &dirty), ==, INKY_OK);
+	munit_assert_uint16(dirty.w, ==, 0);
+
+	/* Tabs, wrapping and a backspace */
+	munit_assert_int8(inky_term_write(dev, term, "ab\tc\r\nwrap me now!\b?"),
+			  ==, INKY_OK);
+	assert_row(term, 0, "ab      c");
+	assert_row(term, 1, "wrap me no");
+	assert_row(term, 2, "w?");
+	munit_assert_uint16(term->col, ==, 2);
+	munit_assert_uint16(term->row, ==, 2);
+
+	/* Scrolling damages only cells that change */
+	munit_assert_int8(inky_term_write(dev, term, "\n"), ==, INKY_OK);
+	assert_row(term, 0, "wrap me no");
+	assert_row(term, 1, "w?");
+	assert_row(term, 2, "");
+
+	munit_assert_int8(inky_term_render(dev, term, &dirty), ==, INKY_OK);
+	munit_assert_int8(inky_term_write(dev, term, "\n"), ==, INKY_OK);
+	assert_row(term, 0, "w?");
+	assert_row(term, 1, "");
+	assert_row(term, 2, "");
+
+	munit_assert_int8(inky_term_render(dev, term, &dirty), ==, INKY_OK);
+	munit_assert_uint16(dirty.y, ==, 5);
+	munit_assert_uint16(dirty.h, ==, 16);
+
+	/* Rewriting the same text damages nothing */
+	munit_assert_int8(inky_term_write(dev, term, "\x1b[1;1Hw?"), ==,
+			  INKY_OK);
+	munit_assert_int8(inky_term_render(dev, term, &dirty), ==, INKY_OK);
+	munit_assert_uint16(dirty.w, ==, 0);
+
+	/* Cursor moves, split across writes, and erases */
+	munit_assert_int8(inky_term_write(dev, term, "\x1b[2;"), ==, INKY_OK);
+	munit_assert_int8(inky_term_write(dev, term, "4HX\x1b[2DY\x1b[A"), ==,
+			  INKY_OK);
+	assert_row(term, 1, "  YX");
+	munit_assert_uint16(term->row, ==, 0);
+	munit_assert_uint16(term->col, ==, 3);
+
+	munit_assert_int8(inky_term_write(dev, term, "\x1b[K\x1b[3;3H"
+					  "\x1b[1J"), ==, INKY_OK);
+	assert_row(term, 0, "");
+	assert_row(term, 1, "");
+	assert_row(term, 2, "");
+
+	munit_assert_int8(inky_term_render(dev, term, &dirty), ==, INKY_OK);
+	munit_assert_uint16(dirty.x, ==, 3);
+	munit_assert_uint16(dirty.y, ==, 5);
+	munit_assert_uint16(dirty.w, ==, 4 * 6);
+	munit_assert_uint16(dirty.h, ==, 2 * 8);
+
+	/* Colors, reverse video and reset */
+	munit_assert_int8(inky_term_write(dev, term, "\x1b[H\x1b[7mA\x1b[27;31m"
+					  "B\x1b[mC"), ==, INKY_OK);
+	munit_assert_int(term->cells[0].fg, ==, INKY_COLOR_WHITE);
+	munit_assert_int(term->cells[0].bg, ==, INKY_COLOR_BLACK);
+	munit_assert_int(term->cells[1].fg, ==,
+			 panel == INKY_COLOR_RED ? INKY_COLOR_RED :
+			 INKY_COLOR_BLACK);
+	munit_assert_int(term->cells[1].bg, ==, INKY_COLOR_WHITE);
+	munit_assert_int(term->cells[2].fg, ==, INKY_COLOR_BLACK);
+
+	munit_assert_int8(inky_term_write(dev, term, "\x1b" "c"), ==,
+			  INKY_OK);
+	assert_row(term, 0, "");
+	munit_assert_uint16(term->col, ==, 0);
+
+	munit_assert_int8(inky_term_free(term), ==, INKY_OK);
+
+	/* Areas off the framebuffer or smaller than a cell */
+	area.x = dev->fb->width - 5;
+	munit_assert_int8(inky_term_create(dev, term, &inky_font_5x7, &area,
+					   INKY_COLOR_BLACK, INKY_COLOR_WHITE),
+			  ==, INKY_E_OUT_OF_RANGE);
+
+	area.x = 0;
+	area.w = 5;
+	munit_assert_int8(inky_term_create(dev, term, &inky_font_5x7, &area,
+					   INKY_COLOR_BLACK, INKY_COLOR_WHITE),
+			  ==, INKY_E_OUT_OF_RANGE);
+
+	return MUNIT_OK;
+}
+
+/**
+ * @}
+ */
+
+/**
+ * @defgroup term-render-test Compare damage rendering to full redraws
+ * @{
+ */
+
+static MunitResult term_render_test(const MunitParameter params[],
+				    void *user_data)
+{
+	INTF(user_data);
+	inky_config *dev = &intf->dev;
+	inky_term *term = (inky_term*) intf->buf;
+	const char *words[] = {
+		"inky ", "\x1b[7m", "\x1b[0m", "\x1b[31m", "\x1b[33m",
+		"\x1b[47m", "log line\n", "\r", "\t", "\xc2\xb0", "\xe2\x82\xac",
+		"\x1b[2K", "\x1b[5;9H", "\x1b[J", "\b\b"
+	};
+	inky_fb ref;
+	inky_config ref_dev;
+
+	munit_assert_not_null(term);
+	munit_assert_int8(inky_setup(dev), ==, INKY_OK);
+
+	ref = *dev->fb;
+	ref_dev = *dev;
+	ref_dev.fb = &ref;
+	ref.buffer = malloc(dev->fb->bytes);
+	munit_assert_not_null(ref.buffer);
+
+	munit_assert_int8(inky_term_create(dev, term, &inky_font_5x7, NULL,
+					   INKY_COLOR_BLACK, INKY_COLOR_WHITE),
+			  ==, INKY_OK);
+
+	for (int k = 0; k < 6; k++) {
+		for (int i = 0; i < 40; i++) {
+			int w = munit_rand_int_range(0, sizeof(words) /
+						     sizeof(words[0]) - 1);
+
+			munit_assert_int8(inky_term_write(dev, term,
+							  words[w]),
+					  ==, INKY_OK);
+		}
+
+		munit_assert_int8(inky_term_render(dev, term, NULL), ==,
+				  INKY_OK);
+
+		memcpy(ref.buffer, dev->fb->buffer, dev->fb->bytes);
+		draw_reference(&ref_dev, term);
+
+		munit_assert_memory_equal(dev->fb->bytes, dev->fb->buffer,
+					  ref.buffer);
+	}
+
+	free(ref.buffer);
+
+	return MUNIT_OK;
+}
+
+/**
+ * @}
+ */
+
+/**
+ * @defgroup term-update-test Send only damaged rows to the panel
+ * @{
+ */
+
+static MunitResult term_update_test(const MunitParameter params[],
+				    void *user_data)
+{
+	INTF(user_data);
+	inky_config *dev = &intf->dev;
+	inky_term *term = (inky_term*) intf->buf;
+	inky_rect area;
+	inky_op op;
+	uint32_t full;
+
+	munit_assert_not_null(term);
+	munit_assert_int8(inky_setup(dev), ==, INKY_OK);
+
+	dev->spi_write_cb = count_spi_write;
+
+	munit_assert_int8(inky_term_create(dev, term, &inky_font_5x7, NULL,
+					   INKY_COLOR_BLACK, INKY_COLOR_WHITE),
+			  ==, INKY_OK);
+
+	spi_bytes = 0;
+	munit_assert_int8(inky_update(dev), ==, INKY_OK);
+	full = spi_bytes;
+
+	/* The whole grid is damaged at first */
+	spi_bytes = 0;
+	munit_assert_int8(inky_term_update(dev, term), ==, INKY_OK);
+	munit_assert_uint32(spi_bytes, >, full / 2);
+	munit_assert_uint32(spi_bytes, <=, full);
+
+	/* Nothing changed, nothing sent */
+	spi_bytes = 0;
+	munit_assert_int8(inky_term_update(dev, term), ==, INKY_OK);
+	munit_assert_uint32(spi_bytes, ==, 0);
+
+	/* One character sends one text row of one or two RAM bytes */
+	munit_assert_int8(inky_term_write(dev, term, "\x1b[3;7Hx"), ==,
+			  INKY_OK);
+
+	spi_bytes = 0;
+	munit_assert_int8(inky_term_update(dev, term), ==, INKY_OK);
+	munit_assert_uint32(spi_bytes, <, full / 10);
+
+	/* Regions must lie inside the framebuffer */
+	area.x = 0;
+	area.y = 0;
+	area.w = dev->fb->width;
+	area.h = dev->fb->height + 1;
+
+	munit_assert_int8(inky_update_region(dev, &area), ==,
+			  INKY_E_OUT_OF_RANGE);
+	munit_assert_int8(inky_op_begin_region(dev, &op, NULL), ==,
+			  INKY_E_NULL_PTR);
+
+	area.h = 0;
+	munit_assert_int8(inky_op_begin_region(dev, &op, &area), ==,
+			  INKY_E_OUT_OF_RANGE);
+
+	area.h = 1;
+	munit_assert_int8(inky_op_begin_region(dev, &op, &area), ==, INKY_OK);
+	munit_assert_uint16(op.area.h, ==, 1);
+
+	return MUNIT_OK;
+}
+
+/**
+ * @}
+ */
+
+/**
+ * @defgroup term-wide-test Render cells as wide as a glyph advance goes
+ * @{
+ */
+
+static MunitResult term_wide_test(const MunitParameter params[],
+				  void *user_data)
+{
+	INTF(user_data);
+	inky_config *dev = &intf->dev;
+	inky_term *term = (inky_term*) intf->buf;
+	static const uint8_t bitmap[] = { 0x81, 0x18 };
+	static const inky_glyph glyphs[] = {
+		{ .codepoint = ' ', .offset = 0, .width = 8, .advance = 255 }
+	};
+	static const inky_font wide = {
+		.height = 2,
+		.n_glyphs = 1,
+		.glyphs = glyphs,
+		.bitmap = bitmap,
+		.fallback = ' '
+	};
+	inky_fb ref;
+	inky_config ref_dev;
+
+	munit_assert_not_null(term);
+	munit_assert_int8(inky_setup(dev), ==, INKY_OK);
+
+	/* The pHAT is too narrow for a single cell */
+	if (dev->fb->width < 255) {
+		munit_assert_int8(inky_term_create(dev, term, &wide, NULL,
+						   INKY_COLOR_BLACK,
+						   INKY_COLOR_WHITE), ==,
+				  INKY_E_OUT_OF_RANGE);
+		return MUNIT_OK;
+	}
+
+	ref = *dev->fb;
+	ref_dev = *dev;
+	ref_dev.fb = &ref;
+	ref.buffer = malloc(dev->fb->bytes);
+	munit_assert_not_null(ref.buffer);
+
+	munit_assert_int8(inky_term_create(dev, term, &wide, NULL,
+					   INKY_COLOR_BLACK, INKY_COLOR_WHITE),
+			  ==, INKY_OK);
+	munit_assert_uint8(term->cell_w, ==, 255);
+	munit_assert_int8(inky_term_write(dev, term, "\x1b[7m \n "), ==,
+			  INKY_OK);
+	munit_assert_int8(inky_term_render(dev, term, NULL), ==, INKY_OK);
+
+	memcpy(ref.buffer, dev->fb->buffer, dev->fb->bytes);
+	draw_reference(&ref_dev, term);
+
+	munit_assert_memory_equal(dev->fb->bytes, dev->fb->buffer,
+				  ref.buffer);
+
+	free(ref.buffer);
+
+	return MUNIT_OK;
+}
+
+/**
+ * @}
+ */
+
+MunitTest term_tests[] = {
+	{
+		.name = "/term-write-test",
+		.test = term_write_test,
+		.setup = term_setup,
+		.tear_down = term_tear_down,
+		.options = MUNIT_TEST_OPTION_NONE,
+		.parameters = fb_test_params
+	},
+
+	{
+		.name = "/term-render-test",
+		.test = term_render_test,
+		.setup = term_setup,
+		.tear_down = term_tear_down,
+		.options = MUNIT_TEST_OPTION_NONE,
+		.parameters = fb_test_params
+	},
+
+	{
+		.name = "/term-update-test",
+		.test = term_update_test,
+		.setup = term_setup,
+		.tear_down = term_tear_down,
+		.options = MUNIT_TEST_OPTION_NONE,
+		.parameters = fb_test_params
+	},
+
+	{
+		.name = "/term-wide-test",
+		.test = term_wide_test,
+		.setup = term_setup,
+		.tear_down = term_tear_down,
+		.options = MUNIT_TEST_OPTION_NONE,
+		.parameters = fb_test_params
+	},
+
+	{
+		.name = NULL,
+		.test = NULL,
+		.setup = NULL,
+		.tear_down = NULL,
+		.options = MUNIT_TEST_OPTION_NONE,
+		.parameters = NULL
+	}
+};
+
+/**
+ * @}
+ * defgroup pimoroni-inky-term-tests
+ */
@@ -0,0 +1,88 @@
+/**
+ * @file test-device.h
+ *
+ * Test device shared by the Pimoroni Inky C test suites. The device
+ * and its HAL stubs are defined in fb-test.c.
+ */
+#ifndef TEST_DEVICE_H
+#define TEST_DEVICE_H
+
+#include "inky.h"
+
+#include <munit/munit.h>
+
+#include <stdint.h>
+
+#define INTF(ptr)				\
+	struct test_intf *intf = (struct test_intf*) ptr;
+
+struct test_intf {
+	uint8_t *last_bytes_out;
+	uint32_t n_bytes_out;
+	uint8_t *last_bytes_in;
+	uint32_t n_bytes_in;
+	inky_color_config color;
+	inky_config dev;
+	void *usrptr;
+	uint8_t *buf;
+};
+
+/** @brief Values of the "color" test parameter */
+extern char* inky_color_params[];
+
+/** @brief Values of the "product" test parameter */
+extern char* inky_pdt_params[];
+
+/** @brief "color" and "product" test parameters */
+extern MunitParameterEnum fb_test_params[];
+
+/** @brief Sub-suites run with the framebuffer suite */
+extern MunitTest blit_tests[];
+
+extern MunitTest text_tests[];
+
+extern MunitTest term_tests[];
+
+extern MunitTest draw_tests[];
+
+extern MunitTest image_tests[];
+
+extern MunitTest dither_tests[];
+
+extern MunitTest convert_tests[];
+
+extern MunitTest binarize_tests[];
+
+extern MunitTest scale_tests[];
+
+extern MunitTest orient_tests[];
+
+extern MunitTest layer_tests[];
+
+extern MunitTest widget_tests[];
+
+inky_color color_from_char(const char* color);
+
+inky_product pdt_from_char(const char* pdt);
+
+void deinitialize_test_device(struct test_intf *intf);
+
+void initialize_test_device(struct test_intf *intf, inky_color color_type,
+			    inky_product product);
+
+void destroy_random_image(uint8_t *img_buf);
+
+uint32_t create_random_image(struct test_intf * intf);
+
+/** @brief Set up the test device for the "color" and "product" test
+ * parameters */
+void *device_setup(const MunitParameter params[], void *user_data);
+
+/** @brief Free the framebuffer, intf->buf and the test device */
+void device_tear_down(void *fixture);
+
+/** @brief Check the dirty rectangle covers every pixel that differs
+ * from before, and if exact, is their bounds */
+void check_dirty(const inky_fb *fb, const uint8_t *before, uint8_t exact);
+
+#endif /* #ifndef TEST_DEVICE_H */
@@ -0,0 +1,309 @@
+/**
+ * @file text-test.c
+ *
+ * Unit testing for the bitmap fonts and text drawing of the Pimoroni
+ * Inky driver
+ */
+
+#include "inky.h"
+
+#include <munit/munit.h>
+
+#include "test-device.h"
+
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+/**
+ * @defgroup pimoroni-inky-text-tests Pimoroni Inky text testing suites
+ * @{
+ */
+
+/*
+**********************************************************************
+************************** TESTS DEFINITIONS *************************
+**********************************************************************
+*/
+
+/**
+ * @defgroup utf8-test Decode UTF-8 and measure strings
+ * @{
+ */
+
+/** @brief Decode every code point of s into cps, returning the count */
+static uint32_t decode_all(const char *s, uint32_t *cps, uint32_t max)
+{
+	uint32_t n = 0;
+	uint32_t cp;
+
+	while ((cp = inky_utf8_next(&s))) {
+		munit_assert_uint32(n, <, max);
+		cps[n++] = cp;
+	}
+
+	/* The terminator is never passed */
+	munit_assert_char(*s, ==, 0);
+	munit_assert_uint32(inky_utf8_next(&s), ==, 0);
+
+	return n;
+}
+
+static MunitResult utf8_test(const MunitParameter params[],
+			     void *user_data)
+{
+	uint32_t cps[16];
+	const inky_font *font = &inky_font_5x7;
+
+	/* One to four byte sequences */
+	munit_assert_uint32(decode_all("A\xc3\xa9\xe2\x82\xac\xf0\x9f\x98\x80",
+				       cps, 16), ==, 4);
+	munit_assert_uint32(cps[0], ==, 'A');
+	munit_assert_uint32(cps[1], ==, 0xe9);
+	munit_assert_uint32(cps[2], ==, 0x20ac);
+	munit_assert_uint32(cps[3], ==, 0x1f600);
+
+	/* Stray continuation, overlong '/', surrogate and an out of range
+	 * lead byte each resync on the next byte */
+	munit_assert_uint32(decode_all("\x80" "a", cps, 16), ==, 2);
+	munit_assert_uint32(cps[0], ==, INKY_UTF8_INVALID);
+	munit_assert_uint32(cps[1], ==, 'a');
+
+	munit_assert_uint32(decode_all("\xc0\xaf", cps, 16), ==, 2);
+	munit_assert_uint32(cps[0], ==, INKY_UTF8_INVALID);
+	munit_assert_uint32(cps[1], ==, INKY_UTF8_INVALID);
+
+	munit_assert_uint32(decode_all("\xed\xa0\x80", cps, 16), ==, 3);
+	munit_assert_uint32(cps[0], ==, INKY_UTF8_INVALID);
+
+	munit_assert_uint32(decode_all("\xf8" "b", cps, 16), ==, 2);
+	munit_assert_uint32(cps[1], ==, 'b');
+
+	/* Truncated sequences never read past the terminator */
+	munit_assert_uint32(decode_all("x\xe2\x82", cps, 16), ==, 3);
+	munit_assert_uint32(cps[0], ==, 'x');
+	munit_assert_uint32(cps[1], ==, INKY_UTF8_INVALID);
+
+	/* Lookup and fallback */
+	munit_assert_not_null(inky_font_find(font, ' '));
+	munit_assert_not_null(inky_font_find(font, '~'));
+	munit_assert_not_null(inky_font_find(font, 0xb0));
+	munit_assert_null(inky_font_find(font, 0x7f));
+	munit_assert_null(inky_font_find(font, 0x20ac));
+	munit_assert_uint32(inky_font_find(font, 'A')->codepoint, ==, 'A');
+
+	munit_assert_uint32(inky_text_width(font, ""), ==, 0);
+	munit_assert_uint32(inky_text_width(font, "abc"), ==, 18);
+	munit_assert_uint32(inky_text_width(font, "ab\nc\n12\xe2\x82\xac"),
+			    ==, 18);
+
+	return MUNIT_OK;
+}
+
+/**
+ * @}
+ */
+
+/**
+ * @defgroup text-draw-test Compare atlas text to per-pixel glyphs
+ * @{
+ */
+
+/** @brief Draw text one pixel at a time from the font bitmap */
+static void draw_reference(inky_config *dev, const inky_font *font,
+			   int32_t x, int32_t y, const char *s,
+			   inky_color fg, const inky_color *bg,
+			   const inky_rect *clip)
+{
+	int32_t pen = x;
+	uint32_t cp;
+
+	while ((cp = inky_utf8_next(&s))) {
+		const inky_glyph *g;
+		uint8_t cell;
+
+		if (cp == '\n') {
+			pen = x;
+			y += font->height;
+			continue;
+		}
+
+		g = inky_font_find(font, cp);
+
+		if (!g) {
+			g = inky_font_find(font, font->fallback);
+		}
+
+		cell = bg && g->advance > g->width ? g->advance : g->width;
+
+		for (int32_t j = 0; j < font->height; j++) {
+			for (int32_t i = 0; i < cell; i++) {
+				const uint8_t *row = &font->bitmap[g->offset +
+								   j * ((g->width + 7) / 8)];
+				int32_t u = pen + i;
+				int32_t v = y + j;
+				int ink = i < g->width &&
+					(row[i / 8] >> (i % 8)) & 1;
+
+				if (u < 0 || v < 0 || u < clip->x ||
+				    v < clip->y || u >= clip->x + clip->w ||
+				    v >= clip->y + clip->h ||
+				    u >= dev->fb->width ||
+				    v >= dev->fb->height) {
+					continue;
+				}
+
+				if (ink) {
+					inky_fb_set_pixel(dev, u, v, fg);
+				} else if (bg) {
+					inky_fb_set_pixel(dev, u, v, *bg);
+				}
+			}
+		}
+
+		pen += g->advance;
+	}
+}
+
+/** @brief Draw s at random places and clips with the atlas and the
+ * reference, comparing the framebuffers */
+static void check_text(inky_config *dev, const inky_text_atlas *atlas,
+		       const char *s, inky_color fg, const inky_color *bg)
+{
+	inky_fb *fb = dev->fb;
+	inky_fb ref = *fb;
+	inky_config ref_dev = *dev;
+	uint8_t *before = malloc(fb->bytes);
+
+	ref.buffer = malloc(fb->bytes);
+	munit_assert_not_null(ref.buffer);
+	munit_assert_not_null(before);
+	ref_dev.fb = &ref;
+
+	for (int i = 0; i < 12; i++) {
+		int16_t x = munit_rand_int_range(-40, fb->width);
+		int16_t y = munit_rand_int_range(-20, fb->height);
+		inky_rect clip;
+
+		clip.x = munit_rand_int_range(0, fb->width - 1);
+		clip.y = munit_rand_int_range(0, fb->height - 1);
+		clip.w = munit_rand_int_range(1, fb->width);
+		clip.h = munit_rand_int_range(1, fb->height);
+
+		/* Half the time draw over the whole screen */
+		if (i % 2) {
+			clip.x = 0;
+			clip.y = 0;
+			clip.w = fb->width;
+			clip.h = fb->height;
+		}
+
+		memcpy(ref.buffer, fb->buffer, fb->bytes);
+		memcpy(before, fb->buffer, fb->bytes);
+		fb->dirty.w = 0;
+		fb->dirty.h = 0;
+
+		draw_reference(&ref_dev, atlas->font, x, y, s, fg, bg, &clip);
+
+		munit_assert_int8(inky_text_draw(dev, atlas, x, y, s,
+						 i % 2 ? NULL : &clip),
+				  ==, INKY_OK);
+
+		munit_assert_memory_equal(fb->bytes, fb->buffer, ref.buffer);
+		check_dirty(fb, before, 0);
+	}
+
+	free(before);
+	free(ref.buffer);
+}
+
+static MunitResult text_draw_test(const MunitParameter params[],
+				  void *user_data)
+{
+	INTF(user_data);
+	inky_config *dev = &intf->dev;
+	const char *s = "Inky 21.5\xc2\xb0" "C\n\xe2\x82\xac" "ab\x80{|}~";
+	inky_color panel = color_from_char(munit_parameters_get(params,
+								 "color"));
+	inky_color white = INKY_COLOR_WHITE;
+	inky_color fg;
+	inky_text_atlas atlas;
+
+	munit_assert_int8(inky_setup(dev), ==, INKY_OK);
+
+	fg = dev->fb->fmt.bpp == 1 ? INKY_COLOR_BLACK : panel;
+
+	/* Start from noise so transparent pixels show */
+	for (uint32_t i = 0; i < dev->fb->bytes; i++) {
+		dev->fb->buffer[i] = munit_rand_uint32() & 0x55;
+	}
+
+	munit_assert_int8(inky_text_atlas_create(dev, &atlas, &inky_font_5x7,
+						 fg, NULL),
+			  ==, INKY_OK);
+
+	check_text(dev, &atlas, s, fg, NULL);
+
+	munit_assert_int8(inky_text_atlas_free(&atlas), ==, INKY_OK);
+	munit_assert_null(atlas.glyphs);
+
+	munit_assert_int8(inky_text_atlas_create(dev, &atlas, &inky_font_5x7,
+						 INKY_COLOR_BLACK, &white),
+			  ==, INKY_OK);
+
+	check_text(dev, &atlas, s, INKY_COLOR_BLACK, &white);
+
+	munit_assert_int8(inky_text_draw(dev, &atlas, 0, 0, NULL, NULL), ==,
+			  INKY_E_NULL_PTR);
+
+	inky_text_atlas_free(&atlas);
+
+	/* Colors the panel lacks */
+	if (dev->fb->fmt.bpp == 1) {
+		munit_assert_int8(inky_text_atlas_create(dev, &atlas,
+							 &inky_font_5x7,
+							 INKY_COLOR_RED,
+							 NULL),
+				  ==, INKY_E_NOT_AVAILABLE);
+	}
+
+	return MUNIT_OK;
+}
+
+/**
+ * @}
+ */
+
+MunitTest text_tests[] = {
+	{
+		.name = "/utf8-test",
+		.test = utf8_test,
+		.setup = NULL,
+		.tear_down = NULL,
+		.options = MUNIT_TEST_OPTION_NONE,
+		.parameters = NULL
+	},
+
+	{
+		.name = "/text-draw-test",
+		.test = text_draw_test,
+		.setup = device_setup,
+		.tear_down = device_tear_down,
+		.options = MUNIT_TEST_OPTION_NONE,
+		.parameters = fb_test_params
+	},
+
+	{
+		.name = NULL,
+		.test = NULL,
+		.setup = NULL,
+		.tear_down = NULL,
+		.options = MUNIT_TEST_OPTION_NONE,
+		.parameters = NULL
+	}
+};
+
+/**
+ * @}
+ * defgroup pimoroni-inky-text-tests
+ */
@@ -0,0 +1,558 @@
+/**
+ * @file widget-test.c
+ *
+ * Unit testing for the retained widgets of the Pimoroni Inky driver
+ */
+
+#include "inky.h"
+
+#include <munit/munit.h>
+
+#include "test-device.h"
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+/**
+ * @defgroup pimoroni-inky-widget-tests Pimoroni Inky widget testing
+ * suites
+ * @{
+ */
+
+/*
+**********************************************************************
+************************** TESTS DEFINITIONS *************************
+**********************************************************************
+*/
+
+/* A dashboard of 6 by 5 fields */
+#define COLS		6
+#define ROWS		5
+#define N_FIELDS	(COLS * ROWS)
+#define N_SAMPLES	8
+
+struct dashboard {
+	inky_widget root;
+	inky_widget fields[N_FIELDS];
+	inky_widget inner[N_FIELDS];
+	INT32_t samples[N_FIELDS][N_SAMPLES];
+	inky_text_atlas atlas;
+	inky_bitmap bitmap;
+	uint8_t mask[8][2];
+};
+
+static void grow(inky_rect *box, const inky_rect *r)
+{
+	uint32_t x1, y1;
+
+	if (box->w == 0) {
+		*box = *r;
+		return;
+	}
+
+	x1 = box->x + box->w > r->x + r->w ? box->x + box->w : r->x + r->w;
+	y1 = box->y + box->h > r->y + r->h ? box->y + box->h : r->y + r->h;
+	box->x = box->x < r->x ? box->x : r->x;
+	box->y = box->y < r->y ? box->y : r->y;
+	box->w = x1 - box->x;
+	box->h = y1 - box->y;
+}
+
+/** @brief Fields of every type in a grid, each with a rectangle inside
+ * the ones of type INKY_WIDGET_RECT */
+static void make_dashboard(inky_config *dev, struct dashboard *d)
+{
+	inky_rect all = { 0, 0, dev->fb->width, dev->fb->height };
+	uint16_t cw = dev->fb->width / COLS;
+	uint16_t ch = dev->fb->height / ROWS;
+
+	memset(d, 0, sizeof(*d));
+
+	munit_assert_int8(inky_text_atlas_create(dev, &d->atlas,
+						 &inky_font_5x7,
+						 INKY_COLOR_BLACK, NULL), ==,
+			  INKY_OK);
+
+	for (uint8_t j = 0; j < 8; j++) {
+		d->mask[j][0] = 0x5a ^ (j * 0x11);
+		d->mask[j][1] = 0x03 & j;
+	}
+
+	d->bitmap.type = INKY_BITMAP_MASK;
+	d->bitmap.width = 10;
+	d->bitmap.height = 8;
+	d->bitmap.stride = 2;
+	d->bitmap.data = &d->mask[0][0];
+
+	munit_assert_int8(inky_widget_init(&d->root, INKY_WIDGET_RECT, &all),
+			  ==, INKY_OK);
+
+	for (uint8_t i = 0; i < N_FIELDS; i++) {
+		inky_widget *f = &d->fields[i];
+		inky_rect b;
+
+		b.x = (i % COLS) * cw + 1;
+		b.y = (i / COLS) * ch + 1;
+		b.w = cw - 2;
+		b.h = ch - 2;
+
+		munit_assert_int8(inky_widget_init(f, i % 5, &b), ==, INKY_OK);
+		munit_assert_int8(inky_widget_add(&d->root, f), ==, INKY_OK);
+
+		switch (f->type) {
+		case INKY_WIDGET_RECT:
+			b.x += 3;
+			b.y += 3;
+			b.w = b.w / 2;
+			b.h = b.h / 2;
+			munit_assert_int8(inky_widget_init(&d->inner[i],
+							   INKY_WIDGET_BAR,
+							   &b), ==, INKY_OK);
+			munit_assert_int8(inky_widget_add(f, &d->inner[i]),
+					  ==, INKY_OK);
+			break;
+		case INKY_WIDGET_TEXT:
+			munit_assert_int8(inky_widget_set_text(f, &d->atlas,
+							       "--"), ==,
+					  INKY_OK);
+			break;
+		case INKY_WIDGET_BITMAP:
+			munit_assert_int8(inky_widget_set_bitmap(f, &d->bitmap),
+					  ==, INKY_OK);
+			break;
+		case INKY_WIDGET_SPARKLINE:
+			munit_assert_int8(inky_widget_set_samples(f,
+								  d->samples[i],
+								  N_SAMPLES),
+					  ==, INKY_OK);
+			break;
+		default:
+			break;
+		}
+	}
+}
+
+/** @brief Give field i a new value */
+static void change(struct dashboard *d, uint8_t i, int32_t v)
+{
+	inky_widget *f = &d->fields[i];
+	char text[INKY_WIDGET_MAX_TEXT];
+
+	switch (f->type) {
+	case INKY_WIDGET_RECT:
+		munit_assert_int8(inky_widget_set_value(f, v % 2), ==,
+				  INKY_OK);
+		break;
+	case INKY_WIDGET_TEXT:
+		snprintf(text, sizeof(text), "%d", (int) v);
+		munit_assert_int8(inky_widget_set_text(f, &d->atlas, text), ==,
+				  INKY_OK);
+		break;
+	case INKY_WIDGET_BITMAP:
+		munit_assert_int8(inky_widget_damage(f), ==, INKY_OK);
+		break;
+	default:
+		munit_assert_int8(inky_widget_set_value(f, v), ==, INKY_OK);
+		break;
+	}
+}
+
+/** @brief Damage every widget of a tree */
+static void damage_all(inky_widget *w)
+{
+	for (; w; w = w->next) {
+		munit_assert_int8(inky_widget_damage(w), ==, INKY_OK);
+		damage_all(w->child);
+	}
+}
+
+/**
+ * @defgroup widget-render-test Compare damage rendering to full redraws
+ * @{
+ */
+
+MunitResult widget_render_test(const MunitParameter params[],
+			       void *fixture)
+{
+	INTF(fixture);
+	inky_config *dev = &intf->dev;
+	struct dashboard *d = malloc(sizeof(*d));
+	inky_rect dirty;
+	inky_fb ref;
+	inky_config ref_dev;
+
+	munit_assert_not_null(d);
+	munit_assert_int8(inky_setup(dev), ==, INKY_OK);
+
+	ref = *dev->fb;
+	ref_dev = *dev;
+	ref_dev.fb = &ref;
+	ref.buffer = malloc(dev->fb->bytes);
+	munit_assert_not_null(ref.buffer);
+
+	make_dashboard(dev, d);
+
+	/* Everything is damaged at first */
+	munit_assert_int8(inky_widget_render(dev, &d->root, &dirty), ==,
+			  INKY_OK);
+	munit_assert_uint16(dirty.x, ==, 0);
+	munit_assert_uint16(dirty.y, ==, 0);
+	munit_assert_uint16(dirty.w, ==, dev->fb->width);
+	munit_assert_uint16(dirty.h, ==, dev->fb->height);
+
+	/* Then nothing until a value changes */
+	munit_assert_int8(inky_widget_render(dev, &d->root, &dirty), ==,
+			  INKY_OK);
+	munit_assert_uint16(dirty.w, ==, 0);
+
+	for (uint8_t k = 0; k < 20; k++) {
+		inky_rect want = { 0, 0, 0, 0 };
+
+		/* Two fields change, the others are set to what they show */
+		for (uint8_t n = 0; n < 2; n++) {
+			uint8_t i = munit_rand_int_range(0, N_FIELDS - 1);
+
+			change(d, i, munit_rand_int_range(-20, 120));
+			grow(&want, &d->fields[i].bounds);
+		}
+
+		munit_assert_int8(inky_widget_set_value(&d->fields[3],
+							d->fields[3].value),
+				  ==, INKY_OK);
+		munit_assert_int8(inky_widget_set_text(&d->fields[1], &d->atlas,
+						       d->fields[1].text), ==,
+				  INKY_OK);
+
+		munit_assert_int8(inky_widget_render(dev, &d->root, &dirty),
+				  ==, INKY_OK);
+
+		/* A field may be given the value it shows */
+		if (dirty.w) {
+			munit_assert_uint16(dirty.x, >=, want.x);
+			munit_assert_uint16(dirty.y, >=, want.y);
+			munit_assert_uint16(dirty.x + dirty.w, <=,
+					    want.x + want.w);
+			munit_assert_uint16(dirty.y + dirty.h, <=,
+					    want.y + want.h);
+		}
+
+		memset(ref.buffer, 0, ref.bytes);
+		damage_all(&d->root);
+		munit_assert_int8(inky_widget_render(&ref_dev, &d->root,
+						     NULL), ==, INKY_OK);
+		munit_assert_memory_equal(dev->fb->bytes, dev->fb->buffer,
+					  ref.buffer);
+	}
+
+	/* Changing one field repaints exactly its bounds and children */
+	munit_assert_int8(inky_widget_set_value(&d->fields[0], 1), ==,
+			  INKY_OK);
+	munit_assert_int8(inky_widget_set_value(&d->fields[0], 0), ==,
+			  INKY_OK);
+	munit_assert_int8(inky_widget_set_value(&d->fields[0], 0), ==,
+			  INKY_OK);
+	munit_assert_int8(inky_widget_update(dev, &d->root), ==, INKY_OK);
+	munit_assert_uint16(dev->fb->dirty.w, ==, 0);
+	munit_assert_uint16(dev->fb->dirty.h, ==, 0);
+	munit_assert_uint8(d->fields[0].damaged, ==, 0);
+	munit_assert_uint8(d->inner[0].damaged, ==, 0);
+
+	munit_assert_int8(inky_widget_set_value(&d->inner[0], 77), ==,
+			  INKY_OK);
+	munit_assert_int8(inky_widget_render(dev, &d->root, &dirty), ==,
+			  INKY_OK);
+	munit_assert_memory_equal(sizeof(dirty), &dirty,
+				  &d->inner[0].bounds);
+
+	/* Moving a child repaints its parent */
+	dirty = d->inner[0].bounds;
+	dirty.x += 1;
+	munit_assert_int8(inky_widget_set_bounds(&d->inner[0], &dirty), ==,
+			  INKY_OK);
+	munit_assert_int8(inky_widget_render(dev, &d->root, &dirty), ==,
+			  INKY_OK);
+	munit_assert_memory_equal(sizeof(dirty), &dirty,
+				  &d->fields[0].bounds);
+
+	/* What was rendered but not sent goes with the next update */
+	munit_assert_uint16(dev->fb->dirty.w, !=, 0);
+	munit_assert_int8(inky_widget_set_value(&d->inner[0], 78), ==,
+			  INKY_OK);
+	munit_assert_int8(inky_widget_update(dev, &d->root), ==, INKY_OK);
+	munit_assert_uint16(dev->fb->dirty.w, ==, 0);
+	munit_assert_uint16(dev->fb->dirty.h, ==, 0);
+	munit_assert_int8(inky_text_atlas_free(&d->atlas), ==, INKY_OK);
+	free(ref.buffer);
+	free(d);
+
+	return MUNIT_OK;
+}
+
+/**
+ * @}
+ */
+
+/**
+ * @defgroup widget-paint-test Check what each widget type draws
+ * @{
+ */
+
+static inky_color pixel(inky_config *dev, uint16_t x, uint16_t y)
+{
+	inky_color c;
+
+	munit_assert_int8(inky_fb_get_pixel(dev, x, y, &c), ==, INKY_OK);
+
+	return c;
+}
+
+MunitResult widget_paint_test(const MunitParameter params[], void *fixture)
+{
+	INTF(fixture);
+	inky_config *dev = &intf->dev;
+	inky_rect b = { 10, 10, 22, 6 };
+	inky_widget bar, up, line, box;
+	inky_color missing;
+	INT32_t samples[4];
+
+	munit_assert_int8(inky_setup(dev), ==, INKY_OK);
+
+	/* Half a bar fills half of the 20 pixels inside the outline */
+	munit_assert_int8(inky_widget_init(&bar, INKY_WIDGET_BAR, &b), ==,
+			  INKY_OK);
+	munit_assert_int8(inky_widget_set_range(&bar, -50, 50), ==, INKY_OK);
+	munit_assert_int8(inky_widget_set_value(&bar, 0), ==, INKY_OK);
+	munit_assert_int8(inky_widget_render(dev, &bar, NULL), ==, INKY_OK);
+
+	for (uint16_t x = 11; x < 31; x++) {
+		munit_assert_int(pixel(dev, x, 12), ==,
+				 x < 21 ? INKY_COLOR_BLACK : INKY_COLOR_WHITE);
+	}
+
+	munit_assert_int(pixel(dev, 31, 12), ==, INKY_COLOR_BLACK);
+
+	/* Values past the range are clamped */
+	munit_assert_int8(inky_widget_set_value(&bar, 500), ==, INKY_OK);
+	munit_assert_int8(inky_widget_render(dev, &bar, NULL), ==, INKY_OK);
+	munit_assert_int(pixel(dev, 30, 12), ==, INKY_COLOR_BLACK);
+
+	/* Taller than wide fills bottom up */
+	b.x = 40;
+	b.w = 6;
+	b.h = 12;
+	munit_assert_int8(inky_widget_init(&up, INKY_WIDGET_BAR, &b), ==,
+			  INKY_OK);
+	munit_assert_int8(inky_widget_set_value(&up, 30), ==, INKY_OK);
+	munit_assert_int8(inky_widget_render(dev, &up, NULL), ==, INKY_OK);
+	munit_assert_int(pixel(dev, 42, 20), ==, INKY_COLOR_BLACK);
+	munit_assert_int(pixel(dev, 42, 18), ==, INKY_COLOR_BLACK);
+	munit_assert_int(pixel(dev, 42, 17), ==, INKY_COLOR_WHITE);
+
+	/* Sparklines end on the right edge and scale to their samples */
+	b.x = 60;
+	b.w = 31;
+	b.h = 11;
+	munit_assert_int8(inky_widget_init(&line, INKY_WIDGET_SPARKLINE, &b),
+			  ==, INKY_OK);
+	munit_assert_int8(inky_widget_set_range(&line, 0, 0), ==, INKY_OK);
+	munit_assert_int8(inky_widget_set_samples(&line, samples, 4), ==,
+			  INKY_OK);
+
+	for (int32_t v = 0; v < 5; v++) {
+		munit_assert_int8(inky_widget_set_value(&line, v * 10), ==,
+				  INKY_OK);
+	}
+
+	munit_assert_uint16(line.count, ==, 4);
+	munit_assert_int8(inky_widget_render(dev, &line, NULL), ==, INKY_OK);
+	munit_assert_int(pixel(dev, 90, 10), ==, INKY_COLOR_BLACK);
+	munit_assert_int(pixel(dev, 60, 20), ==, INKY_COLOR_BLACK);
+	munit_assert_int(pixel(dev, 60, 10), ==, INKY_COLOR_WHITE);
+	munit_assert_int(pixel(dev, 90, 20), ==, INKY_COLOR_WHITE);
+
+	/* Rectangles outline, or fill while their value is set */
+	b.x = 100;
+	b.w = 8;
+	b.h = 8;
+	munit_assert_int8(inky_widget_init(&box, INKY_WIDGET_RECT, &b), ==,
+			  INKY_OK);
+	munit_assert_int8(inky_widget_render(dev, &box, NULL), ==, INKY_OK);
+	munit_assert_int(pixel(dev, 100, 10), ==, INKY_COLOR_BLACK);
+	munit_assert_int(pixel(dev, 103, 13), ==, INKY_COLOR_WHITE);
+
+	munit_assert_int8(inky_widget_set_value(&box, 1), ==, INKY_OK);
+	munit_assert_uint8(box.damaged, ==, 1);
+	munit_assert_int8(inky_widget_render(dev, &box, NULL), ==, INKY_OK);
+	munit_assert_int(pixel(dev, 103, 13), ==, INKY_COLOR_BLACK);
+
+	/* Colors the panel lacks stop the render and keep the damage */
+	missing = inky_color_available(dev, INKY_COLOR_RED) ?
+		INKY_COLOR_YELLOW : INKY_COLOR_RED;
+	munit_assert_int8(inky_widget_set_colors(&box, INKY_COLOR_BLACK,
+						 missing), ==, INKY_OK);
+	munit_assert_int8(inky_widget_render(dev, &box, NULL), ==,
+			  INKY_E_NOT_AVAILABLE);
+	munit_assert_uint8(box.damaged, ==, 1);
+
+	return MUNIT_OK;
+}
+
+/**
+ * @}
+ */
+
+/**
+ * @defgroup widget-args-test Check widget arguments
+ * @{
+ */
+
+MunitResult widget_args_test(const MunitParameter params[], void *fixture)
+{
+	INTF(fixture);
+	inky_config *dev = &intf->dev;
+	inky_rect b = { 0, 0, 8, 8 };
+	inky_widget w, other;
+	inky_widget chain[INKY_DRAW_MAX_CLIP];
+	inky_text_atlas atlas;
+	inky_rect dirty;
+	INT32_t samples[2];
+	char text[INKY_WIDGET_MAX_TEXT + 1];
+
+	munit_assert_int8(inky_widget_init(&w, INKY_WIDGET_BAR, &b), ==,
+			  INKY_OK);
+	munit_assert_int8(inky_widget_render(dev, &w, NULL), ==,
+			  INKY_E_NOT_CONFIGURED);
+
+	munit_assert_int8(inky_setup(dev), ==, INKY_OK);
+
+	munit_assert_int8(inky_widget_init(NULL, INKY_WIDGET_BAR, &b), ==,
+			  INKY_E_NULL_PTR);
+	munit_assert_int8(inky_widget_init(&w, INKY_WIDGET_BAR, NULL), ==,
+			  INKY_E_NULL_PTR);
+	munit_assert_int8(inky_widget_init(&w, INKY_WIDGET_SPARKLINE + 1, &b),
+			  ==, INKY_E_OUT_OF_RANGE);
+	munit_assert_int8(inky_widget_render(dev, NULL, NULL), ==,
+			  INKY_E_NULL_PTR);
+
+	munit_assert_int8(inky_widget_init(&w, INKY_WIDGET_TEXT, &b), ==,
+			  INKY_OK);
+	munit_assert_int8(inky_widget_init(&other, INKY_WIDGET_RECT, &b), ==,
+			  INKY_OK);
+
+	munit_assert_int8(inky_widget_add(&w, NULL), ==, INKY_E_NULL_PTR);
+	munit_assert_int8(inky_widget_add(&w, &w), ==, INKY_E_OUT_OF_RANGE);
+	munit_assert_int8(inky_widget_add(&w, &other), ==, INKY_OK);
+	munit_assert_int8(inky_widget_add(&w, &other), ==,
+			  INKY_E_OUT_OF_RANGE);
+
+	munit_assert_int8(inky_widget_set_value(NULL, 1), ==,
+			  INKY_E_NULL_PTR);
+	munit_assert_int8(inky_widget_set_range(&w, 2, 1), ==,
+			  INKY_E_OUT_OF_RANGE);
+	munit_assert_int8(inky_widget_set_samples(&w, NULL, 2), ==,
+			  INKY_E_NULL_PTR);
+	munit_assert_int8(inky_widget_set_samples(&w, samples, 1), ==,
+			  INKY_E_OUT_OF_RANGE);
+	munit_assert_int8(inky_widget_set_bitmap(&w, NULL), ==,
+			  INKY_E_NULL_PTR);
+	munit_assert_int8(inky_widget_set_colors(NULL, INKY_COLOR_BLACK,
+						 INKY_COLOR_WHITE), ==,
+			  INKY_E_NULL_PTR);
+	munit_assert_int8(inky_widget_set_bounds(&w, NULL), ==,
+			  INKY_E_NULL_PTR);
+	munit_assert_int8(inky_widget_damage(NULL), ==, INKY_E_NULL_PTR);
+
+	munit_assert_int8(inky_text_atlas_create(dev, &atlas, &inky_font_5x7,
+						 INKY_COLOR_BLACK, NULL), ==,
+			  INKY_OK);
+
+	memset(text, 'x', sizeof(text) - 1);
+	text[INKY_WIDGET_MAX_TEXT] = '\0';
+	munit_assert_int8(inky_widget_set_text(&w, &atlas, text), ==,
+			  INKY_E_OUT_OF_RANGE);
+	text[INKY_WIDGET_MAX_TEXT - 1] = '\0';
+	munit_assert_int8(inky_widget_set_text(&w, &atlas, text), ==,
+			  INKY_OK);
+	munit_assert_int8(inky_widget_set_text(&w, NULL, text), ==,
+			  INKY_E_NULL_PTR);
+
+	/* Widgets off the framebuffer draw and send nothing */
+	b.x = dev->fb->width;
+	munit_assert_int8(inky_widget_set_bounds(&w, &b), ==, INKY_OK);
+	munit_assert_int8(inky_widget_render(dev, &w, &dirty), ==, INKY_OK);
+	munit_assert_uint16(dirty.w, ==, 0);
+	munit_assert_uint8(w.damaged, ==, 0);
+
+	/* Trees deeper than the clip stack */
+	b.x = 0;
+
+	for (uint8_t i = 0; i < INKY_DRAW_MAX_CLIP; i++) {
+		munit_assert_int8(inky_widget_init(&chain[i],
+						   INKY_WIDGET_RECT, &b), ==,
+				  INKY_OK);
+
+		if (i) {
+			munit_assert_int8(inky_widget_add(&chain[i - 1],
+							  &chain[i]), ==,
+					  INKY_OK);
+		}
+	}
+
+	munit_assert_int8(inky_widget_render(dev, &chain[0], NULL), ==,
+			  INKY_E_OUT_OF_RANGE);
+	munit_assert_int8(inky_widget_render(dev, &chain[1], NULL), ==,
+			  INKY_OK);
+
+	munit_assert_int8(inky_text_atlas_free(&atlas), ==, INKY_OK);
+
+	return MUNIT_OK;
+}
+
+/**
+ * @}
+ */
+
+MunitTest widget_tests[] = {
+	{
+		.name = "/widget-render-test",
+		.test = widget_render_test,
+		.setup = device_setup,
+		.tear_down = device_tear_down,
+		.options = MUNIT_TEST_OPTION_NONE,
+		.parameters = fb_test_params
+	},
+
+	{
+		.name = "/widget-paint-test",
+		.test = widget_paint_test,
+		.setup = device_setup,
+		.tear_down = device_tear_down,
+		.options = MUNIT_TEST_OPTION_NONE,
+		.parameters = fb_test_params
+	},
+
+	{
+		.name = "/widget-args-test",
+		.test = widget_args_test,
+		.setup = device_setup,
+		.tear_down = device_tear_down,
+		.options = MUNIT_TEST_OPTION_NONE,
+		.parameters = fb_test_params
+	},
+
+	{
+		.name = NULL,
+		.test = NULL,
+		.setup = NULL,
+		.tear_down = NULL,
+		.options = MUNIT_TEST_OPTION_NONE,
+		.parameters = NULL
+	}
+};
+
+/**
+ * @}
+ * defgroup pimoroni-inky-widget-tests
+ */